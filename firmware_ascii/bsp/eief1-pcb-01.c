@@ -253,6 +253,7 @@ Requires:
 Promises:
 @Bsp_u32TimingViolationsCounter is incremented if G_u32SystemTime1ms has
 increased by more than one since this function was last called
+- The violation is added to the trace with MainRecordTimingViolation()
 
 */
 void SystemTimeCheck(void)
@@ -265,12 +266,13 @@ void SystemTimeCheck(void)
     /* Flag, count and optionally display warning */
     Bsp_u32TimingViolationsCounter++;
     G_u32SystemFlags |= _SYSTEM_TIME_WARNING;
+    MainRecordTimingViolation(G_u32SystemTime1ms - u32PreviousSystemTick);
     
+    /* Deferred so that reporting a violation does not cause more of them */
     if(G_u32DebugFlags & _DEBUG_TIME_WARNING_ENABLE)
     {
-      DebugPrintf("\n\r*** 1ms timing violation: ");
-      DebugPrintNumber(Bsp_u32TimingViolationsCounter);
-      DebugLineFeed();
+      DebugLog(DEBUG_LOG_TIMING_VIOLATION, Bsp_u32TimingViolationsCounter, 
+               G_u32SystemTime1ms - u32PreviousSystemTick);
     }
   }
   
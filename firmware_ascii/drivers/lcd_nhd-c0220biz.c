@@ -104,7 +104,7 @@ void LcdCommand(u8 u8Command_)
   au8LCDWriteCommand[1] = u8Command_;
     
   /* Queue the command to the IC application */
-  TwiWriteData(U8_LCD_ADDRESS, sizeof(au8LCDWriteCommand), &au8LCDWriteCommand[0], TWI_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, sizeof(au8LCDWriteCommand), &au8LCDWriteCommand[0], TWI_STOP);
 
   /* Add a delay during initialization to let the command send properly */
   if(G_u32SystemFlags & _SYSTEM_INITIALIZING )
@@ -155,7 +155,7 @@ void LcdMessage(u8 u8Address_, u8* pu8Message_)
   }
     
   /* Queue the message */
-  TwiWriteData(U8_LCD_ADDRESS, u8Index, au8LCDMessage, TWI_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, u8Index, au8LCDMessage, TWI_STOP);
 
 } /* end LcdMessage() */
 
@@ -193,7 +193,7 @@ void LcdClearChars(u8 u8Address_, u8 u8CharactersToClear_)
   }
       
   /* Queue the message */
-  TwiWriteData(U8_LCD_ADDRESS, u8CharactersToClear_ + 1, au8LCDMessage, TWI_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, u8CharactersToClear_ + 1, au8LCDMessage, TWI_STOP);
       	
 } /* end LcdClearChars() */
 
@@ -235,10 +235,10 @@ void LcdInitialize(void)
   
   /* Send Control Command */
   u8Byte = LCD_CONTROL_COMMAND;
-  TwiWriteData(U8_LCD_ADDRESS, 1, &u8Byte, TWI_NO_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, 1, &u8Byte, TWI_NO_STOP);
   
   /* Send Control Commands */
-  TwiWriteData(U8_LCD_ADDRESS, sizeof(au8Commands), &au8Commands[0], TWI_NO_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, sizeof(au8Commands), &au8Commands[0], TWI_NO_STOP);
   
   /* Wait for 200 ms */
   Lcd_u32Timer = G_u32SystemTime1ms;
@@ -246,7 +246,7 @@ void LcdInitialize(void)
   
   /* Send Final Command to turn it on */
   u8Byte = (LCD_DISPLAY_CMD | LCD_DISPLAY_ON);
-  TwiWriteData(U8_LCD_ADDRESS, 1, &u8Byte, TWI_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, 1, &u8Byte, TWI_STOP);
 
   /* Blacklight - White */
   LedOn(LCD_RED);
@@ -254,8 +254,8 @@ void LcdInitialize(void)
   LedOn(LCD_BLUE);
   
   u8Byte = LCD_CONTROL_DATA;
-  TwiWriteData(U8_LCD_ADDRESS, 1,  &u8Byte, TWI_NO_STOP);
-  TwiWriteData(U8_LCD_ADDRESS, 20, &au8Welcome[0], TWI_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, 1,  &u8Byte, TWI_NO_STOP);
+  TwiWriteData(LCD_I2C, U8_LCD_ADDRESS, 20, &au8Welcome[0], TWI_STOP);
    
   Lcd_u32Timer = G_u32SystemTime1ms;
   G_u32ApplicationFlags |= _APPLICATION_FLAGS_LCD;
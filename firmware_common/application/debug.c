@@ -18,6 +18,20 @@ requested using en+c00.  Commands range from 01 to 99 (must include the leading
 for single-digit commands) and all commands must have the prefix en+c. 
 The current command list can be quickly checked in debug_x.h (where x is application-specific)
 
+NAMED COMMANDS
+Tasks can also add commands at run time with DebugRegisterCommand(), usually from 
+their initialization function.  A named command is one or two words followed by 
+up to DEBUG_CMD_MAX_TOKENS words in total, separated by spaces:
+
+  ant stats 3
+  
+The function gets the words after the name as arguments (see fnDebugCommand_type)
+and can convert numbers with DebugParseNumber().  The table is kept sorted by 
+name so the lookup is a binary search.  Type "help" for the list.
+
+void UserApp1NamedCommand(u8 u8Argc_, u8** ppu8Argv_);
+DebugRegisterCommand("app1 rate", "<ms>  Set the update rate", UserApp1NamedCommand);
+
 This application requires a UART resource for input/output data.
 
 The terminal program used to interface to the debugger should be set to:
@@ -41,16 +55,52 @@ CONSTANTS
 - DEBUG_SCANF_BUFFER_SIZE is the size of G_au8DebugScanfBuffer and thus the max of G_u8DebugScanfCharCount
 
 TYPES
-- NONE
+- DebugCommandType
+- DebugLogIdType
+- DebugLogRecordType
+- DebugOutputPolicyType
+- DebugNamedCommandType
+- fnDebugCommand_type
 
 PUBLIC FUNCTIONS
 - u32 DebugPrintf(u8* u8String_)
+- u32 DebugPrintfFmt(u8* pu8Format_, ...)
 - void DebugLineFeed(void)
 - void DebugPrintNumber(u32 u32Number_)
 - u8 DebugScanf(u8* pu8Buffer_)
 - void DebugSetPassthrough(void)
 - void DebugClearPassthrough(void)
-
+- bool DebugLog(DebugLogIdType eId_, u32 u32Arg0_, u32 u32Arg1_)
+- void DebugSetOutputPolicy(DebugOutputPolicyType ePolicy_)
+- void DebugOutputDropCounts(u32* pu32Messages_, u32* pu32Bytes_)
+- bool DebugRegisterCommand(u8* pu8Name_, u8* pu8Help_, fnDebugCommand_type pfnCommand_)
+- bool DebugParseNumber(u8* pu8Arg_, u32* pu32Value_)
+
+DEFERRED LOGGING
+DebugLog() saves a format id, the time and two raw arguments in a RAM ring in a 
+few instructions.  The debug task sends one entry per pass.  By default the entry 
+is formatted as text from Debug_apu8LogFormats[].  Command "Toggle binary log output"
+sends entries as binary frames instead for a host program to decode with the same
+format table:
+
+  DEBUG_LOG_SYNC, id, time (ms, low byte first, low 16 bits), arg0, arg1
+
+Each argument is sent 7 bits per byte, least significant first, with bit 7 set 
+on every byte except the last, so small values take one byte and a typical
+frame is 6 bytes instead of 30-50 characters of text.
+
+OUTPUT POLICY
+Debug output never takes the last DEBUG_TX_RESERVED_SLOTS message slots so heavy
+logging cannot starve functional traffic.  When there is no room the output 
+policy decides what happens (DebugSetOutputPolicy() or command "Cycle debug output policy"):
+- DEBUG_OUTPUT_BLOCK_INIT (default): during initialization the UART and messaging
+  tasks are run until there is room; after that the new message is dropped
+- DEBUG_OUTPUT_DROP_NEWEST: the new message is dropped
+- DEBUG_OUTPUT_DROP_OLDEST: debug messages waiting to be sent are dropped to make room
+
+Dropped messages and bytes are counted and a "[N msgs dropped]" line is sent 
+once space frees up so the gap shows in the output.  Keystroke echo is sent 
+directly and is never dropped.
 
 ***********************************************************************************************************************/
 
@@ -101,6 +151,34 @@ static u8 *Debug_pu8CmdBufferNextChar;                   /*!< @brief Pointer to
 static u16 Debug_u16CommandSize;                         /*!< @brief Number of characters in the command buffer */
 static u8 Debug_u8Command;                               /*!< @brief A validated command number */
 
+static DebugNamedCommandType Debug_asNamedCommands[DEBUG_NAMED_COMMANDS]; /*!< @brief Registered commands sorted by name */
+static u8 Debug_u8NamedCommands;                         /*!< @brief Commands in Debug_asNamedCommands */
+static DebugNamedCommandType* Debug_psNamedCommand;      /*!< @brief Validated named command; NULL for an en+c command */
+static u8* Debug_apu8Tokens[DEBUG_CMD_MAX_TOKENS];       /*!< @brief Words of the command line in Debug_au8CommandBuffer */
+static u8 Debug_u8ArgIndex;                              /*!< @brief Debug_apu8Tokens index of the first argument */
+static u8 Debug_u8Tokens;                                /*!< @brief Words in Debug_apu8Tokens */
+
+static DebugLogRecordType Debug_asLogRing[DEBUG_LOG_RECORDS]; /*!< @brief Deferred log entries */
+static u8 Debug_u8LogHead;                               /*!< @brief Index of the oldest log entry */
+static u8 Debug_u8LogTail;                               /*!< @brief Index of the next free log entry */
+static u8 Debug_u8LogCount;                              /*!< @brief Log entries waiting to be sent */
+static u32 Debug_u32LogDropped;                          /*!< @brief DebugLog() calls that found the ring full */
+
+static DebugOutputPolicyType Debug_eOutputPolicy = DEBUG_OUTPUT_BLOCK_INIT; /*!< @brief What to do when output finds no room */
+static u32 Debug_u32DroppedMessages;                     /*!< @brief Debug messages dropped since startup */
+static u32 Debug_u32DroppedBytes;                        /*!< @brief Debug bytes dropped since startup */
+static u32 Debug_u32DropsUnreported;                     /*!< @brief Dropped messages not yet announced with a marker */
+
+/*! @brief Names by DebugOutputPolicyType for "Cycle debug output policy" */
+static u8* const Debug_apu8OutputPolicyNames[DEBUG_OUTPUT_POLICIES] =
+{ (u8*)"block during init", (u8*)"drop newest", (u8*)"drop oldest" };
+
+/*! @brief Log formats by DebugLogIdType.  Each is given the two arguments of the entry and 
+should only use %u, %d, %x or %c (see DebugPrintfFmt()). */
+static u8* const Debug_apu8LogFormats[DEBUG_LOG_IDS] =
+{ (u8*)"*** 1ms timing violation: %u (%u ms)\n\r"  /* DEBUG_LOG_TIMING_VIOLATION */
+};
+
 /*! @brief Add commands by updating debug.h in the Command-Specific Definitions section, then update this list
 with the function name to call for the corresponding command: */
 #ifdef EIE_ASCII
@@ -109,10 +187,12 @@ DebugCommandType Debug_au8Commands[DEBUG_COMMANDS] =
   {DEBUG_CMD_NAME01, DebugCommandLedTestToggle},
   {DEBUG_CMD_NAME02, DebugCommandSysTimeToggle},
   {DEBUG_CMD_NAME03, DebugCommandDummy},
-  {DEBUG_CMD_NAME04, DebugCommandDummy},
-  {DEBUG_CMD_NAME05, DebugCommandDummy},
-  {DEBUG_CMD_NAME06, DebugCommandDummy},
-  {DEBUG_CMD_NAME07, DebugCommandDummy} 
+  {DEBUG_CMD_NAME04, DebugCommandAntLinkStats},
+  {DEBUG_CMD_NAME05, DebugCommandAntLinkStatsReset},
+  {DEBUG_CMD_NAME06, DebugCommandLogBinaryToggle},
+  {DEBUG_CMD_NAME07, DebugCommandTaskProfile},
+  {DEBUG_CMD_NAME08, DebugCommandTimingTrace},
+  {DEBUG_CMD_NAME09, DebugCommandOutputPolicy} 
 };
 
 static u8 Debug_au8StartupMsg[] = "\n\n\r*** RAZOR SAM3U2 ASCII LCD DEVELOPMENT BOARD ***\n\n\r";
@@ -124,10 +204,12 @@ DebugCommandType Debug_au8Commands[DEBUG_COMMANDS] =
   {DEBUG_CMD_NAME01, DebugCommandLedTestToggle},
   {DEBUG_CMD_NAME02, DebugCommandSysTimeToggle},
   {DEBUG_CMD_NAME03, DebugCommandCaptouchValuesToggle},
-  {DEBUG_CMD_NAME04, DebugCommandDummy},
-  {DEBUG_CMD_NAME05, DebugCommandDummy},
-  {DEBUG_CMD_NAME06, DebugCommandDummy},
-  {DEBUG_CMD_NAME07, DebugCommandDummy} 
+  {DEBUG_CMD_NAME04, DebugCommandAntLinkStats},
+  {DEBUG_CMD_NAME05, DebugCommandAntLinkStatsReset},
+  {DEBUG_CMD_NAME06, DebugCommandLogBinaryToggle},
+  {DEBUG_CMD_NAME07, DebugCommandTaskProfile},
+  {DEBUG_CMD_NAME08, DebugCommandTimingTrace},
+  {DEBUG_CMD_NAME09, DebugCommandOutputPolicy} 
 };
 
 static u8 Debug_au8StartupMsg[] = "\n\n\r*** RAZOR SAM3U2 DOT MATRIX LCD DEVELOPMENT BOARD ***\n\n\r";
@@ -164,8 +246,8 @@ Requires:
 @param u8String_ is a NULL-terminated C-string
 
 Promises:
-- The string is queued to the debug UART.
-- The message token is returned
+- The string is queued to the debug UART unless the output policy drops it
+- The message token is returned; 0 if the string was dropped
 
 */
 u32 DebugPrintf(u8* u8String_)
@@ -179,11 +261,60 @@ u32 DebugPrintf(u8* u8String_)
     pu8Parser++;
   }
     
-  return( UartWriteData(Debug_Uart, u32Size, u8String_) );
+  return( DebugWrite(u8String_, u32Size) );
  
 } /* end DebugPrintf() */
 
 
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn u32 DebugPrintfFmt(u8* pu8Format_, ...)
+
+@brief Formats a string with arguments and queues it to the Debug port as one message.  
+
+A small subset of printf is supported.  Each conversion is %[0][width]type where 
+type is one of:
+- u: unsigned decimal (u32 or smaller)
+- d: signed decimal (s32 or smaller)
+- x / X: unsigned hexadecimal in lower / upper case
+- s: null-terminated string
+- c: single character
+- %: a '%' character
+
+The width pads the field on the left with spaces, or with zeros if it starts with '0'.
+The whole line is built on the stack and sent with a single UartWriteData() call, 
+so it uses one message slot, one token and one transfer instead of one for each piece.
+
+Example:
+DebugPrintfFmt("Captouch (H:V) %u:%u\n\r", u8Horizontal, u8Vertical);
+DebugPrintfFmt("Address 0x%08x\n\r", u32Address);
+
+Requires:
+- The debug UART resource has been setup for the debug application.
+
+@param pu8Format_ is a NULL-terminated format string
+@param ... are the values for each conversion in pu8Format_
+
+Promises:
+- The formatted text up to U16_MAX_TX_MESSAGE_LENGTH characters is queued to 
+  the debug UART unless the output policy drops it; anything longer is cut off
+- The message token is returned; 0 if the text was dropped
+
+*/
+u32 DebugPrintfFmt(u8* pu8Format_, ...)
+{
+  u8 au8Line[U16_MAX_TX_MESSAGE_LENGTH];
+  u16 u16Length;
+  va_list vaArgs;
+  
+  va_start(vaArgs, pu8Format_);
+  u16Length = DebugFormat(au8Line, sizeof(au8Line), pu8Format_, vaArgs);
+  va_end(vaArgs);
+  
+  return( DebugWrite(au8Line, u16Length) );
+ 
+} /* end DebugPrintfFmt() */
+
+
 /*!----------------------------------------------------------------------------------------------------------------------
 @fn void DebugLineFeed(void)
 
@@ -203,7 +334,7 @@ void DebugLineFeed(void)
 {
   u8 au8Linefeed[] = {ASCII_LINEFEED, ASCII_CARRIAGE_RETURN};
   
-  UartWriteData(Debug_Uart, sizeof(au8Linefeed), &au8Linefeed[0]);
+  DebugWrite(&au8Linefeed[0], sizeof(au8Linefeed));
 
 } /* end DebugLineFeed() */
 
@@ -222,7 +353,7 @@ DebugPrintNumber(u32Number);
 
 
 Requires:
-- Enough space is available on the heap to temporarily store the number array
+- NONE
 
 @param u32Number_ is the number to print.
 
@@ -232,52 +363,10 @@ Promises:
 */
 void DebugPrintNumber(u32 u32Number_)
 {
-  bool bFoundDigit = FALSE;
-  u8 au8AsciiNumber[10];
-  u8 u8CharCount = 0;
-  u32 u32Temp, u32Divider = 1000000000;
-  u8 *pu8Data;
-  
-  /* Parse out all the digits, start counting after leading zeros */
-  for(u8 index = 0; index < 10; index++)
-  {
-    /* Get the digit and add offset to get ASCII character */
-    au8AsciiNumber[index] = (u32Number_ / u32Divider) + NUMBER_ASCII_TO_DEC;
-    if(au8AsciiNumber[index] != '0')
-    {
-      bFoundDigit = TRUE;
-    }
-    if(bFoundDigit)
-    {
-      u8CharCount++;
-    }
-    u32Number_ %= u32Divider;
-    u32Divider /= 10;
-  }
-  
-  /* Handle special case where u32Number == 0 */
-  if(!bFoundDigit)
-  {
-    u8CharCount = 1;
-  }
-  
-  /* Allocate memory for the number and copy the array */
-  pu8Data = malloc(u8CharCount);
-  if (pu8Data == NULL)
-  {
-    Debug_u8ErrorCode = DEBUG_ERROR_MALLOC;
-    Debug_pfnStateMachine = DebugSM_Error;
-  }
+  u8 au8AsciiNumber[UTIL_FORMAT_U32_SIZE];
   
-  u32Temp = 9;
-  for(u8 index = u8CharCount; index != 0; index--)
-  {
-    pu8Data[index - 1] = au8AsciiNumber[u32Temp--];
-  }
-    
-  /* Print the ascii string and free the memory */
-  UartWriteData(Debug_Uart, u8CharCount, pu8Data);
-  free(pu8Data);
+  /* The messaging task copies the data so the stack array can be used */
+  DebugWrite(au8AsciiNumber, FormatUnsigned(u32Number_, au8AsciiNumber));
   
 } /* end DebugDebugPrintNumber() */
 
@@ -380,6 +469,242 @@ void DebugClearPassthrough(void)
 } /* end DebugClearPassthrough */
 
 
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn bool DebugLog(DebugLogIdType eId_, u32 u32Arg0_, u32 u32Arg1_)
+
+@brief Saves a log entry that the debug task formats and sends later.  
+
+This takes a few instructions so it can be used in time-critical code and ISRs 
+where DebugPrintf() would cost too much.  The text is in Debug_apu8LogFormats[].
+
+Example:
+DebugLog(DEBUG_LOG_TIMING_VIOLATION, u32Count, u32ElapsedMs);
+
+Requires:
+@param eId_ is the format of the entry
+@param u32Arg0_ is the first value for the format
+@param u32Arg1_ is the second value for the format (any value if unused)
+
+Promises:
+- If there is room, the entry is added to Debug_asLogRing with the current 
+  G_u32SystemTime1ms and TRUE is returned
+- Otherwise Debug_u32LogDropped is incremented and FALSE is returned
+
+*/
+bool DebugLog(DebugLogIdType eId_, u32 u32Arg0_, u32 u32Arg1_)
+{
+  DebugLogRecordType* psRecord;
+  
+  __disable_irq();
+  if(Debug_u8LogCount == DEBUG_LOG_RECORDS)
+  {
+    Debug_u32LogDropped++;
+    __enable_irq();
+    return(FALSE);
+  }
+  
+  psRecord = &Debug_asLogRing[Debug_u8LogTail];
+  psRecord->u32TimeStamp = G_u32SystemTime1ms;
+  psRecord->u32Arg0      = u32Arg0_;
+  psRecord->u32Arg1      = u32Arg1_;
+  psRecord->eId          = eId_;
+  
+  Debug_u8LogTail = (Debug_u8LogTail + 1) & (DEBUG_LOG_RECORDS - 1);
+  Debug_u8LogCount++;
+  __enable_irq();
+  
+  return(TRUE);
+  
+} /* end DebugLog() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn void DebugSetOutputPolicy(DebugOutputPolicyType ePolicy_)
+
+@brief Selects what debug output does when the message pool is short of slots.
+
+Requires:
+@param ePolicy_ is the new policy
+
+Promises:
+- Debug_eOutputPolicy = ePolicy_ if it is a valid policy
+
+*/
+void DebugSetOutputPolicy(DebugOutputPolicyType ePolicy_)
+{
+  if(ePolicy_ < DEBUG_OUTPUT_POLICIES)
+  {
+    Debug_eOutputPolicy = ePolicy_;
+  }
+  
+} /* end DebugSetOutputPolicy() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn void DebugOutputDropCounts(u32* pu32Messages_, u32* pu32Bytes_)
+
+@brief Reports how much debug output has been dropped since startup.
+
+Requires:
+@param pu32Messages_ points to where the dropped message count is written
+@param pu32Bytes_ points to where the dropped byte count is written
+
+Promises:
+- *pu32Messages_ and *pu32Bytes_ hold the totals
+
+*/
+void DebugOutputDropCounts(u32* pu32Messages_, u32* pu32Bytes_)
+{
+  *pu32Messages_ = Debug_u32DroppedMessages;
+  *pu32Bytes_ = Debug_u32DroppedBytes;
+  
+} /* end DebugOutputDropCounts() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn bool DebugRegisterCommand(u8* pu8Name_, u8* pu8Help_, fnDebugCommand_type pfnCommand_)
+
+@brief Adds a named command to the debug terminal.
+
+The name is one word or two words separated by a single space (e.g. "lcd snap").
+Only the pointers are saved, so the strings must stay valid (string literals are fine).
+
+Example:
+DebugRegisterCommand("ant stats", "[channel]  ANT link counters", DebugNamedAntStats);
+
+Requires:
+@param pu8Name_ is the NULL-terminated name, shorter than DEBUG_NAMED_CMD_NAME_SIZE
+@param pu8Help_ is a NULL-terminated description of the arguments and command
+@param pfnCommand_ is called with the arguments typed after the name
+
+Promises:
+- If the name is valid and new and there is space, the command is inserted in 
+  Debug_asNamedCommands in name order and TRUE is returned
+- Otherwise nothing changes and FALSE is returned
+
+*/
+bool DebugRegisterCommand(u8* pu8Name_, u8* pu8Help_, fnDebugCommand_type pfnCommand_)
+{
+  u8 u8Spaces = 0;
+  u8 u8Length = 0;
+  u8 u8Index;
+  
+  if( (pu8Name_ == NULL) || (pfnCommand_ == NULL) || (Debug_u8NamedCommands >= DEBUG_NAMED_COMMANDS) )
+  {
+    return(FALSE);
+  }
+  
+  /* One or two words, no leading, trailing or double spaces */
+  while(pu8Name_[u8Length] != '\0')
+  {
+    if(pu8Name_[u8Length] == ' ')
+    {
+      if( (u8Length == 0) || (pu8Name_[u8Length + 1] == ' ') || (pu8Name_[u8Length + 1] == '\0') )
+      {
+        return(FALSE);
+      }
+      u8Spaces++;
+    }
+    
+    u8Length++;
+    if(u8Length >= DEBUG_NAMED_CMD_NAME_SIZE)
+    {
+      return(FALSE);
+    }
+  }
+  
+  if( (u8Length == 0) || (u8Spaces > 1) || (DebugFindCommand(pu8Name_) != NULL) )
+  {
+    return(FALSE);
+  }
+  
+  /* Shift larger names up one place to keep the table sorted */
+  u8Index = Debug_u8NamedCommands;
+  while( (u8Index > 0) && 
+         (strcmp((char*)Debug_asNamedCommands[u8Index - 1].pu8Name, (char*)pu8Name_) > 0) )
+  {
+    Debug_asNamedCommands[u8Index] = Debug_asNamedCommands[u8Index - 1];
+    u8Index--;
+  }
+  
+  Debug_asNamedCommands[u8Index].pu8Name = pu8Name_;
+  Debug_asNamedCommands[u8Index].pu8Help = (pu8Help_ != NULL) ? pu8Help_ : (u8*)"";
+  Debug_asNamedCommands[u8Index].pfnCommand = pfnCommand_;
+  Debug_u8NamedCommands++;
+  
+  return(TRUE);
+  
+} /* end DebugRegisterCommand() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn bool DebugParseNumber(u8* pu8Arg_, u32* pu32Value_)
+
+@brief Converts a named command argument to a number.
+
+Decimal ("125") and hexadecimal with a 0x prefix ("0x7D") are accepted.
+
+Requires:
+@param pu8Arg_ is a NULL-terminated argument
+@param pu32Value_ points to where the value is written
+
+Promises:
+- Returns TRUE and writes *pu32Value_ if the whole argument is a number that fits in a u32
+- Returns FALSE otherwise and *pu32Value_ is not changed
+
+*/
+bool DebugParseNumber(u8* pu8Arg_, u32* pu32Value_)
+{
+  u32 u32Value = 0;
+  u32 u32Base = 10;
+  u32 u32Digit;
+  u8 u8Char;
+  
+  if( (pu8Arg_[0] == '0') && ( (pu8Arg_[1] == 'x') || (pu8Arg_[1] == 'X') ) )
+  {
+    u32Base = 16;
+    pu8Arg_ += 2;
+  }
+  
+  if(*pu8Arg_ == '\0')
+  {
+    return(FALSE);
+  }
+  
+  while(*pu8Arg_ != '\0')
+  {
+    u8Char = *pu8Arg_++;
+    if( (u8Char >= '0') && (u8Char <= '9') )
+    {
+      u32Digit = u8Char - NUMBER_ASCII_TO_DEC;
+    }
+    else if( (u32Base == 16) && (u8Char >= 'A') && (u8Char <= 'F') )
+    {
+      u32Digit = u8Char - UPPERCASE_ASCII_TO_DEC;
+    }
+    else if( (u32Base == 16) && (u8Char >= 'a') && (u8Char <= 'f') )
+    {
+      u32Digit = u8Char - LOWERCASE_ASCII_TO_DEC;
+    }
+    else
+    {
+      return(FALSE);
+    }
+    
+    /* Reject values that do not fit */
+    if( u32Value > ((0xFFFFFFFF - u32Digit) / u32Base) )
+    {
+      return(FALSE);
+    }
+    u32Value = (u32Value * u32Base) + u32Digit;
+  }
+  
+  *pu32Value_ = u32Value;
+  return(TRUE);
+  
+} /* end DebugParseNumber() */
+
+
 /*!----------------------------------------------------------------------------------------------------------------------
 @fn void SystemStatusReport(void)
 
@@ -409,7 +734,7 @@ Promises:
 void SystemStatusReport(void)
 {
   u8 au8SystemPassed[] = "No failed tasks.\n\r";
-  u8 au8SystemReady[] = "\n\rInitialization complete. Type en+c00 for debug menu.  Failed tasks:\n\r";
+  u8 au8SystemReady[] = "\n\rInitialization complete. Type en+c00 or help for debug menu.  Failed tasks:\n\r";
   u32 u32TaskFlagMaskBit = (u32)0x01;
   bool bNoFailedTasks = TRUE;
 
@@ -485,6 +810,11 @@ void DebugInitialize(void)
 
   /* Initailze the command array as needed */
   Debug_pu8CmdBufferNextChar = &Debug_au8CommandBuffer[0]; 
+  
+  /* Named commands provided by the debug task */
+  DebugRegisterCommand("help", "List named commands", DebugNamedHelp);
+  DebugRegisterCommand("ant stats", "[channel]  Show ANT link statistics", DebugNamedAntStats);
+  DebugRegisterCommand("ant reset", "Reset ANT link statistics", DebugNamedAntReset);
 
   /* Request the UART resource to be used for the Debug application */
   sUartConfig.UartPeripheral     = DEBUG_UART;
@@ -530,6 +860,8 @@ Promises:
 */
 void DebugRunActiveState(void)
 {
+  DebugDropMarker();
+  DebugLogService();
   Debug_pfnStateMachine();
 
 } /* end DebugRunActiveState */
@@ -937,107 +1269,1158 @@ static void DebugCommandSysTimeToggle(void)
   
 } /* end DebugCommandSysTimeToggle() */
 
-/* EIE_DOTMATRIX only tests */
-#ifdef EIE_DOTMATRIX 
+
 /*!----------------------------------------------------------------------------------------------------------------------
-@fn DebugCommandCaptouchValuesToggle
+@fn static void DebugCommandAntLinkStats(void)
 
-@brief Toggles printing the current Captouch horizontal and vertical values.
+@brief Prints one line of link counters for each ANT channel that has seen traffic.
+
+RSSI is shown as last / average / min / max in dBm once the channel has received
+a message with RSSI.
 
 Requires:
 - NONE
 
 Promises:
-@param G_u32DebugFlags flag _DEBUG_CAPTOUCH_VALUES_ENABLE is toggled
+- A heading and up to ANT_NUM_CHANNELS lines are queued to the debug UART
 
 */
-static void DebugCommandCaptouchValuesToggle(void)
+static void DebugCommandAntLinkStats(void)
 {
-  u8 au8CaptouchDisplayMessage[] = "\n\rDisplay Captouch values ";
-  u8 au8CaptouchOnMessage[] = "No values displayed if Captouch is OFF\n\r";
+  u8 au8Heading[] = "\n\rANT link statistics:\n\r";
+  u8 au8NoTraffic[] = "No channel traffic\n\r";
+  u8 au8Line[DEBUG_ANT_LINE_SIZE];
+  AntLinkStatsType sStats;
+  bool bTraffic = FALSE;
   
-  /* Print message and toggle the flag */
-  DebugPrintf(au8CaptouchDisplayMessage);
-  if(G_u32DebugFlags & _DEBUG_CAPTOUCH_VALUES_ENABLE)
+  DebugPrintf(au8Heading);
+  for(u8 i = 0; i < ANT_NUM_CHANNELS; i++)
   {
-    G_u32DebugFlags &= ~_DEBUG_CAPTOUCH_VALUES_ENABLE;
-    DebugPrintf(G_au8UtilMessageOFF);
+    AntQueryLinkStats((AntChannelNumberType)i, &sStats);
+    if( (sStats.u32RxMessages == 0) && (sStats.u32TxMessages == 0) && 
+        (sStats.u32RxFails == 0) && (sStats.u32SearchTimeouts == 0) )
+    {
+      continue;
+    }
+    
+    bTraffic = TRUE;
+    DebugPrintf( DebugAntLinkStatsLine(au8Line, i, &sStats) );
   }
-  else
+  
+  if(!bTraffic)
   {
-    G_u32DebugFlags |= _DEBUG_CAPTOUCH_VALUES_ENABLE;
-    DebugPrintf(G_au8UtilMessageON);
-    DebugPrintf(au8CaptouchOnMessage);
+    DebugPrintf(au8NoTraffic);
   }
   
-} /* end DebugCommandCaptouchValuesToggle() */
-#endif /* EIE_DOTMATRIX only tests */
+} /* end DebugCommandAntLinkStats() */
 
 
-/***********************************************************************************************************************
-State Machine Function Declarations
-***********************************************************************************************************************/
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u8* DebugAntLinkStatsLine(u8* pu8Target_, u8 u8Channel_, AntLinkStatsType* psStats_)
 
-/***********************************************************************************************************************
-State Machine Function Declarations
+@brief Builds the text line for the link counters of one ANT channel.
 
-The debugger state machine monitors the receive buffer to grab characters as they come in
-from the interrupt-driven receiver and store them in the debug command buffer.  Nothing happens 
-until the user sends a CR indicating they think they've entered a valid command.  The command is
-checked and reacted to accordingly.
-***********************************************************************************************************************/
+Requires:
+@param pu8Target_ points to DEBUG_ANT_LINE_SIZE bytes
+@param u8Channel_ is the channel number to print
+@param psStats_ holds the counters of the channel
 
-/*!--------------------------------------------------------------------------------------------------------------------
-@fn void DebugSM_Idle(void)               
+Promises:
+- The line ending in <CR><LF> and a NULL is written to pu8Target_
+- Returns pu8Target_
 
-@brief Waits for a byte to appear in the Rx buffer.  
+*/
+static u8* DebugAntLinkStatsLine(u8* pu8Target_, u8 u8Channel_, AntLinkStatsType* psStats_)
+{
+  u8 *pu8Parser;
+  
+  pu8Parser = DebugAppendNumber(pu8Target_, "Ch", u8Channel_);
+  pu8Parser = DebugAppendNumber(pu8Parser, " rx:", psStats_->u32RxMessages);
+  pu8Parser = DebugAppendNumber(pu8Parser, " tx:", psStats_->u32TxMessages);
+  pu8Parser = DebugAppendNumber(pu8Parser, " rxfail:", psStats_->u32RxFails);
+  pu8Parser = DebugAppendNumber(pu8Parser, " tosearch:", psStats_->u32RxFailGoToSearch);
+  pu8Parser = DebugAppendNumber(pu8Parser, " timeout:", psStats_->u32SearchTimeouts);
+  pu8Parser = DebugAppendNumber(pu8Parser, " ack:", psStats_->u32TransfersAcked);
+  pu8Parser = DebugAppendNumber(pu8Parser, " ackfail:", psStats_->u32TransfersFailed);
+  pu8Parser = DebugAppendNumber(pu8Parser, " rxburstfail:", psStats_->u32TransfersRxFailed);
+  
+  if(psStats_->u32RssiSamples != 0)
+  {
+    strcpy((char*)pu8Parser, " rssi:");
+    pu8Parser += 6;
+    AntGetdBmAscii(psStats_->sRssi.s8Last, pu8Parser);
+    pu8Parser[3] = '/';
+    AntGetdBmAscii(psStats_->sRssi.s8Average, &pu8Parser[4]);
+    pu8Parser[7] = '/';
+    AntGetdBmAscii(psStats_->sRssi.s8Min, &pu8Parser[8]);
+    pu8Parser[11] = '/';
+    AntGetdBmAscii(psStats_->sRssi.s8Max, &pu8Parser[12]);
+    pu8Parser += 15;
+  }
+  
+  strcpy((char*)pu8Parser, "\n\r");
+  return(pu8Target_);
+  
+} /* end DebugAntLinkStatsLine() */
 
-The BufferParser is always moved through all new characters placing them into 
-the command buffer until it hits a CR or there are no new characters to read. 
-If there is no CR in this iteration, nothing else occurs.
 
-Backspace: Echo the backspace and a space character to clear the character on 
-screen; move Debug_pu8BufferCurrentChar back.
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugCommandAntLinkStatsReset(void)
 
-CR: Advance states to process the command.
+@brief Clears the link counters of every ANT channel.
 
-Any other character: Echo it to the UART Tx and place a copy in Debug_au8CommandBuffer.
+Requires:
+- NONE
+
+Promises:
+- AntResetLinkStats() is called for all channels
 
 */
-void DebugSM_Idle(void)               
+static void DebugCommandAntLinkStatsReset(void)
 {
-  bool bCommandFound = FALSE;
-  u8 u8CurrentByte;
-  u8 u8Counter;
-  static u8 au8BackspaceSequence[] = {ASCII_BACKSPACE, ' ', ASCII_BACKSPACE};
-  static u8 au8CommandOverflow[] = "\r\n*** Command too long ***\r\n\n";
+  u8 au8ResetMessage[] = "\n\rANT link statistics cleared\n\r";
   
-  /* Parse any new characters that have come in until no more chars or a command is found */
-  while( (Debug_pu8RxBufferParser != Debug_pu8RxBufferNextChar) && (bCommandFound == FALSE) )
+  for(u8 i = 0; i < ANT_NUM_CHANNELS; i++)
   {
-    /* Grab a copy of the current byte */
-    u8CurrentByte = *Debug_pu8RxBufferParser;
-        
-    /* Process the character */
-    switch (u8CurrentByte)
-    {
-      /* Backspace: update command buffer pointer and send sequence to delete the char on the terminal */
-      case(ASCII_BACKSPACE): 
-      {
-        /* Process for scanf as long as we are not in Passthrough mode */
-        if( G_u32DebugFlags & _DEBUG_PASSTHROUGH )
-        {        
-          if(G_u8DebugScanfCharCount < DEBUG_SCANF_BUFFER_SIZE)
-          {
-            G_au8DebugScanfBuffer[G_u8DebugScanfCharCount] = u8CurrentByte;
-            G_u8DebugScanfCharCount++;
-          }
-        }
-        else
-        {
-          /* Process for scanf */
-          if(G_u8DebugScanfCharCount != 0)
-          {
+    AntResetLinkStats((AntChannelNumberType)i);
+  }
+  DebugPrintf(au8ResetMessage);
+  
+} /* end DebugCommandAntLinkStatsReset() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugCommandLogBinaryToggle(void)
+
+@brief Switches DebugLog() output between text and binary frames.
+
+Requires:
+- NONE
+
+Promises:
+- G_u32DebugFlags _DEBUG_LOG_BINARY is toggled
+- The number of log entries dropped so far is printed
+
+*/
+static void DebugCommandLogBinaryToggle(void)
+{
+  DebugPrintfFmt("\n\rLog entries dropped: %u\n\rBinary log output ", Debug_u32LogDropped);
+  if(G_u32DebugFlags & _DEBUG_LOG_BINARY)
+  {
+    G_u32DebugFlags &= ~_DEBUG_LOG_BINARY;
+    DebugPrintf(G_au8UtilMessageOFF);
+  }
+  else
+  {
+    G_u32DebugFlags |= _DEBUG_LOG_BINARY;
+    DebugPrintf(G_au8UtilMessageON);
+  }
+  
+} /* end DebugCommandLogBinaryToggle() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugCommandTaskProfile(void)
+
+@brief Prints the cycles of each super loop task that has run, then clears them.
+
+The histogram columns count calls of < 256, < 1k, < 4k, < 16k, < 64k, < 256k, 
+< 1M and more cycles (48 cycles per us).
+
+Requires:
+- NONE
+
+Promises:
+- A heading, one line per task that has run and the last overrun are queued to 
+  the debug UART
+- MainProfilerReset() is called
+
+*/
+static void DebugCommandTaskProfile(void)
+{
+#ifdef MAIN_PROFILER_ENABLE
+  MainTaskProfileType sProfile;
+  MainTaskType eOverrunTask;
+  u32 u32OverrunTick;
+  
+  DebugPrintf("\n\r      TASK    CALLS    LAST     MIN     AVG     MAX  OVER  HISTOGRAM\n\r");
+  for(u8 i = 0; i < MAIN_TASKS; i++)
+  {
+    MainProfilerQuery((MainTaskType)i, &sProfile);
+    if(sProfile.u32Calls != 0)
+    {
+      DebugPrintfFmt("%10s %8u %7u %7u %7u %7u %5u  %u/%u/%u/%u/%u/%u/%u/%u\n\r",
+                     MainProfilerTaskName((MainTaskType)i), sProfile.u32Calls, 
+                     sProfile.u32CyclesLast, sProfile.u32CyclesMin, sProfile.u32CyclesAverage, 
+                     sProfile.u32CyclesMax, sProfile.u32Overruns,
+                     sProfile.au16Histogram[0], sProfile.au16Histogram[1], sProfile.au16Histogram[2],
+                     sProfile.au16Histogram[3], sProfile.au16Histogram[4], sProfile.au16Histogram[5],
+                     sProfile.au16Histogram[6], sProfile.au16Histogram[7]);
+    }
+  }
+  
+  if( MainProfilerLastOverrun(&eOverrunTask, &u32OverrunTick) )
+  {
+    DebugPrintfFmt("Last overrun: %s at %u ms\n\r", MainProfilerTaskName(eOverrunTask), u32OverrunTick);
+  }
+  
+  MainProfilerReset();
+#else
+  DebugPrintf("\n\rTask profiler is disabled (MAIN_PROFILER_ENABLE in main.h)\n\r");
+#endif /* MAIN_PROFILER_ENABLE */
+  
+} /* end DebugCommandTaskProfile() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugCommandTimingTrace(void)
+
+@brief Prints the recorded 1ms timing violations, oldest first.
+
+Each line shows the tick of the violation, the ticks missed, the slowest task 
+of the late loop with its cycles and the percent of that loop spent in interrupts.
+
+Requires:
+- NONE
+
+Promises:
+- A heading and one line per record from MainReadTimingViolations() are queued
+  to the debug UART
+
+*/
+static void DebugCommandTimingTrace(void)
+{
+  MainTimingViolationType asViolations[MAIN_VIOLATION_RECORDS];
+  u8 u8Records;
+  const u8* pu8TaskName;
+  
+  u8Records = MainReadTimingViolations(asViolations, MAIN_VIOLATION_RECORDS);
+  if(u8Records == 0)
+  {
+    DebugPrintf("\n\rNo timing violations recorded\n\r");
+    return;
+  }
+  
+  DebugPrintf("\n\r      TICK  MISSED  SLOWEST TASK   CYCLES  ISR%\n\r");
+  for(u8 i = 0; i < u8Records; i++)
+  {
+    pu8TaskName = "-";
+    if(asViolations[i].eSlowestTask < MAIN_TASKS)
+    {
+      pu8TaskName = MainProfilerTaskName(asViolations[i].eSlowestTask);
+    }
+    
+    DebugPrintfFmt("%10u %7u  %12s %8u %5u\n\r", asViolations[i].u32Tick, 
+                   asViolations[i].u16TicksMissed, pu8TaskName, 
+                   asViolations[i].u32SlowestCycles, asViolations[i].u8IsrLoadPercent);
+  }
+  
+} /* end DebugCommandTimingTrace() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugCommandOutputPolicy(void)
+
+@brief Selects the next debug output policy and prints the dropped output counts.
+
+Requires:
+- NONE
+
+Promises:
+- Debug_eOutputPolicy advances to the next DebugOutputPolicyType
+- The new policy and the dropped message and byte totals are queued to the debug UART
+
+*/
+static void DebugCommandOutputPolicy(void)
+{
+  Debug_eOutputPolicy = (DebugOutputPolicyType)( (Debug_eOutputPolicy + 1) % DEBUG_OUTPUT_POLICIES );
+  
+  DebugPrintfFmt("\n\rDebug output policy: %s\n\rDropped: %u messages, %u bytes\n\r",
+                 Debug_apu8OutputPolicyNames[Debug_eOutputPolicy], 
+                 Debug_u32DroppedMessages, Debug_u32DroppedBytes);
+  
+} /* end DebugCommandOutputPolicy() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u32 DebugWrite(u8* pu8Data_, u32 u32Size_)
+
+@brief Queues debug output to the debug UART according to Debug_eOutputPolicy.
+
+All debug text goes through here so that it never uses the last 
+DEBUG_TX_RESERVED_SLOTS message slots.  A pending "[N msgs dropped]" marker
+is sent ahead of the data.
+
+Requires:
+- The debug UART has been requested
+
+@param pu8Data_ points to the bytes to send
+@param u32Size_ is the number of bytes to send
+
+Promises:
+- If there is room, or the policy makes room, the data is queued and its token 
+  is returned
+- Otherwise the drop is counted and 0 is returned
+
+*/
+static u32 DebugWrite(u8* pu8Data_, u32 u32Size_)
+{
+  u32 u32Token = 0;
+  u32 u32Dropped;
+  
+  if( (u32Size_ == 0) || (Debug_Uart == NULL) )
+  {
+    return(0);
+  }
+  
+  if( !DebugOutputRoom(DebugSlotsNeeded(u32Size_)) )
+  {
+    switch(Debug_eOutputPolicy)
+    {
+      case DEBUG_OUTPUT_BLOCK_INIT:
+      {
+        if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+        {
+          DebugOutputWait(u32Size_);
+        }
+        break;
+      }
+      
+      case DEBUG_OUTPUT_DROP_OLDEST:
+      {
+        while( !DebugOutputRoom(DebugSlotsNeeded(u32Size_)) )
+        {
+          u32Dropped = UartDropQueuedMessage(Debug_Uart);
+          if(u32Dropped == 0)
+          {
+            break;
+          }
+          DebugCountDrop(u32Dropped);
+        }
+        break;
+      }
+      
+      default:
+      {
+        break;
+      }
+    } /* end switch(Debug_eOutputPolicy) */
+  }
+  
+  if( DebugOutputRoom(DebugSlotsNeeded(u32Size_)) )
+  {
+    DebugDropMarker();
+    u32Token = UartWriteData(Debug_Uart, u32Size_, pu8Data_);
+  }
+  
+  if(u32Token == 0)
+  {
+    DebugCountDrop(u32Size_);
+  }
+  
+  return(u32Token);
+  
+} /* end DebugWrite() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u8 DebugSlotsNeeded(u32 u32Size_)
+
+@brief Returns the message slots needed to send u32Size_ bytes of debug output.
+
+Requires:
+@param u32Size_ is the number of bytes to send
+
+Promises:
+- Returns the slots for the data plus one if a drop marker must be sent first
+
+*/
+static u8 DebugSlotsNeeded(u32 u32Size_)
+{
+  u32 u32Slots = (u32Size_ + U16_MAX_TX_MESSAGE_LENGTH - 1) / U16_MAX_TX_MESSAGE_LENGTH;
+  
+  if(Debug_u32DropsUnreported != 0)
+  {
+    u32Slots++;
+  }
+  
+  return( (u8)( (u32Slots > U8_TX_QUEUE_SIZE) ? U8_TX_QUEUE_SIZE : u32Slots ) );
+  
+} /* end DebugSlotsNeeded() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static bool DebugOutputRoom(u8 u8Slots_)
+
+@brief Checks if debug output can use u8Slots_ message slots.
+
+Requires:
+@param u8Slots_ is the number of slots wanted
+
+Promises:
+- Returns TRUE if DEBUG_TX_RESERVED_SLOTS would still be free after taking u8Slots_
+
+*/
+static bool DebugOutputRoom(u8 u8Slots_)
+{
+  return( MessagingFreeSlots() >= (u8Slots_ + DEBUG_TX_RESERVED_SLOTS) );
+  
+} /* end DebugOutputRoom() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugOutputWait(u32 u32Size_)
+
+@brief Runs the UART and messaging tasks until u32Size_ bytes of debug output fit.
+
+This is the same manual cycling the UART driver does during initialization, so
+it must not be used once the super loop is running.
+
+Requires:
+- G_u32SystemFlags _SYSTEM_INITIALIZING is set
+
+@param u32Size_ is the number of bytes waiting to be sent
+
+Promises:
+- Returns when there is room or after DEBUG_UART_TIMEOUT ms
+
+*/
+static void DebugOutputWait(u32 u32Size_)
+{
+  u32 u32StartTime = G_u32SystemTime1ms;
+  u32 u32Timer;
+  
+  while( !DebugOutputRoom(DebugSlotsNeeded(u32Size_)) && 
+         !IsTimeUp(&u32StartTime, DEBUG_UART_TIMEOUT) )
+  {
+    WATCHDOG_BONE();
+    UartRunActiveState();
+    MessagingRunActiveState();
+
+    u32Timer = G_u32SystemTime1ms;
+    while( !IsTimeUp(&u32Timer, 1) );
+  }
+  
+} /* end DebugOutputWait() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugCountDrop(u32 u32Size_)
+
+@brief Counts one dropped debug message.
+
+Requires:
+@param u32Size_ is the size of the dropped message in bytes
+
+Promises:
+- Debug_u32DroppedMessages and Debug_u32DropsUnreported are incremented
+- Debug_u32DroppedBytes is increased by u32Size_
+
+*/
+static void DebugCountDrop(u32 u32Size_)
+{
+  Debug_u32DroppedMessages++;
+  Debug_u32DroppedBytes += u32Size_;
+  Debug_u32DropsUnreported++;
+  
+} /* end DebugCountDrop() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugDropMarker(void)
+
+@brief Sends "[N msgs dropped]" for the messages dropped since the last marker.
+
+Requires:
+- NONE
+
+Promises:
+- If messages were dropped and there is room for one slot, the marker is queued 
+  and Debug_u32DropsUnreported is cleared
+
+*/
+static void DebugDropMarker(void)
+{
+  u8 au8Marker[DEBUG_DROP_MARKER_SIZE];
+  u16 u16Length;
+  
+  if( (Debug_u32DropsUnreported == 0) || (Debug_Uart == NULL) || !DebugOutputRoom(1) )
+  {
+    return;
+  }
+  
+  u16Length = DebugFormatArgs(au8Marker, sizeof(au8Marker), (u8*)"[%u msgs dropped]\n\r", 
+                              Debug_u32DropsUnreported);
+  if( UartWriteData(Debug_Uart, u16Length, au8Marker) != 0 )
+  {
+    Debug_u32DropsUnreported = 0;
+  }
+  
+} /* end DebugDropMarker() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugNamedHelp(u8 u8Argc_, u8** ppu8Argv_)
+
+@brief Named command "help": lists the named commands with their help text.
+
+Requires:
+@param u8Argc_ is not used
+@param ppu8Argv_ is not used
+
+Promises:
+- One line per registered command is queued to the debug UART
+
+*/
+static void DebugNamedHelp(u8 u8Argc_, u8** ppu8Argv_)
+{
+  DebugPrintf("\n\rNamed commands (numbered commands: en+c00):\n\r");
+  for(u8 i = 0; i < Debug_u8NamedCommands; i++)
+  {
+    DebugPrintfFmt("  %s  %s\n\r", Debug_asNamedCommands[i].pu8Name, Debug_asNamedCommands[i].pu8Help);
+  }
+  
+} /* end DebugNamedHelp() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugNamedAntStats(u8 u8Argc_, u8** ppu8Argv_)
+
+@brief Named command "ant stats [channel]": prints ANT link counters.
+
+Requires:
+@param u8Argc_ is 0 for all channels with traffic or 1 for a single channel
+@param ppu8Argv_ holds the channel number if u8Argc_ is 1
+
+Promises:
+- The counters of the channel, or of every channel with traffic, are queued to 
+  the debug UART
+- A bad channel number is reported
+
+*/
+static void DebugNamedAntStats(u8 u8Argc_, u8** ppu8Argv_)
+{
+  u8 au8Line[DEBUG_ANT_LINE_SIZE];
+  AntLinkStatsType sStats;
+  u32 u32Channel;
+  
+  if(u8Argc_ == 0)
+  {
+    DebugCommandAntLinkStats();
+    return;
+  }
+  
+  if( !DebugParseNumber(ppu8Argv_[0], &u32Channel) || (u32Channel >= ANT_NUM_CHANNELS) )
+  {
+    DebugPrintfFmt("\n\rChannel must be 0 to %u\n\r", ANT_NUM_CHANNELS - 1);
+    return;
+  }
+  
+  AntQueryLinkStats((AntChannelNumberType)u32Channel, &sStats);
+  DebugLineFeed();
+  DebugPrintf( DebugAntLinkStatsLine(au8Line, (u8)u32Channel, &sStats) );
+  
+} /* end DebugNamedAntStats() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugNamedAntReset(u8 u8Argc_, u8** ppu8Argv_)
+
+@brief Named command "ant reset": same as "Reset ANT link statistics".
+
+Requires:
+@param u8Argc_ is not used
+@param ppu8Argv_ is not used
+
+Promises:
+- DebugCommandAntLinkStatsReset() is called
+
+*/
+static void DebugNamedAntReset(u8 u8Argc_, u8** ppu8Argv_)
+{
+  DebugCommandAntLinkStatsReset();
+  
+} /* end DebugNamedAntReset() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u8 DebugTokenize(u8* pu8Line_, u8** ppu8Tokens_, u8 u8MaxTokens_)
+
+@brief Splits a command line into words in place.
+
+Requires:
+@param pu8Line_ is the command line ending in ASCII_CARRIAGE_RETURN or NULL
+@param ppu8Tokens_ has space for u8MaxTokens_ pointers
+@param u8MaxTokens_ is the most words to accept
+
+Promises:
+- Spaces and the line end in pu8Line_ are replaced with NULLs
+- ppu8Tokens_ points to the start of each word
+- Returns the number of words; u8MaxTokens_ + 1 if there were too many
+
+*/
+static u8 DebugTokenize(u8* pu8Line_, u8** ppu8Tokens_, u8 u8MaxTokens_)
+{
+  u8 u8Tokens = 0;
+  bool bInWord = FALSE;
+  
+  while( (*pu8Line_ != ASCII_CARRIAGE_RETURN) && (*pu8Line_ != '\0') )
+  {
+    if(*pu8Line_ == ' ')
+    {
+      *pu8Line_ = '\0';
+      bInWord = FALSE;
+    }
+    else if(!bInWord)
+    {
+      if(u8Tokens == u8MaxTokens_)
+      {
+        return(u8MaxTokens_ + 1);
+      }
+      
+      ppu8Tokens_[u8Tokens++] = pu8Line_;
+      bInWord = TRUE;
+    }
+    
+    pu8Line_++;
+  }
+  
+  *pu8Line_ = '\0';
+  return(u8Tokens);
+  
+} /* end DebugTokenize() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static DebugNamedCommandType* DebugFindCommand(u8* pu8Name_)
+
+@brief Binary search of Debug_asNamedCommands for a name.
+
+Requires:
+- Debug_asNamedCommands is sorted by name
+
+@param pu8Name_ is the NULL-terminated name to find
+
+Promises:
+- Returns a pointer to the command, or NULL if the name is not registered
+
+*/
+static DebugNamedCommandType* DebugFindCommand(u8* pu8Name_)
+{
+  s16 s16Low = 0;
+  s16 s16High = (s16)Debug_u8NamedCommands - 1;
+  s16 s16Middle;
+  int iCompare;
+  
+  while(s16Low <= s16High)
+  {
+    s16Middle = (s16Low + s16High) / 2;
+    iCompare = strcmp((char*)pu8Name_, (char*)Debug_asNamedCommands[s16Middle].pu8Name);
+    
+    if(iCompare == 0)
+    {
+      return(&Debug_asNamedCommands[s16Middle]);
+    }
+    
+    if(iCompare < 0)
+    {
+      s16High = s16Middle - 1;
+    }
+    else
+    {
+      s16Low = s16Middle + 1;
+    }
+  }
+  
+  return(NULL);
+  
+} /* end DebugFindCommand() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static bool DebugCheckNamedCommand(void)
+
+@brief Looks up the command buffer as a named command.
+
+A two word name is tried first so "ant stats 3" finds "ant stats" before "ant".
+
+Requires:
+- Debug_au8CommandBuffer holds a line ending in ASCII_CARRIAGE_RETURN
+
+Promises:
+- On a match, Debug_psNamedCommand, Debug_apu8Tokens, Debug_u8Tokens and 
+  Debug_u8ArgIndex are set for DebugSM_ProcessCmd() and TRUE is returned
+- Otherwise FALSE is returned
+
+*/
+static bool DebugCheckNamedCommand(void)
+{
+  u8 au8Name[DEBUG_NAMED_CMD_NAME_SIZE];
+  
+  Debug_u8Tokens = DebugTokenize(Debug_au8CommandBuffer, Debug_apu8Tokens, DEBUG_CMD_MAX_TOKENS);
+  if( (Debug_u8Tokens == 0) || (Debug_u8Tokens > DEBUG_CMD_MAX_TOKENS) )
+  {
+    return(FALSE);
+  }
+  
+  if( (Debug_u8Tokens >= 2) && 
+      ( (strlen((char*)Debug_apu8Tokens[0]) + strlen((char*)Debug_apu8Tokens[1]) + 2) <= sizeof(au8Name) ) )
+  {
+    strcpy((char*)au8Name, (char*)Debug_apu8Tokens[0]);
+    strcat((char*)au8Name, " ");
+    strcat((char*)au8Name, (char*)Debug_apu8Tokens[1]);
+    
+    Debug_psNamedCommand = DebugFindCommand(au8Name);
+    if(Debug_psNamedCommand != NULL)
+    {
+      Debug_u8ArgIndex = 2;
+      return(TRUE);
+    }
+  }
+  
+  Debug_psNamedCommand = DebugFindCommand(Debug_apu8Tokens[0]);
+  Debug_u8ArgIndex = 1;
+  
+  return(Debug_psNamedCommand != NULL);
+  
+} /* end DebugCheckNamedCommand() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u8* DebugAppendNumber(u8* pu8Target_, u8* pu8Label_, u32 u32Number_)
+
+@brief Writes a label followed by a decimal number into a line being built.
+
+Requires:
+@param pu8Target_ points to the end of the line with room for the label and 10 digits
+@param pu8Label_ is a null-terminated label
+@param u32Number_ is the number to write
+
+Promises:
+- The label and number are written with a terminating NULL
+- Returns a pointer to the NULL so more text can be appended
+
+*/
+static u8* DebugAppendNumber(u8* pu8Target_, u8* pu8Label_, u32 u32Number_)
+{
+  while(*pu8Label_ != '\0')
+  {
+    *pu8Target_++ = *pu8Label_++;
+  }
+  
+  return( pu8Target_ + NumberToAscii(u32Number_, pu8Target_) );
+  
+} /* end DebugAppendNumber() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u16 DebugFormat(u8* pu8Target_, u16 u16Size_, u8* pu8Format_, va_list vaArgs_)
+
+@brief Builds the text for DebugPrintfFmt().
+
+See DebugPrintfFmt() for the supported conversions.  An unknown conversion 
+character is copied as-is.
+
+Requires:
+@param pu8Target_ points to the output buffer
+@param u16Size_ is the size of pu8Target_
+@param pu8Format_ is a NULL-terminated format string
+@param vaArgs_ holds the arguments for the conversions
+
+Promises:
+- pu8Target_ holds the formatted text (not NULL-terminated), cut off at u16Size_ characters
+- Returns the number of characters written
+
+*/
+static u16 DebugFormat(u8* pu8Target_, u16 u16Size_, u8* pu8Format_, va_list vaArgs_)
+{
+  u8 au8Digits[UTIL_FORMAT_U32_SIZE];
+  u8* pu8Field;
+  u16 u16FieldLength;
+  u16 u16Count = 0;
+  u8 u8Width;
+  u8 u8Pad;
+  u8 u8Base;
+  bool bUpperCase;
+  u32 u32Value;
+  s32 s32Value;
+  bool bNegative;
+  
+  while( (*pu8Format_ != '\0') && (u16Count < u16Size_) )
+  {
+    /* Plain characters are copied */
+    if(*pu8Format_ != '%')
+    {
+      pu8Target_[u16Count++] = *pu8Format_++;
+      continue;
+    }
+    
+    /* Read the flag and width */
+    pu8Format_++;
+    u8Pad = ' ';
+    u8Width = 0;
+    if(*pu8Format_ == '0')
+    {
+      u8Pad = '0';
+      pu8Format_++;
+    }
+    
+    while( (*pu8Format_ >= '0') && (*pu8Format_ <= '9') )
+    {
+      u8Width = (u8Width * 10) + (*pu8Format_ - '0');
+      pu8Format_++;
+    }
+    
+    /* Point pu8Field at the text for the conversion */
+    bNegative = FALSE;
+    u8Base = 0;
+    bUpperCase = FALSE;
+    pu8Field = &au8Digits[0];
+    u16FieldLength = 1;
+    
+    switch(*pu8Format_)
+    {
+      case 'd':
+      {
+        s32Value = va_arg(vaArgs_, s32);
+        u32Value = (u32)s32Value;
+        if(s32Value < 0)
+        {
+          bNegative = TRUE;
+          u32Value = 0 - u32Value;
+        }
+        u8Base = 10;
+        break;
+      }
+      
+      case 'u':
+      {
+        u32Value = va_arg(vaArgs_, u32);
+        u8Base = 10;
+        break;
+      }
+      
+      case 'X':
+      {
+        bUpperCase = TRUE;
+        /* fall through */
+      }
+      
+      case 'x':
+      {
+        u32Value = va_arg(vaArgs_, u32);
+        u8Base = 16;
+        break;
+      }
+      
+      case 's':
+      {
+        pu8Field = va_arg(vaArgs_, u8*);
+        u16FieldLength = strlen((char*)pu8Field);
+        break;
+      }
+      
+      case 'c':
+      {
+        au8Digits[0] = (u8)va_arg(vaArgs_, int);
+        break;
+      }
+      
+      case '\0':
+      {
+        /* A '%' at the end of the format is dropped */
+        u16FieldLength = 0;
+        pu8Format_--;
+        break;
+      }
+      
+      default:
+      {
+        /* "%%" and unknown conversions print the character */
+        au8Digits[0] = *pu8Format_;
+        break;
+      }
+    } /* end switch(*pu8Format_) */
+    
+    pu8Format_++;
+    
+    /* Numbers use the shared conversions in utilities.c */
+    if(u8Base == 10)
+    {
+      u16FieldLength = FormatUnsigned(u32Value, au8Digits);
+    }
+    else if(u8Base == 16)
+    {
+      u16FieldLength = FormatHex(u32Value, au8Digits, 1, bUpperCase);
+    }
+    
+    /* The sign goes before zero padding but after space padding */
+    if(bNegative)
+    {
+      if(u8Width != 0)
+      {
+        u8Width--;
+      }
+      
+      if( (u8Pad == '0') && (u16Count < u16Size_) )
+      {
+        pu8Target_[u16Count++] = '-';
+        bNegative = FALSE;
+      }
+    }
+    
+    while( (u8Width > u16FieldLength) && (u16Count < u16Size_) )
+    {
+      pu8Target_[u16Count++] = u8Pad;
+      u8Width--;
+    }
+    
+    if( bNegative && (u16Count < u16Size_) )
+    {
+      pu8Target_[u16Count++] = '-';
+    }
+    
+    while( (u16FieldLength != 0) && (u16Count < u16Size_) )
+    {
+      pu8Target_[u16Count++] = *pu8Field++;
+      u16FieldLength--;
+    }
+  }
+  
+  return(u16Count);
+  
+} /* end DebugFormat() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u16 DebugFormatArgs(u8* pu8Target_, u16 u16Size_, u8* pu8Format_, ...)
+
+@brief DebugFormat() with the arguments listed in the call.
+
+Requires:
+- See DebugFormat()
+
+Promises:
+- See DebugFormat()
+
+*/
+static u16 DebugFormatArgs(u8* pu8Target_, u16 u16Size_, u8* pu8Format_, ...)
+{
+  u16 u16Length;
+  va_list vaArgs;
+  
+  va_start(vaArgs, pu8Format_);
+  u16Length = DebugFormat(pu8Target_, u16Size_, pu8Format_, vaArgs);
+  va_end(vaArgs);
+  
+  return(u16Length);
+  
+} /* end DebugFormatArgs() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void DebugLogService(void)
+
+@brief Sends the oldest DebugLog() entry, if any.
+
+Only one entry is sent per pass to spread the work and the message slots.  If
+the UART cannot take the entry, it stays in the ring for the next pass.
+
+Requires:
+- Called once per DebugRunActiveState()
+
+Promises:
+- If an entry is waiting, it is queued as text or, if _DEBUG_LOG_BINARY is set, 
+  as a binary frame and removed from Debug_asLogRing
+
+*/
+static void DebugLogService(void)
+{
+  u8 au8Line[U16_MAX_TX_MESSAGE_LENGTH];
+  DebugLogRecordType* psRecord;
+  u16 u16Length;
+  
+  if( (Debug_u8LogCount == 0) || (Debug_Uart == NULL) )
+  {
+    return;
+  }
+  
+  /* Only this task removes entries, so the head entry can be read without locking */
+  psRecord = &Debug_asLogRing[Debug_u8LogHead];
+  if(G_u32DebugFlags & _DEBUG_LOG_BINARY)
+  {
+    u16Length = DebugLogEncodeBinary(psRecord, au8Line);
+  }
+  else
+  {
+    u16Length = DebugFormatArgs(au8Line, sizeof(au8Line), (u8*)"[%u] ", psRecord->u32TimeStamp);
+    u16Length += DebugFormatArgs(&au8Line[u16Length], sizeof(au8Line) - u16Length, 
+                                 Debug_apu8LogFormats[psRecord->eId], psRecord->u32Arg0, psRecord->u32Arg1);
+  }
+  
+  /* Log entries wait in the ring instead of being dropped */
+  if( !DebugOutputRoom(DebugSlotsNeeded(u16Length)) )
+  {
+    return;
+  }
+  
+  DebugDropMarker();
+  if( UartWriteData(Debug_Uart, u16Length, au8Line) == 0 )
+  {
+    return;
+  }
+  
+  Debug_u8LogHead = (Debug_u8LogHead + 1) & (DEBUG_LOG_RECORDS - 1);
+  __disable_irq();
+  Debug_u8LogCount--;
+  __enable_irq();
+  
+} /* end DebugLogService() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static u8 DebugLogEncodeBinary(DebugLogRecordType* psRecord_, u8* pu8Target_)
+
+@brief Writes a log entry as a binary frame (see the file header for the format).
+
+Requires:
+@param psRecord_ is the entry to send
+@param pu8Target_ has room for DEBUG_LOG_FRAME_MAX bytes
+
+Promises:
+- pu8Target_ holds the frame
+- Returns the frame length
+
+*/
+static u8 DebugLogEncodeBinary(DebugLogRecordType* psRecord_, u8* pu8Target_)
+{
+  u32 au32Args[2];
+  u32 u32Value;
+  u8 u8Length = 0;
+  
+  pu8Target_[u8Length++] = DEBUG_LOG_SYNC;
+  pu8Target_[u8Length++] = (u8)psRecord_->eId;
+  pu8Target_[u8Length++] = (u8)(psRecord_->u32TimeStamp & 0xFF);
+  pu8Target_[u8Length++] = (u8)((psRecord_->u32TimeStamp >> 8) & 0xFF);
+  
+  au32Args[0] = psRecord_->u32Arg0;
+  au32Args[1] = psRecord_->u32Arg1;
+  for(u8 i = 0; i < 2; i++)
+  {
+    u32Value = au32Args[i];
+    while(u32Value > 0x7F)
+    {
+      pu8Target_[u8Length++] = (u8)(u32Value & 0x7F) | 0x80;
+      u32Value >>= 7;
+    }
+    pu8Target_[u8Length++] = (u8)u32Value;
+  }
+  
+  return(u8Length);
+  
+} /* end DebugLogEncodeBinary() */
+
+/* EIE_DOTMATRIX only tests */
+#ifdef EIE_DOTMATRIX 
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn DebugCommandCaptouchValuesToggle
+
+@brief Toggles printing the current Captouch horizontal and vertical values.
+
+Requires:
+- NONE
+
+Promises:
+@param G_u32DebugFlags flag _DEBUG_CAPTOUCH_VALUES_ENABLE is toggled
+
+*/
+static void DebugCommandCaptouchValuesToggle(void)
+{
+  u8 au8CaptouchDisplayMessage[] = "\n\rDisplay Captouch values ";
+  u8 au8CaptouchOnMessage[] = "No values displayed if Captouch is OFF\n\r";
+  
+  /* Print message and toggle the flag */
+  DebugPrintf(au8CaptouchDisplayMessage);
+  if(G_u32DebugFlags & _DEBUG_CAPTOUCH_VALUES_ENABLE)
+  {
+    G_u32DebugFlags &= ~_DEBUG_CAPTOUCH_VALUES_ENABLE;
+    DebugPrintf(G_au8UtilMessageOFF);
+  }
+  else
+  {
+    G_u32DebugFlags |= _DEBUG_CAPTOUCH_VALUES_ENABLE;
+    DebugPrintf(G_au8UtilMessageON);
+    DebugPrintf(au8CaptouchOnMessage);
+  }
+  
+} /* end DebugCommandCaptouchValuesToggle() */
+#endif /* EIE_DOTMATRIX only tests */
+
+
+/***********************************************************************************************************************
+State Machine Function Declarations
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+State Machine Function Declarations
+
+The debugger state machine monitors the receive buffer to grab characters as they come in
+from the interrupt-driven receiver and store them in the debug command buffer.  Nothing happens 
+until the user sends a CR indicating they think they've entered a valid command.  The command is
+checked and reacted to accordingly.
+***********************************************************************************************************************/
+
+/*!--------------------------------------------------------------------------------------------------------------------
+@fn void DebugSM_Idle(void)               
+
+@brief Waits for a byte to appear in the Rx buffer.  
+
+The BufferParser is always moved through all new characters placing them into 
+the command buffer until it hits a CR or there are no new characters to read. 
+If there is no CR in this iteration, nothing else occurs.
+
+Backspace: Echo the backspace and a space character to clear the character on 
+screen; move Debug_pu8BufferCurrentChar back.
+
+CR: Advance states to process the command.
+
+Any other character: Echo it to the UART Tx and place a copy in Debug_au8CommandBuffer.
+
+*/
+void DebugSM_Idle(void)               
+{
+  bool bCommandFound = FALSE;
+  u8 u8CurrentByte;
+  u8 u8Counter;
+  static u8 au8BackspaceSequence[] = {ASCII_BACKSPACE, ' ', ASCII_BACKSPACE};
+  static u8 au8CommandOverflow[] = "\r\n*** Command too long ***\r\n\n";
+  
+  /* Parse any new characters that have come in until no more chars or a command is found */
+  while( (Debug_pu8RxBufferParser != Debug_pu8RxBufferNextChar) && (bCommandFound == FALSE) )
+  {
+    /* Grab a copy of the current byte */
+    u8CurrentByte = *Debug_pu8RxBufferParser;
+        
+    /* Process the character */
+    switch (u8CurrentByte)
+    {
+      /* Backspace: update command buffer pointer and send sequence to delete the char on the terminal */
+      case(ASCII_BACKSPACE): 
+      {
+        /* Process for scanf as long as we are not in Passthrough mode */
+        if( G_u32DebugFlags & _DEBUG_PASSTHROUGH )
+        {        
+          if(G_u8DebugScanfCharCount < DEBUG_SCANF_BUFFER_SIZE)
+          {
+            G_au8DebugScanfBuffer[G_u8DebugScanfCharCount] = u8CurrentByte;
+            G_u8DebugScanfCharCount++;
+          }
+        }
+        else
+        {
+          /* Process for scanf */
+          if(G_u8DebugScanfCharCount != 0)
+          {
             G_u8DebugScanfCharCount--;
             G_au8DebugScanfBuffer[G_u8DebugScanfCharCount] = '\0';
           }
@@ -1078,7 +2461,7 @@ void DebugSM_Idle(void)
           G_u8DebugScanfCharCount++;
         }
         
-        /* Echo the character back to the terminal */
+        /* Echo the character back to the terminal (not subject to the output policy so typing is never garbled) */
         Debug_au32MsgTokens[Debug_u8TokenCounter] = UartWriteByte(Debug_Uart, u8CurrentByte);
         AdvanceTokenCounter();
         
@@ -1139,19 +2522,20 @@ void DebugSM_Idle(void)
 @brief Checks to see if a string entered is a valid command.
 
 At the start of this state, the command buffer has a candidate command terminated in CR.
-There is a strict rule that commands are of the form en+cxx where xx is any number
-from 0 to DEBUG_COMMANDS, so parsing can be done based on that rule.  All other 
-strings are invalid.  
+Numbered commands are of the form en+cxx where xx is any number from 0 to DEBUG_COMMANDS.
+Anything else is looked up as a named command (DebugRegisterCommand()).
 
 */
 void DebugSM_CheckCmd(void)        
 {
   static u8 au8CommandHeader[] = "en+c";
-  static u8 au8InvalidCommand[] = "\nInvalid command.  Use en+c##\n\n\r"; 
+  static u8 au8InvalidCommand[] = "\nInvalid command.  Use en+c## or help\n\n\r"; 
   bool bGoodCommand = TRUE;
   u8 u8Index;
   s8 s8Temp;
   
+  Debug_psNamedCommand = NULL;
+  
   /* Verify that the command starts with en+c */
   u8Index = 0;
   do
@@ -1164,8 +2548,14 @@ void DebugSM_CheckCmd(void)
     u8Index++;
   } while ( bGoodCommand && (u8Index < 4) );
   
+  /* Without the en+c header, try the named commands */
+  if(!bGoodCommand)
+  {
+    bGoodCommand = DebugCheckNamedCommand();
+  }
+  
   /* On good header, read the command number */
-  if(bGoodCommand)
+  else
   {
     /* Make an assumption */
     bGoodCommand = FALSE;
@@ -1221,8 +2611,15 @@ void DebugSM_ProcessCmd(void)
   /* Setup for return to Idle state */
   Debug_pfnStateMachine = DebugSM_Idle;
 
-  /* Call the command function in the function array (may change next state ) */
-  Debug_au8Commands[Debug_u8Command].DebugFunction();
+  /* Call the named command with its arguments or the command function in the function array (may change next state ) */
+  if(Debug_psNamedCommand != NULL)
+  {
+    Debug_psNamedCommand->pfnCommand(Debug_u8Tokens - Debug_u8ArgIndex, &Debug_apu8Tokens[Debug_u8ArgIndex]);
+  }
+  else
+  {
+    Debug_au8Commands[Debug_u8Command].DebugFunction();
+  }
   
 } /* end DebugSM_ProcessCmd() */
 
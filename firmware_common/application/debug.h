@@ -22,6 +22,55 @@ typedef struct
 } DebugCommandType;
 
 
+/*! @brief Function called for a named debug command with the arguments typed after its name */
+typedef void(*fnDebugCommand_type)(u8 u8Argc_, u8** ppu8Argv_);
+
+/*! 
+@struct DebugNamedCommandType
+@brief A command added with DebugRegisterCommand(). 
+*/
+typedef struct
+{
+  u8 *pu8Name;                      /*!< @brief One or two words typed to run the command, e.g. "ant stats" */
+  u8 *pu8Help;                      /*!< @brief Arguments and description shown by "help" */
+  fnDebugCommand_type pfnCommand;   /*!< @brief Function to call */
+} DebugNamedCommandType;
+
+
+/*! 
+@enum DebugLogIdType
+@brief Format identifiers for DebugLog().  Add the format string for a new id at 
+the same position in Debug_apu8LogFormats[] in debug.c.
+*/
+typedef enum {DEBUG_LOG_TIMING_VIOLATION = 0,   /*!< @brief Arg0: violation count, Arg1: ms since the previous loop */
+              DEBUG_LOG_IDS                     /*!< @brief Number of log ids (keep last) */
+             } DebugLogIdType;
+
+
+/*! 
+@struct DebugLogRecordType
+@brief One deferred log entry waiting to be sent. 
+*/
+typedef struct
+{
+  u32 u32TimeStamp;                 /*!< @brief G_u32SystemTime1ms when the entry was logged */
+  u32 u32Arg0;                      /*!< @brief First argument of the format */
+  u32 u32Arg1;                      /*!< @brief Second argument of the format */
+  DebugLogIdType eId;               /*!< @brief Format of the entry */
+} DebugLogRecordType;
+
+
+/*! 
+@enum DebugOutputPolicyType
+@brief What debug output does when the message pool is short of slots (see DebugSetOutputPolicy()). 
+*/
+typedef enum {DEBUG_OUTPUT_BLOCK_INIT = 0,      /*!< @brief Wait for space during initialization, otherwise drop the new message */
+              DEBUG_OUTPUT_DROP_NEWEST,         /*!< @brief Drop the new message */
+              DEBUG_OUTPUT_DROP_OLDEST,         /*!< @brief Drop waiting debug messages to make space for the new one */
+              DEBUG_OUTPUT_POLICIES             /*!< @brief Number of policies (keep last) */
+             } DebugOutputPolicyType;
+
+
 /***********************************************************************************************************************
 * Function Declarations
 ***********************************************************************************************************************/
@@ -30,6 +79,7 @@ typedef struct
 /*! @publicsection */                                                                                            
 /*--------------------------------------------------------------------------------------------------------------------*/
 u32 DebugPrintf(u8* u8String_);
+u32 DebugPrintfFmt(u8* pu8Format_, ...);
 void DebugLineFeed(void);
 void DebugPrintNumber(u32 u32Number_);
 
@@ -38,6 +88,14 @@ u8 DebugScanf(u8* pu8Buffer_);
 void DebugSetPassthrough(void);
 void DebugClearPassthrough(void);
 
+bool DebugLog(DebugLogIdType eId_, u32 u32Arg0_, u32 u32Arg1_);
+
+void DebugSetOutputPolicy(DebugOutputPolicyType ePolicy_);
+void DebugOutputDropCounts(u32* pu32Messages_, u32* pu32Bytes_);
+
+bool DebugRegisterCommand(u8* pu8Name_, u8* pu8Help_, fnDebugCommand_type pfnCommand_);
+bool DebugParseNumber(u8* pu8Arg_, u32* pu32Value_);
+
 void SystemStatusReport(void);
 
 
@@ -61,6 +119,30 @@ static void DebugCommandDummy(void);
 static void DebugCommandLedTestToggle(void);
 static void DebugLedTestCharacter(u8 u8Char_);
 static void DebugCommandSysTimeToggle(void);
+static void DebugCommandAntLinkStats(void);
+static void DebugCommandAntLinkStatsReset(void);
+static u8* DebugAppendNumber(u8* pu8Target_, u8* pu8Label_, u32 u32Number_);
+static u16 DebugFormat(u8* pu8Target_, u16 u16Size_, u8* pu8Format_, va_list vaArgs_);
+static u16 DebugFormatArgs(u8* pu8Target_, u16 u16Size_, u8* pu8Format_, ...);
+static void DebugCommandLogBinaryToggle(void);
+static void DebugCommandTaskProfile(void);
+static void DebugCommandTimingTrace(void);
+static void DebugCommandOutputPolicy(void);
+static u32 DebugWrite(u8* pu8Data_, u32 u32Size_);
+static u8 DebugSlotsNeeded(u32 u32Size_);
+static bool DebugOutputRoom(u8 u8Slots_);
+static void DebugOutputWait(u32 u32Size_);
+static void DebugCountDrop(u32 u32Size_);
+static void DebugDropMarker(void);
+static void DebugNamedHelp(u8 u8Argc_, u8** ppu8Argv_);
+static void DebugNamedAntStats(u8 u8Argc_, u8** ppu8Argv_);
+static void DebugNamedAntReset(u8 u8Argc_, u8** ppu8Argv_);
+static u8* DebugAntLinkStatsLine(u8* pu8Target_, u8 u8Channel_, AntLinkStatsType* psStats_);
+static u8 DebugTokenize(u8* pu8Line_, u8** ppu8Tokens_, u8 u8MaxTokens_);
+static DebugNamedCommandType* DebugFindCommand(u8* pu8Name_);
+static bool DebugCheckNamedCommand(void);
+static void DebugLogService(void);
+static u8 DebugLogEncodeBinary(DebugLogRecordType* psRecord_, u8* pu8Target_);
 
 #ifdef EIE_ASCII /* EIE_ASCII-specific debug functions */
 #endif /* EIE_ASCII */
@@ -93,6 +175,7 @@ static void DebugSM_Error(void);
 #define _DEBUG_LED_TEST_ENABLE         (u32)0x00000001      /*!< @brief G_u32DebugFlags set if LED test is enabled */
 #define _DEBUG_TIME_WARNING_ENABLE     (u32)0x00000002      /*!< @brief G_u32DebugFlags set if system time check is enabled */
 #define _DEBUG_PASSTHROUGH             (u32)0x00000004      /*!< @brief G_u32DebugFlags set if Passthrough mode is enabled */
+#define _DEBUG_LOG_BINARY              (u32)0x00000008      /*!< @brief G_u32DebugFlags set if DebugLog() entries are sent as binary frames */
 
 #ifdef EIE_ASCII /* EIE_ASCII-specific G_u32DebugFlags flags */
 #endif /* EIE_ASCII */
@@ -118,34 +201,50 @@ static void DebugSM_Error(void);
 #define DEBUG_CMD_PREFIX_LENGTH   (u8)4                     /*!< @brief Size of command list prefix "00: " */
 #define DEBUG_CMD_NAME_LENGTH     (u8)32                    /*!< @brief Max size for command name */
 #define DEBUG_CMD_POSTFIX_LENGTH  (u8)3                     /*!< @brief Size of command list postfix "<CR><LF>\0" */
+#define DEBUG_ANT_LINE_SIZE       (u8)176                   /*!< @brief Size of one line of the ANT link statistics */
+
+#define DEBUG_LOG_RECORDS         (u8)32                    /*!< @brief DebugLog() entries held until the debug task sends them (power of 2) */
+#define DEBUG_LOG_SYNC            (u8)0xA5                  /*!< @brief First byte of a binary log frame */
+#define DEBUG_LOG_FRAME_MAX       (u8)14                    /*!< @brief Longest binary log frame: sync, id, 2-byte time and two 5-byte arguments */
+
+#define DEBUG_TX_RESERVED_SLOTS   (u8)8                     /*!< @brief Message slots debug output always leaves free for other tasks */
+#define DEBUG_DROP_MARKER_SIZE    (u8)32                    /*!< @brief Buffer size for "[N msgs dropped]" */
+
+#define DEBUG_NAMED_COMMANDS      (u8)24                    /*!< @brief Most commands DebugRegisterCommand() can hold */
+#define DEBUG_NAMED_CMD_NAME_SIZE (u8)16                    /*!< @brief Longest named command name including the NULL */
+#define DEBUG_CMD_MAX_TOKENS      (u8)10                    /*!< @brief Most words in a named command line (name and arguments) */
 
 /* New commands must update the definitions below. Valid commands are in the range
 00 - 99.  Command name string is a maximum of DEBUG_CMD_NAME_LENGTH characters. */
 
 #ifdef EIE_ASCII
-#define DEBUG_COMMANDS          (u8)8   /*!< @brief Total number of debug commands */
+#define DEBUG_COMMANDS          (u8)10  /*!< @brief Total number of debug commands */
 /*                              "0123456789ABCDEF0123456789ABCDEF"  Character position reference */
 #define DEBUG_CMD_NAME00        "Show debug command list         "  /* Command 0: List all commands */
 #define DEBUG_CMD_NAME01        "Toggle LED test                 "  /* Command 1: Test that allows characters to toggle LEDs */
 #define DEBUG_CMD_NAME02        "Toggle system timing warning    "  /* Command 2: Prints message if system tick has advanced more than 1 between main loop sleeps (i.e. tasks are taking too long) */
 #define DEBUG_CMD_NAME03        "Dummy3                          "  /* Command 3: */
-#define DEBUG_CMD_NAME04        "Dummy4                          "  /* Command 4: */
-#define DEBUG_CMD_NAME05        "Dummy5                          "  /* Command 5: */
-#define DEBUG_CMD_NAME06        "Dummy6                          "  /* Command 6: */
-#define DEBUG_CMD_NAME07        "Dummy7                          "  /* Command 7: */
+#define DEBUG_CMD_NAME04        "Show ANT link statistics        "  /* Command 4: Prints the link counters of each ANT channel with traffic */
+#define DEBUG_CMD_NAME05        "Reset ANT link statistics       "  /* Command 5: Clears the link counters of all ANT channels */
+#define DEBUG_CMD_NAME06        "Toggle binary log output        "  /* Command 6: Switches DebugLog() output between text and binary frames */
+#define DEBUG_CMD_NAME07        "Show and reset task profile     "  /* Command 7: Prints the super loop task timing and starts a new measurement */
+#define DEBUG_CMD_NAME08        "Show timing violation trace     "  /* Command 8: Prints the last 1ms timing violations with the slowest task and interrupt load */
+#define DEBUG_CMD_NAME09        "Cycle debug output policy       "  /* Command 9: Selects the next DebugOutputPolicyType and prints the dropped output counts */
 #endif /* EIE_ASCII */
 
 #ifdef EIE_DOTMATRIX
-#define DEBUG_COMMANDS          8   /* Total number of debug commands */
+#define DEBUG_COMMANDS          10  /* Total number of debug commands */
 /*                              "0123456789ABCDEF0123456789ABCDEF"  Character position reference */
 #define DEBUG_CMD_NAME00        "Show debug command list         "  /* Command 0: List all commands */
 #define DEBUG_CMD_NAME01        "Toggle LED test                 "  /* Command 1: Test that allows characters to toggle LEDs */
 #define DEBUG_CMD_NAME02        "Toggle system timing warning    "  /* Command 2: Prints message if system tick has advanced more than 1 between main loop sleeps (i.e. tasks are taking too long) */
 #define DEBUG_CMD_NAME03        "Toggle Captouch value display   "  /* Command 2: Test that shows Captouch sense values on debug port */
-#define DEBUG_CMD_NAME04        "Dummy4                          "  /* Command 4: */
-#define DEBUG_CMD_NAME05        "Dummy5                          "  /* Command 5: */
-#define DEBUG_CMD_NAME06        "Dummy6                          "  /* Command 6: */
-#define DEBUG_CMD_NAME07        "Dummy7                          "  /* Command 7: */
+#define DEBUG_CMD_NAME04        "Show ANT link statistics        "  /* Command 4: Prints the link counters of each ANT channel with traffic */
+#define DEBUG_CMD_NAME05        "Reset ANT link statistics       "  /* Command 5: Clears the link counters of all ANT channels */
+#define DEBUG_CMD_NAME06        "Toggle binary log output        "  /* Command 6: Switches DebugLog() output between text and binary frames */
+#define DEBUG_CMD_NAME07        "Show and reset task profile     "  /* Command 7: Prints the super loop task timing and starts a new measurement */
+#define DEBUG_CMD_NAME08        "Show timing violation trace     "  /* Command 8: Prints the last 1ms timing violations with the slowest task and interrupt load */
+#define DEBUG_CMD_NAME09        "Cycle debug output policy       "  /* Command 9: Selects the next DebugOutputPolicyType and prints the dropped output counts */
 #endif /* EIE_ASCII */
 
 
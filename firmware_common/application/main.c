@@ -1,6 +1,31 @@
 /*!**********************************************************************************************************************
 @file main.c                                                                
 @brief Main system file for the EiE firmware.  
+
+With MAIN_PROFILER_ENABLE defined in main.h (off by default), every task call in the super loop 
+is timed with the DWT cycle counter.  The results are read with MainProfilerQuery()
+or the debug command "Show and reset task profile".
+
+SystemTimeCheck() reports each 1ms timing violation to MainRecordTimingViolation()
+which keeps the last MAIN_VIOLATION_RECORDS with the slowest task of the late loop
+and the time spent in interrupts (G_u32ISRCycleCount) when the profiler is enabled.  
+The debug command 
+"Show timing violation trace" prints them.
+
+------------------------------------------------------------------------------------------------------------------------
+TYPES
+- MainTaskType
+- MainTaskProfileType
+- MainTimingViolationType
+
+PUBLIC FUNCTIONS
+- void MainProfilerQuery(MainTaskType eTask_, MainTaskProfileType* psProfile_)
+- void MainProfilerReset(void)
+- const u8* MainProfilerTaskName(MainTaskType eTask_)
+- bool MainProfilerLastOverrun(MainTaskType* peTask_, u32* pu32Tick_)
+- void MainRecordTimingViolation(u32 u32TickDelta_)
+- u8 MainReadTimingViolations(MainTimingViolationType* psTarget_, u8 u8MaxRecords_)
+
 ***********************************************************************************************************************/
 
 #include "configuration.h"
@@ -29,14 +54,42 @@ const u8 G_aau8AppShortNames[NUMBER_APPLICATIONS][MAX_TASK_NAME_SIZE] =
 #endif /* EIE_DOTMATRIX */
 
 
-/*--------------------------------------------------------------------------------------------------------------------*/
-/* External global variables defined in other files (must indicate which file they are defined in) */
-
-
 /***********************************************************************************************************************
 Global variable definitions with scope limited to this local application.
 Variable names shall start with "Main_" and be declared as static.
 ***********************************************************************************************************************/
+/*! @brief Task names by MainTaskType for profiler reports (from MAIN_TASK_TABLE in main.h) */
+#define MAIN_TASK_ENTRY(eTask_, pu8Name_)   pu8Name_,
+static const u8 Main_aau8TaskNames[MAIN_TASKS][MAX_TASK_NAME_SIZE] = 
+{ MAIN_TASK_TABLE };
+#undef MAIN_TASK_ENTRY
+
+static MainTaskProfileType Main_asTaskProfiles[MAIN_TASKS]; /*!< @brief Measurements by task */
+#ifdef MAIN_PROFILER_ENABLE
+static u32 Main_u32LoopStartMs;                          /*!< @brief G_u32SystemTime1ms at the top of the current loop */
+static u32 Main_u32TaskStartCycles;                      /*!< @brief DWT_CYCCNT when the current task was called */
+static bool Main_bLoopOverrun;                           /*!< @brief TRUE once a task in the current loop passed the tick */
+#endif /* MAIN_PROFILER_ENABLE */
+static bool Main_bOverrunSeen;                           /*!< @brief TRUE once any overrun has been recorded */
+static MainTaskType Main_eLastOverrunTask;               /*!< @brief Task running when the tick was last missed */
+static u32 Main_u32LastOverrunTick;                      /*!< @brief G_u32SystemTime1ms of the last missed tick */
+
+#ifdef MAIN_PROFILER_ENABLE
+static u32 Main_u32LoopStartCycles;                      /*!< @brief DWT_CYCCNT at the top of the current loop */
+static u32 Main_u32LoopStartIsrCycles;                   /*!< @brief G_u32ISRCycleCount at the top of the current loop */
+static MainTaskType Main_eLoopSlowestTask = MAIN_TASKS;  /*!< @brief Slowest task so far in the current loop */
+static u32 Main_u32LoopSlowestCycles;                    /*!< @brief Cycles of Main_eLoopSlowestTask */
+#endif /* MAIN_PROFILER_ENABLE */
+static MainTimingViolationType Main_asViolations[MAIN_VIOLATION_RECORDS]; /*!< @brief Violation ring, oldest overwritten */
+static u8 Main_u8ViolationNext;                          /*!< @brief Main_asViolations index of the next record */
+static u8 Main_u8ViolationCount;                         /*!< @brief Valid records in Main_asViolations */
+
+/*! @brief Runs a super loop task, timing it if the profiler is enabled */
+#ifdef MAIN_PROFILER_ENABLE
+#define MAIN_RUN_TASK(eTask_, fnTask_)   { MainProfilerTaskStart(); fnTask_(); MainProfilerTaskEnd(eTask_); }
+#else
+#define MAIN_RUN_TASK(eTask_, fnTask_)   fnTask_()
+#endif /* MAIN_PROFILER_ENABLE */
 
 
 /*!---------------------------------------------------------------------------------------------------------------------
@@ -61,6 +114,9 @@ void main(void)
   PWMSetupAudio();
   InterruptSetup();
   SysTickSetup();
+#ifdef MAIN_PROFILER_ENABLE
+  MainProfilerInitialize();
+#endif /* MAIN_PROFILER_ENABLE */
   
   /* Driver initialization */
   MessagingInitialize();
@@ -101,35 +157,38 @@ void main(void)
   {
     WATCHDOG_BONE();
     SystemTimeCheck();
+#ifdef MAIN_PROFILER_ENABLE
+    MainProfilerLoopStart();
+#endif /* MAIN_PROFILER_ENABLE */
 
     /* Drivers */
-    MessagingRunActiveState();
-    UartRunActiveState();
-    DebugRunActiveState();
-
-    ButtonRunActiveState();
-    TimerRunActiveState(); 
-    SpiRunActiveState();
-    SspRunActiveState();
-    TwiRunActiveState();
-
-    Adc12RunActiveState();
-    LcdRunActiveState();
-    LedRunActiveState();
-    AntRunActiveState();
-    AntApiRunActiveState();
+    MAIN_RUN_TASK(MAIN_TASK_MESSAGING, MessagingRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_UART,      UartRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_DEBUG,     DebugRunActiveState);
+
+    MAIN_RUN_TASK(MAIN_TASK_BUTTON,    ButtonRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_TIMER,     TimerRunActiveState); 
+    MAIN_RUN_TASK(MAIN_TASK_SPI,       SpiRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_SSP,       SspRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_TWI,       TwiRunActiveState);
+
+    MAIN_RUN_TASK(MAIN_TASK_ADC,       Adc12RunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_LCD,       LcdRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_LED,       LedRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_ANT,       AntRunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_ANT_API,   AntApiRunActiveState);
 
 #ifdef EIE_ASCII
 #endif /* EIE_ASCII */
 
 #ifdef EIE_DOTMATRIX
-    CapTouchRunActiveState();
+    MAIN_RUN_TASK(MAIN_TASK_CAPTOUCH,  CapTouchRunActiveState);
 #endif /* EIE_DOTMATRIX */
 
     /* Applications */
-    UserApp1RunActiveState();
-    UserApp2RunActiveState();
-    UserApp3RunActiveState();
+    MAIN_RUN_TASK(MAIN_TASK_USER_APP1, UserApp1RunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_USER_APP2, UserApp2RunActiveState);
+    MAIN_RUN_TASK(MAIN_TASK_USER_APP3, UserApp3RunActiveState);
         
     /* System sleep */
     HEARTBEAT_OFF();
@@ -141,6 +200,356 @@ void main(void)
 } /* end main() */
 
 
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*! @publicsection */                                                                                            
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void MainProfilerQuery(MainTaskType eTask_, MainTaskProfileType* psProfile_)
+
+@brief Copies the measurements of one super loop task.
+
+Cycles are MCK cycles, so divide by 48 for microseconds.  A task's cycles
+include any interrupts that ran while it was running.
+
+Requires:
+@param eTask_ is the task
+@param psProfile_ points to where the measurements are copied
+
+Promises:
+- *psProfile_ holds the measurements of eTask_ since the last MainProfilerReset()
+
+*/
+void MainProfilerQuery(MainTaskType eTask_, MainTaskProfileType* psProfile_)
+{
+  *psProfile_ = Main_asTaskProfiles[eTask_];
+  
+} /* end MainProfilerQuery() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void MainProfilerReset(void)
+
+@brief Clears the measurements of all tasks.
+
+Requires:
+- NONE
+
+Promises:
+- Main_asTaskProfiles are zero with u32CyclesMin at its largest value
+- No overrun is recorded
+
+*/
+void MainProfilerReset(void)
+{
+  memset(Main_asTaskProfiles, 0, sizeof(Main_asTaskProfiles));
+  for(u8 i = 0; i < MAIN_TASKS; i++)
+  {
+    Main_asTaskProfiles[i].u32CyclesMin = 0xFFFFFFFF;
+  }
+  
+  Main_bOverrunSeen = FALSE;
+  
+} /* end MainProfilerReset() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn const u8* MainProfilerTaskName(MainTaskType eTask_)
+
+@brief Returns the name of a super loop task for reports.
+
+Requires:
+@param eTask_ is the task
+
+Promises:
+- Returns a null-terminated name of less than MAX_TASK_NAME_SIZE characters
+
+*/
+const u8* MainProfilerTaskName(MainTaskType eTask_)
+{
+  return( &Main_aau8TaskNames[eTask_][0] );
+  
+} /* end MainProfilerTaskName() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn bool MainProfilerLastOverrun(MainTaskType* peTask_, u32* pu32Tick_)
+
+@brief Reports which task was running the last time the 1ms tick was missed.
+
+The task that was running when G_u32SystemTime1ms changed during the loop is
+the one that made the loop miss its sleep.  It may not be the slowest task, 
+but it is where the time ran out.
+
+Requires:
+@param peTask_ points to where the task is written
+@param pu32Tick_ points to where G_u32SystemTime1ms at the overrun is written
+
+Promises:
+- Returns FALSE if there has been no overrun since the last MainProfilerReset()
+- Otherwise writes the task and tick and returns TRUE
+
+*/
+bool MainProfilerLastOverrun(MainTaskType* peTask_, u32* pu32Tick_)
+{
+  if(!Main_bOverrunSeen)
+  {
+    return(FALSE);
+  }
+  
+  *peTask_   = Main_eLastOverrunTask;
+  *pu32Tick_ = Main_u32LastOverrunTick;
+  return(TRUE);
+  
+} /* end MainProfilerLastOverrun() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void MainRecordTimingViolation(u32 u32TickDelta_)
+
+@brief Adds a 1ms timing violation to the trace.
+
+The super loop that just finished is the one that ran late, so its slowest 
+task and interrupt time are saved with the violation.  These come from the
+DWT cycle counter, so without MAIN_PROFILER_ENABLE only the tick and the ticks
+missed are recorded.  When the trace is full the oldest record is replaced.
+
+Requires:
+- Called from SystemTimeCheck() before MainProfilerLoopStart()
+
+@param u32TickDelta_ is the number of ticks since the previous loop
+
+Promises:
+- A record with the current tick, the ticks missed, the slowest task of the
+  late loop and the interrupt share of that loop is added to Main_asViolations
+- Without MAIN_PROFILER_ENABLE the slowest task is MAIN_TASKS and the cycles 
+  and interrupt share are 0
+
+*/
+void MainRecordTimingViolation(u32 u32TickDelta_)
+{
+  MainTimingViolationType* psRecord = &Main_asViolations[Main_u8ViolationNext];
+#ifdef MAIN_PROFILER_ENABLE
+  u32 u32LoopCycles = DWT_CYCCNT - Main_u32LoopStartCycles;
+  u32 u32IsrCycles = G_u32ISRCycleCount - Main_u32LoopStartIsrCycles;
+  u32 u32Percent = 0;
+#endif /* MAIN_PROFILER_ENABLE */
+  
+  psRecord->u32Tick = G_u32SystemTime1ms;
+  psRecord->u16TicksMissed = 0;
+  if(u32TickDelta_ > 1)
+  {
+    psRecord->u16TicksMissed = (u16)( (u32TickDelta_ > 0x10000) ? 0xFFFF : (u32TickDelta_ - 1) );
+  }
+  
+#ifdef MAIN_PROFILER_ENABLE
+  psRecord->eSlowestTask = Main_eLoopSlowestTask;
+  psRecord->u32SlowestCycles = Main_u32LoopSlowestCycles;
+  
+  if(u32LoopCycles >= 100)
+  {
+    u32Percent = u32IsrCycles / (u32LoopCycles / 100);
+  }
+  psRecord->u8IsrLoadPercent = (u8)( (u32Percent > 100) ? 100 : u32Percent );
+#else
+  psRecord->eSlowestTask = MAIN_TASKS;
+  psRecord->u32SlowestCycles = 0;
+  psRecord->u8IsrLoadPercent = 0;
+#endif /* MAIN_PROFILER_ENABLE */
+  
+  Main_u8ViolationNext = (Main_u8ViolationNext + 1) % MAIN_VIOLATION_RECORDS;
+  if(Main_u8ViolationCount < MAIN_VIOLATION_RECORDS)
+  {
+    Main_u8ViolationCount++;
+  }
+  
+} /* end MainRecordTimingViolation() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u8 MainReadTimingViolations(MainTimingViolationType* psTarget_, u8 u8MaxRecords_)
+
+@brief Copies the timing violation trace, oldest record first.
+
+Requires:
+@param psTarget_ points to space for u8MaxRecords_ records
+@param u8MaxRecords_ is the most records to copy
+
+Promises:
+- Up to u8MaxRecords_ of the newest records are copied to psTarget_ oldest first
+- Returns the number of records copied
+
+*/
+u8 MainReadTimingViolations(MainTimingViolationType* psTarget_, u8 u8MaxRecords_)
+{
+  u8 u8Records = Main_u8ViolationCount;
+  u8 u8Index;
+  
+  if(u8Records > u8MaxRecords_)
+  {
+    u8Records = u8MaxRecords_;
+  }
+  
+  u8Index = (Main_u8ViolationNext + MAIN_VIOLATION_RECORDS - u8Records) % MAIN_VIOLATION_RECORDS;
+  for(u8 i = 0; i < u8Records; i++)
+  {
+    psTarget_[i] = Main_asViolations[u8Index];
+    u8Index = (u8Index + 1) % MAIN_VIOLATION_RECORDS;
+  }
+  
+  return u8Records;
+  
+} /* end MainReadTimingViolations() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*! @privatesection */                                                                                            
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef MAIN_PROFILER_ENABLE
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void MainProfilerInitialize(void)
+
+@brief Starts the DWT cycle counter and clears the measurements.
+
+Requires:
+- NONE
+
+Promises:
+- Trace is enabled in CoreDebug DEMCR and DWT_CYCCNT is counting
+- MainProfilerReset() has run
+
+*/
+static void MainProfilerInitialize(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA;
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+  
+  MainProfilerReset();
+  
+} /* end MainProfilerInitialize() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void MainProfilerLoopStart(void)
+
+@brief Marks the start of a pass through the super loop.
+
+Requires:
+- Called at the top of the super loop before any task
+
+Promises:
+- Main_u32LoopStartMs = G_u32SystemTime1ms and no overrun is recorded for this loop
+- The cycle and interrupt counts of the loop start now and no slowest task is set
+
+*/
+static void MainProfilerLoopStart(void)
+{
+  Main_u32LoopStartMs = G_u32SystemTime1ms;
+  Main_bLoopOverrun = FALSE;
+  
+  Main_u32LoopStartCycles = DWT_CYCCNT;
+  Main_u32LoopStartIsrCycles = G_u32ISRCycleCount;
+  Main_eLoopSlowestTask = MAIN_TASKS;
+  Main_u32LoopSlowestCycles = 0;
+  
+} /* end MainProfilerLoopStart() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void MainProfilerTaskStart(void)
+
+@brief Saves the cycle counter before a task runs.
+
+Requires:
+- NONE
+
+Promises:
+- Main_u32TaskStartCycles = DWT_CYCCNT
+
+*/
+static void MainProfilerTaskStart(void)
+{
+  Main_u32TaskStartCycles = DWT_CYCCNT;
+  
+} /* end MainProfilerTaskStart() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void MainProfilerTaskEnd(MainTaskType eTask_)
+
+@brief Adds the cycles of the task that just ran to its measurements.
+
+Requires:
+@param eTask_ is the task that ran since MainProfilerTaskStart()
+
+Promises:
+- The measurements of eTask_ are updated
+- eTask_ becomes the slowest task of the loop if no other task took longer
+- If this is the first task in the loop to finish after the 1ms tick changed,
+  the overrun is counted against eTask_
+
+*/
+static void MainProfilerTaskEnd(MainTaskType eTask_)
+{
+  MainTaskProfileType* psProfile = &Main_asTaskProfiles[eTask_];
+  u32 u32Cycles = DWT_CYCCNT - Main_u32TaskStartCycles;
+  u32 u32BinLimit = MAIN_PROFILE_BIN0_CYCLES;
+  u8 u8Bin = 0;
+  
+  psProfile->u32Calls++;
+  psProfile->u32CyclesLast = u32Cycles;
+  if(u32Cycles < psProfile->u32CyclesMin)
+  {
+    psProfile->u32CyclesMin = u32Cycles;
+  }
+  if(u32Cycles > psProfile->u32CyclesMax)
+  {
+    psProfile->u32CyclesMax = u32Cycles;
+  }
+  
+  /* The first call seeds the average */
+  if(psProfile->u32Calls == 1)
+  {
+    psProfile->u32CyclesAverage = u32Cycles;
+  }
+  else
+  {
+    psProfile->u32CyclesAverage += ((s32)u32Cycles - (s32)psProfile->u32CyclesAverage) / MAIN_PROFILE_AVERAGE;
+  }
+  
+  while( (u8Bin < (MAIN_PROFILE_BINS - 1)) && (u32Cycles >= u32BinLimit) )
+  {
+    u8Bin++;
+    u32BinLimit <<= 2;
+  }
+  
+  if(psProfile->au16Histogram[u8Bin] != 0xFFFF)
+  {
+    psProfile->au16Histogram[u8Bin]++;
+  }
+  
+  if(u32Cycles > Main_u32LoopSlowestCycles)
+  {
+    Main_eLoopSlowestTask = eTask_;
+    Main_u32LoopSlowestCycles = u32Cycles;
+  }
+  
+  /* The tick changed while this task ran, so the loop will miss its sleep */
+  if( !Main_bLoopOverrun && (G_u32SystemTime1ms != Main_u32LoopStartMs) )
+  {
+    Main_bLoopOverrun = TRUE;
+    Main_bOverrunSeen = TRUE;
+    Main_eLastOverrunTask = eTask_;
+    Main_u32LastOverrunTick = G_u32SystemTime1ms;
+    psProfile->u32Overruns++;
+  }
+  
+} /* end MainProfilerTaskEnd() */
+#endif /* MAIN_PROFILER_ENABLE */
+
+
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
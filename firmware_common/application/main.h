@@ -51,6 +51,34 @@ FIRMWARE_SUB_REV1: should be updated when a pull request is made to the MASTER b
 
 #define MAX_TASK_NAME_SIZE              (u8)10            /*!< @brief Maximum string size for task name reported in SystemStatusReport */
 
+/* Super loop task profiler: uncomment to time every task and instrumented ISR with the DWT cycle counter */
+//#define MAIN_PROFILER_ENABLE
+
+#define MAIN_PROFILE_BINS               (u8)8             /*!< @brief Histogram bins per task */
+#define MAIN_PROFILE_BIN0_CYCLES        (u32)256          /*!< @brief Upper limit of the first bin; each next bin is 4x larger */
+#define MAIN_PROFILE_AVERAGE            (s32)16           /*!< @brief Calls in the running average of a task */
+#define MAIN_VIOLATION_RECORDS          (u8)16            /*!< @brief Timing violations kept by MainRecordTimingViolation() */
+
+/* DWT cycle counter (not defined in this version of core_cm3.h) */
+#define DWT_CTRL                        (*(volatile u32*)0xE0001000)  /*!< @brief DWT control register */
+#define DWT_CYCCNT                      (*(volatile u32*)0xE0001004)  /*!< @brief DWT cycle counter, counts MCK cycles */
+#define DWT_CTRL_CYCCNTENA              (u32)0x00000001               /*!< @brief DWT_CTRL bit to run DWT_CYCCNT */
+
+/* ISR time accounting for the timing violation trace.  ISR_PROFILE_ENTER() follows the declarations
+of a handler and ISR_PROFILE_EXIT() runs before it returns.  Only the outermost handler adds its 
+time so nested interrupts are not counted twice.  These live here rather than in interrupts.h 
+because configuration.h includes interrupts.h before this file defines MAIN_PROFILER_ENABLE. */
+extern volatile u32 G_u32ISRCycleCount;         /*!< @brief From interrupts.c */
+extern volatile u8 G_u8ISRNesting;              /*!< @brief From interrupts.c */
+
+#ifdef MAIN_PROFILER_ENABLE
+#define ISR_PROFILE_ENTER()   u32 u32IsrStartCycles = DWT_CYCCNT; G_u8ISRNesting++
+#define ISR_PROFILE_EXIT()    if(--G_u8ISRNesting == 0) { G_u32ISRCycleCount += DWT_CYCCNT - u32IsrStartCycles; }
+#else
+#define ISR_PROFILE_ENTER()
+#define ISR_PROFILE_EXIT()
+#endif /* MAIN_PROFILER_ENABLE */
+
 
 /* G_u32SystemFlags */
 #define _SYSTEM_CLOCK_NO_STOP_DEBUG     (u32)0x00000001   /*!< @brief G_u32SystemFlags DEBUG module preventing STOP mode */
@@ -67,10 +95,98 @@ FIRMWARE_SUB_REV1: should be updated when a pull request is made to the MASTER b
 /* end G_u32SystemFlags */
 
 
+/**********************************************************************************************************************
+Type Definitions
+**********************************************************************************************************************/
+
+/* Super loop tasks in the order they are called.  This is the only list of tasks: 
+MAIN_TASK_ENTRY() is defined to pick out the MainTaskType value here and the 
+profiler name in main.c. */
+#define MAIN_TASK_TABLE \
+  MAIN_TASK_ENTRY(MAIN_TASK_MESSAGING, "MESSAGING") \
+  MAIN_TASK_ENTRY(MAIN_TASK_UART,      "UART")      \
+  MAIN_TASK_ENTRY(MAIN_TASK_DEBUG,     "DEBUG")     \
+  MAIN_TASK_ENTRY(MAIN_TASK_BUTTON,    "BUTTON")    \
+  MAIN_TASK_ENTRY(MAIN_TASK_TIMER,     "TIMER")     \
+  MAIN_TASK_ENTRY(MAIN_TASK_SPI,       "SPI")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_SSP,       "SSP")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_TWI,       "TWI")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_ADC,       "ADC")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_LCD,       "LCD")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_LED,       "LED")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_ANT,       "ANT")       \
+  MAIN_TASK_ENTRY(MAIN_TASK_ANT_API,   "ANT_API")   \
+  MAIN_TASK_ENTRY(MAIN_TASK_CAPTOUCH,  "CAPTOUCH")  \
+  MAIN_TASK_ENTRY(MAIN_TASK_USER_APP1, "USERAPP1")  \
+  MAIN_TASK_ENTRY(MAIN_TASK_USER_APP2, "USERAPP2")  \
+  MAIN_TASK_ENTRY(MAIN_TASK_USER_APP3, "USERAPP3")
+
+/*! 
+@enum MainTaskType
+@brief Tasks run by the super loop in the order they are called (see MAIN_TASK_TABLE).
+*/
+#define MAIN_TASK_ENTRY(eTask_, pu8Name_)   eTask_,
+typedef enum {MAIN_TASK_TABLE
+              MAIN_TASKS /*!< @brief Number of tasks (keep last) */
+             } MainTaskType;
+#undef MAIN_TASK_ENTRY
+
+
+/*! 
+@struct MainTaskProfileType
+@brief CPU time of one super loop task in MCK cycles (see MainProfilerQuery()).
+*/
+typedef struct
+{
+  u32 u32Calls;                               /*!< @brief Times the task has run */
+  u32 u32CyclesLast;                          /*!< @brief Cycles of the latest call */
+  u32 u32CyclesMin;                           /*!< @brief Fewest cycles of any call */
+  u32 u32CyclesAverage;                       /*!< @brief Running average over about MAIN_PROFILE_AVERAGE calls */
+  u32 u32CyclesMax;                           /*!< @brief Most cycles of any call */
+  u32 u32Overruns;                            /*!< @brief Times the 1ms tick passed while the task was running */
+  u16 au16Histogram[MAIN_PROFILE_BINS];       /*!< @brief Calls by cycles: < 256, < 1k, < 4k ... (saturates at 0xFFFF) */
+} MainTaskProfileType;
+
+
+/*! 
+@struct MainTimingViolationType
+@brief One 1ms timing violation seen by SystemTimeCheck() (see MainReadTimingViolations()).
+*/
+typedef struct
+{
+  u32 u32Tick;                                /*!< @brief G_u32SystemTime1ms when the violation was seen */
+  u32 u32SlowestCycles;                       /*!< @brief Cycles of the slowest task in the late loop */
+  MainTaskType eSlowestTask;                  /*!< @brief Slowest task in the late loop (MAIN_TASKS if not profiled) */
+  u16 u16TicksMissed;                         /*!< @brief Ticks that passed without a loop */
+  u8 u8IsrLoadPercent;                        /*!< @brief Share of the late loop spent in interrupts */
+} MainTimingViolationType;
+
+
 /**********************************************************************************************************************
 Function Declarations
 **********************************************************************************************************************/
 
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*! @publicsection */                                                                                            
+/*--------------------------------------------------------------------------------------------------------------------*/
+void MainProfilerQuery(MainTaskType eTask_, MainTaskProfileType* psProfile_);
+void MainProfilerReset(void);
+const u8* MainProfilerTaskName(MainTaskType eTask_);
+bool MainProfilerLastOverrun(MainTaskType* peTask_, u32* pu32Tick_);
+void MainRecordTimingViolation(u32 u32TickDelta_);
+u8 MainReadTimingViolations(MainTimingViolationType* psTarget_, u8 u8MaxRecords_);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*! @privatesection */                                                                                            
+/*--------------------------------------------------------------------------------------------------------------------*/
+#ifdef MAIN_PROFILER_ENABLE
+static void MainProfilerInitialize(void);
+static void MainProfilerLoopStart(void);
+static void MainProfilerTaskStart(void);
+static void MainProfilerTaskEnd(MainTaskType eTask_);
+#endif /* MAIN_PROFILER_ENABLE */
+
 
 
 #endif /* __MAIN_H */
@@ -38,21 +38,22 @@ Type Definitions
 This provides self-documentation when indexing peripherals and when assigning
 better names for devices that make use of the peripherals.
 */
-typedef enum {SPI0, UART, USART0, USART1, USART2, USART3} PeripheralType;
+typedef enum {SPI0, UART, USART0, USART1, USART2, USART3, TWI0, TWI1} PeripheralType;
 
 
 /**********************************************************************************************************************
 Includes
 ***********************************************************************************************************************/
 /* Common header files */
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include "AT91SAM3U4.h"
 #include "exceptions.h"
 #include "interrupts.h"
 #include "core_cm3.h"
-#include "main.h"
 #include "typedefs.h"
+#include "main.h"
 #include "utilities.h"
 
 /* EIEF1-PCB-01 specific header files */
@@ -221,6 +222,13 @@ Includes
 
 #define TWI0_IRQHandler             Twi0_IrqHandler
 
+/* Second I2C bus (TWI1): TWD1 / TWCK1 are on PA24 / PA25 which the current boards
+route to other functions, so the bus is configured but has no devices by default */
+#define TWI1_CR_INIT                EIE_TWI_CR_INIT
+#define TWI1_MMR_INIT               EIE_TWI_MMR_INIT
+#define TWI1_CWGR_INIT              EIE_TWI_CWGR_INIT
+#define TWI1_IER_INIT               EIE_TWI_IER_INIT
+
 
 /*! @endcond */
 /***********************************************************************************************************************
@@ -581,7 +589,8 @@ $$$$$ SPI peripheral board-specific parameters
 /*----------------------------------------------------------------------------------------------------------------------
 Blade SPI Setup 
 
-SPI mode to communicate with a Slave device on the Blade connector. 
+SPI mode to communicate with Slave devices on the Blade connector.  Variable
+peripheral select is used so each device on NPCS0-3 keeps its own CSR setup.
 */
 /* SPI Control Register */
 #define BLADE_SPI_CR_INIT (u32)0x00000002
@@ -607,7 +616,7 @@ SPI mode to communicate with a Slave device on the Blade connector.
 */
 
 /* SPI Mode Register */
-#define BLADE_SPI_MR_INIT (u32)0x00000021
+#define BLADE_SPI_MR_INIT (u32)0x00000013
 /*
     31 [0] DLYBCS Delay Between Chip Selects not applicable
     30 [0] "
@@ -624,7 +633,7 @@ SPI mode to communicate with a Slave device on the Blade connector.
     21 [0] "
     20 [0] "
 
-    19 [0] PCS Peripheral Chip Select select CS0
+    19 [0] PCS Peripheral Chip Select not used (variable select)
     18 [0] "
     17 [0] "
     16 [0] "
@@ -633,12 +642,12 @@ SPI mode to communicate with a Slave device on the Blade connector.
 
     07 [0] LLB Local Loopback disabled
     06 [0] Reserved
-    05 [1] WDRBT Wait Data Before Transfer enabled
-    04 [0] MODFDIS Mode Fault not disabled
+    05 [0] WDRBT Wait Data Before Transfer disabled (write-only transfers do not read RDR)
+    04 [1] MODFDIS Mode Fault disabled
 
     03 [0] Reserved
     02 [0] PCSDEC chip select direct connect
-    01 [0] PS Fixed Peripheral Select
+    01 [1] PS Variable Peripheral Select (PCS from TDR)
     00 [1] MSTR Master mode
 */
 
@@ -723,7 +732,7 @@ DLYBCT = 4.5 (round up to 5)
     00 [1] CPOL Clock polarity high when inactive
 */
 
-/* Only a single Slave is used, so other CSRs are the same as CSR0 */
+/* Default setup for devices on NPCS1-3 that do not supply their own CSR value */
 #define BLADE_SPI_CSR1_INIT (u32)0x05303001
 #define BLADE_SPI_CSR2_INIT (u32)0x05303001
 #define BLADE_SPI_CSR3_INIT (u32)0x05303001
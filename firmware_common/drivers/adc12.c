@@ -294,6 +294,8 @@ void ADCC0_IrqHandler(void)
 {
   u16 u16Adc12Result;
   
+  ISR_PROFILE_ENTER();
+
   /* WARNING: if you step through this handler with the ADC12B registers
   debugging, the debugger reads ADC12B_SR and clears the EOC flag bits */
 
@@ -315,7 +317,8 @@ void ADCC0_IrqHandler(void)
   /* Give the Semaphore back, clear the ADC pending flag and exit */
   Adc12_bAdcAvailable = TRUE;
   NVIC->ICPR[0] = (1 << AT91C_ID_ADC12B);
-  
+
+  ISR_PROFILE_EXIT();
 } /* end ADCC0_IrqHandler() */
 
 
@@ -38,17 +38,52 @@ TYPES
 - AntAssignChannelInfoType
 - AntMessageResponseType
 - AntOutgoingMessageListType
+- AntPoolStatsType
+- AntThroughputStatsType
+- AntRxParseStateType
+- AntBurstStateType
+- AntBurstStatusType
+- AntChannelHandlerType
+- AntChannelHandlerEntryType
+- AntDeviceTableModeType
+- AntRssiStatsType
+- AntDeviceInfoType
+- AntDeviceEntryType
+- AntLinkStatsType
 
 PUBLIC FUNCTIONS
 - u8 AntCalculateTxChecksum(u8* pu8Message_)
+- u8 AntBuildDataMessage(u8* pu8Target_, u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_)
 - bool AntQueueOutgoingMessage(u8 *pu8Message_)
+- bool AntQueueDataMessage(u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_)
+- bool AntQueueLatestOutgoingMessage(u8 *pu8Message_)
 - void AntDeQueueApplicationMessage(void)
+- AntApplicationMsgListType* AntPeekApplicationMessage(void)
+- u8 AntReadApplicationMessages(AntApplicationMsgListType* psTarget_, u8 u8MaxMessages_)
+- void AntQueryPoolStats(AntPoolStatsType* psOutgoingStats_, AntPoolStatsType* psApplicationStats_)
+- void AntQueryThroughputStats(AntThroughputStatsType* psStats_)
+- void AntResetThroughputStats(void)
+- bool AntBurstTxStart(AntChannelNumberType eChannel_, u8* pu8Data_, u16 u16Length_)
+- bool AntBurstRxStart(AntChannelNumberType eChannel_, u8* pu8Buffer_, u16 u16Size_)
+- void AntBurstQueryStatus(AntBurstStatusType* psStatus_)
+- bool AntBurstTxActive(AntChannelNumberType eChannel_)
+- bool AntRegisterChannelHandler(AntChannelNumberType eChannel_, u8 u8MessageMask_, AntChannelHandlerType pfnHandler_)
+- void AntDeviceTableSetMode(AntDeviceTableModeType eMode_)
+- void AntDeviceTableClear(void)
+- u8 AntDeviceTableCount(void)
+- bool AntDeviceTableFind(u16 u16DeviceID_, u8 u8DeviceType_, AntDeviceInfoType* psInfo_)
+- u8 AntDeviceTableRead(AntDeviceInfoType* psTarget_, u8 u8MaxDevices_)
+- bool AntQueryLinkStats(AntChannelNumberType eChannel_, AntLinkStatsType* psStats_)
+- bool AntResetLinkStats(AntChannelNumberType eChannel_)
+- bool AntRxTimestampToHostUs(u16 u16RxTimestamp_, u32* pu32HostUs_)
 
 PROTECTED FUNCTIONS
 - void AntInitialize(void)
 - void AntRunActiveState(void)
 - void AntTxFlowControlCallback(void)
 - void AntRxFlowControlCallback(void)
+- void AntSenAssertCallback(void)
+- void AntDebugPrintChannelMessage(u8* pu8Template_, u8 u8Channel_)
 
 
 ***********************************************************************************************************************/
@@ -66,13 +101,13 @@ u32 G_u32AntFlags;                                    /*!< @brief Flag bits for
 AntAssignChannelInfoType G_asAntChannelConfiguration[ANT_NUM_CHANNELS]; /*!< @brief Keeps track of all configured ANT channels */
 AntMessageResponseType G_stAntMessageResponse;           /*!< @brief Holds the latest message response info */
 
-AntApplicationMsgListType *G_psAntApplicationMsgList;  /*!< @brief Public linked list of messages from ANT to the application */
+AntApplicationMsgListType *G_psAntApplicationMsgList;  /*!< @brief Oldest message from ANT to the application (NULL if none) */
 
 /*! @cond DOXYGEN_EXCLUDE */
 u8 G_au8AntMessageOk[]     = "OK\n\r";
 u8 G_au8AntMessageFail[  ] = "FAIL\n\r";
 
-/* Replace 'd' at [12] with channel number */
+/* 'd' at ANT_DEBUG_TEXT_CHANNEL_INDEX is replaced by the channel number (see AntDebugPrintChannelMessage()) */
 u8 G_au8AntMessageAssign[]    = "ANT channel d assign "; 
 u8 G_au8AntMessageUnassign[]  = "ANT channel d unassign ";
 u8 G_au8AntMessageUnhandled[] = "ANT channel d message 0xxx response dd ";
@@ -103,8 +138,6 @@ u8 G_au8AntSetSearchTimeout[] = {MESG_CHANNEL_SEARCH_TIMEOUT_SIZE, MESG_CHANNEL_
                                  0xFF /* SearchTime (0xFF = infinite) */, CS};        
 u8 G_au8AntLibConfig[]        = {MESG_LIB_CONFIG_SIZE, MESG_LIB_CONFIG_ID, 0, LIB_CONFIG_CHANNEL_ID_FLAG | LIB_CONFIG_RSSI_FLAG, CS};        
 
-u8 G_au8AntBroadcastDataMessage[] = {MESG_DATA_SIZE, MESG_BROADCAST_DATA_ID, CH, D_0, D_1, D_2, D_3, D_4, D_5, D_6, D_7, CS};
-u8 G_au8AntAckDataMessage[] = {MESG_DATA_SIZE, MESG_ACKNOWLEDGED_DATA_ID, CH, D_0, D_1, D_2, D_3, D_4, D_5, D_6, D_7, CS};
 u8 G_au8ANTGetVersion[]     = {MESG_REQUEST_SIZE, MESG_REQUEST_ID, 0, MESG_VERSION_ID, 0};   
 /*! @endcond */
 
@@ -125,8 +158,8 @@ Global variable definitions with scope limited to this local application.
 Variable names shall start with "Ant_<type>Name" and be declared as static.
 ***********************************************************************************************************************/
 static fnCode_type Ant_pfnStateMachine;                 /*!< @brief The ANT state machine function pointer */
-static u32 Ant_u32RxTimer;                              /*!< @brief Dedicated timer for receiving bytes */
-static u32 Ant_u32TxTimer;                              /*!< @brief Dedicated timer for transmitting bytes */
+static u32 Ant_u32RxTimer;                              /*!< @brief Start time of the current reception (ms) */
+static u32 Ant_u32TxTimer;                              /*!< @brief Start time of the current transmit step (ms) */
 
 static u32 Ant_u32TxByteCounter = 0;                    /*!< @brief Counter counts callbacks on sent bytes */
 static u32 Ant_u32RxByteCounter = 0;                    /*!< @brief Counter counts callbacks on received bytes */
@@ -142,13 +175,75 @@ static u8 Ant_u8AntVersion[MESG_VERSION_SIZE];          /*!< @brief ANT device v
 static u8 Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE];       /*!< @brief Space for received ANT message bytes used by SSP */
 static u8 *Ant_pu8AntRxBufferNextChar;                  /*!< @brief Pointer to next char to be written in the AntRxBuffer used by SSP */
 
-static u8 *Ant_pu8AntRxBufferCurrentChar;               /*!< @brief Pointer to the current char in the AntRxBuffer */
 static u8 *Ant_pu8AntRxBufferUnreadMsg;                 /*!< @brief Pointer to unread chars in the AntRxBuffer */
-static u8 Ant_u8AntNewRxMessages;                       /*!< @brief Counter for number of new messages in AntRxBuffer */
+static u8 *Ant_pu8AntRxBufferWrapMark;                  /*!< @brief End of the data before the parser skipped back to the start of AntRxBuffer */
+static volatile u8 Ant_u8AntNewRxMessages;              /*!< @brief Counter for number of new messages in AntRxBuffer */
+
+static volatile AntRxParseStateType Ant_eRxParseState;  /*!< @brief Current state of the receive frame parser */
+static u8 *Ant_pu8RxFrameStart;                         /*!< @brief SYNC byte of the frame being parsed */
+static bool Ant_bRxFrameWrapped;                        /*!< @brief The frame being parsed set Ant_pu8AntRxBufferWrapMark */
+static volatile bool Ant_bRxOverrun;                    /*!< @brief The parser dropped a frame because the Rx buffer was full */
+static u8 Ant_u8RxFrameChecksum;                        /*!< @brief Running checksum of the frame being parsed */
+static u8 Ant_u8RxFrameBytesRemaining;                  /*!< @brief Payload bytes still to come in the frame being parsed */
+static volatile u8 Ant_u8RxHandshakeByte;               /*!< @brief First byte sent by ANT after SEN asserted */
+static volatile bool Ant_bRxFrameComplete;              /*!< @brief Set by the parser when a good frame has been received */
+static u32 Ant_u32RxChecksumErrorCounter = 0;           /*!< @brief Increments any time a received frame fails its checksum */
+
+static volatile u32 Ant_u32SenTimeUs;                   /*!< @brief GetSystemTimeUs() at the last SEN assertion */
+static u32 Ant_au32RxFrameTimeUs[ANT_RX_TIME_SLOTS];    /*!< @brief SEN time of each unprocessed frame in Ant_au8AntRxBuffer */
+static volatile u8 Ant_u8RxFrameTimeIn;                 /*!< @brief Next Ant_au32RxFrameTimeUs slot the parser writes */
+static u8 Ant_u8RxFrameTimeOut;                         /*!< @brief Ant_au32RxFrameTimeUs slot of the next frame to process */
+static u32 Ant_u32CurrentRxTimeUs;                      /*!< @brief SEN time of the frame AntProcessMessage() is working on */
+static bool Ant_bRxTimestampReferenceValid = FALSE;     /*!< @brief TRUE once a message with an ANT receive timestamp has arrived */
+static u16 Ant_u16RxTimestampReference;                 /*!< @brief ANT receive timestamp of the reference message */
+static u32 Ant_u32RxTimestampReferenceUs;               /*!< @brief Host time of the reference message */
 
-static u32 Ant_u32ApplicationMessageCount = 0;          /*!< @brief Counts messages queued on G_psAntApplicationMsgList */
 static AntOutgoingMessageListType *Ant_psOutgoingMsgList; /*!< @brief Linked list of outgoing ANT-formatted messages */
-static u32 Ant_u32OutgoingMessageCount = 0;             /*!< @brief Counts messages queued on Ant_psOutgoingMsgList */
+
+/* Fixed-block pool that backs the outgoing message list */
+static AntOutgoingMessageListType Ant_asOutgoingMsgPool[ANT_OUTGOING_MESSAGE_BUFFER_SIZE];        /*!< @brief Storage for outgoing messages */
+static AntOutgoingMessageListType *Ant_apsLatestOutgoingMsg[ANT_NUM_CHANNELS];                     /*!< @brief Waiting message that AntQueueLatestOutgoingMessage() may replace, by channel */
+static u32 Ant_u32LatestReplacedCounter;                                                          /*!< @brief Waiting messages overwritten with a newer value */
+static AntOutgoingMessageListType *Ant_psOutgoingMsgFreeList;                                     /*!< @brief Unused blocks in Ant_asOutgoingMsgPool */
+static AntPoolStatsType Ant_sOutgoingPoolStats;                                                    /*!< @brief Usage statistics for Ant_asOutgoingMsgPool */
+
+/* Ring of messages from ANT to the application */
+static AntApplicationMsgListType Ant_asApplicationMsgRing[ANT_APPLICATION_MESSAGE_BUFFER_SIZE];   /*!< @brief Storage for application messages */
+static u8 Ant_u8ApplicationMsgHead;                                                               /*!< @brief Index of the oldest message in the ring */
+static u8 Ant_u8ApplicationMsgTail;                                                               /*!< @brief Index of the next free slot in the ring */
+static AntPoolStatsType Ant_sApplicationRingStats;                                                 /*!< @brief Usage statistics for Ant_asApplicationMsgRing */
+
+/* Throughput measurement */
+static AntThroughputStatsType Ant_sThroughputStats;                          /*!< @brief Rates and processing cost since the last reset */
+static u32 Ant_u32ThroughputTimer;                                           /*!< @brief Start of the current rate window */
+static u16 Ant_u16TxThisPeriod;                                              /*!< @brief Messages sent in the current rate window */
+static u16 Ant_u16RxThisPeriod;                                              /*!< @brief Frames processed in the current rate window */
+static u32 Ant_u32RxCyclesTotal;                                             /*!< @brief Sum of AntProcessMessage() cycles for the average */
+
+static AntChannelHandlerEntryType Ant_asChannelHandlers[ANT_NUM_CHANNELS];  /*!< @brief Registered application handlers by channel */
+
+static AntDeviceTableModeType Ant_eDeviceTableMode = ANT_DEVICE_TABLE_OFF;   /*!< @brief Device table use */
+static AntDeviceEntryType Ant_asDeviceTable[ANT_DEVICE_TABLE_SIZE];            /*!< @brief Devices heard in scanning mode */
+static u8 Ant_au8DeviceHashBuckets[ANT_DEVICE_HASH_BUCKETS];                  /*!< @brief First entry of each hash chain */
+static u8 Ant_u8DeviceTableCount;                                             /*!< @brief Entries in use (always the lowest indices) */
+static u8 Ant_u8DeviceLruHead;                                                /*!< @brief Most recently heard device */
+static u8 Ant_u8DeviceLruTail;                                                /*!< @brief Least recently heard device (next to evict) */
+
+static AntLinkStatsType Ant_asLinkStats[ANT_NUM_CHANNELS];                    /*!< @brief Link quality counters by channel */
+static s16 Ant_as16LinkRssiAverageX16[ANT_NUM_CHANNELS];                      /*!< @brief Running RSSI average by channel in 1/16 dBm */
+
+static AntBurstStatusType Ant_sBurstStatus;             /*!< @brief Progress of the burst transmit and receive engines */
+static AntChannelNumberType Ant_eBurstTxChannel;        /*!< @brief Channel of the outgoing burst transfer */
+static u8 *Ant_pu8BurstTxData;                          /*!< @brief Caller's source buffer for the outgoing burst transfer */
+static u16 Ant_u16BurstTxChunkStart;                    /*!< @brief Offset of the first byte of the burst being sent */
+static u16 Ant_u16BurstTxNextByte;                      /*!< @brief Offset of the next byte to queue */
+static u8 Ant_u8BurstTxSequence;                        /*!< @brief Sequence bits for the next outgoing packet */
+static u8 Ant_u8BurstTxAttempts;                        /*!< @brief Failed attempts at the burst being sent */
+static AntChannelNumberType Ant_eBurstRxChannel;        /*!< @brief Channel armed for burst reception */
+static u8 *Ant_pu8BurstRxBuffer;                        /*!< @brief Caller's buffer for incoming burst data */
+static u16 Ant_u16BurstRxSize;                          /*!< @brief Size of Ant_pu8BurstRxBuffer */
+static u16 Ant_u16BurstRxNextByte;                      /*!< @brief Offset for the next incoming packet */
+static u8 Ant_u8BurstRxSequence;                        /*!< @brief Expected sequence bits of the next incoming packet */
 
 static u8 Ant_u8SlaveMissedMessageHigh = 0;             /*!< @brief Counter for missed messages if device is a slave */
 static u8 Ant_u8SlaveMissedMessageMid = 0;              /*!< @brief Counter for missed messages if device is a slave */
@@ -159,7 +254,7 @@ static u8 Ant_au8AddMessageFailMsg[] = "\n\rNo space in AntQueueOutgoingMessage\
 
 /* Debug variables */
 static u32 Ant_DebugRxMessageCounter   = 0;             /*!< @brief Number of visits to the RxMessage state */
-static u32 Ant_DebugTotalRxMessages    = 0;             /*!< @brief Number of message received in AntRxMessage */
+static u32 Ant_DebugTotalRxMessages    = 0;             /*!< @brief Number of good frames found by the Rx parser */
 static u32 Ant_DebugProcessRxMessages  = 0;             /*!< @brief Calls to AntProcessMessage */
 static u32 Ant_DebugQueuedDataMessages = 0;             /*!< @brief Calls to AntQueueOutgoingMessage */
 
@@ -207,6 +302,39 @@ u8 AntCalculateTxChecksum(u8* pu8Message_)
 } /* end AntCalculateTxChecksum() */
 
 
+/*!------------------------------------------------------------------------------
+@fn u8 AntBuildDataMessage(u8* pu8Target_, u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_)
+
+@brief Writes a complete Host to ANT data message into caller-provided storage.
+
+Only pu8Target_ is written, so the function is reentrant and can be used from 
+callbacks and ISRs.  The frame is ready for AntQueueOutgoingMessage().
+
+Requires:
+@param pu8Target_ points to at least MESG_DATA_SIZE + MESG_FRAME_SIZE - MESG_SYNC_SIZE bytes
+@param u8MessageId_ is the data message ID (MESG_BROADCAST_DATA_ID, MESG_ACKNOWLEDGED_DATA_ID
+       or MESG_BURST_DATA_ID)
+@param u8Channel_ is the channel byte (channel number and any sequence bits)
+@param pu8Data_ points to ANT_DATA_BYTES of payload
+
+Promises:
+- pu8Target_ holds LENGTH, ID, CHANNEL, the payload and CHECKSUM
+- Returns the number of bytes written
+
+*/
+u8 AntBuildDataMessage(u8* pu8Target_, u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_)
+{
+  pu8Target_[BUFFER_INDEX_MESG_SIZE]   = MESG_DATA_SIZE;
+  pu8Target_[BUFFER_INDEX_MESG_ID]     = u8MessageId_;
+  pu8Target_[BUFFER_INDEX_CHANNEL_NUM] = u8Channel_;
+  memcpy(&pu8Target_[BUFFER_INDEX_MESG_DATA], pu8Data_, ANT_DATA_BYTES);
+  pu8Target_[BUFFER_INDEX_MESG_DATA + ANT_DATA_BYTES] = AntCalculateTxChecksum(pu8Target_);
+  
+  return(MESG_DATA_SIZE + MESG_FRAME_SIZE - MESG_SYNC_SIZE);
+  
+} /* end AntBuildDataMessage() */
+
+
 /*!-----------------------------------------------------------------------------
 @fn bool AntQueueOutgoingMessage(u8 *pu8Message_)
 
@@ -214,9 +342,11 @@ u8 AntCalculateTxChecksum(u8* pu8Message_)
 
 If the list is full, the message is not added.
 The Outgoing message list is the list of messages sent from the Host to the ANT chip.
+Message structures come from a fixed pool of ANT_OUTGOING_MESSAGE_BUFFER_SIZE blocks,
+so the list is full when the pool is empty.
 
 Requires:
-- Enough space is available on the heap
+- NONE
 
 @param pu8Message_ is an ANT-formatted message starting with LENGTH and ending with CHECKSUM
 
@@ -230,1437 +360,3158 @@ Promises:
 bool AntQueueOutgoingMessage(u8 *pu8Message_)
 {
   u8 u8Length;
-  u8 u8MessageCount = 0;
   AntOutgoingMessageListType *psNewDataMessage;
-  AntOutgoingMessageListType *psListParser;
   
-  /* Allocate space for the new message - always do maximum message size */
-  psNewDataMessage = malloc( sizeof(AntOutgoingMessageListType) );
+  /* Take a block from the pool - always maximum message size */
+  psNewDataMessage = AntOutgoingMessageAllocate();
   if (psNewDataMessage == NULL)
   {
     DebugPrintf(Ant_au8AddMessageFailMsg);
     return(FALSE);
   }
   
-  /* Add to the number of queued message */
-  Ant_DebugQueuedDataMessages++;
-
-  /* Fill in all the fields of the newly allocated message structure */
+  /* Fill in the message data of the newly allocated message structure */
   u8Length = *pu8Message_ + 3;
   for(u8 i = 0; i < u8Length; i++)
   {
     psNewDataMessage->au8MessageData[i] = *(pu8Message_ + i);
   }
   
-  psNewDataMessage->u32TimeStamp  = G_u32SystemTime1ms;
-  psNewDataMessage->psNextMessage = NULL;
-
-  /* Insert into an empty list */
-  if(Ant_psOutgoingMsgList == NULL)
-  {
-    Ant_psOutgoingMsgList = psNewDataMessage;
-    Ant_u32OutgoingMessageCount++;
-  }
-
-  /* Otherwise traverse the list to find the end where the new message will be inserted */
-  else
-  {
-    psListParser = Ant_psOutgoingMsgList;
-    while(psListParser->psNextMessage != NULL)  
-    {
-      psListParser = psListParser->psNextMessage;
-      u8MessageCount++;
-    }
-    
-    /* Check for a full list */
-    if(u8MessageCount < ANT_OUTGOING_MESSAGE_BUFFER_SIZE)
-    {
-      /* Insert the new message at the end of the list */
-      psListParser->psNextMessage = psNewDataMessage;
-      Ant_u32OutgoingMessageCount++;
-    }
-    else
-    {
-      DebugPrintf(Ant_au8AddMessageFailMsg);
-      return(FALSE);
-    }
-  }
-    
+  AntOutgoingMessageAppend(psNewDataMessage);
   return(TRUE);
   
 } /* end AntQueueOutgoingMessage() */
 
 
 /*!-----------------------------------------------------------------------------
-@fn void AntDeQueueApplicationMessage(void)
+@fn bool AntQueueDataMessage(u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_)
 
-@brief Releases the first message in G_psAntApplicationMsgList 
+@brief Builds a data message directly in a pool block and adds it to Ant_psOutgoingMsgList.
+
+This saves the intermediate frame that AntQueueOutgoingMessage() copies from, and 
+no shared template is patched, so it can be called from a callback or an ISR.
+The pool functions restore the caller's interrupt mask, and a full pool is only
+counted (nothing is printed) since the debug output is not safe in an ISR.
 
 Requires:
-- G_psAntApplicationMsgList points to the start of the list which is the entry to remove
+@param u8MessageId_ is the data message ID (see AntBuildDataMessage())
+@param u8Channel_ is the channel byte
+@param pu8Data_ points to ANT_DATA_BYTES of payload
 
 Promises:
-- G_psAntApplicationMsgList = G_psAntApplicationMsgList.
+- Returns TRUE if the message was added to the end of Ant_psOutgoingMsgList
+- Returns FALSE if the pool is empty (u32Failures of AntQueryPoolStats() is incremented)
 
 */
-void AntDeQueueApplicationMessage(void)
+bool AntQueueDataMessage(u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_)
 {
-  AntApplicationMsgListType *psMessageToKill;
+  AntOutgoingMessageListType *psNewDataMessage;
   
-  if(G_psAntApplicationMsgList != NULL)
+  psNewDataMessage = AntOutgoingMessageAllocate();
+  if (psNewDataMessage == NULL)
   {
-    psMessageToKill = G_psAntApplicationMsgList;
-    G_psAntApplicationMsgList = G_psAntApplicationMsgList->psNextMessage;
-
-    /* The doomed message is properly disconnected, so kill it */
-    free(psMessageToKill);
-    Ant_u32ApplicationMessageCount--;
+    return(FALSE);
   }
   
-} /* end AntDeQueueApplicationMessage() */
-
-
-/*--------------------------------------------------------------------------------------------------------------------*/
-/*! @protectedsection */                                                                                            
-/*--------------------------------------------------------------------------------------------------------------------*/
-/* Protected Interface-Layer Functions */
+  AntBuildDataMessage(psNewDataMessage->au8MessageData, u8MessageId_, u8Channel_, pu8Data_);
+  AntOutgoingMessageAppend(psNewDataMessage);
+  return(TRUE);
+  
+} /* end AntQueueDataMessage() */
 
 
-/*!------------------------------------------------------------------------------
-@fn void AntInitialize(void)
+/*!-----------------------------------------------------------------------------
+@fn bool AntQueueLatestOutgoingMessage(u8 *pu8Message_)
 
-@brief Initialize the ANT system.  
+@brief Queues a data message, or replaces the one still waiting for the same channel.
 
-The ANT device is reset and communication checked through a version request.  
-The main channel parameters are then set up to default values.
+Each channel has one "latest value" slot.  If a message queued through this
+function has not started transmitting yet, it is overwritten in place so the 
+outgoing list never holds stale data for the channel and the newest value goes
+out at the next channel period.
 
-The user can override this function by holding BUTTON3
-during startup. 
-  
 Requires:
-- ANT_SPI peripheral is correctly configured
-- Debug system is initialized so debug messages can be sent to UART
+@param pu8Message_ is an ANT-formatted data message starting with LENGTH and ending with CHECKSUM
 
 Promises:
-
-If successful:
-- G_stAntSetupData set to default ANT values
-- G_u32ApplicationFlags _APPLICATION_FLAGS_ANT bit is set
-- Ant_pfnStateMachine = AntSM_Idle
-
-If failed or override:
-- G_u32SystemFlags _SYSTEM_STARTUP_NO_ANT is set;
-- G_u32ApplicationFlags  _APPLICATION_FLAGS_ANT bit remains clear
-- Ant_pfnStateMachine = AntSM_NoResponse
+- The message replaces the channel's waiting message, or is added at the end of 
+  Ant_psOutgoingMsgList and becomes the channel's waiting message
+- Returns TRUE if the message was replaced or added; FALSE if the list is full
 
 */
-void AntInitialize(void)
+bool AntQueueLatestOutgoingMessage(u8 *pu8Message_)
 {
-  /* Check for manual disabling of ANT */
-  if( ANT_BOOT_DISABLE() )
+  u8 u8Channel = pu8Message_[BUFFER_INDEX_CHANNEL_NUM] & CHANNEL_NUMBER_MASK;
+  AntOutgoingMessageListType *psMessage;
+  
+  if(u8Channel >= ANT_NUM_CHANNELS)
   {
-    G_u32SystemFlags |= _SYSTEM_STARTUP_NO_ANT;
-    DebugPrintf(G_au8AntMessageNoAnt);
-
-    /* Float all of the ANT interface lines so that the J-Link programmer 
-    or other firmware will not be impacted by the Host MCU */
-    AT91C_BASE_PIOA->PIO_PER = ANT_PIOA_PINS;
-    AT91C_BASE_PIOB->PIO_PER = ANT_PIOB_PINS;
-
-    /* Disable all outputs (set to HiZ input) */
-    AT91C_BASE_PIOA->PIO_ODR = ANT_PIOA_PINS;
-    AT91C_BASE_PIOB->PIO_ODR = ANT_PIOB_PINS;
-    
-    Ant_pfnStateMachine = AntSM_NoResponse;
+    return( AntQueueOutgoingMessage(pu8Message_) );
   }
-  /* Otherwise try to start up ANT normally */
-  else
+  
+  /* Overwrite the waiting message; the state machine only reads it from this task */
+  psMessage = Ant_apsLatestOutgoingMsg[u8Channel];
+  if(psMessage != NULL)
   {
-    /* Give PIO control of ANT_RESET line */
-    AT91C_BASE_PIOB->PIO_OER = PB_21_ANT_RESET;
-    
-    /* Announce on the debug port that ANT setup is starting and intialize pointers */
-    DebugPrintf(G_au8AntMessageInit);
-    G_psAntApplicationMsgList = 0;
-    Ant_psOutgoingMsgList = 0;
+    memcpy(psMessage->au8MessageData, pu8Message_, pu8Message_[BUFFER_INDEX_MESG_SIZE] + MESG_FRAME_SIZE - MESG_SYNC_SIZE);
+    psMessage->u32TimeStamp = G_u32SystemTime1ms;
+    Ant_u32LatestReplacedCounter++;
+    return(TRUE);
+  }
   
-    /* Initialize the G_asAntChannelConfiguration data struct */
-    for(u8 i = 0; i < ANT_NUM_CHANNELS; i++)
-    {
-      G_asAntChannelConfiguration[i].AntChannel          = (AntChannelNumberType)i;
-      G_asAntChannelConfiguration[i].AntChannelType      = ANT_CHANNEL_TYPE_DEFAULT;
-      G_asAntChannelConfiguration[i].AntNetwork          = ANT_NETWORK_DEFAULT;
-      G_asAntChannelConfiguration[i].AntDeviceIdLo       = ANT_DEVICE_ID_LO_DEFAULT;
-      G_asAntChannelConfiguration[i].AntDeviceIdHi       = ANT_DEVICE_ID_HI_DEFAULT;
-      G_asAntChannelConfiguration[i].AntDeviceType       = ANT_DEVICE_TYPE_DEFAULT;
-      G_asAntChannelConfiguration[i].AntTransmissionType = ANT_TRANSMISSION_TYPE_DEFAULT;
-      G_asAntChannelConfiguration[i].AntChannelPeriodLo  = ANT_CHANNEL_PERIOD_LO_DEFAULT;
-      G_asAntChannelConfiguration[i].AntChannelPeriodHi  = ANT_CHANNEL_PERIOD_HI_DEFAULT;
-      G_asAntChannelConfiguration[i].AntFrequency        = ANT_FREQUENCY_DEFAULT;
-      G_asAntChannelConfiguration[i].AntTxPower          = ANT_TX_POWER_DEFAULT;
-      G_asAntChannelConfiguration[i].AntFlags            = 0;
-      
-      for(u8 j = 0; j < ANT_NETWORK_NUMBER_BYTES; j++)
-      {
-        G_asAntChannelConfiguration[i].AntNetworkKey[j] = 0;
-      }
-    } 
-    
-    /* Configure the SSP resource to be used for the application */
-    Ant_sSspConfig.SspPeripheral      = ANT_SPI;
-    Ant_sSspConfig.pCsGpioAddress     = ANT_SPI_CS_GPIO;
-    Ant_sSspConfig.u32CsPin           = ANT_SPI_CS_PIN;
-    Ant_sSspConfig.eBitOrder          = SSP_LSB_FIRST;
-    Ant_sSspConfig.eSspMode           = SSP_SLAVE_FLOW_CONTROL;
-    Ant_sSspConfig.fnSlaveTxFlowCallback = AntTxFlowControlCallback;
-    Ant_sSspConfig.fnSlaveRxFlowCallback = AntRxFlowControlCallback;
-    Ant_sSspConfig.pu8RxBufferAddress = Ant_au8AntRxBuffer;
-    Ant_sSspConfig.ppu8RxNextByte     = &Ant_pu8AntRxBufferNextChar;
-    Ant_sSspConfig.u16RxBufferSize    = ANT_RX_BUFFER_SIZE;
-
-    Ant_Ssp = SspRequest(&Ant_sSspConfig);
-    ANT_SSP_FLAGS = 0;
-    
-    /* Reset ANT, activate SPI interface and get a test message */
-    AntSyncSerialInitialize();
-    
-    /* Report status out the debug port */
-    if(G_u32ApplicationFlags & _APPLICATION_FLAGS_ANT)  
-    {
-      DebugPrintf(G_au8AntMessageOk);
-      DebugPrintf("ANT version: ");
-      DebugPrintf(Ant_u8AntVersion);
-      DebugLineFeed();
-      
-      G_u32AntFlags &= ~_ANT_FLAGS_RESTART;
-      Ant_pfnStateMachine = AntSM_Idle;
-    }
-    else
-    {
-      /* The ANT device is not responding -- it may be dead, or it may not yet
-      be loaded with any firmware */
-      DebugPrintf(G_au8AntMessageInitFail);
-
-      Ant_pfnStateMachine = AntSM_NoResponse;
-    }
+  psMessage = AntOutgoingMessageAllocate();
+  if(psMessage == NULL)
+  {
+    DebugPrintf(Ant_au8AddMessageFailMsg);
+    return(FALSE);
   }
   
-} /* end AntInitialize() */
-
+  memcpy(psMessage->au8MessageData, pu8Message_, pu8Message_[BUFFER_INDEX_MESG_SIZE] + MESG_FRAME_SIZE - MESG_SYNC_SIZE);
+  AntOutgoingMessageAppend(psMessage);
+  Ant_apsLatestOutgoingMsg[u8Channel] = psMessage;
+  return(TRUE);
+  
+} /* end AntQueueLatestOutgoingMessage() */
 
-/*!----------------------------------------------------------------------------------------------------------------------
-@fn void AntRunActiveState(void)
 
-@brief Selects and runs one iteration of the current state in the state machine.
+/*!-----------------------------------------------------------------------------
+@fn void AntDeQueueApplicationMessage(void)
 
-All state machines have a TOTAL of 1ms to execute, so on average n state machines
-may take 1ms / n to execute.
+@brief Releases the oldest message in the application message ring
 
 Requires:
-- State machine function pointer points at current state
+- G_psAntApplicationMsgList points to the oldest message which is the entry to remove
 
 Promises:
-- Calls the function to pointed by the state machine function pointer
+- The oldest message is removed and G_psAntApplicationMsgList points to the next 
+  oldest message (NULL if the ring is now empty)
 
 */
-void AntRunActiveState(void)
+void AntDeQueueApplicationMessage(void)
 {
-  Ant_pfnStateMachine();
-
-} /* end AntRunActiveState */
+  if(Ant_sApplicationRingStats.u16InUse != 0)
+  {
+    Ant_u8ApplicationMsgHead++;
+    if(Ant_u8ApplicationMsgHead == ANT_APPLICATION_MESSAGE_BUFFER_SIZE)
+    {
+      Ant_u8ApplicationMsgHead = 0;
+    }
+    
+    Ant_sApplicationRingStats.u16InUse--;
+    AntUpdateApplicationMsgList();
+  }
+  
+} /* end AntDeQueueApplicationMessage() */
 
 
 /*!-----------------------------------------------------------------------------
-@fn void AntTxFlowControlCallback(void)
+@fn AntApplicationMsgListType* AntPeekApplicationMessage(void)
 
-@brief Callback function to toggle flow control during transmission.  
+@brief Returns the oldest message in the application message ring without removing it.
 
-The peripheral task sending the message must invoke this function after each byte.  
+The message can be read in place; call AntDeQueueApplicationMessage() when done with it.
 
-Note: Since this function is called from an ISR, it should execute as quickly as possible. 
+e.g.
+  AntApplicationMsgListType* psMessage;
+
+  while( (psMessage = AntPeekApplicationMessage()) != NULL )
+  {
+    // Use psMessage->eMessageType, psMessage->au8MessageData, ...
+    AntDeQueueApplicationMessage();
+  }
 
 Requires:
-- NONE 
+- NONE
 
 Promises:
-- SRDY is toggled
-- Ant_u32TxByteCounter incremented
+- Returns a pointer to the oldest message, or NULL if the ring is empty.  The
+  pointer is valid until the message is dequeued.
 
 */
-void AntTxFlowControlCallback(void)
+AntApplicationMsgListType* AntPeekApplicationMessage(void)
 {
-  /* Count the byte and toggle flow control lines */
-  Ant_u32TxByteCounter++; 
-  AntSrdyPulse();
-
-} /* end AntTxFlowControlCallback() */
+  return(G_psAntApplicationMsgList);
+  
+} /* end AntPeekApplicationMessage() */
 
 
 /*!-----------------------------------------------------------------------------
-@fn void AntRxFlowControlCallback(void)
-
-@brief Callback function used during ANT data reception.  
+@fn u8 AntReadApplicationMessages(AntApplicationMsgListType* psTarget_, u8 u8MaxMessages_)
 
-The peripheral task receiving the message must invoke this function after each byte.  
-
-Note: Since this function is called from an ISR, it should execute as quickly as possible. 
-Unfortunately, AntSrdyPulse() takes some time but the duty cycle of this interrupt
-is low enough that we can survive (this interrupt priority could be dropped below everything
-else to mitigate any issues).
+@brief Copies up to u8MaxMessages_ of the oldest application messages into the 
+caller's array and removes them from the ring in one call.
 
 Requires:
-- G_u32AntFlags _ANT_FLAGS_RX_IN_PROGRESS is correctly set
-- A received byte was just written to the Rx buffer
-- _SSP_CS_ASSERTED already in correct state: should be set on first byte, but application should 
-  clear it for all subsequent bytes so flow control is handled entirely by this function
-- ISRs are off already since this is totally not re-entrant
+@param psTarget_ points to an array with space for at least u8MaxMessages_ messages
+@param u8MaxMessages_ is the maximum number of messages to read
 
 Promises:
-- Ant_pu8AntRxBufferNextChar is advanced safely so it is ready to receive the next byte
-- Ant_u32RxByteCounter incremented
-- SRDY is toggled if _ANT_FLAGS_RX_IN_PROGRESS is set
+- Returns the number of messages copied (0 if the ring is empty); messages are
+  in the order they were received
+- The copied messages are removed from the ring
 
 */
-void AntRxFlowControlCallback(void)
+u8 AntReadApplicationMessages(AntApplicationMsgListType* psTarget_, u8 u8MaxMessages_)
 {
-  /* Count the byte and safely advance the receive buffer pointer; this is called from the
-  RX ISR, so it won't be interrupted and break Ant_pu8AntRxBufferNextChar */
-  Ant_u32RxByteCounter++;
-  Ant_pu8AntRxBufferNextChar++;
-  if(Ant_pu8AntRxBufferNextChar == &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE])
+  u8 u8Count;
+  u8 u8FirstPart;
+  
+  /* Read as many messages as are available up to the requested limit */
+  u8Count = (u8)Ant_sApplicationRingStats.u16InUse;
+  if(u8Count > u8MaxMessages_)
   {
-    Ant_pu8AntRxBufferNextChar = &Ant_au8AntRxBuffer[0];
+    u8Count = u8MaxMessages_;
   }
   
-  /* Only toggle SRDY if a reception is flagged in progress */
-  if( G_u32AntFlags & _ANT_FLAGS_RX_IN_PROGRESS )
+  if(u8Count == 0)
   {
-    AntSrdyPulse();
+    return(0);
   }
-  
-} /* end AntRxFlowControlCallback() */
 
+  /* The messages may wrap around the end of the ring so copy in up to two blocks */
+  u8FirstPart = ANT_APPLICATION_MESSAGE_BUFFER_SIZE - Ant_u8ApplicationMsgHead;
+  if(u8FirstPart > u8Count)
+  {
+    u8FirstPart = u8Count;
+  }
 
-/*--------------------------------------------------------------------------------------------------------------------*/
-/*! @privatesection */                                                                                            
-/*--------------------------------------------------------------------------------------------------------------------*/
-/* ANT private Interface-layer Functions */
-
-                                   
-/*!-----------------------------------------------------------------------------
-@fn bool AntTxMessage(u8 *pu8AntTxMessage_)
+  memcpy(psTarget_, &Ant_asApplicationMsgRing[Ant_u8ApplicationMsgHead], 
+         u8FirstPart * sizeof(AntApplicationMsgListType));
+  memcpy(psTarget_ + u8FirstPart, &Ant_asApplicationMsgRing[0], 
+         (u8Count - u8FirstPart) * sizeof(AntApplicationMsgListType));
+  
+  /* Release the messages that were read */
+  Ant_u8ApplicationMsgHead = (Ant_u8ApplicationMsgHead + u8Count) % ANT_APPLICATION_MESSAGE_BUFFER_SIZE;
+  Ant_sApplicationRingStats.u16InUse -= u8Count;
+  AntUpdateApplicationMsgList();
+  
+  return(u8Count);
+  
+} /* end AntReadApplicationMessages() */
 
-@brief Send a message from the Host to the ANT device.  
 
-To do this, we must tell ANT that we have a message to send by asserting MRDY, 
-wait for ANT to acknowledge with SEN, then read a byte from ANT to confirm the 
-transmission can proceed.  If ANT wants to send a message at the
-same time, the byte it sends will be an Rx byte so the AntTxMessage must suspend 
-and go read the incoming message first.  The Tx process would restart after 
-ANT's message has been received by the host.
+/*!-----------------------------------------------------------------------------
+@fn void AntQueryPoolStats(AntPoolStatsType* psOutgoingStats_, AntPoolStatsType* psApplicationStats_)
 
-Once ANT confirms that the Host may transmit, the message to transmit is queued 
-and data is sent byte-by-byte with SRDY used for flow control after each byte.  
-Due to the speed of the chip-to-chip communications, even the longest ANT message
-should be able to send in less than 500us so it will likely be done on the main 
-program cycle that immediately follows this call.  
+@brief Reports usage of the outgoing message pool and the application message ring.
 
 Requires:
-@param pu8AntTxMessage_ points to an Ant formatted message where the first data byte
-       is the length byte (since ANT sends the SYNC byte) and the last byte is
-       the checksum.
+@param psOutgoingStats_ points to space for the outgoing pool statistics (NULL to skip)
+@param psApplicationStats_ points to space for the application ring statistics (NULL to skip)
 
 Promises:
-- MRDY is de-asserted
-- Returns TRUE if the transmit message is queued successfully; Ant_u32CurrentTxMessageToken holds the message token
-- Returns FALSE if the transfer couldn't start or if receive message interrupted
-  (G_u32AntFlags _ANT_FLAGS_TX_INTERRUPTED is set;  AntRxBufferCurrentChar pointing to the received byte).
+- The current statistics of each requested pool are copied to the targets
 
 */
-static bool AntTxMessage(u8 *pu8AntTxMessage_)
+void AntQueryPoolStats(AntPoolStatsType* psOutgoingStats_, AntPoolStatsType* psApplicationStats_)
 {
-  u8 u8Byte;
-  u32 u32Length;
-  u8 au8TxInProgressMsg[] = "AntTx: msg already in progress\n\r";
-  u8 au8TxTimeoutMsg[]    = "AntTx: SEN timeout\n\r";
-  u8 au8TxNoTokenMsg[]    = "AntTx: No token\n\r";
-  u8 au8TxNoSyncMsg[]     = "AntTx: No SYNC\n\r";
-
-  /* Check G_u32AntFlags first to ensure a transmission is not already taking place */
-  if(G_u32AntFlags & (_ANT_FLAGS_TX_IN_PROGRESS | _ANT_FLAGS_RX_IN_PROGRESS) )
+  if(psOutgoingStats_ != NULL)
   {
-    DebugPrintf(au8TxInProgressMsg);
-    return FALSE;
+    *psOutgoingStats_ = Ant_sOutgoingPoolStats;
   }
-  
-  /* Initialize the timeout timer and notify ANT that the Host wishes to send a message */
-  Ant_u32RxTimer = 0;
-  SYNC_MRDY_ASSERT();                          
 
-  /* Wait for SEN to be asserted indicating ANT is ready for a message */
-  while ( !IS_SEN_ASSERTED() && (Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT) )
-  {
-    Ant_u32RxTimer++;
-  }
-  
-  /* If we timed out, then clear MRDY and exit */
-  if(Ant_u32RxTimer > ANT_ACTIVITY_TIME_COUNT)
+  if(psApplicationStats_ != NULL)
   {
-    SYNC_MRDY_DEASSERT();                          
-    DebugPrintf(au8TxTimeoutMsg);
-    return(FALSE);
+    *psApplicationStats_ = Ant_sApplicationRingStats;
   }
   
-  /* Else we have SEN flag; queue to read 1 byte after a short delay before toggling SRDY */
-  AntSrdyPulse();
+} /* end AntQueryPoolStats() */
 
-  /* Wait for the first byte to come in via the ISR / Rx Callback*/
-  while( !(ANT_SSP_FLAGS & _SSP_RX_COMPLETE) && (Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT) )
-  {
-    Ant_u32RxTimer++;
-  }
 
-  /* Ok to deassert MRDY now */
-  SYNC_MRDY_DEASSERT();                     
+/*!-----------------------------------------------------------------------------
+@fn void AntQueryThroughputStats(AntThroughputStatsType* psStats_)
 
-  /* If we timed out now, then clear MRDY and exit.  Because CS is still asserted, the task
-  will attempt to read a message but fail and eventually abort. */
-  if(Ant_u32RxTimer > ANT_ACTIVITY_TIME_COUNT)
-  {
-   DebugPrintf(au8TxTimeoutMsg);
-   return(FALSE);
-  }
-          
-  /* When the byte comes in, the SSP module will set the _SSP_RX_COMPLETE flag and also call the 
-  Rx callback but does not toggle SRDY at this time.  We must look at this byte to determine if ANT 
-  initiated this particular communication and is telling us that a message is coming in, or if we 
-  initiated the communication and ANT is allowing us to transmit. */
+@brief Reports the message rates, the deepest outgoing list and the CPU cost of 
+processing received frames.
 
-  /* Read the byte - don't advance the pointer yet */
-  u8Byte = *Ant_pu8AntRxBufferCurrentChar;                       
+These are measured on the target with the real nRF51422, so a load test (see 
+AntLoadTestStart()) shows how the Host code paths behave at a given message rate.
+Cycle counts come from SysTick and have a resolution of SYSTICK_DIVIDER cycles.  
+Time in interrupts that run during AntProcessMessage() is included.
 
-  /* If the byte is TX_SYNC, then ANT wants to send a message which must be done first */
-  if (u8Byte == MESG_TX_SYNC)                     
-  {
-    G_u32AntFlags |= _ANT_FLAGS_TX_INTERRUPTED;
-    return(FALSE);
-  }
+Requires:
+@param psStats_ points to space for the statistics
 
-  /* Since the Rx byte is in our Rx buffer, advance both pointers since it's not an incoming message */
-  AdvanceAntRxBufferCurrentChar();
-  AdvanceAntRxBufferUnreadMsgPointer();
+Promises:
+- The statistics since the last AntResetThroughputStats() are copied to psStats_
 
-  /* Clear the status flag and process the byte */
-  ANT_SSP_FLAGS &= ~_SSP_RX_COMPLETE;
+*/
+void AntQueryThroughputStats(AntThroughputStatsType* psStats_)
+{
+  *psStats_ = Ant_sThroughputStats;
   
-  /* If the byte is RX_SYNC, then proceed to send the message */
-  if (u8Byte == MESG_RX_SYNC)                     
+  psStats_->u32RxCyclesAverage = 0;
+  if(Ant_sThroughputStats.u32RxMessages != 0)
   {
-    /* Flag that a transmit is in progress */
-    G_u32AntFlags |= _ANT_FLAGS_TX_IN_PROGRESS;
-    
-    /* Read the message length and add three for the length, message ID and checksum */
-    u32Length = (u32)(pu8AntTxMessage_[0] + 3); 
-    
-    /* Queue the message to the peripheral and capture the token */ 
-    Ant_u32CurrentTxMessageToken = SspWriteData(Ant_Ssp, u32Length, pu8AntTxMessage_);
-
-    /* Return TRUE only if we received a message token indicating the message has been queued */
-    if(Ant_u32CurrentTxMessageToken != 0)
-    {
-      return(TRUE);
-    }
-    else
-    {
-      DebugPrintf(au8TxNoTokenMsg);
-      return(FALSE);
-    }
+    psStats_->u32RxCyclesAverage = Ant_u32RxCyclesTotal / Ant_sThroughputStats.u32RxMessages;
   }
+  
+} /* end AntQueryThroughputStats() */
 
-  /* If we get here, not a sync byte, so return */
-  DebugPrintf(au8TxNoSyncMsg);
-  return(FALSE);
 
-} /* end AntTxMessage() */
+/*!-----------------------------------------------------------------------------
+@fn void AntResetThroughputStats(void)
+
+@brief Clears the throughput statistics and starts a new rate window.
+
+Requires:
+- NONE
+
+Promises:
+- Ant_sThroughputStats and the window counters are zero
+
+*/
+void AntResetThroughputStats(void)
+{
+  memset(&Ant_sThroughputStats, 0, sizeof(AntThroughputStatsType));
+  Ant_u32RxCyclesTotal = 0;
+  Ant_u16TxThisPeriod = 0;
+  Ant_u16RxThisPeriod = 0;
+  Ant_u32ThroughputTimer = G_u32SystemTime1ms;
+  
+} /* end AntResetThroughputStats() */
 
 
 /*!-----------------------------------------------------------------------------
-@fn static void AntRxMessage(void)
+@fn bool AntBurstTxStart(AntChannelNumberType eChannel_, u8* pu8Data_, u16 u16Length_)
+
+@brief Starts sending a buffer as ANT burst data.
 
-@brief Completely receive a message from ANT to the Host.  
+The buffer is split into bursts of ANT_BURST_CHUNK_PACKETS packets that are fed 
+to the outgoing message list a few at a time from AntSM_Idle so other messages
+still get through.  The first packet of each burst is a header with the offset of
+the burst's data and the total length so AntBurstRxStart() on the other end can
+reassemble the whole buffer.  A burst that fails is sent again from its header up 
+to ANT_BURST_MAX_RETRIES times.  Progress is reported by AntBurstQueryStatus().
 
-Incoming bytes are deposited directly into the receive buffer from the SSP ISR 
-which should be extremely fast and complete in a maximum of 500us.  
+The header packet is not part of the ANT burst format: a receiver that is not
+using AntBurstRxStart() sees it as the first 8 bytes of every burst.
+
+EVENT_TRANSFER_TX_COMPLETED and EVENT_TRANSFER_TX_FAILED do not say which transfer
+they belong to, so a burst is not started while tracked acknowledged messages 
+(AntQueueTrackedAckMessage()) are pending on the channel, and none are accepted 
+while the burst runs.  Untracked acknowledged messages must not be sent on the
+channel during a burst either.
 
 Requires:
-- _SSP_CS_ASSERTED is set indicating a message is ready to come in 
-- ANT SSP receive interrupt is active
-- G_u32AntFlags _ANT_FLAGS_TX_INTERRUPTED is set if the system wanted to transmit
-  but ANT wanted to send a message at the same time (so MESG_TX_SYNC has already 
-  been received); _SSP_RX_COMPLETE must still be set from this.
-- Ant_pu8AntRxBufferCurrentChar points to the first byte of the message
+- eChannel_ is open
+- No other burst transmission is in progress
+
+@param eChannel_ is the channel to send on
+@param pu8Data_ points to the data which must not change until the transfer is 
+       ANT_BURST_DONE or ANT_BURST_FAILED
+@param u16Length_ is the number of bytes to send (the last packet is zero-padded)
 
 Promises:
-- If a good new message has been received, then Ant_u8AntNewMessages is incremented
-  and the message is at Ant_pu8AntRxBufferUnreadMsg in Ant_au8AntRxBuffer
-- If a good message is not received, then Ant_u8AntNewMessages is unchanged.
-- In both cases, Ant_pu8AntRxBufferNextChar points at the next empty buffer location
+- Returns TRUE and the transfer is ANT_BURST_BUSY if it was started
+- Returns FALSE if another transfer is in progress, a tracked acknowledged message
+  is pending on eChannel_ or the arguments are invalid
 
 */
-static void AntRxMessage(void)
+bool AntBurstTxStart(AntChannelNumberType eChannel_, u8* pu8Data_, u16 u16Length_)
 {
-  u8 u8Checksum;
-  u8 u8Length;
-  u32 u32CurrentRxByteCount;
-  u8 au8RxTimeoutMsg[] = "AntRx: timeout\n\r";
-  u8 au8RxFailMsg[]    = "AntRx: message failed\n\r";
-  bool bReceptionError = FALSE;
-  
-  /* Ensure we have SEN */
-  if( !( IS_SEN_ASSERTED() ) )
+  if( ((u8)eChannel_ >= ANT_NUM_CHANNELS) || (Ant_sBurstStatus.eTxState == ANT_BURST_BUSY) ||
+      (pu8Data_ == NULL) || (u16Length_ == 0) || AntApiAckPending((u8)eChannel_) )
   {
-    return;
+    return(FALSE);
   }
- 
-  /* Initialize the receive timer and get a snapshot of current byte count */
-  u32CurrentRxByteCount = Ant_u32RxByteCounter;
-  Ant_u32RxTimer = 0;
   
-  /* If the Global _ANT_FLAGS_TX_INTERRUPTED flag has been set, then we have already read the TX_SYNC byte */
-  if(G_u32AntFlags & _ANT_FLAGS_TX_INTERRUPTED)
+  Ant_eBurstTxChannel      = eChannel_;
+  Ant_pu8BurstTxData       = pu8Data_;
+  Ant_u16BurstTxChunkStart = 0;
+  Ant_u16BurstTxNextByte   = 0;
+  Ant_u8BurstTxSequence    = 0;
+  Ant_u8BurstTxAttempts    = 0;
+  
+  Ant_sBurstStatus.u16TxLength    = u16Length_;
+  Ant_sBurstStatus.u16TxBytesSent = 0;
+  Ant_sBurstStatus.u16TxRetries   = 0;
+  Ant_sBurstStatus.eTxState       = ANT_BURST_BUSY;
+  
+  return(TRUE);
+  
+} /* end AntBurstTxStart() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn bool AntBurstRxStart(AntChannelNumberType eChannel_, u8* pu8Buffer_, u16 u16Size_)
+
+@brief Arms (or disarms) reassembly of incoming burst data on a channel.
+
+While armed, burst packets on eChannel_ are written to pu8Buffer_ instead of the
+application message list.  The header packet of each burst says where its data goes,
+so a transfer sent with AntBurstTxStart() is put back together across bursts.  
+The data should be used when AntBurstQueryStatus() reports ANT_BURST_DONE since the
+next transfer starts again at the beginning of the buffer.
+
+Requires:
+@param eChannel_ is the channel to receive on
+@param pu8Buffer_ points to the receive buffer, or NULL to disarm
+@param u16Size_ is the size of pu8Buffer_ in bytes
+
+Promises:
+- Returns TRUE and the receive state is ANT_BURST_IDLE if armed or disarmed
+- Returns FALSE if eChannel_ is not a valid channel or u16Size_ cannot hold one 
+  burst packet
+
+*/
+bool AntBurstRxStart(AntChannelNumberType eChannel_, u8* pu8Buffer_, u16 u16Size_)
+{
+  if( ((u8)eChannel_ >= ANT_NUM_CHANNELS) ||
+      ((pu8Buffer_ != NULL) && (u16Size_ < ANT_BURST_PACKET_BYTES)) )
   {
-    /* Clear flag and adjust the starting byte counter since the message came in during AntTxMessage*/
-    G_u32AntFlags &= ~_ANT_FLAGS_TX_INTERRUPTED;
-    u32CurrentRxByteCount--;
-    
+    return(FALSE);
   }
-  /* Otherwise we need to first read the sync byte  */
-  else
-  {
-    /* Cycle SRDY to get the first byte */
-    AntSrdyPulse();
+  
+  Ant_eBurstRxChannel    = eChannel_;
+  Ant_pu8BurstRxBuffer   = pu8Buffer_;
+  Ant_u16BurstRxSize     = u16Size_;
+  Ant_u16BurstRxNextByte = 0;
+  Ant_u8BurstRxSequence  = 0;
+  
+  Ant_sBurstStatus.u16RxLength   = 0;
+  Ant_sBurstStatus.u16RxBytes    = 0;
+  Ant_sBurstStatus.u16RxFailures = 0;
+  Ant_sBurstStatus.eRxState      = ANT_BURST_IDLE;
 
-    /* Begin the receive cycle that takes place using interrupts and callbacks and is monitored by a timeout of 
-    about 500us - this should be plenty of time to receive even the longest ANT message but still only half the 
-    allowed 1ms loop time for the system. */
-    
-    /* Read the first byte when it comes in */
-    while( !(ANT_SSP_FLAGS & _SSP_RX_COMPLETE) &&
-           (Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT) )
-    {
-      Ant_u32RxTimer++;
-    }
-  }
+  return(TRUE);
   
-  if( Ant_u32RxTimer > ANT_ACTIVITY_TIME_COUNT) 
-  {
-    AntAbortMessage();
-    DebugPrintf(au8RxTimeoutMsg);
-    return;
-  }
+} /* end AntBurstRxStart() */
 
-  /* _SSP_RX_COMPLETE flag will be set and the Rx callback will have run.  
-  The callback does NOT toggle SRDY yet.  _SSP_RX_COMPLETE should still
-  be set from AntTxMessage if that's what got us here. */
-  ANT_SSP_FLAGS &= ~_SSP_RX_COMPLETE;
-   
-  /* One way or the other, we now have a potential SYNC byte at Ant_pu8AntRxBufferCurrentChar.  
-  Proceed to test it and receive the rest of the message */
-  if (*Ant_pu8AntRxBufferCurrentChar == MESG_TX_SYNC)                     
-  {
-    /* Flag that a reception is in progress */
-    G_u32AntFlags |= _ANT_FLAGS_RX_IN_PROGRESS;
-    
-    /* Cycle SRDY to get the next byte (length) */
-    AntSrdyPulse();
-    
-    /* We block here while the SSP interrupts and Rx callback handle the rest of the reception until a full 
-    message is received. We know it is received when SEN is deasserted. This takes about 500us */
-    while( IS_SEN_ASSERTED() && (Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT) )
-    {
-      Ant_u32RxTimer++;
-    }
+
+/*!-----------------------------------------------------------------------------
+@fn void AntBurstQueryStatus(AntBurstStatusType* psStatus_)
+
+@brief Reports the progress and error counters of the burst engines.
+
+Requires:
+@param psStatus_ points to space for the status
+
+Promises:
+- The current burst status is copied to psStatus_
+
+*/
+void AntBurstQueryStatus(AntBurstStatusType* psStatus_)
+{
+  *psStatus_ = Ant_sBurstStatus;
   
-    /* One way or another, this Rx is done! */
-    G_u32AntFlags &= ~_ANT_FLAGS_RX_IN_PROGRESS;
-    ANT_SSP_FLAGS &= ~_SSP_RX_COMPLETE;
+} /* end AntBurstQueryStatus() */
 
-    /* Check that the above loop ended as expected and didn't time out */
-    if(Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT)
-    {  
-      /* Update counter to see how many bytes we should have */
-      u32CurrentRxByteCount = Ant_u32RxByteCounter - u32CurrentRxByteCount;
-    
-      /* RxBufferCurrentChar is still pointing to the SYNC byte. Validate what should be a complete message now. */
-      u8Checksum = *Ant_pu8AntRxBufferCurrentChar;
-      AdvanceAntRxBufferCurrentChar();
-      
-      /* Read the length byte and add two to count the length byte and message ID but not checksum as length will be our checksum counter */
-      u8Length = *Ant_pu8AntRxBufferCurrentChar + 2;  
-      
-      /* Optional check (u8Length does not include the SYNC byte or Checksum byte so add 2) */
-      if(u32CurrentRxByteCount != (u8Length + 2) )
-      {
-        /* Could throw out the message right away - this could save some potential weird memory accesses
-        if there was any corruption or a wild u8Length value */
-        G_u32AntFlags |= _ANT_FLAGS_LENGTH_MISMATCH;
-      }
- 
-      /* Validate the remaining bytes based on u8Length*/
-      do
-      {
-        u8Checksum ^= *Ant_pu8AntRxBufferCurrentChar;                     
-        AdvanceAntRxBufferCurrentChar();
-      } while (--u8Length);
-      
-      /* AntRxBufferCurrentChar is pointing to the last received byte that should be the checksum. */
-      if (u8Checksum == *Ant_pu8AntRxBufferCurrentChar)      
-      {
-        Ant_u8AntNewRxMessages++;
-        Ant_DebugTotalRxMessages++;
-      }
-      /* If the message was not good, then move Ant_pu8AntRxBufferUnreadMsg passed the garbage data */
-      else
-      {
-        Ant_pu8AntRxBufferUnreadMsg = Ant_pu8AntRxBufferCurrentChar;
-        AdvanceAntRxBufferUnreadMsgPointer();
-      }
-    } /* end if(Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT) */
-    else
-    {
-      /* Advance the timeout tick */
-      Ant_u32RxTimeoutCounter++;
-      bReceptionError = TRUE;
-    }
-  } /* end if(*Ant_pu8AntRxBufferCurrentChar == MESG_TX_SYNC) */
-  else
-  {
-    /* Otherwise we have received an unexpected byte -- flag it, clear Ssp flags and abandon the byte */
-    Ant_u32UnexpectedByteCounter++;
-    bReceptionError = TRUE;
-  }
 
-  /* Handle a reception error if it occured */
-  if(bReceptionError)
-  {
-    /* Toggle SRDY until CS deasserts and throw out the message */
-    DebugPrintf(au8RxFailMsg);
-    while( IS_SEN_ASSERTED()  && (Ant_u32RxTimer < ANT_ACTIVITY_TIME_COUNT) )
-    {
-      Ant_u32RxTimer++;
-      AntSrdyPulse();
-    }
-   
-    /* Since we have flow control, we can safely assume that no other messages
-    have come in and Ant_pu8AntRxBufferNextChar is pointing to where the next 
-    valid message WILL come in - so push all the pointers there. */
-    Ant_pu8AntRxBufferCurrentChar = Ant_pu8AntRxBufferNextChar;
-    Ant_pu8AntRxBufferUnreadMsg = Ant_pu8AntRxBufferNextChar;
-    ANT_SSP_FLAGS &= ~(_SSP_TX_COMPLETE | _SSP_RX_COMPLETE);
+/*!-----------------------------------------------------------------------------
+@fn bool AntBurstTxActive(AntChannelNumberType eChannel_)
+
+@brief Reports if a burst is being sent on a channel.
+
+Requires:
+@param eChannel_ is the channel to check
+
+Promises:
+- Returns TRUE if the outgoing burst transfer is ANT_BURST_BUSY on eChannel_
+
+*/
+bool AntBurstTxActive(AntChannelNumberType eChannel_)
+{
+  return( (Ant_sBurstStatus.eTxState == ANT_BURST_BUSY) && (Ant_eBurstTxChannel == eChannel_) );
+  
+} /* end AntBurstTxActive() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn bool AntRegisterChannelHandler(AntChannelNumberType eChannel_, u8 u8MessageMask_, AntChannelHandlerType pfnHandler_)
+
+@brief Routes the application messages of one channel straight to a task's handler.
+
+Messages of the types selected by u8MessageMask_ are handed to pfnHandler_ 
+from AntProcessMessage() instead of being added to the application message ring,
+so tasks sharing the radio do not have to filter (or consume) each other's messages.
+Types not in the mask still go to the ring.
+
+Requires:
+- pfnHandler_ is short: it runs in the ANT task and the message is only valid 
+  during the call
+
+@param eChannel_ is the channel to route
+@param u8MessageMask_ is a combination of _ANT_HANDLER_MASK_DATA and _ANT_HANDLER_MASK_TICK
+@param pfnHandler_ is the function to call, or NULL to send the channel's messages
+       to the application ring again
+
+Promises:
+- Returns TRUE and the handler for eChannel_ is replaced
+- Returns FALSE if eChannel_ is not a valid channel
 
+*/
+bool AntRegisterChannelHandler(AntChannelNumberType eChannel_, u8 u8MessageMask_, AntChannelHandlerType pfnHandler_)
+{
+  if((u8)eChannel_ >= ANT_NUM_CHANNELS)
+  {
+    return(FALSE);
   }
-  /* No reception error: */
-  else
+  
+  if(pfnHandler_ == NULL)
   {
-    /* Finish by advancing the current byte pointer */
-    AdvanceAntRxBufferCurrentChar();
+    u8MessageMask_ = 0;
   }
   
-} /* end AntRxMessage() */
+  Ant_asChannelHandlers[eChannel_].pfnHandler    = pfnHandler_;
+  Ant_asChannelHandlers[eChannel_].u8MessageMask = u8MessageMask_;
+  
+  return(TRUE);
+  
+} /* end AntRegisterChannelHandler() */
 
 
 /*!-----------------------------------------------------------------------------
-@fn static void AntAbortMessage(void)
+@fn void AntDeviceTableSetMode(AntDeviceTableModeType eMode_)
 
-@brief Kills the current message in progress with ANT and resets all of the pointers.
+@brief Turns the device table on or off.
 
-Any existing received buffer data is lost.  Interrupts are disabled
-during this time to ensure pointers do not get moved by
-an outside function.  
+With the table on, every data message that carries a device ID in its extended 
+data (e.g. from AntOpenScanningChannel()) updates the device's entry.  In 
+ANT_DEVICE_TABLE_ONLY mode those messages are not added to the application ring.
+Turning the table off keeps the entries until AntDeviceTableClear().
 
 Requires:
-- NONE 
+@param eMode_ is the new table mode
 
 Promises:
-- Ant_pu8AntRxBufferNextChar, Ant_pu8AntRxBufferCurrentChar, Ant_pu8AntRxBufferUnreadMsg,
-  and Ant_u8AntNewRxMessages reset.
+- Ant_eDeviceTableMode = eMode_
 
 */
-static void AntAbortMessage(void)
+void AntDeviceTableSetMode(AntDeviceTableModeType eMode_)
 {
-  __disable_irq();
-  Ant_pu8AntRxBufferNextChar = &Ant_au8AntRxBuffer[0];
-  Ant_pu8AntRxBufferCurrentChar = &Ant_au8AntRxBuffer[0];
-  Ant_pu8AntRxBufferUnreadMsg = &Ant_au8AntRxBuffer[0];
-  Ant_u8AntNewRxMessages = 0;
-  __enable_irq();
+  Ant_eDeviceTableMode = eMode_;
   
-} /* end AntAbortMessage() */
+} /* end AntDeviceTableSetMode() */
 
 
 /*!-----------------------------------------------------------------------------
-@fn static void AdvanceAntRxBufferCurrentChar(void)
+@fn void AntDeviceTableClear(void)
 
-@brief Safely advances Ant_pu8AntRxBufferCurrentChar within the circular buffer
+@brief Empties the device table.
 
 Requires:
-- No interrupt functions may use Ant_pu8AntRxBufferCurrentChar 
+- NONE
 
 Promises:
-- Ant_pu8AntRxBufferCurrentChar points to the next char to write in Ant_au8AntRxBuffer
+- All entries are removed and all hash buckets are empty
 
 */
-static void AdvanceAntRxBufferCurrentChar(void)
+void AntDeviceTableClear(void)
 {
-  Ant_pu8AntRxBufferCurrentChar++;
-  if(Ant_pu8AntRxBufferCurrentChar == &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE])
+  for(u8 i = 0; i < ANT_DEVICE_HASH_BUCKETS; i++)
   {
-    Ant_pu8AntRxBufferCurrentChar = &Ant_au8AntRxBuffer[0];
+    Ant_au8DeviceHashBuckets[i] = ANT_DEVICE_NONE;
   }
   
-} /* end AdvanceAntRxBufferCurrentChar() */
+  Ant_u8DeviceTableCount = 0;
+  Ant_u8DeviceLruHead = ANT_DEVICE_NONE;
+  Ant_u8DeviceLruTail = ANT_DEVICE_NONE;
+  
+} /* end AntDeviceTableClear() */
 
 
-/*!-----------------------------------------------------------------------------/
-@fn static void AdvanceAntRxBufferUnreadMsgPointer(void)
+/*!-----------------------------------------------------------------------------
+@fn u8 AntDeviceTableCount(void)
 
-@brief Increments Ant_pu8AntRxBufferUnreadMsg and handles the wrap-around.
+@brief Returns the number of devices in the table.
 
 Requires:
-- Ant_pu8AntRxBufferUnreadMsg cannot be moved in an ISR
+- NONE
 
 Promises:
-- Ant_pu8AntRxBufferUnreadMsg points to the next char in the circular buffer
+- Returns the number of entries in use (at most ANT_DEVICE_TABLE_SIZE)
 
 */
-static void AdvanceAntRxBufferUnreadMsgPointer(void)
+u8 AntDeviceTableCount(void)
 {
-  Ant_pu8AntRxBufferUnreadMsg++;
-  if (Ant_pu8AntRxBufferUnreadMsg == &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE])
-  {
-    Ant_pu8AntRxBufferUnreadMsg = &Ant_au8AntRxBuffer[0];
-  }
+  return(Ant_u8DeviceTableCount);
   
-} /* end AdvanceAntRxBufferUnreadMsgPointer() */
+} /* end AntDeviceTableCount() */
 
 
-/*!------------------------------------------------------------------------------
-@fn u8 AntExpectResponse(u8 u8ExpectedMessageID_, u32 u32TimeoutMS_) 
+/*!-----------------------------------------------------------------------------
+@fn bool AntDeviceTableFind(u16 u16DeviceID_, u8 u8DeviceType_, AntDeviceInfoType* psInfo_)
 
-@brief Waits a specified amount of time for a particular message to arrive from ANT in 
-response to a message sent to ANT. ***This function violates the 1ms system rule, 
-so should only be used during initialization.***
+@brief Looks up one device without touching its LRU position.
 
-The expected message could be a response event, or it could be the complete
-message that was expected.
-  
 Requires:
-- A message had been sent to ANT to which a response should be coming in
-- Ant_u8AntNewRxMessages == 0 as this function is meant to run one-to-one with
-  transmitted messages.
-- SSP task should be in manual mode so it is busy sending the Tx message to which
-  this function will wait for the ANT response.
-
-@param u8ExpectedMessageID_ is the ID of a message to which a response is expected
-@param u32TimeoutMS_ is the maximum value in ms to wait for the response 
+@param u16DeviceID_ is the device number to find
+@param u8DeviceType_ is the device type to find
+@param psInfo_ points to space for the device information
 
 Promises:
-- Returns 0 if the message is received and was successful
-- Returns 1 if a response is never received or if the response indicates the
-  message was not successful.
+- Returns TRUE and copies the entry to psInfo_ if the device is in the table
+- Returns FALSE otherwise (psInfo_ unchanged)
 
 */
-static u8 AntExpectResponse(u8 u8ExpectedMessageID_, u32 u32TimeoutMS_) 
+bool AntDeviceTableFind(u16 u16DeviceID_, u8 u8DeviceType_, AntDeviceInfoType* psInfo_)
 {
-  bool bTimeout = FALSE;
-  u8 u8ReturnValue = 1;
-  u32 u32StartTime = G_u32SystemTime1ms;
-
-  /* Wait for current message to send */
-  while( IS_SEN_ASSERTED() && !bTimeout )
+  u8 u8Index = AntDeviceTableLookup(u16DeviceID_, u8DeviceType_);
+  
+  if(u8Index == ANT_DEVICE_NONE)
   {
-    bTimeout = IsTimeUp(&u32StartTime, ANT_MSG_TIMEOUT_MS);
+    return(FALSE);
   }
+  
+  *psInfo_ = Ant_asDeviceTable[u8Index].sInfo;
+  return(TRUE);
+  
+} /* end AntDeviceTableFind() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn u8 AntDeviceTableRead(AntDeviceInfoType* psTarget_, u8 u8MaxDevices_)
+
+@brief Copies the current device population, most recently heard first.
+
+Requires:
+@param psTarget_ points to an array of at least u8MaxDevices_ entries
+@param u8MaxDevices_ is the maximum number of devices to copy
+
+Promises:
+- Returns the number of devices copied to psTarget_
 
-  if( !bTimeout )
+*/
+u8 AntDeviceTableRead(AntDeviceInfoType* psTarget_, u8 u8MaxDevices_)
+{
+  u8 u8Count = 0;
+  u8 u8Index = Ant_u8DeviceLruHead;
+  
+  while( (u8Index != ANT_DEVICE_NONE) && (u8Count < u8MaxDevices_) )
   {
-    /* Done with this message token, so it can be cleared */
-    G_u32AntFlags &= ~_ANT_FLAGS_TX_IN_PROGRESS;
-    AntDeQueueOutgoingMessage();
-    Ant_u32CurrentTxMessageToken = 0;
-    
-    /* Wait for SEN */
-    u32StartTime = G_u32SystemTime1ms;
-    while( !IS_SEN_ASSERTED() && !bTimeout )
-    {
-      bTimeout = IsTimeUp(&u32StartTime, ANT_MSG_TIMEOUT_MS);
-    }
+    psTarget_[u8Count] = Ant_asDeviceTable[u8Index].sInfo;
+    u8Count++;
+    u8Index = Ant_asDeviceTable[u8Index].u8LruNext;
   }
   
-  /* If no timeout then read the incoming message */
-  if( !bTimeout )
-  {
-    AntRxMessage();
+  return(u8Count);
+  
+} /* end AntDeviceTableRead() */
 
-    /* If there is a new message in the receive buffer, then check that it is a response to the expected
-    message and that the response is no error */
-    if(Ant_u8AntNewRxMessages)
-    {
-#if 0 
-     /* Check if the response is an Event, the event is a reply to the expected message, and the reply is good.
-      Since Ant_pu8AntRxBufferUnreadMsg is pointing to the SYNC byte, add 1 when using BUFFER_INDEX values. */
-      if( (*(Ant_pu8AntRxBufferUnreadMsg + MESG_ID_OFFSET) == MESG_RESPONSE_EVENT_ID) &&    
-          (*(Ant_pu8AntRxBufferUnreadMsg + MESG_RESPONSE_MESG_ID_OFFSET) == u8ExpectedMessageID_) &&
-          (*(Ant_pu8AntRxBufferUnreadMsg + MESG_RESPONSE_CODE_OFFSET) == RESPONSE_NO_ERROR) )
-      {
-        u8ReturnValue = 0;
-      }
-#endif
-      /* 2017-11-18 Fix to handle Events and responses but also just message replys so ExpectResponse will
-      still return correctly for regular messages */
 
-      /* Check if the response is an Event */
-      if( *(Ant_pu8AntRxBufferUnreadMsg + MESG_ID_OFFSET) == MESG_RESPONSE_EVENT_ID )
-      {
-        /* For Event messages, check if it is a reply to the expected message and the reply is good. */
-        if( (*(Ant_pu8AntRxBufferUnreadMsg + MESG_RESPONSE_MESG_ID_OFFSET) == u8ExpectedMessageID_) &&
-            (*(Ant_pu8AntRxBufferUnreadMsg + MESG_RESPONSE_CODE_OFFSET)    == RESPONSE_NO_ERROR   ) )
-        {
-          u8ReturnValue = 0;
-        }
-      }
-      /* If not an event, the message should be a response to the requested message */
-      else if ( *(Ant_pu8AntRxBufferUnreadMsg + MESG_ID_OFFSET) == u8ExpectedMessageID_)
-      {
-        u8ReturnValue = 0;
-      }
-        
-    } /* end if(!bTimeout) */
+/*!-----------------------------------------------------------------------------
+@fn bool AntQueryLinkStats(AntChannelNumberType eChannel_, AntLinkStatsType* psStats_)
+
+@brief Reports the link quality counters of a channel.
+
+Comparing the counters over time for different channel periods and frequencies
+shows which settings give the best link.
+
+Requires:
+@param eChannel_ is the channel to report
+@param psStats_ points to space for the counters
+
+Promises:
+- Returns TRUE and the counters of eChannel_ since the last AntResetLinkStats() 
+  are copied to psStats_
+- Returns FALSE and psStats_ is unchanged if eChannel_ is not a valid channel
+
+*/
+bool AntQueryLinkStats(AntChannelNumberType eChannel_, AntLinkStatsType* psStats_)
+{
+  if((u8)eChannel_ >= ANT_NUM_CHANNELS)
+  {
+    return(FALSE);
   }
   
-  /* Process any message in the RxBuffer and return the result value */
-  AntProcessMessage();
-  return(u8ReturnValue);
+  *psStats_ = Ant_asLinkStats[eChannel_];
+  return(TRUE);
+  
+} /* end AntQueryLinkStats() */
 
-} /* end AntExpectResponse */
 
+/*!-----------------------------------------------------------------------------
+@fn bool AntResetLinkStats(AntChannelNumberType eChannel_)
 
-/*!------------------------------------------------------------------------------
-@fn static u8 AntProcessMessage(void)
+@brief Clears the link quality counters of a channel.
 
-@brief Reads the latest received Ant message and updates system information accordingly. 
-  
 Requires:
-- Ant_u8AntNewRxMessages holds the number of unprocessed messages in the message queue
-- Ant_pu8AntRxBufferUnreadMsg points to the first byte of an unread verified ANT message
+@param eChannel_ is the channel to clear
 
 Promises:
-- Returns 1 if Ant_u8AntNewRxMessages == 0 or the message exceeds the maximum allowed length
-- Returns 0 otherwise and:
-  - Ant_u8AntNewRxMessages--
-  - Ant_pu8AntRxBufferUnreadMsg points to the first byte of the next unread verified ANT message
-  - System flags are updated
+- Returns TRUE and all counters of eChannel_ are zero, the RSSI values are 
+  ANT_RSSI_NONE and u32ResetTime is the current time
+- Returns FALSE if eChannel_ is not a valid channel
 
 */
-static u8 AntProcessMessage(void)
+bool AntResetLinkStats(AntChannelNumberType eChannel_)
 {
-  u8 u8MessageLength;
-  u8 u8Channel;
-  u8 au8MessageCopy[MESG_MAX_SIZE];
-  AntExtendedDataType sExtendedData;
+  AntLinkStatsType *psStats;
   
-  /* Exit immediately if there are no messages in the RxBuffer */
-	if (!Ant_u8AntNewRxMessages)
+  if((u8)eChannel_ >= ANT_NUM_CHANNELS)
   {
-    return(1);
+    return(FALSE);
   }
   
-  Ant_DebugProcessRxMessages++;
+  psStats = &Ant_asLinkStats[eChannel_];
+  memset(psStats, 0, sizeof(AntLinkStatsType));
+  AntRssiStatsReset(&psStats->sRssi);
+  psStats->u32ResetTime  = G_u32SystemTime1ms;
+  Ant_as16LinkRssiAverageX16[eChannel_] = 0;
+  return(TRUE);
   
-  /* Otherwise decrement the new message counter, and get a copy of the message 
-  since the rx buffer is circular and we want to index the various bytes using 
-  the ANT byte definitions. */  
-  Ant_u8AntNewRxMessages--;
-  AdvanceAntRxBufferUnreadMsgPointer();
-  u8MessageLength = *Ant_pu8AntRxBufferUnreadMsg;
+} /* end AntResetLinkStats() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn bool AntRxTimestampToHostUs(u16 u16RxTimestamp_, u32* pu32HostUs_)
+
+@brief Converts an ANT receive timestamp to the GetSystemTimeUs() time base.
+
+ANT stamps received messages with a 16-bit, ANT_RX_TIMESTAMP_HZ counter when 
+LIB_CONFIG_RX_TIMESTAMP_FLAG extended data is enabled.  The latest message that
+carried one is the reference: its ANT timestamp and its host time (SEN assertion)
+describe the same moment, so other ANT timestamps are placed relative to it.
+The counter wraps every 2 seconds, so u16RxTimestamp_ must be within 1 second 
+of the reference.  The result includes the delay from the radio event to SEN, 
+which is the same for every message.
+
+e.g.
+u32 u32RadioTimeUs;
+
+if( AntRxTimestampToHostUs(psMessage->sExtendedData.u16RxTimestamp, &u32RadioTimeUs) )
+{
+  u32 u32AgeUs = GetSystemTimeUs() - u32RadioTimeUs;
+}
+
+Requires:
+@param u16RxTimestamp_ is an AntExtendedDataType u16RxTimestamp
+@param pu32HostUs_ points to where the host time is written
+
+Promises:
+- Returns FALSE if no message with an ANT receive timestamp has been received
+- Otherwise *pu32HostUs_ is the host time in microseconds and TRUE is returned
+
+*/
+bool AntRxTimestampToHostUs(u16 u16RxTimestamp_, u32* pu32HostUs_)
+{
+  s32 s32DeltaTicks;
   
-  /* Check to ensure the message size is legit.  !!!!! Clean up pointers if not */
-  if(u8MessageLength > MESG_MAX_SIZE)
+  if(!Ant_bRxTimestampReferenceValid)
   {
-    return(1);
+    return(FALSE);
   }
   
-  /* Copy the message so it can be indexed easily */ 
-  for(u8 i = 0; i < (u8MessageLength + MESG_FRAME_SIZE - MESG_SYNC_SIZE); i++)
-  {
-    au8MessageCopy[i] = *Ant_pu8AntRxBufferUnreadMsg;
-    AdvanceAntRxBufferUnreadMsgPointer();
-  }
-  /* Note: Ant_pu8AntRxBufferUnreadMsg is now pointing at the next unread message */
+  /* 1000000 / 32768 = 15625 / 512 us per tick; the signed difference handles wrap */
+  s32DeltaTicks = (s16)(u16RxTimestamp_ - Ant_u16RxTimestampReference);
+  *pu32HostUs_ = Ant_u32RxTimestampReferenceUs + (u32)((s32DeltaTicks * 15625) / 512);
   
-  /* Get the channel number since it is needed for many things below (this value
-  will NOT be the channel for messages that do not include the channel number,
-  but that should be fine as long as the value is used in the correct context. */
-  u8Channel = au8MessageCopy[BUFFER_INDEX_CHANNEL_NUM];
+  return(TRUE);
   
-  /* Decide what to do based on the Message ID */
-  switch( au8MessageCopy[BUFFER_INDEX_MESG_ID] )
+} /* end AntRxTimestampToHostUs() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*! @protectedsection */                                                                                            
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected Interface-Layer Functions */
+
+
+/*!------------------------------------------------------------------------------
+@fn void AntInitialize(void)
+
+@brief Initialize the ANT system.  
+
+The ANT device is reset and communication checked through a version request.  
+The main channel parameters are then set up to default values.
+
+The user can override this function by holding BUTTON3
+during startup. 
+  
+Requires:
+- ANT_SPI peripheral is correctly configured
+- Debug system is initialized so debug messages can be sent to UART
+
+Promises:
+
+If successful:
+- G_stAntSetupData set to default ANT values
+- G_u32ApplicationFlags _APPLICATION_FLAGS_ANT bit is set
+- Ant_pfnStateMachine = AntSM_Idle
+
+If failed or override:
+- G_u32SystemFlags _SYSTEM_STARTUP_NO_ANT is set;
+- G_u32ApplicationFlags  _APPLICATION_FLAGS_ANT bit remains clear
+- Ant_pfnStateMachine = AntSM_NoResponse
+
+*/
+void AntInitialize(void)
+{
+  /* The message pools must be ready even if ANT does not start */
+  AntPoolInitialize();
+  AntDeviceTableClear();
+  AntResetThroughputStats();
+  for(u8 i = 0; i < ANT_NUM_CHANNELS; i++)
   {
-    case MESG_RESPONSE_EVENT_ID:
-    { 
-      /* Channel Message received: it is a Channel Response or Channel Event */
-      if( au8MessageCopy[BUFFER_INDEX_RESPONSE_MESG_ID] != MESG_EVENT_ID )
+    AntResetLinkStats((AntChannelNumberType)i);
+  }
+
+  /* Check for manual disabling of ANT */
+  if( ANT_BOOT_DISABLE() )
+  {
+    G_u32SystemFlags |= _SYSTEM_STARTUP_NO_ANT;
+    DebugPrintf(G_au8AntMessageNoAnt);
+
+    /* Float all of the ANT interface lines so that the J-Link programmer 
+    or other firmware will not be impacted by the Host MCU */
+    AT91C_BASE_PIOA->PIO_PER = ANT_PIOA_PINS;
+    AT91C_BASE_PIOB->PIO_PER = ANT_PIOB_PINS;
+
+    /* Disable all outputs (set to HiZ input) */
+    AT91C_BASE_PIOA->PIO_ODR = ANT_PIOA_PINS;
+    AT91C_BASE_PIOB->PIO_ODR = ANT_PIOB_PINS;
+    
+    Ant_pfnStateMachine = AntSM_NoResponse;
+  }
+  /* Otherwise try to start up ANT normally */
+  else
+  {
+    /* Give PIO control of ANT_RESET line */
+    AT91C_BASE_PIOB->PIO_OER = PB_21_ANT_RESET;
+    
+    /* Announce on the debug port that ANT setup is starting and intialize pointers */
+    DebugPrintf(G_au8AntMessageInit);
+  
+    /* Initialize the G_asAntChannelConfiguration data struct */
+    for(u8 i = 0; i < ANT_NUM_CHANNELS; i++)
+    {
+      G_asAntChannelConfiguration[i].AntChannel          = (AntChannelNumberType)i;
+      G_asAntChannelConfiguration[i].AntChannelType      = ANT_CHANNEL_TYPE_DEFAULT;
+      G_asAntChannelConfiguration[i].AntNetwork          = ANT_NETWORK_DEFAULT;
+      G_asAntChannelConfiguration[i].AntDeviceIdLo       = ANT_DEVICE_ID_LO_DEFAULT;
+      G_asAntChannelConfiguration[i].AntDeviceIdHi       = ANT_DEVICE_ID_HI_DEFAULT;
+      G_asAntChannelConfiguration[i].AntDeviceType       = ANT_DEVICE_TYPE_DEFAULT;
+      G_asAntChannelConfiguration[i].AntTransmissionType = ANT_TRANSMISSION_TYPE_DEFAULT;
+      G_asAntChannelConfiguration[i].AntChannelPeriodLo  = ANT_CHANNEL_PERIOD_LO_DEFAULT;
+      G_asAntChannelConfiguration[i].AntChannelPeriodHi  = ANT_CHANNEL_PERIOD_HI_DEFAULT;
+      G_asAntChannelConfiguration[i].AntFrequency        = ANT_FREQUENCY_DEFAULT;
+      G_asAntChannelConfiguration[i].AntTxPower          = ANT_TX_POWER_DEFAULT;
+      G_asAntChannelConfiguration[i].AntFlags            = 0;
+      
+      for(u8 j = 0; j < ANT_NETWORK_NUMBER_BYTES; j++)
       {
-        /* We have a Channel Response: parse it out based on the message ID to which the 
-        response applies and post the result */
-        G_stAntMessageResponse.u8Channel = u8Channel;
-        G_stAntMessageResponse.u8MessageNumber = au8MessageCopy[BUFFER_INDEX_RESPONSE_MESG_ID];
-        G_stAntMessageResponse.u8ResponseCode  = au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE];      
-        
-        switch(au8MessageCopy[BUFFER_INDEX_RESPONSE_MESG_ID])
-        {
-          case MESG_OPEN_SCAN_CHANNEL_ID:
-          {
-            DebugPrintf("Scanning ");
-            /* Fall through */
-          }
-            
-          case MESG_OPEN_CHANNEL_ID:
-          {
-            G_au8AntMessageOpen[12] = u8Channel + 0x30;
-            DebugPrintf(G_au8AntMessageOpen);
-            
-            /* Only change the flags if the command was successful */
-            if( au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE] == RESPONSE_NO_ERROR )
-            {
-              G_asAntChannelConfiguration[u8Channel].AntFlags |= _ANT_FLAGS_CHANNEL_OPEN;
-              G_asAntChannelConfiguration[u8Channel].AntFlags &= ~_ANT_FLAGS_CHANNEL_OPEN_PENDING;
-            }
-            break;
-          }
-          
-          case MESG_CLOSE_CHANNEL_ID:
-          {  
-            G_au8AntMessageClose[12] = au8MessageCopy[BUFFER_INDEX_CHANNEL_NUM] + 0x30;
-            DebugPrintf(G_au8AntMessageClose);
+        G_asAntChannelConfiguration[i].AntNetworkKey[j] = 0;
+      }
+    } 
+    
+    /* Configure the SSP resource to be used for the application */
+    Ant_sSspConfig.SspPeripheral      = ANT_SPI;
+    Ant_sSspConfig.pCsGpioAddress     = ANT_SPI_CS_GPIO;
+    Ant_sSspConfig.u32CsPin           = ANT_SPI_CS_PIN;
+    Ant_sSspConfig.eBitOrder          = SSP_LSB_FIRST;
+    Ant_sSspConfig.eSspMode           = SSP_SLAVE_FLOW_CONTROL;
+    Ant_sSspConfig.fnSlaveTxFlowCallback = AntTxFlowControlCallback;
+    Ant_sSspConfig.fnSlaveRxFlowCallback = AntRxFlowControlCallback;
+    Ant_sSspConfig.fnSlaveCsAssertCallback = AntSenAssertCallback;
+    Ant_sSspConfig.pu8RxBufferAddress = Ant_au8AntRxBuffer;
+    Ant_sSspConfig.ppu8RxNextByte     = &Ant_pu8AntRxBufferNextChar;
+    Ant_sSspConfig.u16RxBufferSize    = ANT_RX_BUFFER_SIZE;
 
-            break;
-          }
-          
-          case MESG_UNASSIGN_CHANNEL_ID:
-          {
-            G_au8AntMessageUnassign[12] = au8MessageCopy[BUFFER_INDEX_CHANNEL_NUM] + 0x30;
-            DebugPrintf(G_au8AntMessageUnassign);
+    Ant_Ssp = SspRequest(&Ant_sSspConfig);
+    ANT_SSP_FLAGS = 0;
+    
+    /* SRDY pulses are timed by the TC0 Channel 0 one-shot: RA compare asserts SRDY
+    and RC compare deasserts it and stops the timer */
+    TimerStop(TIMER0_CHANNEL0);
+    TimerSetCompareA(TIMER0_CHANNEL0, ANT_SRDY_DELAY_TICKS);
+    TimerSet(TIMER0_CHANNEL0, ANT_SRDY_DELAY_TICKS + ANT_SRDY_PERIOD_TICKS);
+    TimerAssignCompareACallback(TIMER0_CHANNEL0, AntSrdyAssertCallback);
+    TimerAssignCallback(TIMER0_CHANNEL0, AntSrdyDeassertCallback);
+    
+    /* Reset ANT, activate SPI interface and get a test message */
+    AntSyncSerialInitialize();
+    
+    /* Report status out the debug port */
+    if(G_u32ApplicationFlags & _APPLICATION_FLAGS_ANT)  
+    {
+      DebugPrintf(G_au8AntMessageOk);
+      DebugPrintf("ANT version: ");
+      DebugPrintf(Ant_u8AntVersion);
+      DebugLineFeed();
+      
+      G_u32AntFlags &= ~_ANT_FLAGS_RESTART;
+      Ant_pfnStateMachine = AntSM_Idle;
+    }
+    else
+    {
+      /* The ANT device is not responding -- it may be dead, or it may not yet
+      be loaded with any firmware */
+      DebugPrintf(G_au8AntMessageInitFail);
 
-            /* Only change the flags if the command was successful */
-            if( au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE] == RESPONSE_NO_ERROR )
-            {
-              G_asAntChannelConfiguration[u8Channel].AntFlags &= ~_ANT_FLAGS_CHANNEL_CONFIGURED;
-            }
-            break;
-          }
-          
-          default:
+      Ant_pfnStateMachine = AntSM_NoResponse;
+    }
+  }
+  
+} /* end AntInitialize() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn void AntRunActiveState(void)
+
+@brief Selects and runs one iteration of the current state in the state machine.
+
+All state machines have a TOTAL of 1ms to execute, so on average n state machines
+may take 1ms / n to execute.
+
+Requires:
+- State machine function pointer points at current state
+
+Promises:
+- Calls the function to pointed by the state machine function pointer
+
+*/
+void AntRunActiveState(void)
+{
+  AntThroughputUpdate();
+  Ant_pfnStateMachine();
+
+} /* end AntRunActiveState */
+
+
+/*!-----------------------------------------------------------------------------
+@fn void AntTxFlowControlCallback(void)
+
+@brief Callback function to toggle flow control during transmission.  
+
+The peripheral task sending the message must invoke this function after each byte.  
+
+Note: Since this function is called from an ISR, it should execute as quickly as possible. 
+
+Requires:
+- NONE 
+
+Promises:
+- SRDY is toggled
+- Ant_u32TxByteCounter incremented
+
+*/
+void AntTxFlowControlCallback(void)
+{
+  /* Count the byte and toggle flow control lines */
+  Ant_u32TxByteCounter++; 
+  AntSrdyPulse();
+
+} /* end AntTxFlowControlCallback() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn void AntRxFlowControlCallback(void)
+
+@brief Callback function used during ANT data reception that also runs the 
+receive frame parser.  
+
+The peripheral task receiving the message must invoke this function after each byte.
+Each byte is checked against the frame format (SYNC, LENGTH, ID, payload, CHECKSUM)
+as it arrives, so the state machine never waits for or re-reads a whole message.
+Bytes that do not belong to a good frame are dropped from the receive buffer by 
+not advancing (or by rewinding) Ant_pu8AntRxBufferNextChar, so the buffer only
+ever holds complete, verified messages.  A frame never wraps around the end of the
+buffer: if a maximum-size frame would not fit, it starts again at the front and 
+Ant_pu8AntRxBufferWrapMark tells AntProcessMessage() where to skip back.  The 
+front is only used once AntProcessMessage() has read past it; otherwise the frame
+is dropped as an overrun.
+
+Note: Since this function is called from an ISR, it should execute as quickly as possible. 
+AntSrdyPulse() only starts a timer, so the SRDY timing does not add to the ISR.
+
+Requires:
+- A received byte was just written to the Rx buffer at Ant_pu8AntRxBufferNextChar
+- ISRs are off already since this is totally not re-entrant
+
+Promises:
+- Ant_u32RxByteCounter incremented
+- The first byte of a transaction is saved in Ant_u8RxHandshakeByte
+- Frame bytes are kept (Ant_pu8AntRxBufferNextChar advanced) and SRDY is toggled to 
+  request the next byte
+- A good checksum increments Ant_u8AntNewRxMessages and sets Ant_bRxFrameComplete; 
+  a bad frame is dropped with AntRxDropFrame()
+- A frame that cannot wrap to the front without overwriting unread messages sets
+  Ant_bRxOverrun and is discarded
+- MESG_RX_SYNC is left for the task since it means the Host may transmit
+- Any other unexpected byte or an impossible length puts the parser in ANT_RX_PARSE_DISCARD
+  where SRDY is toggled on every byte until ANT releases SEN
+
+*/
+void AntRxFlowControlCallback(void)
+{
+  u8 u8Byte;
+  bool bKeepByte = TRUE;
+  bool bRequestNextByte = TRUE;
+  
+  /* Count the byte and look at it before deciding if it stays in the buffer */
+  Ant_u32RxByteCounter++;
+  u8Byte = *Ant_pu8AntRxBufferNextChar;
+  
+  switch(Ant_eRxParseState)
+  {
+    case ANT_RX_PARSE_SYNC:
+    {
+      /* The first byte says if ANT is sending (TX_SYNC) or letting the Host send (RX_SYNC) */
+      Ant_u8RxHandshakeByte = u8Byte;
+      if(u8Byte == MESG_TX_SYNC)
+      {
+        /* Keep the frame contiguous so it can be parsed in place */
+        Ant_bRxFrameWrapped = FALSE;
+        if( (&Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE] - Ant_pu8AntRxBufferNextChar) < MESG_MAX_SIZE )
+        {
+          /* The front is still in use if the reader is there or has yet to skip back to it */
+          if( (Ant_pu8AntRxBufferUnreadMsg < &Ant_au8AntRxBuffer[MESG_MAX_SIZE]) ||
+              (Ant_pu8AntRxBufferUnreadMsg >= Ant_pu8AntRxBufferWrapMark) )
           {
-            G_au8AntMessageUnhandled[12] = au8MessageCopy[BUFFER_INDEX_CHANNEL_NUM] + NUMBER_ASCII_TO_DEC;
-            G_au8AntMessageUnhandled[24] = HexToASCIICharLower( (au8MessageCopy[BUFFER_INDEX_RESPONSE_MESG_ID] >> 4) & 0x0F );
-            G_au8AntMessageUnhandled[25] = HexToASCIICharLower( (au8MessageCopy[BUFFER_INDEX_RESPONSE_MESG_ID] & 0x0F) );
-            G_au8AntMessageUnhandled[36] = HexToASCIICharLower( (au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE] >> 4) & 0x0F );
-            G_au8AntMessageUnhandled[37] = HexToASCIICharLower( (au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE] & 0x0F) );
-            DebugPrintf(G_au8AntMessageUnhandled);
+            Ant_bRxOverrun = TRUE;
+            bKeepByte = FALSE;
+            Ant_eRxParseState = ANT_RX_PARSE_DISCARD;
             break;
           }
-        } /* end switch */
+          
+          Ant_pu8AntRxBufferWrapMark = Ant_pu8AntRxBufferNextChar;
+          Ant_pu8AntRxBufferNextChar = &Ant_au8AntRxBuffer[0];
+          *Ant_pu8AntRxBufferNextChar = u8Byte;
+          Ant_bRxFrameWrapped = TRUE;
+        }
         
-        /* All messages print an "ok" or "fail" */
-        if( au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE] == RESPONSE_NO_ERROR ) 
+        Ant_pu8RxFrameStart = Ant_pu8AntRxBufferNextChar;
+        Ant_u8RxFrameChecksum = u8Byte;
+        Ant_eRxParseState = ANT_RX_PARSE_LENGTH;
+      }
+      else
+      {
+        /* Handshake bytes are not part of a message */
+        bKeepByte = FALSE;
+        if(u8Byte == MESG_RX_SYNC)
         {
-          DebugPrintf(G_au8AntMessageOk);
+          bRequestNextByte = FALSE;
         }
         else
         {
-          DebugPrintf(G_au8AntMessageFail);
-          G_u32AntFlags |= _ANT_FLAGS_CMD_ERROR;
+          Ant_u32UnexpectedByteCounter++;
+          Ant_eRxParseState = ANT_RX_PARSE_DISCARD;
         }
+      }
+      break;
+    }
 
+    case ANT_RX_PARSE_LENGTH:
+    {
+      /* A length that cannot fit in a message means the frame is garbage */
+      if(u8Byte > (MESG_MAX_SIZE - MESG_FRAME_SIZE))
+      {
+        AntRxDropFrame();
+        bKeepByte = FALSE;
+        Ant_eRxParseState = ANT_RX_PARSE_DISCARD;
       }
-      /* The message is a Channel Event, so the Event Code must be parsed out */
+      else
+      {
+        Ant_u8RxFrameChecksum ^= u8Byte;
+        Ant_u8RxFrameBytesRemaining = u8Byte;
+        Ant_eRxParseState = ANT_RX_PARSE_ID;
+      }
+      break;
+    }
+
+    case ANT_RX_PARSE_ID:
+    {
+      Ant_u8RxFrameChecksum ^= u8Byte;
+      if(Ant_u8RxFrameBytesRemaining == 0)
+      {
+        Ant_eRxParseState = ANT_RX_PARSE_CHECKSUM;
+      }
+      else
+      {
+        Ant_eRxParseState = ANT_RX_PARSE_PAYLOAD;
+      }
+      break;
+    }
+
+    case ANT_RX_PARSE_PAYLOAD:
+    {
+      Ant_u8RxFrameChecksum ^= u8Byte;
+      Ant_u8RxFrameBytesRemaining--;
+      if(Ant_u8RxFrameBytesRemaining == 0)
+      {
+        Ant_eRxParseState = ANT_RX_PARSE_CHECKSUM;
+      }
+      break;
+    }
+
+    case ANT_RX_PARSE_CHECKSUM:
+    {
+      if(u8Byte == Ant_u8RxFrameChecksum)
+      {
+        /* Frame-complete event for the state machine with the time the transfer started */
+        Ant_au32RxFrameTimeUs[Ant_u8RxFrameTimeIn] = Ant_u32SenTimeUs;
+        Ant_u8RxFrameTimeIn = (Ant_u8RxFrameTimeIn + 1) & (ANT_RX_TIME_SLOTS - 1);
+        Ant_u8AntNewRxMessages++;
+        Ant_DebugTotalRxMessages++;
+        Ant_bRxFrameComplete = TRUE;
+      }
+      else
+      {
+        /* Rewind so the next frame overwrites the bad one */
+        Ant_u32RxChecksumErrorCounter++;
+        AntRxDropFrame();
+        bKeepByte = FALSE;
+      }
+      
+      Ant_eRxParseState = ANT_RX_PARSE_SYNC;
+      break;
+    }
+
+    case ANT_RX_PARSE_DISCARD:
+    {
+      /* Throw everything out until ANT releases SEN */
+      bKeepByte = FALSE;
+      break;
+    }
+
+    default:
+    {
+      Ant_eRxParseState = ANT_RX_PARSE_DISCARD;
+      bKeepByte = FALSE;
+      break;
+    }
+  } /* end switch(Ant_eRxParseState) */
+  
+  /* Safely advance the receive buffer pointer past a kept byte; this is called from the
+  RX ISR, so it won't be interrupted and break Ant_pu8AntRxBufferNextChar.  This only
+  reaches the end of the buffer after the last byte of a frame. */
+  if(bKeepByte)
+  {
+    Ant_pu8AntRxBufferNextChar++;
+    if(Ant_pu8AntRxBufferNextChar == &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE])
+    {
+      Ant_pu8AntRxBufferNextChar = &Ant_au8AntRxBuffer[0];
+    }
+  }
+  
+  /* Toggle SRDY for the next byte as long as ANT still holds SEN */
+  if( bRequestNextByte && IS_SEN_ASSERTED() )
+  {
+    AntSrdyPulse();
+  }
+  
+} /* end AntRxFlowControlCallback() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn void AntSenAssertCallback(void)
+
+@brief Callback from the SSP ISR when ANT asserts SEN to start a transfer.
+
+The time is saved with microsecond resolution so received frames are stamped with
+when ANT started sending them instead of when the state machine got to them.
+
+Requires:
+- Called only from the SSP ISR
+
+Promises:
+- Ant_u32SenTimeUs = GetSystemTimeUs()
+
+*/
+void AntSenAssertCallback(void)
+{
+  Ant_u32SenTimeUs = GetSystemTimeUs();
+  
+} /* end AntSenAssertCallback() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn void AntDebugPrintChannelMessage(u8* pu8Template_, u8 u8Channel_)
+
+@brief Prints one of the "ANT channel d ..." status strings for a channel.
+
+The channel digit is patched into a copy on the stack so the shared template 
+is never written.
+
+Requires:
+@param pu8Template_ is a null-terminated template of less than ANT_DEBUG_TEXT_SIZE 
+       characters with the channel digit at ANT_DEBUG_TEXT_CHANNEL_INDEX
+@param u8Channel_ is the channel number to print
+
+Promises:
+- The string with the channel number is queued to the debug port
+
+*/
+void AntDebugPrintChannelMessage(u8* pu8Template_, u8 u8Channel_)
+{
+  u8 au8Text[ANT_DEBUG_TEXT_SIZE];
+  
+  strncpy((char*)au8Text, (char*)pu8Template_, ANT_DEBUG_TEXT_SIZE - 1);
+  au8Text[ANT_DEBUG_TEXT_SIZE - 1] = '\0';
+  au8Text[ANT_DEBUG_TEXT_CHANNEL_INDEX] = (u8Channel_ & CHANNEL_NUMBER_MASK) + NUMBER_ASCII_TO_DEC;
+  DebugPrintf(au8Text);
+  
+} /* end AntDebugPrintChannelMessage() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*! @privatesection */                                                                                            
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* ANT private Interface-layer Functions */
+
+                                   
+/*!-----------------------------------------------------------------------------
+@fn bool AntTxMessage(u8 *pu8AntTxMessage_)
+
+@brief Queues a message from the Host to the ANT device once ANT has granted the 
+transaction.  
+
+Before this is called, AntSM_TxWaitSen and AntSM_TxWaitHandshake have asserted MRDY, 
+waited for ANT to acknowledge with SEN and read the first byte from ANT.  If that byte 
+was MESG_RX_SYNC, the Host may transmit.  This function only hands the message to 
+the SSP peripheral, so it never waits.
+
+Data is sent byte-by-byte with SRDY used for flow control after each byte.  
+Due to the speed of the chip-to-chip communications, even the longest ANT message
+should be able to send in less than 500us so it will likely be done on the main 
+program cycle that immediately follows this call.  
+
+Requires:
+- ANT answered the handshake with MESG_RX_SYNC and still holds SEN
+
+@param pu8AntTxMessage_ points to an Ant formatted message where the first data byte
+       is the length byte (since ANT sends the SYNC byte) and the last byte is
+       the checksum.
+
+Promises:
+- Returns TRUE if the transmit message is queued successfully; Ant_u32CurrentTxMessageToken 
+  holds the message token and G_u32AntFlags _ANT_FLAGS_TX_IN_PROGRESS is set
+- Returns FALSE if the SSP peripheral did not accept the message
+
+*/
+static bool AntTxMessage(u8 *pu8AntTxMessage_)
+{
+  u32 u32Length;
+  u8 au8TxNoTokenMsg[] = "AntTx: No token\n\r";
+
+  /* Flag that a transmit is in progress */
+  G_u32AntFlags |= _ANT_FLAGS_TX_IN_PROGRESS;
+  
+  /* Read the message length and add three for the length, message ID and checksum */
+  u32Length = (u32)(pu8AntTxMessage_[0] + 3); 
+  
+  /* Queue the message to the peripheral and capture the token */ 
+  Ant_u32CurrentTxMessageToken = SspWriteData(Ant_Ssp, u32Length, pu8AntTxMessage_);
+
+  /* Return TRUE only if we received a message token indicating the message has been queued */
+  if(Ant_u32CurrentTxMessageToken != 0)
+  {
+    Ant_sThroughputStats.u32TxMessages++;
+    Ant_u16TxThisPeriod++;
+    return(TRUE);
+  }
+
+  G_u32AntFlags &= ~_ANT_FLAGS_TX_IN_PROGRESS;
+  DebugPrintf(au8TxNoTokenMsg);
+  return(FALSE);
+
+} /* end AntTxMessage() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn static void AntRxStart(void)
+
+@brief Starts receiving the message that ANT has signalled with SEN.  
+
+The bytes are received and checked by the parser in AntRxFlowControlCallback.
+This only flags the reception and toggles SRDY to ask for the first byte, unless 
+that byte already came in while the Host was trying to transmit.
+
+Requires:
+- SEN is asserted
+- G_u32AntFlags _ANT_FLAGS_TX_INTERRUPTED is set if the first byte of the transaction
+  was already read by AntSM_TxWaitHandshake
+
+Promises:
+- G_u32AntFlags _ANT_FLAGS_RX_IN_PROGRESS is set and _ANT_FLAGS_TX_INTERRUPTED is clear
+- Ant_u32RxTimer is loaded with the current time
+- SRDY is toggled if the first byte is still needed
+
+*/
+static void AntRxStart(void)
+{
+  Ant_DebugRxMessageCounter++;
+  Ant_u32RxTimer = G_u32SystemTime1ms;
+  G_u32AntFlags |= _ANT_FLAGS_RX_IN_PROGRESS;
+
+  /* If the transmit handshake was interrupted, the parser already has the first byte */
+  if(G_u32AntFlags & _ANT_FLAGS_TX_INTERRUPTED)
+  {
+    G_u32AntFlags &= ~_ANT_FLAGS_TX_INTERRUPTED;
+  }
+  else
+  {
+    AntSrdyPulse();
+  }
+  
+} /* end AntRxStart() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn static void AntRxDropFrame(void)
+
+@brief Removes the partly received frame from the receive buffer.
+
+If the frame had wrapped to the front of the buffer, the wrap is undone so 
+AntProcessMessage() does not skip back to a frame that was never completed.
+
+Requires:
+- Ant_pu8RxFrameStart and Ant_bRxFrameWrapped describe the frame being parsed
+- Called from the SSP ISR or with interrupts disabled
+
+Promises:
+- Ant_pu8AntRxBufferNextChar is back where it was before the frame's SYNC byte
+- Ant_pu8AntRxBufferWrapMark is cleared if the frame had set it
+
+*/
+static void AntRxDropFrame(void)
+{
+  if(Ant_bRxFrameWrapped)
+  {
+    Ant_pu8AntRxBufferNextChar = Ant_pu8AntRxBufferWrapMark;
+    Ant_pu8AntRxBufferWrapMark = &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE];
+    Ant_bRxFrameWrapped = FALSE;
+  }
+  else
+  {
+    Ant_pu8AntRxBufferNextChar = Ant_pu8RxFrameStart;
+  }
+  
+} /* end AntRxDropFrame() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn static void AntRxFinish(void)
+
+@brief Closes a reception once ANT has released SEN.
+
+Requires:
+- SEN is deasserted so the parser will not see any more bytes for this transaction
+
+Promises:
+- A frame that was cut short is dropped from the receive buffer and 
+  G_u32AntFlags _ANT_FLAGS_LENGTH_MISMATCH is set
+- A frame the parser dropped for lack of space sets G_u32AntFlags _ANT_FLAGS_RX_OVERRUN
+- Ant_eRxParseState is ANT_RX_PARSE_SYNC ready for the next transaction
+- G_u32AntFlags _ANT_FLAGS_RX_IN_PROGRESS and ANT_SSP_FLAGS _SSP_RX_COMPLETE are clear
+
+*/
+static void AntRxFinish(void)
+{
+  AntRxParseStateType eLastState;
+  u8 au8RxFailMsg[] = "AntRx: message failed\n\r";
+
+  __disable_irq();
+  eLastState = Ant_eRxParseState;
+  if( (eLastState != ANT_RX_PARSE_SYNC) && (eLastState != ANT_RX_PARSE_DISCARD) )
+  {
+    AntRxDropFrame();
+  }
+  Ant_eRxParseState = ANT_RX_PARSE_SYNC;
+  __enable_irq();
+  
+  if(Ant_bRxOverrun)
+  {
+    Ant_bRxOverrun = FALSE;
+    G_u32AntFlags |= _ANT_FLAGS_RX_OVERRUN;
+  }
+  else if(eLastState == ANT_RX_PARSE_DISCARD)
+  {
+    DebugPrintf(au8RxFailMsg);
+  }
+  else if(eLastState != ANT_RX_PARSE_SYNC)
+  {
+    G_u32AntFlags |= _ANT_FLAGS_LENGTH_MISMATCH;
+  }
+  
+  G_u32AntFlags &= ~_ANT_FLAGS_RX_IN_PROGRESS;
+  ANT_SSP_FLAGS &= ~_SSP_RX_COMPLETE;
+
+} /* end AntRxFinish() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn static void AntRxAbortFrame(void)
+
+@brief Throws out a reception that has stalled and flushes ANT.
+
+Any part of a frame already received is dropped and the parser discards 
+whatever else ANT sends until it releases SEN.  Messages already verified in 
+the receive buffer are kept.
+
+Requires:
+- NONE
+
+Promises:
+- Ant_eRxParseState is ANT_RX_PARSE_DISCARD
+- Ant_u32RxTimeoutCounter is incremented and Ant_u32RxTimer is reloaded
+- SRDY is toggled to restart the flow of bytes from ANT
+
+*/
+static void AntRxAbortFrame(void)
+{
+  u8 au8RxTimeoutMsg[] = "AntRx: timeout\n\r";
+
+  __disable_irq();
+  if( (Ant_eRxParseState != ANT_RX_PARSE_SYNC) && (Ant_eRxParseState != ANT_RX_PARSE_DISCARD) )
+  {
+    AntRxDropFrame();
+  }
+  Ant_eRxParseState = ANT_RX_PARSE_DISCARD;
+  __enable_irq();
+
+  Ant_u32RxTimeoutCounter++;
+  Ant_u32RxTimer = G_u32SystemTime1ms;
+  DebugPrintf(au8RxTimeoutMsg);
+  AntSrdyPulse();
+
+} /* end AntRxAbortFrame() */
+
+
+/*!------------------------------------------------------------------------------
+@fn static u8 AntProcessMessage(void)
+
+@brief Reads the latest received Ant message and updates system information accordingly. 
+
+The message is read in place in Ant_au8AntRxBuffer: the parser never lets a frame 
+wrap, so the BUFFER_INDEX_ constants can be used directly from the LENGTH byte.
+  
+Requires:
+- Ant_u8AntNewRxMessages holds the number of unprocessed messages in the message queue
+- Ant_pu8AntRxBufferUnreadMsg points to the first byte of an unread verified ANT message,
+  or to Ant_pu8AntRxBufferWrapMark if the message is at the start of the buffer
+
+Promises:
+- Returns 1 if Ant_u8AntNewRxMessages == 0
+- Returns 0 otherwise and:
+  - Ant_u8AntNewRxMessages--
+  - Ant_pu8AntRxBufferUnreadMsg points to the first byte of the next unread verified ANT message
+  - System flags are updated
+
+*/
+static u8 AntProcessMessage(void)
+{
+  u8 u8Channel;
+  u8 *pu8Message;
+  AntExtendedDataType sExtendedData;
+  u32 u32StartMs;
+  u32 u32StartTick;
+  u32 u32Cycles;
+  
+  /* Exit immediately if there are no messages in the RxBuffer */
+	if (!Ant_u8AntNewRxMessages)
+  {
+    return(1);
+  }
+  
+  Ant_DebugProcessRxMessages++;
+  GetSystemTimeTicks(&u32StartMs, &u32StartTick);
+  
+  /* Otherwise decrement the new message counter.  The parser increments it from the SSP ISR. */  
+  __disable_irq();
+  Ant_u8AntNewRxMessages--;
+  __enable_irq();
+  
+  Ant_u32CurrentRxTimeUs = Ant_au32RxFrameTimeUs[Ant_u8RxFrameTimeOut];
+  Ant_u8RxFrameTimeOut = (Ant_u8RxFrameTimeOut + 1) & (ANT_RX_TIME_SLOTS - 1);
+  
+  /* Skip back to the front of the buffer if that is where the parser put this message */
+  if(Ant_pu8AntRxBufferUnreadMsg >= Ant_pu8AntRxBufferWrapMark)
+  {
+    Ant_pu8AntRxBufferUnreadMsg = &Ant_au8AntRxBuffer[0];
+    Ant_pu8AntRxBufferWrapMark  = &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE];
+  }
+  
+  /* Index the message from its LENGTH byte */
+  pu8Message = Ant_pu8AntRxBufferUnreadMsg + MESG_SYNC_SIZE;
+  
+  /* Get the channel number since it is needed for many things below (this value
+  will NOT be the channel for messages that do not include the channel number,
+  but that should be fine as long as the value is used in the correct context. */
+  u8Channel = pu8Message[BUFFER_INDEX_CHANNEL_NUM];
+  
+  /* Decide what to do based on the Message ID */
+  switch( pu8Message[BUFFER_INDEX_MESG_ID] )
+  {
+    case MESG_RESPONSE_EVENT_ID:
+    { 
+      /* Channel Message received: it is a Channel Response or Channel Event */
+      if( pu8Message[BUFFER_INDEX_RESPONSE_MESG_ID] != MESG_EVENT_ID )
+      {
+        /* We have a Channel Response: parse it out based on the message ID to which the 
+        response applies and post the result */
+        G_stAntMessageResponse.u8Channel = u8Channel;
+        G_stAntMessageResponse.u8MessageNumber = pu8Message[BUFFER_INDEX_RESPONSE_MESG_ID];
+        G_stAntMessageResponse.u8ResponseCode  = pu8Message[BUFFER_INDEX_RESPONSE_CODE];      
+        AntApiResponseEvent(u8Channel, pu8Message[BUFFER_INDEX_RESPONSE_MESG_ID], pu8Message[BUFFER_INDEX_RESPONSE_CODE]);
+        
+        switch(pu8Message[BUFFER_INDEX_RESPONSE_MESG_ID])
+        {
+          case MESG_OPEN_SCAN_CHANNEL_ID:
+          {
+            DebugPrintf("Scanning ");
+            /* Fall through */
+          }
+            
+          case MESG_OPEN_CHANNEL_ID:
+          {
+            AntDebugPrintChannelMessage(G_au8AntMessageOpen, u8Channel);
+            
+            /* Only change the flags if the command was successful */
+            if( pu8Message[BUFFER_INDEX_RESPONSE_CODE] == RESPONSE_NO_ERROR )
+            {
+              G_asAntChannelConfiguration[u8Channel].AntFlags |= _ANT_FLAGS_CHANNEL_OPEN;
+              G_asAntChannelConfiguration[u8Channel].AntFlags &= ~_ANT_FLAGS_CHANNEL_OPEN_PENDING;
+            }
+            break;
+          }
+          
+          case MESG_CLOSE_CHANNEL_ID:
+          {  
+            AntDebugPrintChannelMessage(G_au8AntMessageClose, pu8Message[BUFFER_INDEX_CHANNEL_NUM]);
+
+            break;
+          }
+          
+          case MESG_BURST_DATA_ID:
+          {
+            /* ANT only responds to a burst packet if it was rejected */
+            if( pu8Message[BUFFER_INDEX_RESPONSE_CODE] != RESPONSE_NO_ERROR )
+            {
+              AntBurstTxEvent(u8Channel, FALSE);
+            }
+            break;
+          }
+          
+          case MESG_UNASSIGN_CHANNEL_ID:
+          {
+            AntDebugPrintChannelMessage(G_au8AntMessageUnassign, pu8Message[BUFFER_INDEX_CHANNEL_NUM]);
+
+            /* Only change the flags if the command was successful */
+            if( pu8Message[BUFFER_INDEX_RESPONSE_CODE] == RESPONSE_NO_ERROR )
+            {
+              G_asAntChannelConfiguration[u8Channel].AntFlags &= ~_ANT_FLAGS_CHANNEL_CONFIGURED;
+            }
+            break;
+          }
+          
+          default:
+          {
+            /* Patch a copy so the template is never modified */
+            u8 au8Text[sizeof(G_au8AntMessageUnhandled)];
+            
+            memcpy(au8Text, G_au8AntMessageUnhandled, sizeof(au8Text));
+            au8Text[ANT_DEBUG_TEXT_CHANNEL_INDEX] = pu8Message[BUFFER_INDEX_CHANNEL_NUM] + NUMBER_ASCII_TO_DEC;
+            au8Text[24] = HexToASCIICharLower( (pu8Message[BUFFER_INDEX_RESPONSE_MESG_ID] >> 4) & 0x0F );
+            au8Text[25] = HexToASCIICharLower( (pu8Message[BUFFER_INDEX_RESPONSE_MESG_ID] & 0x0F) );
+            au8Text[36] = HexToASCIICharLower( (pu8Message[BUFFER_INDEX_RESPONSE_CODE] >> 4) & 0x0F );
+            au8Text[37] = HexToASCIICharLower( (pu8Message[BUFFER_INDEX_RESPONSE_CODE] & 0x0F) );
+            DebugPrintf(au8Text);
+            break;
+          }
+        } /* end switch */
+        
+        /* All messages print an "ok" or "fail" */
+        if( pu8Message[BUFFER_INDEX_RESPONSE_CODE] == RESPONSE_NO_ERROR ) 
+        {
+          DebugPrintf(G_au8AntMessageOk);
+        }
+        else
+        {
+          DebugPrintf(G_au8AntMessageFail);
+          G_u32AntFlags |= _ANT_FLAGS_CMD_ERROR;
+        }
+
+      }
+      /* The message is a Channel Event, so the Event Code must be parsed out */
       else 
       { 
-        switch ( au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE] )
+        AntLinkStatsEvent(u8Channel, pu8Message[BUFFER_INDEX_RESPONSE_CODE]);
+        switch ( pu8Message[BUFFER_INDEX_RESPONSE_CODE] )
         {
           case RESPONSE_NO_ERROR: 
           {
-            AntTickExtended(au8MessageCopy);
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rRESPONSE_NO_ERROR\n\r");
+#endif
+            break;
+          }
+
+          case EVENT_RX_FAIL: /* Slave did not receive a message when expected */
+          {
+            /* The Slave missed a message it was expecting: communicate this to the
+            application in case it matters. Could also queue a debug message here. */
+            Ant_u8SlaveMissedMessageLow++;
+            if(Ant_u8SlaveMissedMessageLow == 0)
+            {
+              Ant_u8SlaveMissedMessageMid++;
+              if(Ant_u8SlaveMissedMessageMid == 0)
+              {
+                Ant_u8SlaveMissedMessageHigh++;
+                /* Let this overflow without action */
+              }
+            }
+            
+            /* Queue an ANT_TICK message to the application message list. */
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_RX_FAIL\n\r");
+#endif
+            break;
+          }
+
+          case EVENT_RX_FAIL_GO_TO_SEARCH: /* Slave has lost sync with Master (channel still open) */
+          {
+            /* The Slave missed enough consecutive messages so it goes back to search: communicate this to the
+            application in case it matters. Could also queue a debug message here. */
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_RX_FAIL_GO_TO_SEARCH\n\r");
+#endif
+            break;
+          }
+
+          case EVENT_TX: /* ANT has sent a data message */
+          {
+            /* If this is a Master device, then EVENT_TX means it's time to queue the 
+            next message */
+            if(G_asAntChannelConfiguration[u8Channel].AntChannelType == CHANNEL_TYPE_MASTER)
+            {
+              AntTickExtended(pu8Message);
+            }
 #ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rRESPONSE_NO_ERROR\n\r");
+            DebugPrintf("\n\rEVENT_TX\n\r");
+#endif
+            break;
+          } 
+
+          case EVENT_TRANSFER_TX_COMPLETED: /* ACK received from an acknowledged data message or burst */
+          { 
+            G_asAntChannelConfiguration[u8Channel].AntFlags |= _ANT_FLAGS_GOT_ACK;
+            AntBurstTxEvent(u8Channel, TRUE);
+            AntApiAckEvent(u8Channel, TRUE);
+
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_TRANSFER_TX_COMPLETED\n\r");
+#endif
+            break;
+          } 
+
+          case EVENT_TRANSFER_TX_FAILED: /* ACK was not received from an acknowledged data message or burst */
+          { 
+            AntBurstTxEvent(u8Channel, FALSE);
+            AntApiAckEvent(u8Channel, FALSE);
+
+            /* Regardless of complete or fail, it is time to send the next message */
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_TRANSFER_TX_FAILED\n\r");
+#endif
+            break;
+          } 
+
+          case EVENT_TRANSFER_RX_FAILED: /* An incoming burst was not received completely */
+          {
+            AntBurstRxFailed(u8Channel);
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_TRANSFER_RX_FAILED\n\r");
+#endif
+            break;
+          }
+
+          case EVENT_RX_SEARCH_TIMEOUT: /* The ANT channel is going to close due to search timeout */
+          {
+            /* Forward this to application */
+            AntTickExtended(pu8Message);
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_RX_SEARCH_TIMEOUT\n\r");
+#endif
+            break;
+          }
+ 
+          case EVENT_CHANNEL_CLOSED: /* The ANT channel is now closed */
+          {
+            DebugPrintf("Channel closed\n\r");
+            G_asAntChannelConfiguration[u8Channel].AntFlags &= ~_ANT_FLAGS_CHANNEL_OPEN;
+#ifdef ANT_VERBOSE 
+            DebugPrintf("\n\rEVENT_CHANNEL_CLOSED\n\r");
 #endif
             break;
           }
+          
+          /* All other messages are unexpected for now */
+          default:
+          {
+            DebugPrintNumber(pu8Message[BUFFER_INDEX_RESPONSE_CODE]);
+            DebugPrintf(": unexpected channel event\n\r");
+
+            G_u32AntFlags |= _ANT_FLAGS_UNEXPECTED_EVENT;
+            break;
+          }
+        } /* end pu8Message[BUFFER_INDEX_RESPONSE_CODE] */
+      } /* end else RF event */
+      
+      break; 
+    } /* end case MESG_RESPONSE_EVENT_ID */
+
+    case MESG_ACKNOWLEDGED_DATA_ID: /* An acknowledged data message was received */
+    /* Fall through */
+      
+    case MESG_BROADCAST_DATA_ID: /* A broadcast data message was received */
+    { 
+      /* Parse the extended data and put the message to the device table and/or the application buffer */
+      AntParseExtendedData(pu8Message, &sExtendedData);
+      AntLinkStatsData(u8Channel, &sExtendedData);
+      if( (Ant_eDeviceTableMode == ANT_DEVICE_TABLE_OFF) ||
+          !(sExtendedData.u8Flags & LIB_CONFIG_CHANNEL_ID_FLAG) ||
+          AntDeviceTableUpdate(&pu8Message[BUFFER_INDEX_MESG_DATA], &sExtendedData) )
+      {
+        AntQueueExtendedApplicationMessage(ANT_DATA, &pu8Message[BUFFER_INDEX_MESG_DATA], &sExtendedData);
+      }
+      
+#if 0 
+/* 2017-JUN-23 Don't think this should be here as it should be
+the application looking for data messages and deciding what
+that should be. If it is required, perhaps the call to AntTickExtended
+should be modified since pu8Message doesn't have an EVENT CODE. 
+      
+There are some legacy applications that will fail if this is removed, so
+we'll keep the code available until those can be updated.  Do not rely on
+this for future development. */
+      
+      /* If this is a Slave device, then a data message received means it's time to send */
+      if(G_asAntChannelConfiguration[u8Channel].AntChannelType == CHANNEL_TYPE_SLAVE)
+      {
+        AntTickExtended(pu8Message);
+      }
+#endif      
+      break;
+    } /* end case MESG_BROADCAST_DATA_ID */
+
+    case MESG_BURST_DATA_ID: /* A burst packet was received */
+    {
+      /* The channel byte also carries the sequence number */
+      u8Channel = pu8Message[BUFFER_INDEX_CHANNEL_NUM] & CHANNEL_NUMBER_MASK;
+      AntLinkStatsData(u8Channel, NULL);
+      if( !AntBurstRxPacket(u8Channel, pu8Message[BUFFER_INDEX_CHANNEL_NUM], &pu8Message[BUFFER_INDEX_MESG_DATA]) )
+      {
+        /* No burst buffer armed on this channel, so hand the packet over like broadcast data */
+        pu8Message[BUFFER_INDEX_CHANNEL_NUM] = u8Channel;
+        AntParseExtendedData(pu8Message, &sExtendedData);
+        AntQueueExtendedApplicationMessage(ANT_DATA, &pu8Message[BUFFER_INDEX_MESG_DATA], &sExtendedData);
+      }
+      break;
+    } /* end case MESG_BURST_DATA_ID */
+    
+    case MESG_CHANNEL_STATUS_ID: /* Message sent in response to a channel status request */
+    { 
+      break;
+    } /* end case ChannelStatus_CMD */
+    
+    case MESG_VERSION_ID:
+    {
+      for(u8 i = 0; i < MESG_VERSION_SIZE; i++)
+      {
+        Ant_u8AntVersion[i] = pu8Message[BUFFER_INDEX_VERSION_BYTE0 + i];
+      }
+      
+      /* If we get a version message, we know that ANT comms is good */
+      G_u32ApplicationFlags |= _APPLICATION_FLAGS_ANT;
+      
+      break;
+    } /* end case MESG_VERSION_ID */
+
+    case MESG_RESTART_ID:
+    {
+      G_u32AntFlags |= _ANT_FLAGS_RESTART;  
+      break;
+    } /* end case MESG_RESTART_ID */
+    
+    default:
+    {
+      G_u32AntFlags |= _ANT_FLAGS_UNEXPECTED_MSG;
+      break;
+    }
+  } /* end switch( pu8Message[BUFFER_INDEX_MESG_ID] ) */
+  
+  /* Release the frame; Ant_pu8AntRxBufferUnreadMsg now points at the next unread message */
+  Ant_pu8AntRxBufferUnreadMsg += pu8Message[BUFFER_INDEX_MESG_SIZE] + MESG_FRAME_SIZE;
+  
+  /* Account for the processing time of the frame */
+  u32Cycles = AntElapsedCycles(u32StartMs, u32StartTick);
+  Ant_u32RxCyclesTotal += u32Cycles;
+  if(u32Cycles > Ant_sThroughputStats.u32RxCyclesMax)
+  {
+    Ant_sThroughputStats.u32RxCyclesMax = u32Cycles;
+  }
+  Ant_sThroughputStats.u32RxMessages++;
+  Ant_u16RxThisPeriod++;
+           
+  return(0);
+  
+} /* end AntProcessMessage() */
+
+
+/*!------------------------------------------------------------------------------
+@fn static bool AntParseExtendedData(u8* pu8SourceMessage_, AntExtendedDataType* psExtDataTarget_)
+
+@brief Reads extended data based on the flags that are set.
+
+Loads AntExtendedDataType which currently has these fields:
+{
+  u8 u8Channel;                        
+  u16 u16DeviceID;                         
+  u8 u8DeviceType;                         
+  u8 u8TransType;                          
+  u8 u8Flags;                             
+  s8 s8RSSI;                              
+  u16 u16RxTimestamp;
+} AntExtendedDataType;
+
+A message with a receive timestamp also becomes the reference for AntRxTimestampToHostUs().
+
+For now we don't have a use for MeasurementType or Threshold from the RSSI
+extended information, so this code is commented out but in the correct location if needed.
+
+Requires:
+@param pu8SourceMessage_ points to an ANT message buffer that holds a complete ANT data
+       message structure except for SYNC byte; therefore buffer indices from antmessage.h can be used.
+@param psExtDataTarget_ points to the target AntExtendedDataType structure
+
+Promises:
+- Returns TRUE if extended data is present; all values are read into local variables and then
+  loaded into psExtDataTarget_.
+- Returns FALSE if no extended data is present; psExtDataTarget_ is set to default values
+
+*/
+static bool AntParseExtendedData(u8* pu8SourceMessage_, AntExtendedDataType* psExtDataTarget_)
+{
+  bool bReturnValue;
+  u8 u8MessageSize;
+  u8 u8Channel;                        
+  u8 u8Flags = 0;       
+  u8 u8BufferOffset = 0;
+  
+  /* Channel ID extended data */
+  u16 u16DeviceID = 0xFFFF;;                         
+  u8 u8DeviceType = 0xFF;                        
+  u8 u8TransType = 0xFF;                          
+
+  /* RSSI extended data */
+  s8 s8RSSI = 0xFF;   
+  //u8 u8MeasurementType = 0xFF;
+  //u8 u8Threshold = 0xFF;
+  
+  /* RF Timestamp data */
+  u16 u16RxTimestamp = 0xFFFF;
+    
+  /* Get generic data */
+  u8MessageSize = *(pu8SourceMessage_ + BUFFER_INDEX_MESG_SIZE);
+  u8Channel = *(pu8SourceMessage_ + BUFFER_INDEX_CHANNEL_NUM);
+
+  /* Check to see if the message is the regular size (MESG_MAX_DATA_SIZE) */
+  if(u8MessageSize == MESG_MAX_DATA_SIZE)
+  {
+    bReturnValue = FALSE;
+  }
+  
+  /* Check for a message that is too big or too small */
+  else if( (u8MessageSize > MESG_MAX_SIZE) ||
+           (u8MessageSize < MESG_MAX_DATA_SIZE) )
+  {
+    DebugPrintf("\n\rUnexpected ANT message size\n\n\r");
+    bReturnValue = FALSE;
+  }
+  
+  /* Otherwise we have some extended message data */
+  else 
+  {
+    /* The byte after data must be flag byte */
+    u8Flags = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA_FLAGS);
+    bReturnValue = TRUE;
+    
+    /* Channel ID information is always first if it's there */
+    if(u8Flags & LIB_CONFIG_CHANNEL_ID_FLAG)
+    {
+      u16DeviceID = (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) & 0x00FF;
+      u8BufferOffset++;
+      u16DeviceID |= ( (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) << 8 ) & 0xFF00;
+      u8BufferOffset++;
+      u8DeviceType = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
+      u8BufferOffset++;
+      u8TransType = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
+      u8BufferOffset++;
+    }
+    
+    /* RSSI information is always next if it's there */
+    if(u8Flags & LIB_CONFIG_RSSI_FLAG)
+    {
+      //u8MeasurementType = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
+      u8BufferOffset++;
+      s8RSSI = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
+      u8BufferOffset++;
+      //u8Threshold = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
+      u8BufferOffset++;
+    }   
+
+    /* Timestamp information is always last */
+    if(u8Flags & LIB_CONFIG_RX_TIMESTAMP_FLAG)
+    {
+      u16RxTimestamp = (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) & 0x00FF;
+      u8BufferOffset++;
+      u16RxTimestamp |= ( (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) << 8 ) & 0xFF00;
+      
+      Ant_u16RxTimestampReference   = u16RxTimestamp;
+      Ant_u32RxTimestampReferenceUs = Ant_u32CurrentRxTimeUs;
+      Ant_bRxTimestampReferenceValid = TRUE;
+    }
+  }
+  
+  /* Load psExtDataTarget_ (either real or default data) and return */
+  psExtDataTarget_->u8Flags      = u8Flags;
+  psExtDataTarget_->u8Channel    = u8Channel;
+  psExtDataTarget_->u16DeviceID  = u16DeviceID;
+  psExtDataTarget_->u8DeviceType = u8DeviceType;
+  psExtDataTarget_->u8TransType  = u8TransType;
+  psExtDataTarget_->s8RSSI       = s8RSSI;
+  psExtDataTarget_->u16RxTimestamp = u16RxTimestamp;
+
+  return bReturnValue;
+  
+} /* end AntParseExtendedData */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static bool AntQueueExtendedApplicationMessage(AntApplicationMessageType eMessageType_, u8* pu8DataSource_, AntExtendedDataType* psExtData_)
+
+@brief Adds a new ANT message to the tail of the application message ring, or hands
+it to the handler registered for its channel.
+
+The Application ring is used to communicate message information between the ANT driver and
+the ANT_API simplified interface task.  It has room for ANT_APPLICATION_MESSAGE_BUFFER_SIZE
+messages and adding one takes constant time. The messages are either ANT_DATA or ANT_TICK messsage and include
+all information and data from the original ANT message.
+
+Requires:
+- NONE
+
+@param eMessageType_ specifies the type of message
+@param pu8DataSource_ is a pointer to the first element of an array of 8 data bytes
+@param psExtData_ is a pointer to the extended data for the message
+
+Promises:
+- If a handler is registered for the channel and message type, it is called 
+  with the message and TRUE is returned
+- Otherwise the message is written to the ring slot at Ant_u8ApplicationMsgTail
+- Returns TRUE if the entry is added successfully.
+- Returns FALSE if the ring is full.
+
+*/
+static bool AntQueueExtendedApplicationMessage(AntApplicationMessageType eMessageType_, 
+                                               u8* pu8DataSource_, 
+                                               AntExtendedDataType* psExtData_)
+{
+  AntApplicationMsgListType *psNewMessage;
+  AntApplicationMsgListType sHandlerMessage;
+  AntChannelHandlerType pfnHandler = NULL;
+  u8 Ant_au8AddMessageFailMsg[] = "\n\rNo space in AntQueueApplicationMessage\n\r";
+  
+  /* A registered handler takes the message instead of the ring */
+  if( (psExtData_->u8Channel < ANT_NUM_CHANNELS) &&
+      (Ant_asChannelHandlers[psExtData_->u8Channel].u8MessageMask & (1 << eMessageType_)) )
+  {
+    pfnHandler = Ant_asChannelHandlers[psExtData_->u8Channel].pfnHandler;
+    psNewMessage = &sHandlerMessage;
+  }
+  else
+  {
+    /* Check for a full ring */
+    if(Ant_sApplicationRingStats.u16InUse == ANT_APPLICATION_MESSAGE_BUFFER_SIZE)
+    {
+      Ant_sApplicationRingStats.u32Failures++;
+      DebugPrintf(Ant_au8AddMessageFailMsg);
+      return(FALSE);
+    }
+    
+    psNewMessage = &Ant_asApplicationMsgRing[Ant_u8ApplicationMsgTail];
+  }
+  
+  /* Fill in all the fields of the newly allocated message structure */
+  for(u8 i = 0; i < ANT_APPLICATION_MESSAGE_BYTES; i++)
+  {
+    psNewMessage->au8MessageData[i] = *(pu8DataSource_ + i);
+  }
+  
+  /* Fill basic items */
+  psNewMessage->u32TimeStamp  = G_u32SystemTime1ms;
+  psNewMessage->u32TimeStampUs = Ant_u32CurrentRxTimeUs;
+  psNewMessage->eMessageType  = eMessageType_;
+  
+  /* Copy all extended data fields */
+  psNewMessage->sExtendedData.u8Channel    = psExtData_->u8Channel;
+  psNewMessage->sExtendedData.u16DeviceID  = psExtData_->u16DeviceID;
+  psNewMessage->sExtendedData.u8DeviceType = psExtData_->u8DeviceType;
+  psNewMessage->sExtendedData.u8TransType  = psExtData_->u8TransType;
+  psNewMessage->sExtendedData.u8Flags      = psExtData_->u8Flags;
+  psNewMessage->sExtendedData.s8RSSI       = psExtData_->s8RSSI;
+  psNewMessage->sExtendedData.u16RxTimestamp = psExtData_->u16RxTimestamp;
+  psNewMessage->u8Channel                  = psExtData_->u8Channel;
+  
+  if(pfnHandler != NULL)
+  {
+    pfnHandler(psNewMessage);
+    return(TRUE);
+  }
+    
+  /* Commit the slot */
+  Ant_u8ApplicationMsgTail++;
+  if(Ant_u8ApplicationMsgTail == ANT_APPLICATION_MESSAGE_BUFFER_SIZE)
+  {
+    Ant_u8ApplicationMsgTail = 0;
+  }
+  
+  AntPoolCountAllocation(&Ant_sApplicationRingStats);
+  AntUpdateApplicationMsgList();
+  
+  return(TRUE);
+    
+} /* end AntQueueExtendedApplicationMessage() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntTickExtended(u8* pu8AntMessage_)
+
+@brief Queues an ANT_TICK message to the application message queue.
+
+This is expected to run for a Channel Event ANT message though it will work
+for a standard Channel Response (although the names of the indexes will not
+be quite right).  Currently this function is only called for Channel Events,
+so if that changes it should be thought about carefully.
+
+Requires:
+@param pu8AntMessage_ points to an ANT message that starts with the LENGTH 
+(i.e. no SYNC byte) 
+
+Promises:
+- A MESSAGE_ANT_TICK is queued to the application message ring
+
+*/
+static void AntTickExtended(u8* pu8AntMessage_)
+{
+  u8 au8Message[ANT_APPLICATION_MESSAGE_BYTES];
+  AntExtendedDataType sExtData;
+
+  /* Update data to communicate the ANT_TICK to the application */
+  au8Message[ANT_TICK_MSG_ID_INDEX]               = MESSAGE_ANT_TICK;
+  au8Message[ANT_TICK_MSG_CHANNEL_INDEX]          = *(pu8AntMessage_ + BUFFER_INDEX_CHANNEL_NUM);
+  au8Message[ANT_TICK_MSG_RESPONSE_TYPE_INDEX]    = *(pu8AntMessage_ + BUFFER_INDEX_RESPONSE_MESG_ID);
+  au8Message[ANT_TICK_MSG_EVENT_CODE_INDEX]       = *(pu8AntMessage_ + BUFFER_INDEX_RESPONSE_CODE);
+  au8Message[ANT_TICK_MSG_SENTINEL_INDEX]         = MESSAGE_ANT_TICK_SENTINEL;
+  au8Message[ANT_TICK_MSG_MISSED_HIGH_BYTE_INDEX] = Ant_u8SlaveMissedMessageHigh;
+  au8Message[ANT_TICK_MSG_MISSED_MID_BYTE_INDEX]  = Ant_u8SlaveMissedMessageMid;
+  au8Message[ANT_TICK_MSG_MISSED_LOW_BYTE_INDEX]  = Ant_u8SlaveMissedMessageLow;
+
+  /* Extended data is not valid for an ANT_TICK message */
+  sExtData.u8Channel    = au8Message[ANT_TICK_MSG_CHANNEL_INDEX];
+  sExtData.u16DeviceID  = 0xFF;
+  sExtData.u8DeviceType = 0xFF;
+  sExtData.u8TransType  = 0xFF;
+  sExtData.s8RSSI       = 0xFF;
+  sExtData.u8Flags      = 0xFF;
+  sExtData.u16RxTimestamp = 0xFFFF;
+  
+  /* Data is ready so queue it in to the application buffer */
+  AntQueueExtendedApplicationMessage(ANT_TICK, 
+                                     &au8Message[ANT_TICK_MSG_ID_INDEX],
+                                     &sExtData);
+
+} /* end AntTickExtended() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntDeQueueOutgoingMessage(void)
+
+@brief Removes the oldest entry of Ant_psOutgoingMsgList.
+
+Requires:
+- NONE 
+
+Promises:
+- Ant_psOutgoingMsgList = Ant_psOutgoingMsgList->psNextMessage 
+  and the message block is returned to the pool
+
+*/
+static void AntDeQueueOutgoingMessage(void)
+{
+  AntOutgoingMessageListType *psMessageToKill;
+  
+  /* Messages may be appended from an ISR */
+  __disable_irq();
+  psMessageToKill = Ant_psOutgoingMsgList;
+  if(psMessageToKill != NULL)
+  {
+    Ant_psOutgoingMsgList = psMessageToKill->psNextMessage;
+  }
+  __enable_irq();
+  
+  /* The doomed message is properly disconnected, so return it to the pool */
+  if(psMessageToKill != NULL)
+  {
+    AntOutgoingMessageFree(psMessageToKill);
+  }
+  
+} /* end AntDeQueueOutgoingMessage() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntPoolInitialize(void)
+
+@brief Links every block of the outgoing message pool into its free list, empties
+the application message ring and clears the statistics.
+
+Requires:
+- No messages are queued (any queued message is lost)
+
+Promises:
+- Ant_psOutgoingMsgFreeList holds all pool blocks
+- Ant_psOutgoingMsgList and G_psAntApplicationMsgList are empty
+- Pool and ring statistics are reset
+
+*/
+static void AntPoolInitialize(void)
+{
+  Ant_psOutgoingMsgList = NULL;
+  Ant_psOutgoingMsgFreeList = NULL;
+  for(u8 i = 0; i < ANT_OUTGOING_MESSAGE_BUFFER_SIZE; i++)
+  {
+    Ant_asOutgoingMsgPool[i].psNextMessage = Ant_psOutgoingMsgFreeList;
+    Ant_psOutgoingMsgFreeList = &Ant_asOutgoingMsgPool[i];
+  }
+  memset(Ant_apsLatestOutgoingMsg, 0, sizeof(Ant_apsLatestOutgoingMsg));
+  
+  G_psAntApplicationMsgList = NULL;
+  Ant_u8ApplicationMsgHead = 0;
+  Ant_u8ApplicationMsgTail = 0;
+
+  memset(&Ant_sOutgoingPoolStats, 0, sizeof(AntPoolStatsType));
+  memset(&Ant_sApplicationRingStats, 0, sizeof(AntPoolStatsType));
+  Ant_sOutgoingPoolStats.u16Size    = ANT_OUTGOING_MESSAGE_BUFFER_SIZE;
+  Ant_sApplicationRingStats.u16Size = ANT_APPLICATION_MESSAGE_BUFFER_SIZE;
+  
+} /* end AntPoolInitialize() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntPoolCountAllocation(AntPoolStatsType* psStats_)
+
+@brief Updates a pool's statistics after a successful allocation.
+
+Requires:
+@param psStats_ points to the statistics of the pool that was allocated from
+
+Promises:
+- u16InUse, u16HighWater and u32Allocations are updated
+
+*/
+static void AntPoolCountAllocation(AntPoolStatsType* psStats_)
+{
+  psStats_->u16InUse++;
+  psStats_->u32Allocations++;
+  if(psStats_->u16InUse > psStats_->u16HighWater)
+  {
+    psStats_->u16HighWater = psStats_->u16InUse;
+  }
+  
+} /* end AntPoolCountAllocation() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static AntOutgoingMessageListType* AntOutgoingMessageAllocate(void)
+
+@brief Takes a block from the outgoing message pool in constant time.
+
+Safe to call from an ISR: the interrupt mask is restored, not simply enabled.
+
+Requires:
+- NONE
+
+Promises:
+- Returns a pointer to an unused AntOutgoingMessageListType, or NULL if the pool
+  is empty (u32Failures is incremented)
+
+*/
+static AntOutgoingMessageListType* AntOutgoingMessageAllocate(void)
+{
+  AntOutgoingMessageListType *psBlock;
+  u32 u32Primask = __get_PRIMASK();
+  
+  __disable_irq();
+  psBlock = Ant_psOutgoingMsgFreeList;
+  if(psBlock == NULL)
+  {
+    Ant_sOutgoingPoolStats.u32Failures++;
+  }
+  else
+  {
+    Ant_psOutgoingMsgFreeList = psBlock->psNextMessage;
+    AntPoolCountAllocation(&Ant_sOutgoingPoolStats);
+  }
+  __set_PRIMASK(u32Primask);
+  
+  return(psBlock);
+  
+} /* end AntOutgoingMessageAllocate() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntOutgoingMessageFree(AntOutgoingMessageListType* psMessage_)
+
+@brief Returns a block to the outgoing message pool in constant time.
+
+Requires:
+@param psMessage_ was allocated with AntOutgoingMessageAllocate() and is no longer on any list
+
+Promises:
+- psMessage_ is on Ant_psOutgoingMsgFreeList
+- The caller's interrupt mask is unchanged
+
+*/
+static void AntOutgoingMessageFree(AntOutgoingMessageListType* psMessage_)
+{
+  u32 u32Primask;
+  
+  AntLatestSlotRelease(psMessage_);
+  
+  u32Primask = __get_PRIMASK();
+  __disable_irq();
+  psMessage_->psNextMessage = Ant_psOutgoingMsgFreeList;
+  Ant_psOutgoingMsgFreeList = psMessage_;
+  Ant_sOutgoingPoolStats.u16InUse--;
+  __set_PRIMASK(u32Primask);
+  
+} /* end AntOutgoingMessageFree() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntOutgoingMessageAppend(AntOutgoingMessageListType* psMessage_)
+
+@brief Time stamps a filled pool block and links it at the end of Ant_psOutgoingMsgList.
+
+The list is walked and linked with interrupts disabled so messages can be queued 
+from an ISR while the state machine removes them.
+
+Requires:
+@param psMessage_ was allocated with AntOutgoingMessageAllocate() and holds a complete message
+
+Promises:
+- psMessage_ is the last message on Ant_psOutgoingMsgList
+- Ant_DebugQueuedDataMessages is incremented
+- The caller's interrupt mask is unchanged
+
+*/
+static void AntOutgoingMessageAppend(AntOutgoingMessageListType* psMessage_)
+{
+  AntOutgoingMessageListType *psListParser;
+  u32 u32Primask;
+
+  psMessage_->u32TimeStamp  = G_u32SystemTime1ms;
+  psMessage_->psNextMessage = NULL;
+
+  u32Primask = __get_PRIMASK();
+  __disable_irq();
+  Ant_DebugQueuedDataMessages++;
+  
+  /* Insert into an empty list */
+  if(Ant_psOutgoingMsgList == NULL)
+  {
+    Ant_psOutgoingMsgList = psMessage_;
+  }
+
+  /* Otherwise traverse the list to find the end where the new message will be inserted */
+  else
+  {
+    psListParser = Ant_psOutgoingMsgList;
+    while(psListParser->psNextMessage != NULL)  
+    {
+      psListParser = psListParser->psNextMessage;
+    }
+    
+    psListParser->psNextMessage = psMessage_;
+  }
+  
+  if(Ant_sOutgoingPoolStats.u16InUse > Ant_sThroughputStats.u16MaxOutgoingDepth)
+  {
+    Ant_sThroughputStats.u16MaxOutgoingDepth = Ant_sOutgoingPoolStats.u16InUse;
+  }
+  __set_PRIMASK(u32Primask);
+  
+} /* end AntOutgoingMessageAppend() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static u32 AntElapsedCycles(u32 u32StartMs_, u32 u32StartTick_)
+
+@brief Returns the CPU cycles since a SysTick reading.
+
+SysTick counts down from U32_SYSTICK_COUNT - 1 at MCK / SYSTICK_DIVIDER and 
+reloads every millisecond, so the whole milliseconds come from G_u32SystemTime1ms.
+Both ends are read with GetSystemTimeTicks() so a SysTick between the two reads 
+cannot produce a negative (wrapped) result.
+
+Requires:
+@param u32StartMs_ and u32StartTick_ are the pair from GetSystemTimeTicks() at the start
+
+Promises:
+- Returns the elapsed time in CPU cycles
+
+*/
+static u32 AntElapsedCycles(u32 u32StartMs_, u32 u32StartTick_)
+{
+  u32 u32EndMs;
+  u32 u32EndTick;
+  u32 u32Ticks;
+  
+  GetSystemTimeTicks(&u32EndMs, &u32EndTick);
+  u32Ticks = ((u32EndMs - u32StartMs_) * U32_SYSTICK_COUNT) + u32StartTick_ - u32EndTick;
+  return(u32Ticks * SYSTICK_DIVIDER);
+  
+} /* end AntElapsedCycles() */
 
-          case EVENT_RX_FAIL: /* Slave did not receive a message when expected */
-          {
-            /* The Slave missed a message it was expecting: communicate this to the
-            application in case it matters. Could also queue a debug message here. */
-            Ant_u8SlaveMissedMessageLow++;
-            if(Ant_u8SlaveMissedMessageLow == 0)
-            {
-              Ant_u8SlaveMissedMessageMid++;
-              if(Ant_u8SlaveMissedMessageMid == 0)
-              {
-                Ant_u8SlaveMissedMessageHigh++;
-                /* Let this overflow without action */
-              }
-            }
-            
-            /* Queue an ANT_TICK message to the application message list. */
-            AntTickExtended(au8MessageCopy);
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_RX_FAIL\n\r");
-#endif
-            break;
-          }
 
-          case EVENT_RX_FAIL_GO_TO_SEARCH: /* Slave has lost sync with Master (channel still open) */
-          {
-            /* The Slave missed enough consecutive messages so it goes back to search: communicate this to the
-            application in case it matters. Could also queue a debug message here. */
-            AntTickExtended(au8MessageCopy);
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_RX_FAIL_GO_TO_SEARCH\n\r");
-#endif
-            break;
-          }
+/*!-----------------------------------------------------------------------------/
+@fn static void AntThroughputUpdate(void)
 
-          case EVENT_TX: /* ANT has sent a data message */
-          {
-            /* If this is a Master device, then EVENT_TX means it's time to queue the 
-            next message */
-            if(G_asAntChannelConfiguration[u8Channel].AntChannelType == CHANNEL_TYPE_MASTER)
-            {
-              AntTickExtended(au8MessageCopy);
-            }
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_TX\n\r");
-#endif
-            break;
-          } 
+@brief Closes the message rate window every ANT_THROUGHPUT_PERIOD_MS.
 
-          case EVENT_TRANSFER_TX_COMPLETED: /* ACK received from an acknowledged data message */
-          { 
-            G_asAntChannelConfiguration[u8Channel].AntFlags |= _ANT_FLAGS_GOT_ACK;
+Requires:
+- NONE
 
-            AntTickExtended(au8MessageCopy);
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_TRANSFER_TX_COMPLETED\n\r");
-#endif
-            break;
-          } 
+Promises:
+- At the end of a window, u16TxPerSecond / u16RxPerSecond hold its counts, the 
+  maximums are updated and a new window starts
 
-          case EVENT_TRANSFER_TX_FAILED: /* ACK was not received from an acknowledged data message */
-          { 
-            /* Regardless of complete or fail, it is time to send the next message */
-            AntTickExtended(au8MessageCopy);
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_TRANSFER_TX_FAILED\n\r");
-#endif
-            break;
-          } 
+*/
+static void AntThroughputUpdate(void)
+{
+  if( IsTimeUp(&Ant_u32ThroughputTimer, ANT_THROUGHPUT_PERIOD_MS) )
+  {
+    Ant_u32ThroughputTimer = G_u32SystemTime1ms;
+    
+    Ant_sThroughputStats.u16TxPerSecond = Ant_u16TxThisPeriod;
+    Ant_sThroughputStats.u16RxPerSecond = Ant_u16RxThisPeriod;
+    if(Ant_u16TxThisPeriod > Ant_sThroughputStats.u16MaxTxPerSecond)
+    {
+      Ant_sThroughputStats.u16MaxTxPerSecond = Ant_u16TxThisPeriod;
+    }
+    if(Ant_u16RxThisPeriod > Ant_sThroughputStats.u16MaxRxPerSecond)
+    {
+      Ant_sThroughputStats.u16MaxRxPerSecond = Ant_u16RxThisPeriod;
+    }
+    
+    Ant_u16TxThisPeriod = 0;
+    Ant_u16RxThisPeriod = 0;
+  }
+  
+} /* end AntThroughputUpdate() */
 
-          case EVENT_RX_SEARCH_TIMEOUT: /* The ANT channel is going to close due to search timeout */
-          {
-            /* Forward this to application */
-            AntTickExtended(au8MessageCopy);
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_RX_SEARCH_TIMEOUT\n\r");
-#endif
-            break;
-          }
- 
-          case EVENT_CHANNEL_CLOSED: /* The ANT channel is now closed */
-          {
-            DebugPrintf("Channel closed\n\r");
-            G_asAntChannelConfiguration[u8Channel].AntFlags &= ~_ANT_FLAGS_CHANNEL_OPEN;
-#ifdef ANT_VERBOSE 
-            DebugPrintf("\n\rEVENT_CHANNEL_CLOSED\n\r");
-#endif
-            break;
-          }
-          
-          /* All other messages are unexpected for now */
-          default:
-          {
-            DebugPrintNumber(au8MessageCopy[BUFFER_INDEX_RESPONSE_CODE]);
-            DebugPrintf(": unexpected channel event\n\r");
 
-            G_u32AntFlags |= _ANT_FLAGS_UNEXPECTED_EVENT;
-            break;
-          }
-        } /* end Ant_pu8AntRxBufferUnreadMsg[EVENT_CODE_INDEX] */
-      } /* end else RF event */
-      
-      break; 
-    } /* end case MESG_RESPONSE_EVENT_ID */
+/*!-----------------------------------------------------------------------------/
+@fn static void AntLatestSlotRelease(AntOutgoingMessageListType* psMessage_)
+
+@brief Stops a message from being replaced by AntQueueLatestOutgoingMessage().
+
+Requires:
+@param psMessage_ has been handed to SSP or is about to be freed
+
+Promises:
+- If psMessage_ is its channel's waiting message, the channel's slot is empty
+
+*/
+static void AntLatestSlotRelease(AntOutgoingMessageListType* psMessage_)
+{
+  u8 u8Channel = psMessage_->au8MessageData[BUFFER_INDEX_CHANNEL_NUM] & CHANNEL_NUMBER_MASK;
+  
+  if( (u8Channel < ANT_NUM_CHANNELS) && (Ant_apsLatestOutgoingMsg[u8Channel] == psMessage_) )
+  {
+    Ant_apsLatestOutgoingMsg[u8Channel] = NULL;
+  }
+  
+} /* end AntLatestSlotRelease() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntUpdateApplicationMsgList(void)
+
+@brief Points G_psAntApplicationMsgList at the oldest message in the ring.
+
+Requires:
+- Ant_u8ApplicationMsgHead and Ant_sApplicationRingStats.u16InUse are current
+
+Promises:
+- G_psAntApplicationMsgList points to the oldest message, or is NULL if the ring is empty
+
+*/
+static void AntUpdateApplicationMsgList(void)
+{
+  if(Ant_sApplicationRingStats.u16InUse != 0)
+  {
+    G_psAntApplicationMsgList = &Ant_asApplicationMsgRing[Ant_u8ApplicationMsgHead];
+  }
+  else
+  {
+    G_psAntApplicationMsgList = NULL;
+  }
+  
+} /* end AntUpdateApplicationMsgList() */
+
+
+/* ANT Private Device Table Functions */
+
+/*!-----------------------------------------------------------------------------/
+@fn static u8 AntDeviceTableLookup(u16 u16DeviceID_, u8 u8DeviceType_)
+
+@brief Finds a device in the hash table.
+
+Requires:
+@param u16DeviceID_ is the device number to find
+@param u8DeviceType_ is the device type to find
+
+Promises:
+- Returns the index of the device in Ant_asDeviceTable or ANT_DEVICE_NONE
+
+*/
+static u8 AntDeviceTableLookup(u16 u16DeviceID_, u8 u8DeviceType_)
+{
+  u8 u8Index = Ant_au8DeviceHashBuckets[ANT_DEVICE_HASH(u16DeviceID_, u8DeviceType_)];
+  
+  while(u8Index != ANT_DEVICE_NONE)
+  {
+    if( (Ant_asDeviceTable[u8Index].sInfo.u16DeviceID == u16DeviceID_) &&
+        (Ant_asDeviceTable[u8Index].sInfo.u8DeviceType == u8DeviceType_) )
+    {
+      break;
+    }
+    
+    u8Index = Ant_asDeviceTable[u8Index].u8HashNext;
+  }
+  
+  return(u8Index);
+  
+} /* end AntDeviceTableLookup() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntDeviceLruUnlink(u8 u8Index_)
+
+@brief Removes an entry from the LRU list.
+
+Requires:
+@param u8Index_ is an entry on the LRU list
+
+Promises:
+- The entry's neighbours (or the list head / tail) are linked to each other
+
+*/
+static void AntDeviceLruUnlink(u8 u8Index_)
+{
+  AntDeviceEntryType *psEntry = &Ant_asDeviceTable[u8Index_];
+  
+  if(psEntry->u8LruPrev == ANT_DEVICE_NONE)
+  {
+    Ant_u8DeviceLruHead = psEntry->u8LruNext;
+  }
+  else
+  {
+    Ant_asDeviceTable[psEntry->u8LruPrev].u8LruNext = psEntry->u8LruNext;
+  }
+  
+  if(psEntry->u8LruNext == ANT_DEVICE_NONE)
+  {
+    Ant_u8DeviceLruTail = psEntry->u8LruPrev;
+  }
+  else
+  {
+    Ant_asDeviceTable[psEntry->u8LruNext].u8LruPrev = psEntry->u8LruPrev;
+  }
+  
+} /* end AntDeviceLruUnlink() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntDeviceLruPushFront(u8 u8Index_)
+
+@brief Makes an entry the most recently used.
+
+Requires:
+@param u8Index_ is an entry that is not on the LRU list
+
+Promises:
+- The entry is at Ant_u8DeviceLruHead
+
+*/
+static void AntDeviceLruPushFront(u8 u8Index_)
+{
+  Ant_asDeviceTable[u8Index_].u8LruPrev = ANT_DEVICE_NONE;
+  Ant_asDeviceTable[u8Index_].u8LruNext = Ant_u8DeviceLruHead;
+  
+  if(Ant_u8DeviceLruHead == ANT_DEVICE_NONE)
+  {
+    Ant_u8DeviceLruTail = u8Index_;
+  }
+  else
+  {
+    Ant_asDeviceTable[Ant_u8DeviceLruHead].u8LruPrev = u8Index_;
+  }
+  
+  Ant_u8DeviceLruHead = u8Index_;
+  
+} /* end AntDeviceLruPushFront() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static bool AntDeviceTableUpdate(u8* pu8Data_, AntExtendedDataType* psExtData_)
+
+@brief Records a data message in the device table.
+
+A device that is not in the table takes a free entry or, if the table is full,
+the entry of the device that has not been heard from for the longest time.
+
+Requires:
+- Ant_eDeviceTableMode is not ANT_DEVICE_TABLE_OFF
+- psExtData_ includes the channel ID (LIB_CONFIG_CHANNEL_ID_FLAG)
+
+@param pu8Data_ points to the 8 data bytes of the message
+@param psExtData_ points to the parsed extended data of the message
+
+Promises:
+- The device's payload, last-seen time, message count and RSSI statistics are 
+  updated and it is the most recently used entry
+- Returns TRUE if the message should also go to the application ring
+
+*/
+static bool AntDeviceTableUpdate(u8* pu8Data_, AntExtendedDataType* psExtData_)
+{
+  u8 u8Index;
+  u8 *pu8Link;
+  AntDeviceEntryType *psEntry;
+  
+  u8Index = AntDeviceTableLookup(psExtData_->u16DeviceID, psExtData_->u8DeviceType);
+  if(u8Index != ANT_DEVICE_NONE)
+  {
+    AntDeviceLruUnlink(u8Index);
+    psEntry = &Ant_asDeviceTable[u8Index];
+  }
+  else
+  {
+    /* Take a free entry or evict the least recently heard device */
+    if(Ant_u8DeviceTableCount < ANT_DEVICE_TABLE_SIZE)
+    {
+      u8Index = Ant_u8DeviceTableCount;
+      Ant_u8DeviceTableCount++;
+    }
+    else
+    {
+      u8Index = Ant_u8DeviceLruTail;
+      AntDeviceLruUnlink(u8Index);
+      
+      pu8Link = &Ant_au8DeviceHashBuckets[ANT_DEVICE_HASH(Ant_asDeviceTable[u8Index].sInfo.u16DeviceID, 
+                                                          Ant_asDeviceTable[u8Index].sInfo.u8DeviceType)];
+      while(*pu8Link != u8Index)
+      {
+        pu8Link = &Ant_asDeviceTable[*pu8Link].u8HashNext;
+      }
+      *pu8Link = Ant_asDeviceTable[u8Index].u8HashNext;
+    }
+    
+    psEntry = &Ant_asDeviceTable[u8Index];
+    memset(psEntry, 0, sizeof(AntDeviceEntryType));
+    psEntry->sInfo.u16DeviceID   = psExtData_->u16DeviceID;
+    psEntry->sInfo.u8DeviceType  = psExtData_->u8DeviceType;
+    AntRssiStatsReset(&psEntry->sInfo.sRssi);
+    
+    pu8Link = &Ant_au8DeviceHashBuckets[ANT_DEVICE_HASH(psExtData_->u16DeviceID, psExtData_->u8DeviceType)];
+    psEntry->u8HashNext = *pu8Link;
+    *pu8Link = u8Index;
+  }
+  
+  AntDeviceLruPushFront(u8Index);
+  
+  /* Update the device information */
+  psEntry->sInfo.u8TransType = psExtData_->u8TransType;
+  psEntry->sInfo.u32LastSeen = G_u32SystemTime1ms;
+  psEntry->sInfo.u32MessageCount++;
+  memcpy(psEntry->sInfo.au8LastPayload, pu8Data_, ANT_APPLICATION_MESSAGE_BYTES);
+  
+  if(psExtData_->u8Flags & LIB_CONFIG_RSSI_FLAG)
+  {
+    AntRssiStatsUpdate(&psEntry->sInfo.sRssi, &psEntry->s16RssiAverageX16, ANT_DEVICE_RSSI_AVERAGE, psExtData_->s8RSSI);
+  }
+  
+  return(Ant_eDeviceTableMode == ANT_DEVICE_TABLE_TRACK);
+  
+} /* end AntDeviceTableUpdate() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntRssiStatsReset(AntRssiStatsType* psRssi_)
+
+@brief Marks a set of RSSI statistics as having no samples.
+
+Requires:
+@param psRssi_ points to the statistics to clear
+
+Promises:
+- All values in psRssi_ are ANT_RSSI_NONE
+
+*/
+static void AntRssiStatsReset(AntRssiStatsType* psRssi_)
+{
+  psRssi_->s8Last    = ANT_RSSI_NONE;
+  psRssi_->s8Min     = ANT_RSSI_NONE;
+  psRssi_->s8Max     = ANT_RSSI_NONE;
+  psRssi_->s8Average = ANT_RSSI_NONE;
+  
+} /* end AntRssiStatsReset() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntRssiStatsUpdate(AntRssiStatsType* psRssi_, s16* ps16AverageX16_, 
+                                   s16 s16Window_, s8 s8Rssi_)
+
+@brief Adds one RSSI sample to a set of RSSI statistics.
+
+The average is kept in 1/16 dBm by the caller so it does not lose the fraction
+between samples.  The first sample seeds the average.
+
+Requires:
+- psRssi_ has been cleared with AntRssiStatsReset()
+
+@param psRssi_ points to the statistics to update
+@param ps16AverageX16_ points to the running average in 1/16 dBm that goes with psRssi_
+@param s16Window_ is the approximate number of samples in the running average
+@param s8Rssi_ is the new sample
+
+Promises:
+- Last, minimum, maximum and average in psRssi_ include s8Rssi_
+
+*/
+static void AntRssiStatsUpdate(AntRssiStatsType* psRssi_, s16* ps16AverageX16_, s16 s16Window_, s8 s8Rssi_)
+{
+  s16 s16Rssi = s8Rssi_;
+  
+  /* A minimum of ANT_RSSI_NONE means this is the first sample */
+  if(psRssi_->s8Min == ANT_RSSI_NONE)
+  {
+    psRssi_->s8Min = s8Rssi_;
+    psRssi_->s8Max = s8Rssi_;
+    *ps16AverageX16_ = s16Rssi * 16;
+  }
+  else
+  {
+    if(s8Rssi_ < psRssi_->s8Min)
+    {
+      psRssi_->s8Min = s8Rssi_;
+    }
+    if(s8Rssi_ > psRssi_->s8Max)
+    {
+      psRssi_->s8Max = s8Rssi_;
+    }
+    *ps16AverageX16_ += ((s16Rssi * 16) - *ps16AverageX16_) / s16Window_;
+  }
+  
+  psRssi_->s8Last    = s8Rssi_;
+  psRssi_->s8Average = (s8)(*ps16AverageX16_ / 16);
+  
+} /* end AntRssiStatsUpdate() */
+
 
-    case MESG_ACKNOWLEDGED_DATA_ID: /* An acknowledged data message was received */
-    /* Fall through */
-      
-    case MESG_BROADCAST_DATA_ID: /* A broadcast data message was received */
-    { 
-      /* Parse the extended data and put the message to the application buffer */
-      AntParseExtendedData(au8MessageCopy, &sExtendedData);
-      AntQueueExtendedApplicationMessage(ANT_DATA, &au8MessageCopy[BUFFER_INDEX_MESG_DATA], &sExtendedData);
-      
-#if 0 
-/* 2017-JUN-23 Don't think this should be here as it should be
-the application looking for data messages and deciding what
-that should be. If it is required, perhaps the call to AntTickExtended
-should be modified since au8MessageCopy doesn't have an EVENT CODE. 
+/*!-----------------------------------------------------------------------------/
+@fn static void AntLinkStatsEvent(u8 u8Channel_, u8 u8EventCode_)
+
+@brief Counts a channel event in the link statistics of its channel.
+
+Requires:
+@param u8Channel_ is the channel of the event
+@param u8EventCode_ is the event code from MESG_RESPONSE_EVENT_ID
+
+Promises:
+- The counter for u8EventCode_ is incremented; other events are ignored
+
+*/
+static void AntLinkStatsEvent(u8 u8Channel_, u8 u8EventCode_)
+{
+  AntLinkStatsType *psStats;
+  
+  if(u8Channel_ >= ANT_NUM_CHANNELS)
+  {
+    return;
+  }
+  
+  psStats = &Ant_asLinkStats[u8Channel_];
+  switch(u8EventCode_)
+  {
+    case EVENT_TX:
+      psStats->u32TxMessages++;
+      break;
       
-There are some legacy applications that will fail if this is removed, so
-we'll keep the code available until those can be updated.  Do not rely on
-this for future development. */
+    case EVENT_RX_FAIL:
+      psStats->u32RxFails++;
+      break;
       
-      /* If this is a Slave device, then a data message received means it's time to send */
-      if(G_asAntChannelConfiguration[u8Channel].AntChannelType == CHANNEL_TYPE_SLAVE)
-      {
-        AntTickExtended(au8MessageCopy);
-      }
-#endif      
+    case EVENT_RX_FAIL_GO_TO_SEARCH:
+      psStats->u32RxFailGoToSearch++;
       break;
-    } /* end case MESG_BROADCAST_DATA_ID */
-    
-    case MESG_CHANNEL_STATUS_ID: /* Message sent in response to a channel status request */
-    { 
+      
+    case EVENT_RX_SEARCH_TIMEOUT:
+      psStats->u32SearchTimeouts++;
       break;
-    } /* end case ChannelStatus_CMD */
-    
-    case MESG_VERSION_ID:
-    {
-      for(u8 i = 0; i < MESG_VERSION_SIZE; i++)
-      {
-        Ant_u8AntVersion[i] = au8MessageCopy[BUFFER_INDEX_VERSION_BYTE0 + i];
-      }
       
-      /* If we get a version message, we know that ANT comms is good */
-      G_u32ApplicationFlags |= _APPLICATION_FLAGS_ANT;
+    case EVENT_TRANSFER_TX_COMPLETED:
+      psStats->u32TransfersAcked++;
+      break;
       
+    case EVENT_TRANSFER_TX_FAILED:
+      psStats->u32TransfersFailed++;
       break;
-    } /* end case MESG_VERSION_ID */
-
-    case MESG_RESTART_ID:
-    {
-      G_u32AntFlags |= _ANT_FLAGS_RESTART;  
+      
+    case EVENT_TRANSFER_RX_FAILED:
+      psStats->u32TransfersRxFailed++;
       break;
-    } /* end case MESG_RESTART_ID */
-    
+      
     default:
-    {
-      G_u32AntFlags |= _ANT_FLAGS_UNEXPECTED_MSG;
       break;
-    }
-  } /* end switch( Ant_pu8AntRxBufferUnreadMsg[MESG_ID_OFFSET] ) */
-           
-  return(0);
+  }
   
-} /* end AntProcessMessage() */
+} /* end AntLinkStatsEvent() */
 
 
-/*!------------------------------------------------------------------------------
-@fn static bool AntParseExtendedData(u8* pu8SourceMessage_, AntExtendedDataType* psExtDataTarget_)
+/*!-----------------------------------------------------------------------------/
+@fn static void AntLinkStatsData(u8 u8Channel_, AntExtendedDataType* psExtData_)
 
-@brief Reads extended data based on the flags that are set.
+@brief Counts a received data message and its RSSI in the link statistics of its channel.
 
-Loads AntExtendedDataType which currently has these fields:
+Requires:
+@param u8Channel_ is the channel the message was received on
+@param psExtData_ points to the parsed extended data, or NULL if it was not parsed
+
+Promises:
+- u32RxMessages is incremented
+- If the message carried RSSI, the RSSI values are updated
+
+*/
+static void AntLinkStatsData(u8 u8Channel_, AntExtendedDataType* psExtData_)
 {
-  u8 u8Channel;                        
-  u16 u16DeviceID;                         
-  u8 u8DeviceType;                         
-  u8 u8TransType;                          
-  u8 u8Flags;                             
-  s8 s8RSSI;                              
-} AntExtendedDataType;
+  AntLinkStatsType *psStats;
+  
+  if(u8Channel_ >= ANT_NUM_CHANNELS)
+  {
+    return;
+  }
+  
+  psStats = &Ant_asLinkStats[u8Channel_];
+  psStats->u32RxMessages++;
+  
+  if( (psExtData_ == NULL) || !(psExtData_->u8Flags & LIB_CONFIG_RSSI_FLAG) )
+  {
+    return;
+  }
+  
+  psStats->u32RssiSamples++;
+  AntRssiStatsUpdate(&psStats->sRssi, &Ant_as16LinkRssiAverageX16[u8Channel_], ANT_LINK_RSSI_AVERAGE, psExtData_->s8RSSI);
+  
+} /* end AntLinkStatsData() */
 
-For now we don't have a use for MeasurementType or Threshold from the RSSI
-extended information, so this code is commented out but in the correct location if needed.
+
+/* ANT Private Burst Functions */
+
+/*!-----------------------------------------------------------------------------/
+@fn static u16 AntBurstTxChunkEnd(void)
+
+@brief Returns the offset just past the last byte of the burst being sent.
 
 Requires:
-@param pu8SourceMessage_ points to an ANT message buffer that holds a complete ANT data
-       message structure except for SYNC byte; therefore buffer indices from antmessage.h can be used.
-@param psExtDataTarget_ points to the target AntExtendedDataType structure
+- A burst transmission is in progress
 
 Promises:
-- Returns TRUE if extended data is present; all values are read into local variables and then
-  loaded into psExtDataTarget_.
-- Returns FALSE if no extended data is present; psExtDataTarget_ is set to default values
+- Returns the end of the current burst (limited to the transfer length)
 
 */
-static bool AntParseExtendedData(u8* pu8SourceMessage_, AntExtendedDataType* psExtDataTarget_)
+static u16 AntBurstTxChunkEnd(void)
 {
-  bool bReturnValue;
-  u8 u8MessageSize;
-  u8 u8Channel;                        
-  u8 u8Flags = 0;       
-  u8 u8BufferOffset = 0;
+  u16 u16ChunkEnd = Ant_u16BurstTxChunkStart + ANT_BURST_CHUNK_BYTES;
   
-  /* Channel ID extended data */
-  u16 u16DeviceID = 0xFFFF;;                         
-  u8 u8DeviceType = 0xFF;                        
-  u8 u8TransType = 0xFF;                          
-
-  /* RSSI extended data */
-  s8 s8RSSI = 0xFF;   
-  //u8 u8MeasurementType = 0xFF;
-  //u8 u8Threshold = 0xFF;
+  if(u16ChunkEnd > Ant_sBurstStatus.u16TxLength)
+  {
+    u16ChunkEnd = Ant_sBurstStatus.u16TxLength;
+  }
   
-  /* RF Timestamp data */
-  u16 u16RxTimestamp = 0xFFFF;
-    
-  /* Get generic data */
-  u8MessageSize = *(pu8SourceMessage_ + BUFFER_INDEX_MESG_SIZE);
-  u8Channel = *(pu8SourceMessage_ + BUFFER_INDEX_CHANNEL_NUM);
+  return(u16ChunkEnd);
+  
+} /* end AntBurstTxChunkEnd() */
 
-  /* Check to see if the message is the regular size (MESG_MAX_DATA_SIZE) */
-  if(u8MessageSize == MESG_MAX_DATA_SIZE)
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntBurstTxService(void)
+
+@brief Queues the next packets of the burst being sent.
+
+At most ANT_BURST_PACKETS_PER_PASS packets are queued per call and 
+ANT_BURST_POOL_RESERVE outgoing blocks are always left for other messages.
+Nothing past the end of the current burst is queued until ANT reports 
+EVENT_TRANSFER_TX_COMPLETED for it.
+
+Requires:
+- Called from AntSM_Idle
+
+Promises:
+- Burst packets are added to Ant_psOutgoingMsgList with the sequence number in
+  the upper bits of the channel byte and SEQUENCE_LAST_MESSAGE on the last packet 
+  of each burst
+- The sequence 0 packet of each burst is a header with the offset of the burst's 
+  data at ANT_BURST_HEADER_INDEX_OFFSET and the transfer length at 
+  ANT_BURST_HEADER_INDEX_LENGTH
+
+*/
+static void AntBurstTxService(void)
+{
+  u8 au8Packet[MESG_MAX_SIZE];
+  u16 u16ChunkEnd;
+  u16 u16Bytes;
+  u8 u8Sequence;
+  
+  if(Ant_sBurstStatus.eTxState != ANT_BURST_BUSY)
   {
-    bReturnValue = FALSE;
+    return;
   }
   
-  /* Check for a message that is too big or too small */
-  else if( (u8MessageSize > MESG_MAX_SIZE) ||
-           (u8MessageSize < MESG_MAX_DATA_SIZE) )
+  u16ChunkEnd = AntBurstTxChunkEnd();
+  for(u8 i = 0; i < ANT_BURST_PACKETS_PER_PASS; i++)
   {
-    DebugPrintf("\n\rUnexpected ANT message size\n\n\r");
-    bReturnValue = FALSE;
+    if( (Ant_u16BurstTxNextByte >= u16ChunkEnd) ||
+        ((Ant_sOutgoingPoolStats.u16InUse + ANT_BURST_POOL_RESERVE) >= Ant_sOutgoingPoolStats.u16Size) )
+    {
+      break;
+    }
+    
+    /* Build the packet: the header if this is the start of the burst, otherwise data */
+    au8Packet[0] = MESG_DATA_SIZE;
+    au8Packet[1] = MESG_BURST_DATA_ID;
+    memset(&au8Packet[BUFFER_INDEX_MESG_DATA], 0, ANT_BURST_PACKET_BYTES);
+    
+    u8Sequence = Ant_u8BurstTxSequence;
+    if(u8Sequence == 0)
+    {
+      u16Bytes = 0;
+      au8Packet[BUFFER_INDEX_MESG_DATA + ANT_BURST_HEADER_INDEX_OFFSET]     = (u8)(Ant_u16BurstTxChunkStart & 0xFF);
+      au8Packet[BUFFER_INDEX_MESG_DATA + ANT_BURST_HEADER_INDEX_OFFSET + 1] = (u8)(Ant_u16BurstTxChunkStart >> 8);
+      au8Packet[BUFFER_INDEX_MESG_DATA + ANT_BURST_HEADER_INDEX_LENGTH]     = (u8)(Ant_sBurstStatus.u16TxLength & 0xFF);
+      au8Packet[BUFFER_INDEX_MESG_DATA + ANT_BURST_HEADER_INDEX_LENGTH + 1] = (u8)(Ant_sBurstStatus.u16TxLength >> 8);
+    }
+    else
+    {
+      u16Bytes = u16ChunkEnd - Ant_u16BurstTxNextByte;
+      if(u16Bytes <= ANT_BURST_PACKET_BYTES)
+      {
+        u8Sequence |= SEQUENCE_LAST_MESSAGE;
+      }
+      else
+      {
+        u16Bytes = ANT_BURST_PACKET_BYTES;
+      }
+      memcpy(&au8Packet[BUFFER_INDEX_MESG_DATA], Ant_pu8BurstTxData + Ant_u16BurstTxNextByte, u16Bytes);
+    }
+    
+    au8Packet[2] = (u8)Ant_eBurstTxChannel | u8Sequence;
+    au8Packet[BUFFER_INDEX_MESG_DATA + ANT_BURST_PACKET_BYTES] = AntCalculateTxChecksum(au8Packet);
+    
+    if( !AntQueueOutgoingMessage(au8Packet) )
+    {
+      break;
+    }
+    
+    Ant_u16BurstTxNextByte += u16Bytes;
+    Ant_u8BurstTxSequence = ANT_BURST_NEXT_SEQUENCE(Ant_u8BurstTxSequence);
   }
   
-  /* Otherwise we have some extended message data */
-  else 
+} /* end AntBurstTxService() */
+
+
+/*!-----------------------------------------------------------------------------/
+@fn static void AntBurstTxEvent(u8 u8Channel_, bool bSuccess_)
+
+@brief Advances or restarts the burst being sent based on ANT's result.
+
+Requires:
+@param u8Channel_ is the channel of the event
+@param bSuccess_ is TRUE for EVENT_TRANSFER_TX_COMPLETED; FALSE for 
+       EVENT_TRANSFER_TX_FAILED or a rejected burst packet
+
+Promises:
+- On success after the whole burst was queued, the next burst is started or the
+  transfer is ANT_BURST_DONE
+- On failure, the rest of the burst is purged from the outgoing list and the burst
+  is sent again from its header, or the transfer is ANT_BURST_FAILED after
+  ANT_BURST_MAX_RETRIES attempts
+- Events for other channels or with no transfer in progress are ignored
+
+*/
+static void AntBurstTxEvent(u8 u8Channel_, bool bSuccess_)
+{
+  u16 u16ChunkEnd;
+  
+  if( (Ant_sBurstStatus.eTxState != ANT_BURST_BUSY) ||
+      (u8Channel_ != (u8)Ant_eBurstTxChannel) )
   {
-    /* The byte after data must be flag byte */
-    u8Flags = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA_FLAGS);
-    bReturnValue = TRUE;
+    return;
+  }
+  
+  if(bSuccess_)
+  {
+    /* A completion before the whole burst was queued is not for this burst */
+    u16ChunkEnd = AntBurstTxChunkEnd();
+    if(Ant_u16BurstTxNextByte < u16ChunkEnd)
+    {
+      return;
+    }
     
-    /* Channel ID information is always first if it's there */
-    if(u8Flags & LIB_CONFIG_CHANNEL_ID_FLAG)
+    Ant_sBurstStatus.u16TxBytesSent = u16ChunkEnd;
+    Ant_u16BurstTxChunkStart = u16ChunkEnd;
+    Ant_u8BurstTxSequence = 0;
+    Ant_u8BurstTxAttempts = 0;
+    
+    if(Ant_u16BurstTxChunkStart >= Ant_sBurstStatus.u16TxLength)
     {
-      u16DeviceID = (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) & 0x00FF;
-      u8BufferOffset++;
-      u16DeviceID |= ( (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) << 8 ) & 0xFF00;
-      u8BufferOffset++;
-      u8DeviceType = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
-      u8BufferOffset++;
-      u8TransType = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
-      u8BufferOffset++;
+      Ant_sBurstStatus.eTxState = ANT_BURST_DONE;
+    }
+  }
+  else
+  {
+    /* ANT can report several errors for one burst; only the first restarts it */
+    if(Ant_u8BurstTxSequence == 0)
+    {
+      return;
     }
     
-    /* RSSI information is always next if it's there */
-    if(u8Flags & LIB_CONFIG_RSSI_FLAG)
+    AntBurstPurgeOutgoing();
+    Ant_u16BurstTxNextByte = Ant_u16BurstTxChunkStart;
+    Ant_u8BurstTxSequence = 0;
+    
+    Ant_u8BurstTxAttempts++;
+    if(Ant_u8BurstTxAttempts > ANT_BURST_MAX_RETRIES)
     {
-      //u8MeasurementType = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
-      u8BufferOffset++;
-      s8RSSI = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
-      u8BufferOffset++;
-      //u8Threshold = *(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset);
-      u8BufferOffset++;
-    }   
-
-    /* Timestamp information is always last */
-    if(u8Flags & LIB_CONFIG_RX_TIMESTAMP_FLAG)
+      Ant_sBurstStatus.eTxState = ANT_BURST_FAILED;
+      DebugPrintf("ANT burst transfer failed\n\r");
+    }
+    else
     {
-      u16RxTimestamp = (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) & 0x00FF;
-      u8BufferOffset++;
-      u16RxTimestamp |= ( (u16)(*(pu8SourceMessage_ + BUFFER_INDEX_EXT_DATA + u8BufferOffset)) << 8 ) & 0xFF00;
+      Ant_sBurstStatus.u16TxRetries++;
     }
   }
   
-  /* Load psExtDataTarget_ (either real or default data) and return */
-  psExtDataTarget_->u8Flags      = u8Flags;
-  psExtDataTarget_->u8Channel    = u8Channel;
-  psExtDataTarget_->u16DeviceID  = u16DeviceID;
-  psExtDataTarget_->u8DeviceType = u8DeviceType;
-  psExtDataTarget_->u8TransType  = u8TransType;
-  psExtDataTarget_->s8RSSI       = s8RSSI;
-
-  return bReturnValue;
-  
-} /* end AntParseExtendedData */
-
+} /* end AntBurstTxEvent() */
 
-/*!-----------------------------------------------------------------------------/
-@fn static bool AntQueueExtendedApplicationMessage(AntApplicationMessageType eMessageType_, u8* pu8DataSource_, AntExtendedDataType* psExtData_)
 
-@brief Creates a new ANT message structure and adds it to G_psAntApplicationMsgList.
+/*!-----------------------------------------------------------------------------/
+@fn static void AntBurstPurgeOutgoing(void)
 
-The Application list is used to communicate message information between the ANT driver and
-the ANT_API simplified interface task.  It has room for ANT_APPLICATION_MESSAGE_BUFFER_SIZE
-messages. The messages are either ANT_DATA or ANT_TICK messsage and include
-all information and data from the original ANT message.
+@brief Removes the queued packets of the burst being sent from Ant_psOutgoingMsgList.
 
 Requires:
-- Enough space is available on the heap
-
-@param eMessageType_ specifies the type of message
-@param pu8DataSource_ is a pointer to the first element of an array of 8 data bytes
-@param psTargetList_ is a pointer to the list pointer that is being updated
+- NONE
 
 Promises:
-- A new list item in the target linked list is created and inserted at the end
-  of the list.
-- Returns TRUE if the entry is added successfully.
-- Returns FALSE if the malloc fails or the list is full.
+- All burst packets for Ant_eBurstTxChannel are returned to the pool except a 
+  message that is currently being transmitted
 
 */
-static bool AntQueueExtendedApplicationMessage(AntApplicationMessageType eMessageType_, 
-                                               u8* pu8DataSource_, 
-                                               AntExtendedDataType* psExtData_)
+static void AntBurstPurgeOutgoing(void)
 {
-  AntApplicationMsgListType *psNewMessage;
-  AntApplicationMsgListType *psListParser;
-  u8 u8MessageCount = 0;
-  u8 Ant_au8AddMessageFailMsg[] = "\n\rNo space in AntQueueApplicationMessage\n\r";
-  
-  /* Allocate space for the new message - always do maximum message size */
-  psNewMessage = malloc( sizeof(AntApplicationMsgListType) );
-  if (psNewMessage == NULL)
-  {
-    DebugPrintf(Ant_au8AddMessageFailMsg);
-    return(FALSE);
-  }
+  AntOutgoingMessageListType *psPrevious = NULL;
+  AntOutgoingMessageListType *psMessage = Ant_psOutgoingMsgList;
+  AntOutgoingMessageListType *psNext;
   
-  /* Fill in all the fields of the newly allocated message structure */
-  for(u8 i = 0; i < ANT_APPLICATION_MESSAGE_BYTES; i++)
+  /* The head of the list must stay if SSP is still sending it */
+  if( (Ant_u32CurrentTxMessageToken != 0) && (psMessage != NULL) )
   {
-    psNewMessage->au8MessageData[i] = *(pu8DataSource_ + i);
+    psPrevious = psMessage;
+    psMessage = psMessage->psNextMessage;
   }
   
-  /* Fill basic items */
-  psNewMessage->u32TimeStamp  = G_u32SystemTime1ms;
-  psNewMessage->eMessageType  = eMessageType_;
-  
-  /* Copy all extended data fields */
-  psNewMessage->sExtendedData.u8Channel    = psExtData_->u8Channel;
-  psNewMessage->sExtendedData.u16DeviceID  = psExtData_->u16DeviceID;
-  psNewMessage->sExtendedData.u8DeviceType = psExtData_->u8DeviceType;
-  psNewMessage->sExtendedData.u8TransType  = psExtData_->u8TransType;
-  psNewMessage->sExtendedData.u8Flags      = psExtData_->u8Flags;
-  psNewMessage->sExtendedData.s8RSSI       = psExtData_->s8RSSI;
-    
-  psNewMessage->psNextMessage = NULL;
-
-  /* Insert into an empty list */
-  if(G_psAntApplicationMsgList == NULL)
-  {
-    G_psAntApplicationMsgList = psNewMessage;
-    Ant_u32ApplicationMessageCount++;
-  }
-
-  /* Otherwise traverse the list to find the end where the new message will be inserted */
-  else
+  while(psMessage != NULL)
   {
-    psListParser = G_psAntApplicationMsgList;
-    while(psListParser->psNextMessage != NULL) 
-    {
-      psListParser = psListParser->psNextMessage;
-      u8MessageCount++;
-    }
+    psNext = psMessage->psNextMessage;
     
-    /* Check for full list */
-    if(u8MessageCount < ANT_APPLICATION_MESSAGE_BUFFER_SIZE)
+    if( (psMessage->au8MessageData[BUFFER_INDEX_MESG_ID] == MESG_BURST_DATA_ID) &&
+        ((psMessage->au8MessageData[BUFFER_INDEX_CHANNEL_NUM] & CHANNEL_NUMBER_MASK) == (u8)Ant_eBurstTxChannel) )
     {
-      /* Insert the new message at the end of the list */
-      psListParser->psNextMessage = psNewMessage;
-      Ant_u32ApplicationMessageCount++;
+      /* Re-read the link in case an ISR just appended behind this message */
+      __disable_irq();
+      psNext = psMessage->psNextMessage;
+      if(psPrevious == NULL)
+      {
+        Ant_psOutgoingMsgList = psNext;
+      }
+      else
+      {
+        psPrevious->psNextMessage = psNext;
+      }
+      __enable_irq();
+      
+      AntOutgoingMessageFree(psMessage);
     }
-    /* Handle a full list */
     else
     {
-      DebugPrintf(Ant_au8AddMessageFailMsg);
-      return(FALSE);
+      psPrevious = psMessage;
     }
-  }
-    
-  return(TRUE);
     
-} /* end AntQueueExtendedApplicationMessage() */
+    psMessage = psNext;
+  }
+  
+} /* end AntBurstPurgeOutgoing() */
 
 
 /*!-----------------------------------------------------------------------------/
-@fn static void AntTickExtended(u8* pu8AntMessage_)
+@fn static bool AntBurstRxPacket(u8 u8Channel_, u8 u8ChannelByte_, u8* pu8Data_)
 
-@brief Queues an ANT_TICK message to the application message queue.
+@brief Adds a received burst packet to the armed receive buffer.
 
-This is expected to run for a Channel Event ANT message though it will work
-for a standard Channel Response (although the names of the indexes will not
-be quite right).  Currently this function is only called for Channel Events,
-so if that changes it should be thought about carefully.
+The sequence 0 packet of each burst is the header from AntBurstTxService().
+A header with offset 0 starts a new transfer; any other header continues the 
+current transfer from its offset, which also covers a burst the sender re-sent
+after a failure.  A packet out of sequence drops the partial burst and data is
+ignored until the next header.
 
 Requires:
-@param pu8AntMessage_ points to an ANT message that starts with the LENGTH 
-(i.e. no SYNC byte) 
+@param u8Channel_ is the channel the packet was received on
+@param u8ChannelByte_ is the raw channel byte with the sequence number bits
+@param pu8Data_ points to the 8 data bytes of the packet
 
 Promises:
-- A MESSAGE_ANT_TICK is queued to G_psAntApplicationMsgList
+- Returns FALSE if burst reception is not armed for u8Channel_
+- Otherwise returns TRUE and the packet data is copied to the buffer, updating
+  u16RxBytes at the end of each burst and setting ANT_BURST_DONE once all 
+  u16RxLength bytes have arrived
+- A transfer longer than the buffer is ANT_BURST_FAILED
 
 */
-static void AntTickExtended(u8* pu8AntMessage_)
+static bool AntBurstRxPacket(u8 u8Channel_, u8 u8ChannelByte_, u8* pu8Data_)
 {
-  u8 au8Message[ANT_APPLICATION_MESSAGE_BYTES];
-  AntExtendedDataType sExtData;
-
-  /* Update data to communicate the ANT_TICK to the application */
-  au8Message[ANT_TICK_MSG_ID_INDEX]               = MESSAGE_ANT_TICK;
-  au8Message[ANT_TICK_MSG_CHANNEL_INDEX]          = *(pu8AntMessage_ + BUFFER_INDEX_CHANNEL_NUM);
-  au8Message[ANT_TICK_MSG_RESPONSE_TYPE_INDEX]    = *(pu8AntMessage_ + BUFFER_INDEX_RESPONSE_MESG_ID);
-  au8Message[ANT_TICK_MSG_EVENT_CODE_INDEX]       = *(pu8AntMessage_ + BUFFER_INDEX_RESPONSE_CODE);
-  au8Message[ANT_TICK_MSG_SENTINEL_INDEX]         = MESSAGE_ANT_TICK_SENTINEL;
-  au8Message[ANT_TICK_MSG_MISSED_HIGH_BYTE_INDEX] = Ant_u8SlaveMissedMessageHigh;
-  au8Message[ANT_TICK_MSG_MISSED_MID_BYTE_INDEX]  = Ant_u8SlaveMissedMessageMid;
-  au8Message[ANT_TICK_MSG_MISSED_LOW_BYTE_INDEX]  = Ant_u8SlaveMissedMessageLow;
-
-  /* Extended data is not valid for an ANT_TICK message */
-  sExtData.u8Channel    = au8Message[ANT_TICK_MSG_CHANNEL_INDEX];
-  sExtData.u16DeviceID  = 0xFF;
-  sExtData.u8DeviceType = 0xFF;
-  sExtData.u8TransType  = 0xFF;
-  sExtData.s8RSSI       = 0xFF;
-  sExtData.u8Flags      = 0xFF;
+  u8 u8Sequence = u8ChannelByte_ & (SEQUENCE_NUMBER_MASK & ~SEQUENCE_LAST_MESSAGE);
+  u16 u16Offset;
+  u16 u16Length;
+  u16 u16Bytes;
   
-  /* Data is ready so queue it in to the application buffer */
-  AntQueueExtendedApplicationMessage(ANT_TICK, 
-                                     &au8Message[ANT_TICK_MSG_ID_INDEX],
-                                     &sExtData);
-
-} /* end AntTickExtended() */
+  if( (Ant_pu8BurstRxBuffer == NULL) || (u8Channel_ != (u8)Ant_eBurstRxChannel) )
+  {
+    return(FALSE);
+  }
+  
+  /* Header packet */
+  if(u8Sequence == 0)
+  {
+    u16Offset = pu8Data_[ANT_BURST_HEADER_INDEX_OFFSET] | (pu8Data_[ANT_BURST_HEADER_INDEX_OFFSET + 1] << 8);
+    u16Length = pu8Data_[ANT_BURST_HEADER_INDEX_LENGTH] | (pu8Data_[ANT_BURST_HEADER_INDEX_LENGTH + 1] << 8);
+    
+    if( (Ant_sBurstStatus.eRxState == ANT_BURST_BUSY) && (Ant_u8BurstRxSequence != 0) )
+    {
+      Ant_sBurstStatus.u16RxFailures++;
+    }
+    Ant_u8BurstRxSequence = 0;
+    
+    if(u16Offset == 0)
+    {
+      Ant_sBurstStatus.u16RxLength = u16Length;
+      Ant_sBurstStatus.u16RxBytes  = 0;
+      if( (u16Length == 0) || (u16Length > Ant_u16BurstRxSize) )
+      {
+        Ant_sBurstStatus.u16RxFailures++;
+        Ant_sBurstStatus.eRxState = ANT_BURST_FAILED;
+        return(TRUE);
+      }
+      Ant_sBurstStatus.eRxState = ANT_BURST_BUSY;
+    }
+    else if( (Ant_sBurstStatus.eRxState != ANT_BURST_BUSY) || 
+             (u16Length != Ant_sBurstStatus.u16RxLength) ||
+             (u16Offset > Ant_sBurstStatus.u16RxBytes) )
+    {
+      /* The middle of a transfer whose start was missed */
+      return(TRUE);
+    }
+    
+    Ant_u16BurstRxNextByte = u16Offset;
+    Ant_u8BurstRxSequence = ANT_BURST_NEXT_SEQUENCE(0);
+    return(TRUE);
+  }
+  
+  /* Data packets are only used between a header and the end of its burst */
+  if( (Ant_sBurstStatus.eRxState != ANT_BURST_BUSY) || (Ant_u8BurstRxSequence == 0) )
+  {
+    return(TRUE);
+  }
+  
+  if( (u8Sequence != Ant_u8BurstRxSequence) ||
+      (Ant_u16BurstRxNextByte >= Ant_sBurstStatus.u16RxLength) )
+  {
+    AntBurstRxFailed(u8Channel_);
+    return(TRUE);
+  }
+  
+  /* The last packet of the transfer is zero-padded */
+  u16Bytes = Ant_sBurstStatus.u16RxLength - Ant_u16BurstRxNextByte;
+  if(u16Bytes > ANT_BURST_PACKET_BYTES)
+  {
+    u16Bytes = ANT_BURST_PACKET_BYTES;
+  }
+  
+  memcpy(Ant_pu8BurstRxBuffer + Ant_u16BurstRxNextByte, pu8Data_, u16Bytes);
+  Ant_u16BurstRxNextByte += u16Bytes;
+  Ant_u8BurstRxSequence = ANT_BURST_NEXT_SEQUENCE(Ant_u8BurstRxSequence);
+  
+  if(u8ChannelByte_ & SEQUENCE_LAST_MESSAGE)
+  {
+    Ant_sBurstStatus.u16RxBytes = Ant_u16BurstRxNextByte;
+    Ant_u8BurstRxSequence = 0;
+    if(Ant_u16BurstRxNextByte >= Ant_sBurstStatus.u16RxLength)
+    {
+      Ant_sBurstStatus.eRxState = ANT_BURST_DONE;
+    }
+  }
+  
+  return(TRUE);
+  
+} /* end AntBurstRxPacket() */
 
 
 /*!-----------------------------------------------------------------------------/
-@fn static void AntDeQueueOutgoingMessage(void)
+@fn static void AntBurstRxFailed(u8 u8Channel_)
 
-@brief Removes the oldest entry of Ant_psOutgoingMsgList.
+@brief Drops a partially received burst.
+
+The transfer stays ANT_BURST_BUSY because the sender re-sends a failed burst
+from its header.
 
 Requires:
-- NONE 
+@param u8Channel_ is the channel of the failure
 
 Promises:
-- Ant_psOutgoingMsgList = Ant_psOutgoingMsgList->psNextMessage 
-  and the memory is freed
+- If a burst was being received on u8Channel_, u16RxFailures is incremented and
+  data is ignored until the next header
 
 */
-static void AntDeQueueOutgoingMessage(void)
+static void AntBurstRxFailed(u8 u8Channel_)
 {
-  AntOutgoingMessageListType *psMessageToKill;
-  
-  if(Ant_psOutgoingMsgList != NULL)
+  if( (Ant_pu8BurstRxBuffer != NULL) && (u8Channel_ == (u8)Ant_eBurstRxChannel) &&
+      (Ant_sBurstStatus.eRxState == ANT_BURST_BUSY) && (Ant_u8BurstRxSequence != 0) )
   {
-    psMessageToKill = Ant_psOutgoingMsgList;
-    Ant_psOutgoingMsgList = Ant_psOutgoingMsgList->psNextMessage;
-  
-    /* The doomed message is properly disconnected, so kill it */
-    free(psMessageToKill);
+    Ant_sBurstStatus.u16RxFailures++;
+    Ant_u8BurstRxSequence = 0;
   }
   
-} /* end AntDeQueueOutgoingMessage() */
+} /* end AntBurstRxFailed() */
 
 
 /* ANT Private Serial-layer Functions */
@@ -1676,8 +3527,9 @@ Requires:
 
 Promises:
 - Ant_pu8AntRxBufferNextChar is initialized to start of AntRxBuffer
-- Ant_pu8AntRxBufferUnreadMsg is initialized to start of AntRxBuffer
-- Message counter Ant_u8AntNewRxMessages reset to 0;
+- Ant_pu8AntRxBufferUnreadMsg is initialized to start of AntRxBuffer and 
+  Ant_pu8AntRxBufferWrapMark to its end
+- Message counter Ant_u8AntNewRxMessages and the frame time ring reset to 0 and the Rx parser is waiting for SYNC
 - If ANT starts up correctly and responds to version request, then 
   G_u32SystemFlags _APPLICATION_FLAGS_ANT is set and Ant_u8AntVersion is populated
   with the returned version information from the ANT IC.  
@@ -1688,11 +3540,17 @@ static void AntSyncSerialInitialize(void)
   u32 u32EventTimer;
   u8 u8ErrorCount = 0;
   
-  /* Initialize buffer pointers */  
+  /* Initialize buffer pointers and the receive parser */  
   Ant_pu8AntRxBufferNextChar    = Ant_au8AntRxBuffer;
-  Ant_pu8AntRxBufferCurrentChar = Ant_au8AntRxBuffer;
   Ant_pu8AntRxBufferUnreadMsg   = Ant_au8AntRxBuffer;
+  Ant_pu8AntRxBufferWrapMark    = &Ant_au8AntRxBuffer[ANT_RX_BUFFER_SIZE];
   Ant_u8AntNewRxMessages = 0;
+  Ant_u8RxFrameTimeIn  = 0;
+  Ant_u8RxFrameTimeOut = 0;
+  Ant_eRxParseState = ANT_RX_PARSE_SYNC;
+  Ant_bRxFrameComplete = FALSE;
+  Ant_bRxFrameWrapped = FALSE;
+  Ant_bRxOverrun = FALSE;
  
   /* Reset the 51422 and initialize SRDY and MRDY */
   u32EventTimer = G_u32SystemTime1ms;
@@ -1718,20 +3576,36 @@ static void AntSyncSerialInitialize(void)
   /* SEN is asserted if bErrorStatus is FALSE */
   if (u8ErrorCount == 0)
   {
-    /* Receive and process what should be the restart message */
-    AntRxMessage();
-    AntProcessMessage();   
-
-    /* Send out version request message and expect response */
+    /* Queue the version request behind the restart message */
     G_au8ANTGetVersion[4] = AntCalculateTxChecksum(&G_au8ANTGetVersion[0]);
-    AntTxMessage(&G_au8ANTGetVersion[0]);   
+    AntQueueOutgoingMessage(&G_au8ANTGetVersion[0]);   
     
-    /* Process the message through AntExpectResponse */
-    u8ErrorCount += AntExpectResponse(MESG_VERSION_ID, ANT_MSG_TIMEOUT_MS);
+    /* Run the state machine until ANT has sent its restart message and answered the 
+    version request (processing the reply sets _APPLICATION_FLAGS_ANT) and the 
+    transaction is closed.  This blocks, so it is only allowed during initialization. */
+    Ant_pfnStateMachine = AntSM_Idle;
+    u32EventTimer = G_u32SystemTime1ms;
+    while( ( !(G_u32ApplicationFlags & _APPLICATION_FLAGS_ANT) || 
+             (Ant_pfnStateMachine != AntSM_Idle) ) && 
+           (u8ErrorCount == 0) )
+    {
+      Ant_pfnStateMachine();
+      if(IsTimeUp(&u32EventTimer, ANT_MSG_TIMEOUT_MS))
+      {
+        u8ErrorCount++;
+      }
+    }
   }
   
   if(u8ErrorCount != 0)
   {
+    /* Leave the interface quiet with nothing left to send */
+    SYNC_MRDY_DEASSERT();
+    while(Ant_psOutgoingMsgList != NULL)
+    {
+      AntDeQueueOutgoingMessage();
+    }
+    
     DebugPrintf("\n\rANT failed boot\n\r");
   }
  
@@ -1741,31 +3615,68 @@ static void AntSyncSerialInitialize(void)
 /*!-----------------------------------------------------------------------------
 @fn static void AntSrdyPulse(void)
 
-@brief Pulses Srdy with added delays on the front and middle. 
+@brief Starts an SRDY pulse timed by the TC0 Channel 0 one-shot.
 
-1. A delay controlled by ANT_SRDY_DELAY is passed
-2. SRDY is asserted
-3. A delay of ANT_SRDY_PERIOD is passed
-4. SRDY is deasserted
+The pulse runs entirely from timer interrupts, so this returns immediately:
+1. ANT_SRDY_DELAY_TICKS pass to guarantee space between pulses
+2. SRDY is asserted on RA compare (AntSrdyAssertCallback)
+3. ANT_SRDY_PERIOD_TICKS pass
+4. SRDY is deasserted on RC compare (AntSrdyDeassertCallback) and the timer stops
 
 Requires:
-- NONE 
+- TIMER0_CHANNEL0 was set up in AntInitialize 
 
 Promises:
-- SRDY pulsed and ends deasserted
+- SRDY is deasserted now and a new pulse is started; a pulse already in 
+  progress is cut short and restarted
 
 */
 static void AntSrdyPulse(void)
 {
-  for(u32 i = 0; i < ANT_SRDY_DELAY; i++);
-  SYNC_SRDY_ASSERT();
-  
-  for(u32 i = 0; i < ANT_SRDY_PERIOD; i++);
   SYNC_SRDY_DEASSERT();
+  TimerStart(TIMER0_CHANNEL0);
 
 } /* end AntSrdyPulse() */
 
 
+/*!-----------------------------------------------------------------------------
+@fn static void AntSrdyAssertCallback(void)
+
+@brief TC0 RA compare callback that starts the SRDY pulse.
+
+Requires:
+- Called from TC0_IrqHandler
+
+Promises:
+- SRDY is asserted
+
+*/
+static void AntSrdyAssertCallback(void)
+{
+  SYNC_SRDY_ASSERT();
+
+} /* end AntSrdyAssertCallback() */
+
+
+/*!-----------------------------------------------------------------------------
+@fn static void AntSrdyDeassertCallback(void)
+
+@brief TC0 RC compare callback that ends the SRDY pulse.
+
+Requires:
+- Called from TC0_IrqHandler; the TC0 clock has stopped (CPCSTOP)
+
+Promises:
+- SRDY is deasserted
+
+*/
+static void AntSrdyDeassertCallback(void)
+{
+  SYNC_SRDY_DEASSERT();
+
+} /* end AntSrdyDeassertCallback() */
+
+
 /***********************************************************************************************************************
 ##### ANT State Machine Definition                                             
 ***********************************************************************************************************************/
@@ -1789,7 +3700,8 @@ static void AntSM_Idle(void)
       "Length mismatch\n\r",
       "Command error\n\r",
       "Unexpected event\n\r",
-      "Unexpected message\n\r"
+      "Unexpected message\n\r",
+      "Rx overrun\n\r"
   };
   
   /* Check flags */
@@ -1813,12 +3725,14 @@ static void AntSM_Idle(void)
     G_u32AntFlags &= ~ANT_ERROR_FLAGS_MASK;
   }
   
-  /* Process messages received from ANT */
+  /* Process messages received from ANT and feed any burst transfer in progress */
   AntProcessMessage();
+  AntBurstTxService();
 
   /* Handle messages coming in from ANT */
   if( IS_SEN_ASSERTED() )
   {
+    AntRxStart();
     Ant_pfnStateMachine = AntSM_ReceiveMessage;
   }
   
@@ -1826,17 +3740,10 @@ static void AntSM_Idle(void)
   else if( (Ant_u32CurrentTxMessageToken == 0 ) && 
            (Ant_psOutgoingMsgList != NULL) )
   {
-    /* Give the message to AntTx which will set Ant_u32CurrentTxMessageToken */
-    if(AntTxMessage(Ant_psOutgoingMsgList->au8MessageData))
-    {
-      Ant_u32TxTimer = G_u32SystemTime1ms;
-      Ant_pfnStateMachine = AntSM_TransmitMessage;
-    }
-    else
-    {
-      /* Transmit attempt failed.  !!!! Do something? */
-      DebugPrintf("\n\rANT transmit failed\n\r");
-    }
+    /* Notify ANT that the Host wishes to send a message */
+    Ant_u32TxTimer = G_u32SystemTime1ms;
+    SYNC_MRDY_ASSERT();                          
+    Ant_pfnStateMachine = AntSM_TxWaitSen;
   }
   
 } /* end AntSM_Idle() */
@@ -1845,21 +3752,121 @@ static void AntSM_Idle(void)
 /*!------------------------------------------------------------------------------
 @fn static void AntSM_ReceiveMessage(void)
 
-@brief Completely receive an ANT message. Reception is very fast and should complete 
-in less than 600us for a 15-byte message.  AntRxMessage could just be called from Idle,
-but giving it its own state minimizes the total time and allows for easier future
-updates should they be required.
+@brief Wait for an ANT message to be received.  The bytes are received and checked
+by the parser in AntRxFlowControlCallback, so this state only reacts to the
+frame-complete event and waits for ANT to release SEN.  A whole message takes 
+less than 600us, so this normally finishes on the next pass.
 */
 static void AntSM_ReceiveMessage(void)
 {
-  Ant_DebugRxMessageCounter++;
-  AntRxMessage();
-  
-  Ant_pfnStateMachine = AntSM_Idle;
+  /* Process a new frame as soon as the parser reports it */
+  if(Ant_bRxFrameComplete)
+  {
+    Ant_bRxFrameComplete = FALSE;
+    AntProcessMessage();
+  }
+
+  /* ANT releases SEN once the whole message has been clocked out */
+  if( !IS_SEN_ASSERTED() )
+  {
+    AntRxFinish();
+    Ant_pfnStateMachine = AntSM_Idle;
+  }
+  else if( IsTimeUp(&Ant_u32RxTimer, ANT_FRAME_TIMEOUT_MS) )
+  {
+    /* Stay here while the parser flushes ANT */
+    AntRxAbortFrame();
+  }
 
 } /* end AntSM_ReceiveMessage() */
 
 
+/*!------------------------------------------------------------------------------
+@fn static void AntSM_TxWaitSen(void)
+
+@brief MRDY is asserted; wait for ANT to acknowledge with SEN and then ask for the 
+byte that says whether the Host may transmit.
+*/
+static void AntSM_TxWaitSen(void)
+{
+  u8 au8TxTimeoutMsg[] = "AntTx: SEN timeout\n\r";
+
+  if( IS_SEN_ASSERTED() )
+  {
+    /* Queue to read 1 byte; the Rx parser sets Ant_u8RxHandshakeByte */
+    Ant_u32TxTimer = G_u32SystemTime1ms;
+    AntSrdyPulse();
+    Ant_pfnStateMachine = AntSM_TxWaitHandshake;
+  }
+  else if( IsTimeUp(&Ant_u32TxTimer, ANT_HANDSHAKE_TIMEOUT_MS) )
+  {
+    SYNC_MRDY_DEASSERT();                          
+    DebugPrintf(au8TxTimeoutMsg);
+    Ant_pfnStateMachine = AntSM_Idle;
+  }
+
+} /* end AntSM_TxWaitSen() */
+
+
+/*!------------------------------------------------------------------------------
+@fn static void AntSM_TxWaitHandshake(void)
+
+@brief Wait for the first byte from ANT after SEN.  MESG_RX_SYNC means the Host may 
+transmit.  Anything else means ANT initiated this communication (or is confused), 
+so the transmit is put off and the message is received first.  The transmit is 
+retried from Idle.
+*/
+static void AntSM_TxWaitHandshake(void)
+{
+  u8 au8TxTimeoutMsg[] = "AntTx: handshake timeout\n\r";
+  u8 au8TxNoSyncMsg[]  = "AntTx: No SYNC\n\r";
+
+  if(ANT_SSP_FLAGS & _SSP_RX_COMPLETE)
+  {
+    /* Ok to deassert MRDY now */
+    SYNC_MRDY_DEASSERT();                     
+    ANT_SSP_FLAGS &= ~_SSP_RX_COMPLETE;
+
+    if(Ant_u8RxHandshakeByte == MESG_RX_SYNC)
+    {
+      if(AntTxMessage(Ant_psOutgoingMsgList->au8MessageData))
+      {
+        /* The message is with SSP now, so a newer value must be queued separately.  If the
+        transmit failed the message stays queued and can still be replaced. */
+        AntLatestSlotRelease(Ant_psOutgoingMsgList);
+        Ant_pfnStateMachine = AntSM_TransmitMessage;
+      }
+      else
+      {
+        /* Transmit attempt failed.  !!!! Do something? */
+        DebugPrintf("\n\rANT transmit failed\n\r");
+        Ant_pfnStateMachine = AntSM_Idle;
+      }
+    }
+    else
+    {
+      /* The parser is already receiving (TX_SYNC) or discarding (anything else) */
+      if(Ant_u8RxHandshakeByte != MESG_TX_SYNC)
+      {
+        DebugPrintf(au8TxNoSyncMsg);
+      }
+      
+      G_u32AntFlags |= _ANT_FLAGS_TX_INTERRUPTED;
+      AntRxStart();
+      Ant_pfnStateMachine = AntSM_ReceiveMessage;
+    }
+  }
+  else if( IsTimeUp(&Ant_u32TxTimer, ANT_HANDSHAKE_TIMEOUT_MS) )
+  {
+    /* Because CS is still asserted, Idle will attempt to read a message but fail and eventually abort. */
+    SYNC_MRDY_DEASSERT();                     
+    DebugPrintf(au8TxTimeoutMsg);
+    Ant_pfnStateMachine = AntSM_Idle;
+  }
+
+} /* end AntSM_TxWaitHandshake() */
+
+
 /*!------------------------------------------------------------------------------
 @fn static void AntSM_TransmitMessage(void)
 
@@ -1886,24 +3893,9 @@ static void AntSM_TransmitMessage(void)
       Ant_u32CurrentTxMessageToken = 0;
       G_u32AntFlags &= ~_ANT_FLAGS_TX_IN_PROGRESS;
 
-      /* Wait for SEN to deassert so we know ANT is totally ready for the next
-      transaction.  This takes about 170us, so block in this state until that's over */
-      while ( IS_SEN_ASSERTED() && (Ant_u32TxTimer < ANT_ACTIVITY_TIME_COUNT) )
-      {
-        Ant_u32TxTimer++;
-      }
-
-      /* If we timed out, then ANT is likely stuck */
-      if(Ant_u32RxTimer > ANT_ACTIVITY_TIME_COUNT)
-      {
-        /* Try to unstick ANT !!!! Should have a timeout for this */
-        while( IS_SEN_ASSERTED() )
-        {
-          AntSrdyPulse();
-        }
-      }
-      
-      Ant_pfnStateMachine = AntSM_Idle;
+      /* SEN takes about 170us to deassert after the last byte */
+      Ant_u32TxTimer = G_u32SystemTime1ms;
+      Ant_pfnStateMachine = AntSM_TxWaitSenRelease;
       break;
     }
     
@@ -1917,6 +3909,30 @@ static void AntSM_TransmitMessage(void)
 } /* end AntSM_TransmitMessage() */
 
 
+/*!------------------------------------------------------------------------------
+@fn static void AntSM_TxWaitSenRelease(void)
+
+@brief Wait for SEN to deassert after a transmit so we know ANT is totally ready 
+for the next transaction.  If it never does, ANT is likely stuck so the Rx parser
+is set to discard and SRDY is toggled until ANT lets go.
+*/
+static void AntSM_TxWaitSenRelease(void)
+{
+  if( !IS_SEN_ASSERTED() )
+  {
+    Ant_pfnStateMachine = AntSM_Idle;
+  }
+  else if( IsTimeUp(&Ant_u32TxTimer, ANT_HANDSHAKE_TIMEOUT_MS) )
+  {
+    /* Try to unstick ANT */
+    Ant_eRxParseState = ANT_RX_PARSE_DISCARD;
+    AntRxStart();
+    Ant_pfnStateMachine = AntSM_ReceiveMessage;
+  }
+  
+} /* end AntSM_TxWaitSenRelease() */
+
+
 /*!------------------------------------------------------------------------------
 @fn static void AntSM_NoResponse(void)
 
@@ -62,6 +62,7 @@ typedef struct
 #define _ANT_FLAGS_CHANNEL_OPEN           (u8)0x04               /* Set when the ANT channel is open */
 #define _ANT_FLAGS_CHANNEL_CLOSE_PENDING  (u8)0x08               /* Set when a request to close the ANT channel has been sent */
 #define _ANT_FLAGS_GOT_ACK                (u8)0x10               /* Set when an Acked data message gets acked */
+#define _ANT_FLAGS_LATEST_VALUE           (u8)0x20               /* Set when a new broadcast replaces the unsent one */
 
 
 /*! 
@@ -77,26 +78,123 @@ typedef struct
   u8 u8TransType;                          /*!< @brief Transmission Type from the received message */
   s8 s8RSSI;                               /*!< @brief RSSI from the received message */
   u8 u8Dummy;                              /*!< @brief Pad for 4-byte alignment */
+  u16 u16RxTimestamp;                      /*!< @brief ANT receive time in 1/ANT_RX_TIMESTAMP_HZ s (0xFFFF if LIB_CONFIG_RX_TIMESTAMP_FLAG is clear) */
+  u16 u16Pad;                              /*!< @brief Pad for 4-byte alignment */
 } AntExtendedDataType;
 
 
 #define ANT_APPLICATION_MESSAGE_BYTES       (u8)8
 
+/* AntRegisterChannelHandler() message type mask bits (bit number is the AntApplicationMessageType) */
+#define _ANT_HANDLER_MASK_DATA              (u8)0x02      /*!< @brief Route ANT_DATA messages to the handler */
+#define _ANT_HANDLER_MASK_TICK              (u8)0x04      /*!< @brief Route ANT_TICK messages to the handler */
+
+#define ANT_DEVICE_TABLE_SIZE               (u8)32        /*!< @brief Devices tracked in scanning mode */
+#define ANT_DEVICE_HASH_BUCKETS             (u8)32        /*!< @brief Hash buckets for the device table (power of 2) */
+#define ANT_DEVICE_NONE                     (u8)0xFF      /*!< @brief Empty hash bucket / end of a device list */
+#define ANT_RSSI_NONE                       (s8)0x7F      /*!< @brief RSSI statistic that has no samples yet */
+#define ANT_DEVICE_RSSI_AVERAGE             (s16)8        /*!< @brief Messages in the running RSSI average */
+#define ANT_LINK_RSSI_AVERAGE               (s16)16       /*!< @brief Messages in the running RSSI average of a channel */
+#define ANT_DEVICE_HASH(u16Id_, u8Type_)    (u8)( ((u16Id_) ^ ((u16Id_) >> 8) ^ (u8Type_)) & (ANT_DEVICE_HASH_BUCKETS - 1) ) /*!< @brief Bucket for a device */
+
 /*! 
 @struct AntApplicationMsgListType
-@brief Data struct for the ANT application API message information 
+@brief Data struct for the ANT application API message information.  Messages are
+held in a fixed-capacity ring; G_psAntApplicationMsgList points at the oldest one.
 */
 typedef struct
 {
   u32 u32TimeStamp;                                  /*!< @brief Current G_u32SystemTime1s */
+  u32 u32TimeStampUs;                                /*!< @brief GetSystemTimeUs() when ANT asserted SEN to send the message */
   AntApplicationMessageType eMessageType;            /*!< @brief Type of data */
   u8 u8Channel;                                      /*!< @brief Channel to which the data applies */
   u8 au8MessageData[ANT_APPLICATION_MESSAGE_BYTES];  /*!< @brief Array for message data */
   AntExtendedDataType sExtendedData;                 /*!< @brief Struct of extended message data */
-  void *psNextMessage;                               /*!< @brief Pointer to next AntApplicationMsgListType */
 } AntApplicationMsgListType;
 
 
+/*! 
+@typedef AntChannelHandlerType
+@brief Application function that receives the messages of a registered channel */
+typedef void(*AntChannelHandlerType)(AntApplicationMsgListType* psMessage_);
+
+
+/*! 
+@struct AntChannelHandlerEntryType
+@brief Handler registration for one ANT channel */
+typedef struct
+{
+  AntChannelHandlerType pfnHandler;        /*!< @brief Function to call, or NULL to use the application ring */
+  u8 u8MessageMask;                        /*!< @brief _ANT_HANDLER_MASK_ bits for the message types to route */
+} AntChannelHandlerEntryType;
+
+
+/*! 
+@enum AntDeviceTableModeType
+@brief Use of the device table for data messages that carry a device ID */
+typedef enum {ANT_DEVICE_TABLE_OFF, ANT_DEVICE_TABLE_TRACK, ANT_DEVICE_TABLE_ONLY} AntDeviceTableModeType;
+
+
+/*! 
+@struct AntRssiStatsType
+@brief RSSI statistics of a device or channel (all ANT_RSSI_NONE until the first sample) */
+typedef struct
+{
+  s8 s8Last;                               /*!< @brief RSSI of the latest message */
+  s8 s8Min;                                /*!< @brief Weakest RSSI received */
+  s8 s8Max;                                /*!< @brief Strongest RSSI received */
+  s8 s8Average;                            /*!< @brief Running average RSSI */
+} AntRssiStatsType;
+
+
+/*! 
+@struct AntDeviceInfoType
+@brief What is known about one device heard in scanning mode */
+typedef struct
+{
+  u16 u16DeviceID;                                   /*!< @brief Device number */
+  u8 u8DeviceType;                                   /*!< @brief Device type */
+  u8 u8TransType;                                    /*!< @brief Transmission type of the latest message */
+  u32 u32LastSeen;                                   /*!< @brief G_u32SystemTime1ms of the latest message */
+  u32 u32MessageCount;                               /*!< @brief Messages received from the device */
+  AntRssiStatsType sRssi;                            /*!< @brief RSSI over about ANT_DEVICE_RSSI_AVERAGE messages */
+  u8 au8LastPayload[ANT_APPLICATION_MESSAGE_BYTES];  /*!< @brief Data bytes of the latest message */
+} AntDeviceInfoType;
+
+
+/*! 
+@struct AntDeviceEntryType
+@brief Device table entry with its hash chain and LRU links */
+typedef struct
+{
+  AntDeviceInfoType sInfo;                 /*!< @brief Information reported to the application */
+  s16 s16RssiAverageX16;                   /*!< @brief Running RSSI average in 1/16 dBm */
+  u8 u8HashNext;                           /*!< @brief Next entry in the same hash bucket */
+  u8 u8LruPrev;                            /*!< @brief Entry heard more recently */
+  u8 u8LruNext;                            /*!< @brief Entry heard less recently */
+  u8 au8Pad[3];                            /*!< @brief Preserve 4-byte alignment */
+} AntDeviceEntryType;
+
+
+/*! 
+@struct AntLinkStatsType
+@brief Link quality counters for one channel (see AntQueryLinkStats()) */
+typedef struct
+{
+  u32 u32RxMessages;                       /*!< @brief Broadcast, acknowledged and burst data messages received */
+  u32 u32TxMessages;                       /*!< @brief EVENT_TX: messages sent by ANT on a master channel */
+  u32 u32RxFails;                          /*!< @brief EVENT_RX_FAIL: expected messages that were missed */
+  u32 u32RxFailGoToSearch;                 /*!< @brief EVENT_RX_FAIL_GO_TO_SEARCH: times the channel lost sync */
+  u32 u32SearchTimeouts;                   /*!< @brief EVENT_RX_SEARCH_TIMEOUT */
+  u32 u32TransfersAcked;                   /*!< @brief EVENT_TRANSFER_TX_COMPLETED */
+  u32 u32TransfersFailed;                  /*!< @brief EVENT_TRANSFER_TX_FAILED */
+  u32 u32TransfersRxFailed;                /*!< @brief EVENT_TRANSFER_RX_FAILED */
+  u32 u32RssiSamples;                      /*!< @brief Received messages that carried RSSI */
+  AntRssiStatsType sRssi;                  /*!< @brief RSSI over about ANT_LINK_RSSI_AVERAGE messages */
+  u32 u32ResetTime;                        /*!< @brief G_u32SystemTime1ms when the counters were last reset */
+} AntLinkStatsType;
+
+
 /*! 
 @struct AntOutgoingMessageListType
 @brief Data struct for outgoing data messages */
@@ -119,6 +217,67 @@ typedef struct
 } AntMessageResponseType;
 
 
+/*! 
+@struct AntPoolStatsType
+@brief Usage statistics for the fixed-block ANT outgoing message pool or the application message ring */
+typedef struct
+{
+  u16 u16Size;                             /*!< @brief Number of blocks (or ring slots) available */
+  u16 u16InUse;                            /*!< @brief Number of blocks currently allocated (or messages queued) */
+  u16 u16HighWater;                        /*!< @brief Largest number of blocks ever allocated at once */
+  u16 u16Pad;                              /*!< @brief Preserve 4-byte alignment */
+  u32 u32Allocations;                      /*!< @brief Total number of successful allocations */
+  u32 u32Failures;                         /*!< @brief Number of allocations attempted with the pool empty */
+} AntPoolStatsType;
+
+
+/*! 
+@struct AntThroughputStatsType
+@brief Message rates and Host processing cost measured on the target (see AntQueryThroughputStats()) */
+typedef struct
+{
+  u32 u32TxMessages;                       /*!< @brief Messages handed to the SSP since the last reset */
+  u32 u32RxMessages;                       /*!< @brief Frames processed by AntProcessMessage() since the last reset */
+  u16 u16TxPerSecond;                      /*!< @brief Messages sent in the last complete second */
+  u16 u16RxPerSecond;                      /*!< @brief Frames processed in the last complete second */
+  u16 u16MaxTxPerSecond;                   /*!< @brief Highest u16TxPerSecond since the last reset */
+  u16 u16MaxRxPerSecond;                   /*!< @brief Highest u16RxPerSecond since the last reset */
+  u16 u16MaxOutgoingDepth;                 /*!< @brief Most messages on the outgoing list at once */
+  u16 u16Pad;                              /*!< @brief Preserve 4-byte alignment */
+  u32 u32RxCyclesMax;                      /*!< @brief Most CPU cycles AntProcessMessage() spent on one frame */
+  u32 u32RxCyclesAverage;                  /*!< @brief Average CPU cycles AntProcessMessage() spends on a frame */
+} AntThroughputStatsType;
+
+
+/*! 
+@enum AntRxParseStateType
+@brief States of the incremental receive frame parser run from AntRxFlowControlCallback */
+typedef enum {ANT_RX_PARSE_SYNC, ANT_RX_PARSE_LENGTH, ANT_RX_PARSE_ID, ANT_RX_PARSE_PAYLOAD, 
+              ANT_RX_PARSE_CHECKSUM, ANT_RX_PARSE_DISCARD} AntRxParseStateType;
+
+
+/*! 
+@enum AntBurstStateType
+@brief Progress of a burst transfer in one direction */
+typedef enum {ANT_BURST_IDLE, ANT_BURST_BUSY, ANT_BURST_DONE, ANT_BURST_FAILED} AntBurstStateType;
+
+
+/*! 
+@struct AntBurstStatusType
+@brief Snapshot of the burst transmit and receive engines */
+typedef struct
+{
+  AntBurstStateType eTxState;              /*!< @brief State of the outgoing transfer */
+  AntBurstStateType eRxState;              /*!< @brief State of the incoming transfer (ANT_BURST_DONE once all u16RxLength bytes arrived) */
+  u16 u16TxLength;                         /*!< @brief Total bytes in the outgoing transfer */
+  u16 u16TxBytesSent;                      /*!< @brief Outgoing bytes confirmed by EVENT_TRANSFER_TX_COMPLETED */
+  u16 u16TxRetries;                        /*!< @brief Bursts re-sent after a failure */
+  u16 u16RxLength;                         /*!< @brief Total bytes in the incoming transfer from its burst header */
+  u16 u16RxBytes;                          /*!< @brief Bytes from complete bursts in the receive buffer */
+  u16 u16RxFailures;                       /*!< @brief Incoming bursts dropped for sequence errors or EVENT_TRANSFER_RX_FAILED */
+} AntBurstStatusType;
+
+
 
 /**********************************************************************************************************************
 Macros 
@@ -147,11 +306,28 @@ Constants / Definitions
 
 #define ANT_CONFIGURE_TIMEOUT_MS          (u32)2000              /*!< @brief Maximum time to send all channel configuration messages */
 #define ANT_INFINITE_SEARCH_TIMEOUT       (u8)0xFF               /*!< @brief Value for Set Search Timeout for infinite timeout */
+#define ANT_DEBUG_TEXT_SIZE               (u8)48                 /*!< @brief Largest "ANT channel d ..." status string including the terminator */
+#define ANT_DEBUG_TEXT_CHANNEL_INDEX      (u8)12                 /*!< @brief Position of the channel digit in the status strings */
+#define ANT_THROUGHPUT_PERIOD_MS          (u32)1000              /*!< @brief Window for the per-second message rates */
+#define ANT_RX_TIMESTAMP_HZ               (u32)32768             /*!< @brief Clock rate of the ANT receive timestamp extended data */
+#define ANT_RX_TIME_SLOTS                 (u8)64                 /*!< @brief SEN times held for unprocessed frames (power of 2, more than fit in Ant_au8AntRxBuffer) */
+
+#define ANT_BURST_PACKET_BYTES            (u16)8                 /*!< @brief Data bytes in one burst packet */
+#define ANT_BURST_CHUNK_PACKETS           (u16)16                /*!< @brief Packets per ANT burst; a failed burst is re-sent from its first packet */
+#define ANT_BURST_CHUNK_BYTES             (u16)((ANT_BURST_CHUNK_PACKETS - 1) * ANT_BURST_PACKET_BYTES) /*!< @brief Data bytes per burst after its header packet */
+#define ANT_BURST_HEADER_INDEX_OFFSET     (u8)0                  /*!< @brief Header packet: transfer offset of the burst's data (LSB first) */
+#define ANT_BURST_HEADER_INDEX_LENGTH     (u8)2                  /*!< @brief Header packet: total bytes in the transfer (LSB first) */
+#define ANT_BURST_MAX_RETRIES             (u8)3                  /*!< @brief Re-sends of one burst before the transfer fails */
+#define ANT_BURST_PACKETS_PER_PASS        (u8)2                  /*!< @brief Burst packets queued per pass through AntSM_Idle */
+#define ANT_BURST_POOL_RESERVE            (u16)4                 /*!< @brief Outgoing pool blocks a burst leaves free for other messages */
+#define ANT_BURST_NEXT_SEQUENCE(u8Seq_)   (u8)( ((u8Seq_) == SEQUENCE_NUMBER_ROLLOVER) ? SEQUENCE_NUMBER_INC : ((u8Seq_) + SEQUENCE_NUMBER_INC) ) /*!< @brief Burst sequence after u8Seq_: 0, 1, 2, 3, 1, 2, 3... */
 
 /*!@cond DOXYGEN_EXCLUDE */
 #define ANT_RESET_WAIT_MS                 (u32)100
 #define ANT_RESTART_DELAY_MS              (u32)1000
 #define ANT_MSG_TIMEOUT_MS                (u32)1000
+#define ANT_HANDSHAKE_TIMEOUT_MS          (u32)2                 /* Maximum time for ANT to answer MRDY or release SEN */
+#define ANT_FRAME_TIMEOUT_MS              (u32)3                 /* Maximum time for a whole frame to arrive once SEN asserts */
 
 /* G_u32AntFlags */
 /* Error / event flags */
@@ -159,9 +335,10 @@ Constants / Definitions
 #define _ANT_FLAGS_CMD_ERROR              (u32)0x00000002        /* A command received an error response  */
 #define _ANT_FLAGS_UNEXPECTED_EVENT       (u32)0x00000004        /* The message parser handled an unexpected event */
 #define _ANT_FLAGS_UNEXPECTED_MSG         (u32)0x00000008        /* The message parser handled an unexpected message */
+#define _ANT_FLAGS_RX_OVERRUN             (u32)0x00000010        /* A received frame was dropped because the Rx buffer was full */
 
 #define ANT_ERROR_FLAGS_MASK              (u32)0x0000FFFF        /* Mask out all error flags */
-#define ANT_ERROR_FLAGS_COUNT             (u8)4                  /* Current number of error flags */
+#define ANT_ERROR_FLAGS_COUNT             (u8)5                  /* Current number of error flags */
 
 /* Status flags */
 #define _ANT_FLAGS_RESTART                (u32)0x00010000        /* An ANT restart message was received */
@@ -193,8 +370,8 @@ Constants / Definitions
 /* #### end of default channel configuration parameters ####*/
 
 #define ANT_ACTIVITY_TIME_COUNT   (u32)10000    /* Value used in a while loop that is waiting for an activity to be completed */
-#define ANT_SRDY_DELAY            (u32)200      /* A loop-kill delay to provide guaranteed minimum space for SRDY messages */
-#define ANT_SRDY_PERIOD           (u32)20       /* A loop-kill delay to stretch the SRDY pulse out */
+#define ANT_SRDY_DELAY_TICKS      (u16)360      /* TC0 ticks (41.7ns) before SRDY asserts to guarantee minimum space between SRDY pulses (15us) */
+#define ANT_SRDY_PERIOD_TICKS     (u16)36       /* TC0 ticks (41.7ns) that SRDY stays asserted (1.5us) */
 
 
 /* Network number */
@@ -234,8 +411,29 @@ Function prototypes
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* ANT Public Interface-layer Functions */
 u8 AntCalculateTxChecksum(u8* pu8Message_);
+u8 AntBuildDataMessage(u8* pu8Target_, u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_);
 bool AntQueueOutgoingMessage(u8 *pu8Message_);
+bool AntQueueDataMessage(u8 u8MessageId_, u8 u8Channel_, u8* pu8Data_);
+bool AntQueueLatestOutgoingMessage(u8 *pu8Message_);
 void AntDeQueueApplicationMessage(void);
+AntApplicationMsgListType* AntPeekApplicationMessage(void);
+u8 AntReadApplicationMessages(AntApplicationMsgListType* psTarget_, u8 u8MaxMessages_);
+void AntQueryPoolStats(AntPoolStatsType* psOutgoingStats_, AntPoolStatsType* psApplicationStats_);
+void AntQueryThroughputStats(AntThroughputStatsType* psStats_);
+void AntResetThroughputStats(void);
+bool AntBurstTxStart(AntChannelNumberType eChannel_, u8* pu8Data_, u16 u16Length_);
+bool AntBurstRxStart(AntChannelNumberType eChannel_, u8* pu8Buffer_, u16 u16Size_);
+void AntBurstQueryStatus(AntBurstStatusType* psStatus_);
+bool AntBurstTxActive(AntChannelNumberType eChannel_);
+bool AntRegisterChannelHandler(AntChannelNumberType eChannel_, u8 u8MessageMask_, AntChannelHandlerType pfnHandler_);
+void AntDeviceTableSetMode(AntDeviceTableModeType eMode_);
+void AntDeviceTableClear(void);
+u8 AntDeviceTableCount(void);
+bool AntDeviceTableFind(u16 u16DeviceID_, u8 u8DeviceType_, AntDeviceInfoType* psInfo_);
+u8 AntDeviceTableRead(AntDeviceInfoType* psTarget_, u8 u8MaxDevices_);
+bool AntQueryLinkStats(AntChannelNumberType eChannel_, AntLinkStatsType* psStats_);
+bool AntResetLinkStats(AntChannelNumberType eChannel_);
+bool AntRxTimestampToHostUs(u16 u16RxTimestamp_, u32* pu32HostUs_);
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -247,6 +445,8 @@ void AntRunActiveState(void);
 
 void AntTxFlowControlCallback(void);
 void AntRxFlowControlCallback(void);
+void AntSenAssertCallback(void);
+void AntDebugPrintChannelMessage(u8* pu8Template_, u8 u8Channel_);
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -254,26 +454,58 @@ void AntRxFlowControlCallback(void);
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* ANT Private Interface-layer Functions */
 static bool AntTxMessage(u8 *pu8AntTxMessage_);
-static void AntRxMessage(void);
-static void AntAbortMessage(void);
-static void AdvanceAntRxBufferCurrentChar(void);
-static void AdvanceAntRxBufferUnreadMsgPointer(void);
+static void AntRxStart(void);
+static void AntRxDropFrame(void);
+static void AntRxFinish(void);
+static void AntRxAbortFrame(void);
 
-static u8 AntExpectResponse(u8 u8ExpectedMessageID_, u32 u32TimeoutMS_);
 static u8 AntProcessMessage(void);
 static bool AntParseExtendedData(u8* pu8SourceMessage_, AntExtendedDataType* psExtDataTarget_);
 static bool AntQueueExtendedApplicationMessage(AntApplicationMessageType eMessageType_, u8* pu8DataSource_, AntExtendedDataType* psExtData_);
 static void AntTickExtended(u8* pu8AntMessage_);
 static void AntDeQueueOutgoingMessage(void);
 
+static void AntPoolInitialize(void);
+static void AntPoolCountAllocation(AntPoolStatsType* psStats_);
+static AntOutgoingMessageListType* AntOutgoingMessageAllocate(void);
+static void AntOutgoingMessageFree(AntOutgoingMessageListType* psMessage_);
+static void AntOutgoingMessageAppend(AntOutgoingMessageListType* psMessage_);
+static u32 AntElapsedCycles(u32 u32StartMs_, u32 u32StartTick_);
+static void AntThroughputUpdate(void);
+static void AntLatestSlotRelease(AntOutgoingMessageListType* psMessage_);
+static void AntUpdateApplicationMsgList(void);
+
+static u8 AntDeviceTableLookup(u16 u16DeviceID_, u8 u8DeviceType_);
+static void AntDeviceLruUnlink(u8 u8Index_);
+static void AntDeviceLruPushFront(u8 u8Index_);
+static bool AntDeviceTableUpdate(u8* pu8Data_, AntExtendedDataType* psExtData_);
+
+static void AntRssiStatsReset(AntRssiStatsType* psRssi_);
+static void AntRssiStatsUpdate(AntRssiStatsType* psRssi_, s16* ps16AverageX16_, s16 s16Window_, s8 s8Rssi_);
+
+static void AntLinkStatsEvent(u8 u8Channel_, u8 u8EventCode_);
+static void AntLinkStatsData(u8 u8Channel_, AntExtendedDataType* psExtData_);
+
+static u16 AntBurstTxChunkEnd(void);
+static void AntBurstTxService(void);
+static void AntBurstTxEvent(u8 u8Channel_, bool bSuccess_);
+static void AntBurstPurgeOutgoing(void);
+static bool AntBurstRxPacket(u8 u8Channel_, u8 u8ChannelByte_, u8* pu8Data_);
+static void AntBurstRxFailed(u8 u8Channel_);
+
 /* ANT Private Serial-layer Functions */
 static void AntSyncSerialInitialize(void);
 static void AntSrdyPulse(void);
+static void AntSrdyAssertCallback(void);
+static void AntSrdyDeassertCallback(void);
 
 /* ANT State Machine Definition */
 static void AntSM_Idle(void);
 static void AntSM_ReceiveMessage(void);
+static void AntSM_TxWaitSen(void);
+static void AntSM_TxWaitHandshake(void);
 static void AntSM_TransmitMessage(void);
+static void AntSM_TxWaitSenRelease(void);
 static void AntSM_NoResponse(void);
 
 #endif /* __ANT_H */
\ No newline at end of file
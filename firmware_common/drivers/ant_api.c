@@ -5,11 +5,15 @@
 This file holds the source code for all public functions that work with ant.c.  
 
 Once the ANT radio has been configured, all messaging from the ANT device is handled through 
-the incoming queue G_psAntApplicationMsgList.  The application is responsible for checking this
-queue for messages that belong to it and must manage timing and handle appropriate updates per 
-the ANT messaging protocol.  This should be no problem on the regular 1ms loop timing of the main 
-system (assuming ANT message rate is less than 1kHz).  Faster systems or burst messaging will need 
-to be handled seperately as an add-on to this API.
+the incoming message ring in ant.c (G_psAntApplicationMsgList points at the oldest message).
+AntReadAppMessageBuffer() copies one message to the globals below; AntPeekApplicationMessage()
+and AntReadApplicationMessages() in ant.c read messages in place or in bulk without the per-message
+copy.  A task that owns a channel can instead call AntRegisterChannelHandler() so the messages
+of that channel go straight to its handler and never reach the shared ring.  Otherwise the 
+application is responsible for checking this queue for messages that belong to it.  Either way
+it must manage timing and handle appropriate updates per the ANT messaging protocol.  This should be no problem on the regular 1ms loop timing of the main 
+system (assuming ANT message rate is less than 1kHz).  Burst data is sent with AntQueueBurstTransfer()
+and collected into an application buffer with AntReceiveBurstTransfer(); ant.c paces the packets.
 
 Copy the following definitions to your client task:
   
@@ -17,6 +21,8 @@ Copy the following definitions to your client task:
 
 extern u32 G_u32AntApiCurrentMessageTimeStamp;                            // From ant_api.c
 
+extern u32 G_u32AntApiCurrentMessageTimeStampUs;                          // From ant_api.c
+
 extern AntApplicationMessageType G_eAntApiCurrentMessageClass;            // From ant_api.c
 
 extern u8 G_au8AntApiCurrentMessageBytes[ANT_APPLICATION_MESSAGE_BYTES];  // From ant_api.c
@@ -27,6 +33,7 @@ extern AntExtendedDataType G_sAntApiCurrentMessageExtData;                // Fro
 ------------------------------------------------------------------------------------------------------------------------
 GLOBALS
 - u32 G_u32AntApiCurrentMessageTimeStamp
+- u32 G_u32AntApiCurrentMessageTimeStampUs
 - AntApplicationMessageType G_eAntApiCurrentMessageClass
 - u8 G_au8AntApiCurrentMessageBytes[ANT_APPLICATION_MESSAGE_BYTES]
 - AntExtendedDataType G_sAntApiCurrentMessageExtData
@@ -35,12 +42,19 @@ CONSTANTS
 - NONE
 
 TYPES
-- NONE (see ant.h for all types used)
+- AntAckStatusType
+- AntAckMessageType
+- AntAssignStatusType
+- AntAssignJobType
+- AntBroadcastBatchType
+- AntLoadTestStatusType
+(see ant.h for all other types used)
 
 
 PUBLIC ANT CONFIGURATION / STATUS FUNCTIONS
 - AntChannelStatusType AntRadioStatusChannel(AntChannelNumberType eChannel_)
 - bool AntAssignChannel(AntAssignChannelInfoType* psAntSetupInfo_)
+- AntAssignStatusType AntAssignChannelStatus(AntChannelNumberType eChannel_)
 - bool AntUnassignChannelNumber(AntChannelNumberType eChannel_)
 - bool AntOpenChannelNumber(AntChannelNumberType eAntChannelToOpen)
 - bool AntCloseChannelNumber(AntChannelNumberType eAntChannelToClose)
@@ -49,12 +63,26 @@ PUBLIC ANT CONFIGURATION / STATUS FUNCTIONS
 
 PUBLIC ANT DATA FUNCTIONS
 - bool AntQueueBroadcastMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
+- void AntSetBroadcastLatestValue(AntChannelNumberType eChannel_, bool bEnable_)
+- u8 AntQueueBroadcastBatch(AntBroadcastBatchType* psBatch_, u8 u8Count_)
 - bool AntQueueAcknowledgedMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
+- u16 AntQueueTrackedAckMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
+- AntAckStatusType AntQueryTrackedAckMessage(u16 u16Handle_)
+- bool AntQueueBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Data_, u16 u16Length_)
+- bool AntReceiveBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Buffer_, u16 u16Size_)
 - bool AntReadAppMessageBuffer(void)
 
+PUBLIC ANT LOAD TEST FUNCTIONS
+- bool AntLoadTestStart(AntChannelNumberType eChannel_, u16 u16MessagesPerSecond_)
+- void AntLoadTestStop(void)
+- void AntLoadTestQuery(AntLoadTestStatusType* psStatus_)
+
 PROTECTED FUNCTIONS
 - void AntApiInitialize(void)
 - void AntApiRunActiveState(void)
+- void AntApiAckEvent(u8 u8Channel_, bool bDelivered_)
+- bool AntApiAckPending(u8 u8Channel_)
+- void AntApiResponseEvent(u8 u8Channel_, u8 u8MessageId_, u8 u8ResponseCode_)
 
 
 ***********************************************************************************************************************/
@@ -68,6 +96,7 @@ All Global variable names shall start with "G_<type>AntApi"
 volatile u32 G_u32AntApiFlags;                                      /*!< @brief Global state flags */
 
 u32 G_u32AntApiCurrentMessageTimeStamp = 0;                         /*!< @brief Current read message's G_u32SystemTime1ms */
+u32 G_u32AntApiCurrentMessageTimeStampUs = 0;                       /*!< @brief Current read message's GetSystemTimeUs() at SEN assertion */
 AntApplicationMessageType G_eAntApiCurrentMessageClass = ANT_EMPTY; /*!< @brief Type of data */
 u8 G_au8AntApiCurrentMessageBytes[ANT_APPLICATION_MESSAGE_BYTES];   /*!< @brief Array for message payload data */
 AntExtendedDataType G_sAntApiCurrentMessageExtData;                 /*!< @brief Extended data struct for the current message */
@@ -107,16 +136,23 @@ extern u8 G_au8AntSetChannelPower[];                          /* From ant.c */
 extern u8 G_au8AntSetSearchTimeout[];                         /* From ant.c */
 extern u8 G_au8AntLibConfig[];                                /* From ant.c */
 
-extern u8 G_au8AntBroadcastDataMessage[];                     /* From ant.c */
-extern u8 G_au8AntAckDataMessage[];                           /* From ant.c */
-
 
 /***********************************************************************************************************************
 Global variable definitions with scope limited to this local application.
 Variable names shall start with "AntApi_<type>Name" and be declared as static.
 ***********************************************************************************************************************/
 static fnCode_type AntApi_StateMachine;             /*!< @brief The state machine function pointer */
-static u32 AntApi_u32Timeout;                       /*!< @brief Timeout counter used across states */
+static AntAssignJobType AntApi_asAssignJobs[ANT_NUM_CHANNELS];  /*!< @brief Channel configuration progress by channel */
+static u16 AntApi_u16AssignNextTicket;              /*!< @brief Start order of the next channel configuration */
+
+static AntAckMessageType AntApi_asAckMessages[ANT_ACK_MESSAGE_SLOTS];  /*!< @brief Tracked acknowledged messages */
+static u8 AntApi_au8AckActive[ANT_NUM_CHANNELS];    /*!< @brief Slot being delivered on each channel or ANT_ACK_NONE */
+static u8 AntApi_u8AckGeneration;                   /*!< @brief Generation of the latest handle */
+static u16 AntApi_u16AckNextTicket;                 /*!< @brief Queue order of the next tracked message */
+
+static AntLoadTestStatusType AntApi_sLoadTest;      /*!< @brief Load generator settings and counters */
+static u32 AntApi_u32LoadTestTimer;                 /*!< @brief Start of the current load test window */
+static u16 AntApi_u16LoadTestThisPeriod;            /*!< @brief Broadcasts attempted in the current window */
 
 static u8* AntApi_apu8AntAssignChannel[] = {G_au8AntSetNetworkKey, G_au8AntLibConfig, G_au8AntAssignChannel, G_au8AntSetChannelID, 
                                             G_au8AntSetChannelPeriod, G_au8AntSetChannelRFFreq, G_au8AntSetChannelPower,
@@ -138,8 +174,10 @@ Function Definitions
 @brief Updates all configuration messages to completely configure an ANT channel with an application's 
 required parameters for communication.  
 
-The application should monitor AntRadioStatusChannel()
-to see if all of the configuration messages are sent and the channel is configured properly.
+The configuration messages are queued by AntApiRunActiveState() as fast as the outgoing 
+list accepts them, so several channels can be assigned at the same time.  The application 
+should monitor AntRadioStatusChannel() or AntAssignChannelStatus() to see if all of the 
+configuration messages are sent and the channel is configured properly.
 
 e.g.
   AntAssignChannelInfoType sChannelInfo;
@@ -177,93 +215,69 @@ Requires:
 
 Promises:
 - Channel, Channel ID, message period, radio frequency and radio power are configured.
-- Returns TRUE if the channel is ready to be set up; all global setup messages are updated with the values
-  from psAntSetupInfo; 
-- Returns FALSE if the channel is already configured
+- Returns TRUE if the channel is ready to be set up; the channel parameters are saved in 
+  G_asAntChannelConfiguration and the channel's configuration is ANT_ASSIGN_BUSY
+- Returns FALSE if the channel is already configured or being configured
 
 */
 bool AntAssignChannel(AntAssignChannelInfoType* psAntSetupInfo_)
 {
+  AntAssignChannelInfoType *psConfig = &G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel];
+  AntAssignJobType *psJob = &AntApi_asAssignJobs[psAntSetupInfo_->AntChannel];
+  
   /* Check to ensure the selected channel is available */
-  if(AntRadioStatusChannel(psAntSetupInfo_->AntChannel) != ANT_UNCONFIGURED)
+  if( (AntRadioStatusChannel(psAntSetupInfo_->AntChannel) != ANT_UNCONFIGURED) ||
+      (psJob->eStatus == ANT_ASSIGN_BUSY) )
   {
     DebugPrintf("AntAssignChannel error: channel is not unconfigured\n\r");
     return FALSE;
   }
   
-  /* Setup the library config message (for extended data) - use defaults for now */
-  G_au8AntLibConfig[4] = AntCalculateTxChecksum(G_au8AntLibConfig);
-
-  /* Set Network key message */
-  G_au8AntSetNetworkKey[2] = psAntSetupInfo_->AntNetwork;
+  /* Save the channel parameters; the messages are built from them as they are queued */
   for(u8 i = 0; i < ANT_NETWORK_NUMBER_BYTES; i++)
   {
-    G_au8AntSetNetworkKey[i + 3] = psAntSetupInfo_->AntNetworkKey[i];
-    G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntNetworkKey[i] = psAntSetupInfo_->AntNetworkKey[i];
+    psConfig->AntNetworkKey[i] = psAntSetupInfo_->AntNetworkKey[i];
   }
-  G_au8AntSetNetworkKey[11] = AntCalculateTxChecksum(G_au8AntSetNetworkKey);
-    
-  /* Setup the channel message */
-  G_au8AntAssignChannel[2] = psAntSetupInfo_->AntChannel;
-  G_au8AntAssignChannel[3] = psAntSetupInfo_->AntChannelType;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntChannelType = psAntSetupInfo_->AntChannelType;
-
-  G_au8AntAssignChannel[4] = psAntSetupInfo_->AntNetwork;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntNetwork = psAntSetupInfo_->AntNetwork;
-
-  G_au8AntAssignChannel[5] = AntCalculateTxChecksum(G_au8AntAssignChannel);
-
-  /* Setup the channel ID message */
-  G_au8AntSetChannelID[2] = psAntSetupInfo_->AntChannel;
-  G_au8AntSetChannelID[3] = psAntSetupInfo_->AntDeviceIdLo;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntDeviceIdLo = psAntSetupInfo_->AntDeviceIdLo;
-
-  G_au8AntSetChannelID[4] = psAntSetupInfo_->AntDeviceIdHi;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntDeviceIdHi = psAntSetupInfo_->AntDeviceIdHi;
-
-  G_au8AntSetChannelID[5] = psAntSetupInfo_->AntDeviceType;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntDeviceType = psAntSetupInfo_->AntDeviceType;
-
-  G_au8AntSetChannelID[6] = psAntSetupInfo_->AntTransmissionType;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntTransmissionType = psAntSetupInfo_->AntTransmissionType;
+  psConfig->AntChannelType      = psAntSetupInfo_->AntChannelType;
+  psConfig->AntNetwork          = psAntSetupInfo_->AntNetwork;
+  psConfig->AntDeviceIdLo       = psAntSetupInfo_->AntDeviceIdLo;
+  psConfig->AntDeviceIdHi       = psAntSetupInfo_->AntDeviceIdHi;
+  psConfig->AntDeviceType       = psAntSetupInfo_->AntDeviceType;
+  psConfig->AntTransmissionType = psAntSetupInfo_->AntTransmissionType;
+  psConfig->AntChannelPeriodLo  = psAntSetupInfo_->AntChannelPeriodLo;
+  psConfig->AntChannelPeriodHi  = psAntSetupInfo_->AntChannelPeriodHi;
+  psConfig->AntFrequency        = psAntSetupInfo_->AntFrequency;
+  psConfig->AntTxPower          = psAntSetupInfo_->AntTxPower;
+  
+  /* Start the channel's configuration pipeline */
+  psJob->eStatus       = ANT_ASSIGN_BUSY;
+  psJob->u8NextMessage = 0;
+  psJob->u8Responses   = 0;
+  psJob->u16Ticket     = AntApi_u16AssignNextTicket++;
+  psJob->u32Timer      = G_u32SystemTime1ms;
+  return TRUE;
 
-  G_au8AntSetChannelID[7] = AntCalculateTxChecksum(G_au8AntSetChannelID);
-    
-  /* Setup the channel period message */
-  G_au8AntSetChannelPeriod[2] = psAntSetupInfo_->AntChannel;
-  G_au8AntSetChannelPeriod[3] = psAntSetupInfo_->AntChannelPeriodLo;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntChannelPeriodLo = psAntSetupInfo_->AntChannelPeriodLo;
+} /* end AntAssignChannel() */
 
-  G_au8AntSetChannelPeriod[4] = psAntSetupInfo_->AntChannelPeriodHi;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntChannelPeriodHi = psAntSetupInfo_->AntChannelPeriodHi;
 
-  G_au8AntSetChannelPeriod[5] = AntCalculateTxChecksum(G_au8AntSetChannelPeriod);
-    
-  /* Setup the channel frequency message */
-  G_au8AntSetChannelRFFreq[2] = psAntSetupInfo_->AntChannel;
-  G_au8AntSetChannelRFFreq[3] = psAntSetupInfo_->AntFrequency;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntFrequency = psAntSetupInfo_->AntFrequency;
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn AntAssignStatusType AntAssignChannelStatus(AntChannelNumberType eChannel_)
 
-  G_au8AntSetChannelRFFreq[4] = AntCalculateTxChecksum(G_au8AntSetChannelRFFreq);
+@brief Reports the progress of AntAssignChannel() for a channel.  
 
-  /* Setup the channel power message */
-  G_au8AntSetChannelPower[3] = psAntSetupInfo_->AntTxPower;
-  G_asAntChannelConfiguration[psAntSetupInfo_->AntChannel].AntTxPower = psAntSetupInfo_->AntTxPower;
+Requires:
+@param eChannel_ is the ANT channel to check
 
-  G_au8AntSetChannelPower[4] = AntCalculateTxChecksum(G_au8AntSetChannelPower);
-     
-  /* Setup the the channel search timeout (currently set at default for infinite search) */
-  G_au8AntSetSearchTimeout[2] = psAntSetupInfo_->AntChannel;
-  G_au8AntSetSearchTimeout[3] = ANT_INFINITE_SEARCH_TIMEOUT;
+Promises:
+- Returns ANT_ASSIGN_BUSY while configuration messages are outstanding, then 
+  ANT_ASSIGN_DONE or ANT_ASSIGN_FAILED (ANT_ASSIGN_IDLE if never assigned)
 
-  G_au8AntSetSearchTimeout[4] = AntCalculateTxChecksum(G_au8AntSetSearchTimeout);
-  
-  /* Set the next state to begin transferring */
-  AntApi_u32Timeout = G_u32SystemTime1ms;
-  AntApi_StateMachine = AntApiSM_AssignChannel;
-  return TRUE;
+*/
+AntAssignStatusType AntAssignChannelStatus(AntChannelNumberType eChannel_)
+{
+  return(AntApi_asAssignJobs[eChannel_].eStatus);
 
-} /* end AntAssignChannel() */
+} /* end AntAssignChannelStatus() */
 
 
 /*!---------------------------------------------------------------------------------------------------------------------
@@ -375,6 +389,10 @@ when other channels are already open will result in a failure.
 Returns TRUE if message is successfully queued - this can be ignored or checked.  
 Application should monitor AntRadioStatusChannel() for actual channel status.
 
+Every device in range is reported, so a busy area produces hundreds of messages per
+second.  Call AntDeviceTableSetMode(ANT_DEVICE_TABLE_ONLY) to collect them in the 
+ant.c device table instead and query it with AntDeviceTableFind() / AntDeviceTableRead().
+
 e.g.
 AntChannelStatusType eAntCurrentState;
 
@@ -520,6 +538,11 @@ AntChannelStatusType AntRadioStatusChannel(AntChannelNumberType eChannel_)
 
 @brief Adds an ANT broadcast message to the outgoing messages list.  
 
+If the channel is in latest-value mode (AntSetBroadcastLatestValue()), the message 
+replaces a broadcast on the channel that has not been sent yet.  Otherwise the 
+message is built directly in the outgoing pool and the call is safe from a channel
+handler or an ISR.
+
 Requires:
 @param eChannel_ is the channel number on which to broadcast
 @param pu8Data_ is a pointer to the first element of an array of 8 data bytes
@@ -530,25 +553,102 @@ Promises:
 */
 bool AntQueueBroadcastMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
 {
-  /* Update the dynamic message data */
-  G_au8AntBroadcastDataMessage[2] = eChannel_;
-  for(u8 i = 0; i < ANT_DATA_BYTES; i++)
+  u8 au8Message[MESG_MAX_SIZE];
+  
+  if(G_asAntChannelConfiguration[eChannel_].AntFlags & _ANT_FLAGS_LATEST_VALUE)
   {
-    G_au8AntBroadcastDataMessage[3 + i] = *(pu8Data_ + i);
+    AntBuildDataMessage(au8Message, MESG_BROADCAST_DATA_ID, eChannel_, pu8Data_);
+    return( AntQueueLatestOutgoingMessage(au8Message) );
   }
- 
-  G_au8AntBroadcastDataMessage[11] = AntCalculateTxChecksum(G_au8AntBroadcastDataMessage);
   
-  return( AntQueueOutgoingMessage(G_au8AntBroadcastDataMessage) );
+  return( AntQueueDataMessage(MESG_BROADCAST_DATA_ID, eChannel_, pu8Data_) );
 
 } /* end AntQueueBroadcastMessage */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void AntSetBroadcastLatestValue(AntChannelNumberType eChannel_, bool bEnable_)
+
+@brief Selects "latest value" mode for broadcasts on a channel.  
+
+In this mode AntQueueBroadcastMessage() replaces a broadcast that is still waiting 
+to be sent on the channel instead of adding another one.  A task that updates its 
+data faster than the channel period then always sends its newest data one period 
+later and never fills the outgoing list with stale values.
+
+Requires:
+@param eChannel_ is the channel number to change
+@param bEnable_ is TRUE for latest-value mode; FALSE to queue every broadcast (default)
+
+Promises:
+- _ANT_FLAGS_LATEST_VALUE for eChannel_ is set or cleared
+
+*/
+void AntSetBroadcastLatestValue(AntChannelNumberType eChannel_, bool bEnable_)
+{
+  if(bEnable_)
+  {
+    G_asAntChannelConfiguration[eChannel_].AntFlags |= _ANT_FLAGS_LATEST_VALUE;
+  }
+  else
+  {
+    G_asAntChannelConfiguration[eChannel_].AntFlags &= ~_ANT_FLAGS_LATEST_VALUE;
+  }
+
+} /* end AntSetBroadcastLatestValue */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u8 AntQueueBroadcastBatch(AntBroadcastBatchType* psBatch_, u8 u8Count_)
+
+@brief Queues broadcasts for several channels in one call.  
+
+The batch is only queued if the outgoing pool has a block for every entry, so 
+a task updating all of its channels each period does not send a partial set.  
+Each entry follows the channel's latest-value setting like AntQueueBroadcastMessage().
+
+Requires:
+@param psBatch_ points to u8Count_ channel / payload entries
+@param u8Count_ is the number of entries
+
+Promises:
+- Returns the number of broadcasts queued: u8Count_, or 0 if the pool was too 
+  low to take the batch
+
+*/
+u8 AntQueueBroadcastBatch(AntBroadcastBatchType* psBatch_, u8 u8Count_)
+{
+  AntPoolStatsType sOutgoingStats;
+  AntPoolStatsType sApplicationStats;
+  u8 u8Queued = 0;
+  
+  AntQueryPoolStats(&sOutgoingStats, &sApplicationStats);
+  if( (sOutgoingStats.u16Size - sOutgoingStats.u16InUse) < u8Count_ )
+  {
+    return(0);
+  }
+  
+  for(u8 i = 0; i < u8Count_; i++)
+  {
+    if( AntQueueBroadcastMessage(psBatch_[i].eChannel, psBatch_[i].au8Data) )
+    {
+      u8Queued++;
+    }
+  }
+  
+  return(u8Queued);
+  
+} /* end AntQueueBroadcastBatch */
+
+
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn bool AntQueueAcknowledgedMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
 
 @brief Adds an ANT Acknowledged message to the outgoing messages list.  
 
+The message is built directly in the outgoing pool, so the call is safe from a 
+channel handler or an ISR.
+
 Requires:
 @param eChannel_ is the channel number on which to broadcast
 @param pu8Data_ is a pointer to the first element of an array of 8 data bytes
@@ -559,19 +659,176 @@ Promises:
 */
 bool AntQueueAcknowledgedMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
 {
-  /* Update the dynamic message data */
-  G_au8AntAckDataMessage[2] = eChannel_;
-  for(u8 i = 0; i < ANT_DATA_BYTES; i++)
-  {
-    G_au8AntAckDataMessage[3 + i] = *(pu8Data_ + i);
-  }
- 
-  G_au8AntAckDataMessage[11] = AntCalculateTxChecksum(G_au8AntAckDataMessage);
-  return( AntQueueOutgoingMessage(G_au8AntAckDataMessage) );
+  return( AntQueueDataMessage(MESG_ACKNOWLEDGED_DATA_ID, eChannel_, pu8Data_) );
  
 } /* end AntQueueAcknowledgedMessage */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u16 AntQueueTrackedAckMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
+
+@brief Hands an acknowledged message to the delivery engine and returns a handle for its result.  
+
+The engine sends one tracked message per channel at a time and waits for 
+EVENT_TRANSFER_TX_COMPLETED or EVENT_TRANSFER_TX_FAILED before sending the next one.  A failed 
+message is sent again after ANT_ACK_BACKOFF_MS, doubling each time, up to ANT_ACK_MAX_RETRIES 
+times.  Messages on the same channel are delivered in order.  AntQueryTrackedAckMessage() reports
+the result.
+
+Since ANT events do not say which message they belong to, tracked and untracked 
+(AntQueueAcknowledgedMessage()) acknowledged messages should not be mixed on one channel.
+For the same reason no tracked message is accepted while a burst transfer 
+(AntQueueBurstTransfer()) is being sent on the channel.
+
+Requires:
+@param eChannel_ is the channel number on which to send
+@param pu8Data_ is a pointer to the first element of an array of 8 data bytes
+
+Promises:
+- Returns a non-zero handle if the message was accepted
+- Returns 0 if all ANT_ACK_MESSAGE_SLOTS are waiting or being sent, or a burst is 
+  being sent on eChannel_
+
+*/
+u16 AntQueueTrackedAckMessage(AntChannelNumberType eChannel_, u8 *pu8Data_)
+{
+  u8 u8Slot = ANT_ACK_NONE;
+  AntAckMessageType *psAck;
+  
+  if( ((u8)eChannel_ >= ANT_NUM_CHANNELS) || AntBurstTxActive(eChannel_) )
+  {
+    return(0);
+  }
+  
+  /* Use a free slot, or else one whose result is already known */
+  for(u8 i = 0; i < ANT_ACK_MESSAGE_SLOTS; i++)
+  {
+    if(AntApi_asAckMessages[i].eStatus == ANT_ACK_UNKNOWN)
+    {
+      u8Slot = i;
+      break;
+    }
+    
+    if( (u8Slot == ANT_ACK_NONE) && 
+        ((AntApi_asAckMessages[i].eStatus == ANT_ACK_DELIVERED) || 
+         (AntApi_asAckMessages[i].eStatus == ANT_ACK_FAILED)) )
+    {
+      u8Slot = i;
+    }
+  }
+  
+  if(u8Slot == ANT_ACK_NONE)
+  {
+    return(0);
+  }
+  
+  /* Generation 0 is never used so a handle is never 0 */
+  AntApi_u8AckGeneration++;
+  if(AntApi_u8AckGeneration == 0)
+  {
+    AntApi_u8AckGeneration = 1;
+  }
+  
+  psAck = &AntApi_asAckMessages[u8Slot];
+  psAck->eStatus      = ANT_ACK_WAITING;
+  psAck->eChannel     = eChannel_;
+  psAck->u8Attempts   = 0;
+  psAck->u8Generation = AntApi_u8AckGeneration;
+  psAck->u16Ticket    = AntApi_u16AckNextTicket++;
+  psAck->u32Timer     = G_u32SystemTime1ms;
+  psAck->u32Delay     = 0;
+  memcpy(psAck->au8Data, pu8Data_, ANT_DATA_BYTES);
+  
+  return( ((u16)psAck->u8Generation << 8) | u8Slot );
+
+} /* end AntQueueTrackedAckMessage */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn AntAckStatusType AntQueryTrackedAckMessage(u16 u16Handle_)
+
+@brief Reports the delivery status of a tracked acknowledged message.  
+
+Requires:
+@param u16Handle_ is a handle returned by AntQueueTrackedAckMessage()
+
+Promises:
+- Returns the message status; ANT_ACK_DELIVERED and ANT_ACK_FAILED stay available until 
+  the slot is needed for a new message
+- Returns ANT_ACK_UNKNOWN for an invalid handle or a result that has been reused
+
+*/
+AntAckStatusType AntQueryTrackedAckMessage(u16 u16Handle_)
+{
+  u8 u8Slot = (u8)(u16Handle_ & 0x00FF);
+  
+  if( (u8Slot >= ANT_ACK_MESSAGE_SLOTS) ||
+      (AntApi_asAckMessages[u8Slot].u8Generation != (u8)(u16Handle_ >> 8)) )
+  {
+    return(ANT_ACK_UNKNOWN);
+  }
+  
+  return(AntApi_asAckMessages[u8Slot].eStatus);
+
+} /* end AntQueryTrackedAckMessage */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn bool AntQueueBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Data_, u16 u16Length_)
+
+@brief Starts sending a buffer of any length as ANT burst data.
+
+ant.c feeds the data to ANT in bursts and re-sends a burst that fails.  The application
+monitors AntBurstQueryStatus() until the transfer is ANT_BURST_DONE or ANT_BURST_FAILED.
+
+Requires:
+@param eChannel_ is the channel number on which to send
+@param pu8Data_ points to the data to send; it must not change until the transfer ends
+@param u16Length_ is the number of bytes to send
+
+Promises:
+- Returns TRUE if the channel is open and the transfer was started.
+- Returns FALSE if tracked acknowledged messages are pending on the channel 
+  (see AntBurstTxStart())
+
+*/
+bool AntQueueBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Data_, u16 u16Length_)
+{
+  if(AntRadioStatusChannel(eChannel_) != ANT_OPEN)
+  {
+    return(FALSE);
+  }
+  
+  return( AntBurstTxStart(eChannel_, pu8Data_, u16Length_) );
+
+} /* end AntQueueBurstTransfer */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn bool AntReceiveBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Buffer_, u16 u16Size_)
+
+@brief Collects burst data received on a channel into an application buffer.  
+
+While armed, burst packets on eChannel_ no longer appear as ANT_DATA messages.  
+A transfer sent with AntQueueBurstTransfer() is reassembled across its bursts and
+AntBurstQueryStatus() reports ANT_BURST_DONE once all of its bytes have arrived.
+
+Requires:
+@param eChannel_ is the channel number on which to receive
+@param pu8Buffer_ points to the receive buffer, or NULL to stop collecting bursts
+@param u16Size_ is the size of pu8Buffer_ in bytes
+
+Promises:
+- Returns TRUE if reception was armed or disarmed.
+
+*/
+bool AntReceiveBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Buffer_, u16 u16Size_)
+{
+  return( AntBurstRxStart(eChannel_, pu8Buffer_, u16Size_) );
+
+} /* end AntReceiveBurstTransfer */
+
+
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn bool AntReadAppMessageBuffer(void)
 
@@ -581,6 +838,7 @@ New messages are buffered by ant.c and made available to the application
 on a FIFO basis.  Whenever this function is called, the global 
 parameters are updated:
 - G_u32AntApiCurrentMessageTimeStamp
+- G_u32AntApiCurrentMessageTimeStampUs
 - G_eAntApiCurrentMessageClass
 - G_au8AntApiCurrentMessageBytes
 - G_sAntApiCurrentMessageExtData
@@ -595,38 +853,30 @@ Requires:
 Promises:
 - Returns TRUE if there is new data; 
   G_u32AntApiCurrentMessageTimeStamp
+  G_u32AntApiCurrentMessageTimeStampUs
   G_eAntApiCurrentMessageClass
   G_au8AntApiCurrentMessageBytes
   G_sAntApiCurrentMessageExtData
-  are all updated with the oldest data from G_psAntApplicationMsgList and the message
-  is removed from the buffer.
+  are all updated with the oldest message in the application message ring and the 
+  message is removed from the ring.
 - Returns FALSE if no new data is present (all variables unchanged)
 
 */
 bool AntReadAppMessageBuffer(void)
 {
-  u8 *pu8Parser;
+  AntApplicationMsgListType *psMessage;
   
-  if(G_psAntApplicationMsgList != NULL)
+  psMessage = AntPeekApplicationMessage();
+  if(psMessage != NULL)
   {
     /* Grab the single bytes */
-    G_u32AntApiCurrentMessageTimeStamp = G_psAntApplicationMsgList->u32TimeStamp;
-    G_eAntApiCurrentMessageClass = G_psAntApplicationMsgList->eMessageType;
+    G_u32AntApiCurrentMessageTimeStamp = psMessage->u32TimeStamp;
+    G_u32AntApiCurrentMessageTimeStampUs = psMessage->u32TimeStampUs;
+    G_eAntApiCurrentMessageClass = psMessage->eMessageType;
     
-    /* Copy over all the payload data */
-    pu8Parser = &(G_psAntApplicationMsgList->au8MessageData[0]);
-    for(u8 i = 0; i < ANT_APPLICATION_MESSAGE_BYTES; i++)
-    {
-      G_au8AntApiCurrentMessageBytes[i] = *(pu8Parser + i);
-    }
-    
-    /* Copy over the extended data */
-    G_sAntApiCurrentMessageExtData.u8Channel    = G_psAntApplicationMsgList->sExtendedData.u8Channel;
-    G_sAntApiCurrentMessageExtData.u8Flags      = G_psAntApplicationMsgList->sExtendedData.u8Flags;
-    G_sAntApiCurrentMessageExtData.u16DeviceID  = G_psAntApplicationMsgList->sExtendedData.u16DeviceID;
-    G_sAntApiCurrentMessageExtData.u8DeviceType = G_psAntApplicationMsgList->sExtendedData.u8DeviceType;
-    G_sAntApiCurrentMessageExtData.u8TransType  = G_psAntApplicationMsgList->sExtendedData.u8TransType;
-    G_sAntApiCurrentMessageExtData.s8RSSI       = G_psAntApplicationMsgList->sExtendedData.s8RSSI;
+    /* Copy over all the payload data and the extended data */
+    memcpy(G_au8AntApiCurrentMessageBytes, psMessage->au8MessageData, ANT_APPLICATION_MESSAGE_BYTES);
+    G_sAntApiCurrentMessageExtData = psMessage->sExtendedData;
     
     /* Done, so message can be removed from the buffer */
     AntDeQueueApplicationMessage();    
@@ -696,6 +946,90 @@ void AntGetdBmAscii(s8 s8RssiValue_, u8* pu8Result_)
 } /* end AntGetdBmAscii() */
 
 
+/***ANT LOAD TEST FUNCTIONS***/
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn bool AntLoadTestStart(AntChannelNumberType eChannel_, u16 u16MessagesPerSecond_)
+
+@brief Starts queueing broadcasts on an open channel at a fixed rate.  
+
+This loads the Host side of the driver (queueing, the SSP transfers and the 
+responses from ANT) with the radio on the board, so no second device is needed.
+Each payload holds a 32-bit sequence number followed by the 32-bit 
+G_u32SystemTime1ms when it was queued (both MSB first), so a receiver can 
+count lost messages and measure latency.  Use AntQueryThroughputStats() and 
+AntQueryPoolStats() for the results.
+
+Rates above the channel message rate fill the outgoing list unless the channel 
+is in latest-value mode (AntSetBroadcastLatestValue()).
+
+Requires:
+@param eChannel_ is an open channel
+@param u16MessagesPerSecond_ is 1 to ANT_LOAD_TEST_MAX_RATE
+
+Promises:
+- Returns TRUE and restarts the load test counters if the load test started
+- Returns FALSE if the channel is not open or the rate is out of range
+
+*/
+bool AntLoadTestStart(AntChannelNumberType eChannel_, u16 u16MessagesPerSecond_)
+{
+  if( (u16MessagesPerSecond_ == 0) || (u16MessagesPerSecond_ > ANT_LOAD_TEST_MAX_RATE) ||
+      (AntRadioStatusChannel(eChannel_) != ANT_OPEN) )
+  {
+    return(FALSE);
+  }
+  
+  AntApi_sLoadTest.eChannel = eChannel_;
+  AntApi_sLoadTest.u32Queued = 0;
+  AntApi_sLoadTest.u32Dropped = 0;
+  AntApi_u16LoadTestThisPeriod = 0;
+  AntApi_u32LoadTestTimer = G_u32SystemTime1ms;
+  AntApi_sLoadTest.u16MessagesPerSecond = u16MessagesPerSecond_;
+  
+  return(TRUE);
+  
+} /* end AntLoadTestStart */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void AntLoadTestStop(void)
+
+@brief Stops the load generator.  The counters keep their values for AntLoadTestQuery().
+
+Requires:
+- NONE
+
+Promises:
+- No more load test broadcasts are queued
+
+*/
+void AntLoadTestStop(void)
+{
+  AntApi_sLoadTest.u16MessagesPerSecond = 0;
+  
+} /* end AntLoadTestStop */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void AntLoadTestQuery(AntLoadTestStatusType* psStatus_)
+
+@brief Reports the load generator settings and counters.
+
+Requires:
+@param psStatus_ points to space for the status
+
+Promises:
+- The current status is copied to psStatus_
+
+*/
+void AntLoadTestQuery(AntLoadTestStatusType* psStatus_)
+{
+  *psStatus_ = AntApi_sLoadTest;
+  
+} /* end AntLoadTestQuery */
+
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /*! @protectedsection */                                                                                            
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -716,6 +1050,9 @@ Promises:
 */
 void AntApiInitialize(void)
 {
+  /* No tracked acknowledged messages are being delivered */
+  memset(AntApi_au8AckActive, ANT_ACK_NONE, sizeof(AntApi_au8AckActive));
+  
   /* If good initialization, set state to Idle */
   if(G_u32ApplicationFlags & _APPLICATION_FLAGS_ANT)
   {
@@ -748,98 +1085,451 @@ Promises:
 */
 void AntApiRunActiveState(void)
 {
+  AntApiAckService();
+  AntApiAssignService();
+  AntApiLoadTestService();
   AntApi_StateMachine();
 
 } /* end AntApiRunActiveState */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void AntApiAckEvent(u8 u8Channel_, bool bDelivered_)
+
+@brief Reports the result of an acknowledged transfer to the delivery engine.
+
+Called by ant.c for EVENT_TRANSFER_TX_COMPLETED and EVENT_TRANSFER_TX_FAILED.
+Events on a channel that is sending a burst belong to the burst and are ignored.
+
+Requires:
+@param u8Channel_ is the channel of the event
+@param bDelivered_ is TRUE if the message was acknowledged
+
+Promises:
+- If a tracked message was sent on the channel, it is ANT_ACK_DELIVERED, waits to be 
+  sent again, or is ANT_ACK_FAILED once ANT_ACK_MAX_RETRIES retries have failed
+
+*/
+void AntApiAckEvent(u8 u8Channel_, bool bDelivered_)
+{
+  u8 u8Slot;
+  AntAckMessageType *psAck;
+  
+  if( (u8Channel_ >= ANT_NUM_CHANNELS) || AntBurstTxActive((AntChannelNumberType)u8Channel_) )
+  {
+    return;
+  }
+  
+  u8Slot = AntApi_au8AckActive[u8Channel_];
+  if( (u8Slot == ANT_ACK_NONE) || (AntApi_asAckMessages[u8Slot].eStatus != ANT_ACK_SENT) )
+  {
+    return;
+  }
+  
+  psAck = &AntApi_asAckMessages[u8Slot];
+  if(bDelivered_)
+  {
+    psAck->eStatus = ANT_ACK_DELIVERED;
+    AntApi_au8AckActive[u8Channel_] = ANT_ACK_NONE;
+  }
+  else if(psAck->u8Attempts > ANT_ACK_MAX_RETRIES)
+  {
+    psAck->eStatus = ANT_ACK_FAILED;
+    AntApi_au8AckActive[u8Channel_] = ANT_ACK_NONE;
+  }
+  else
+  {
+    /* Back off before trying again: ANT_ACK_BACKOFF_MS, then twice that, ... */
+    psAck->eStatus  = ANT_ACK_WAITING;
+    psAck->u32Timer = G_u32SystemTime1ms;
+    psAck->u32Delay = ANT_ACK_BACKOFF_MS << (psAck->u8Attempts - 1);
+  }
+
+} /* end AntApiAckEvent */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn bool AntApiAckPending(u8 u8Channel_)
+
+@brief Reports if the delivery engine has tracked messages waiting or being sent on a channel.
+
+Used by ant.c so a burst transfer does not share the channel's transfer events 
+with tracked acknowledged messages.
+
+Requires:
+@param u8Channel_ is the channel to check
+
+Promises:
+- Returns TRUE if a tracked message on u8Channel_ is ANT_ACK_WAITING or ANT_ACK_SENT
+
+*/
+bool AntApiAckPending(u8 u8Channel_)
+{
+  for(u8 i = 0; i < ANT_ACK_MESSAGE_SLOTS; i++)
+  {
+    if( ((u8)AntApi_asAckMessages[i].eChannel == u8Channel_) &&
+        ((AntApi_asAckMessages[i].eStatus == ANT_ACK_WAITING) || 
+         (AntApi_asAckMessages[i].eStatus == ANT_ACK_SENT)) )
+    {
+      return(TRUE);
+    }
+  }
+  
+  return(FALSE);
+  
+} /* end AntApiAckPending */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void AntApiResponseEvent(u8 u8Channel_, u8 u8MessageId_, u8 u8ResponseCode_)
+
+@brief Matches a channel response from ANT to a channel configuration in progress.
+
+ANT answers commands in the order they were sent, so the response belongs to the 
+oldest configuration whose next unanswered message has this ID (and, for 
+channel-specific messages, this channel).
+
+Requires:
+- Called by ant.c for every channel response
+
+@param u8Channel_ is the channel byte of the response
+@param u8MessageId_ is the ID of the message being answered
+@param u8ResponseCode_ is the response code
+
+Promises:
+- A matching configuration counts the response and is ANT_ASSIGN_DONE after the
+  last one, or ANT_ASSIGN_FAILED if the response is an error
+
+*/
+void AntApiResponseEvent(u8 u8Channel_, u8 u8MessageId_, u8 u8ResponseCode_)
+{
+  AntAssignJobType *psJob;
+  u8 u8Match = ANT_NUM_CHANNELS;
+  bool bChannelMessage;
+  
+  /* The network key, library config and transmit power commands are not channel-specific */
+  bChannelMessage = (u8MessageId_ != MESG_NETWORK_KEY_ID) && 
+                    (u8MessageId_ != MESG_LIB_CONFIG_ID) &&
+                    (u8MessageId_ != MESG_RADIO_TX_POWER_ID);
+  
+  for(u8 i = 0; i < ANT_NUM_CHANNELS; i++)
+  {
+    psJob = &AntApi_asAssignJobs[i];
+    if( (psJob->eStatus == ANT_ASSIGN_BUSY) &&
+        (psJob->u8Responses < psJob->u8NextMessage) &&
+        (AntApi_apu8AntAssignChannel[psJob->u8Responses][BUFFER_INDEX_MESG_ID] == u8MessageId_) &&
+        ( !bChannelMessage || (i == u8Channel_) ) &&
+        ( (u8Match == ANT_NUM_CHANNELS) ||
+          ((s16)(psJob->u16Ticket - AntApi_asAssignJobs[u8Match].u16Ticket) < 0) ) )
+    {
+      u8Match = i;
+    }
+  }
+  
+  if(u8Match == ANT_NUM_CHANNELS)
+  {
+    return;
+  }
+  
+  psJob = &AntApi_asAssignJobs[u8Match];
+  if(u8ResponseCode_ != RESPONSE_NO_ERROR)
+  {
+    /* Channel flags remain clear for the application to check */
+    AntDebugPrintChannelMessage(G_au8AntMessageAssign, u8Match);
+    DebugPrintf(G_au8AntMessageFail);
+    psJob->eStatus = ANT_ASSIGN_FAILED;
+    return;
+  }
+  
+  psJob->u8Responses++;
+  psJob->u32Timer = G_u32SystemTime1ms;
+  if(psJob->u8Responses == ANT_ASSIGN_MESSAGES)
+  {
+    AntDebugPrintChannelMessage(G_au8AntMessageAssign, u8Match);
+    DebugPrintf(G_au8AntMessageOk);
+    G_asAntChannelConfiguration[u8Match].AntFlags |= _ANT_FLAGS_CHANNEL_CONFIGURED;
+    psJob->eStatus = ANT_ASSIGN_DONE;
+  }
+
+} /* end AntApiResponseEvent */
+
+
 /*----------------------------------------------------------------------------------------------------------------------*/
 /*! @privatesection */                                                                                            
 /*----------------------------------------------------------------------------------------------------------------------*/
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void AntApiBuildAssignMessages(AntChannelNumberType eChannel_)
 
-/**********************************************************************************************************************
-State Machine Function Definitions
-**********************************************************************************************************************/
+@brief Updates all configuration messages with the parameters of a channel.
 
-/*!-------------------------------------------------------------------------------------------------------------------
-@fn static void AntApiSM_Idle(void)
+Requires:
+@param eChannel_ is the channel whose parameters are in G_asAntChannelConfiguration
+
+Promises:
+- All messages in AntApi_apu8AntAssignChannel are filled in for eChannel_ with checksums
 
-@brief Wait for a message to be queued.
 */
-static void AntApiSM_Idle(void)
+static void AntApiBuildAssignMessages(AntChannelNumberType eChannel_)
 {
-  /* Monitor requests to send generic ANT messages */
+  AntAssignChannelInfoType *psConfig = &G_asAntChannelConfiguration[eChannel_];
   
-} /* end AntApiSM_Idle() */
+  /* Setup the library config message (for extended data) - use defaults for now */
+  G_au8AntLibConfig[4] = AntCalculateTxChecksum(G_au8AntLibConfig);
+
+  /* Set Network key message */
+  G_au8AntSetNetworkKey[2] = psConfig->AntNetwork;
+  for(u8 i = 0; i < ANT_NETWORK_NUMBER_BYTES; i++)
+  {
+    G_au8AntSetNetworkKey[i + 3] = psConfig->AntNetworkKey[i];
+  }
+  G_au8AntSetNetworkKey[11] = AntCalculateTxChecksum(G_au8AntSetNetworkKey);
+    
+  /* Setup the channel message */
+  G_au8AntAssignChannel[2] = eChannel_;
+  G_au8AntAssignChannel[3] = psConfig->AntChannelType;
+  G_au8AntAssignChannel[4] = psConfig->AntNetwork;
+  G_au8AntAssignChannel[5] = AntCalculateTxChecksum(G_au8AntAssignChannel);
+
+  /* Setup the channel ID message */
+  G_au8AntSetChannelID[2] = eChannel_;
+  G_au8AntSetChannelID[3] = psConfig->AntDeviceIdLo;
+  G_au8AntSetChannelID[4] = psConfig->AntDeviceIdHi;
+  G_au8AntSetChannelID[5] = psConfig->AntDeviceType;
+  G_au8AntSetChannelID[6] = psConfig->AntTransmissionType;
+  G_au8AntSetChannelID[7] = AntCalculateTxChecksum(G_au8AntSetChannelID);
+    
+  /* Setup the channel period message */
+  G_au8AntSetChannelPeriod[2] = eChannel_;
+  G_au8AntSetChannelPeriod[3] = psConfig->AntChannelPeriodLo;
+  G_au8AntSetChannelPeriod[4] = psConfig->AntChannelPeriodHi;
+  G_au8AntSetChannelPeriod[5] = AntCalculateTxChecksum(G_au8AntSetChannelPeriod);
+    
+  /* Setup the channel frequency message */
+  G_au8AntSetChannelRFFreq[2] = eChannel_;
+  G_au8AntSetChannelRFFreq[3] = psConfig->AntFrequency;
+  G_au8AntSetChannelRFFreq[4] = AntCalculateTxChecksum(G_au8AntSetChannelRFFreq);
+
+  /* Setup the channel power message */
+  G_au8AntSetChannelPower[3] = psConfig->AntTxPower;
+  G_au8AntSetChannelPower[4] = AntCalculateTxChecksum(G_au8AntSetChannelPower);
      
+  /* Setup the the channel search timeout (currently set at default for infinite search) */
+  G_au8AntSetSearchTimeout[2] = eChannel_;
+  G_au8AntSetSearchTimeout[3] = ANT_INFINITE_SEARCH_TIMEOUT;
+  G_au8AntSetSearchTimeout[4] = AntCalculateTxChecksum(G_au8AntSetSearchTimeout);
+  
+} /* end AntApiBuildAssignMessages() */
 
-/*!-------------------------------------------------------------------------------------------------------------------
-@fn static void AntApiSM_AssignChannel(void)          
 
-@brief Send all configuration messages to ANT to fully assign the channel.
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void AntApiAssignService(void)
+
+@brief Feeds the configuration messages of every channel being assigned to ANT.
+
+Messages are queued as soon as the outgoing list accepts them instead of after 
+the previous response, so several channels are configured at once.  
+ANT_ASSIGN_POOL_RESERVE outgoing blocks are left for other messages.  Responses 
+are counted by AntApiResponseEvent().
+
+Requires:
+- Called every loop from AntApiRunActiveState()
+
+Promises:
+- Unsent configuration messages are queued while there is room
+- A configuration with no response for ANT_ACTIVITY_TIME_COUNT ms is ANT_ASSIGN_FAILED
 
-The selected channel has already been verified unconfigured, and all required setup
-messages are ready to go.  
 */
-static void AntApiSM_AssignChannel(void)          
+static void AntApiAssignService(void)
 {
-  static u8 u8CurrentMessageToSend = 0;
-  static u8 u8CurrentMesssageId = 0;
-  static bool bMessageInProgress = FALSE;
+  AntAssignJobType *psJob;
+  AntPoolStatsType sOutgoingStats;
   
-  /* Queue the next message if it's time */
-  if(bMessageInProgress == FALSE)
+  for(u8 u8Channel = 0; u8Channel < ANT_NUM_CHANNELS; u8Channel++)
   {
-    u8CurrentMesssageId = *(AntApi_apu8AntAssignChannel[u8CurrentMessageToSend] + BUFFER_INDEX_MESG_ID); 
-    AntQueueOutgoingMessage(AntApi_apu8AntAssignChannel[u8CurrentMessageToSend]);
-    bMessageInProgress = TRUE;
+    psJob = &AntApi_asAssignJobs[u8Channel];
+    if(psJob->eStatus != ANT_ASSIGN_BUSY)
+    {
+      continue;
+    }
+    
+    if(psJob->u8NextMessage < ANT_ASSIGN_MESSAGES)
+    {
+      AntApiBuildAssignMessages((AntChannelNumberType)u8Channel);
+      AntQueryPoolStats(&sOutgoingStats, NULL);
+      while( (psJob->u8NextMessage < ANT_ASSIGN_MESSAGES) &&
+             ((sOutgoingStats.u16InUse + ANT_ASSIGN_POOL_RESERVE) < sOutgoingStats.u16Size) &&
+             AntQueueOutgoingMessage(AntApi_apu8AntAssignChannel[psJob->u8NextMessage]) )
+      {
+        psJob->u8NextMessage++;
+        sOutgoingStats.u16InUse++;
+      }
+    }
+    
+    /* Check for timeout */
+    if(IsTimeUp(&psJob->u32Timer, ANT_ACTIVITY_TIME_COUNT) )
+    {
+      /* Report the error.  Channel flags will remain clear for application to check. */
+      AntDebugPrintChannelMessage(G_au8AntMessageAssign, u8Channel);
+      DebugPrintf(G_au8AntMessageFail);
+      psJob->eStatus = ANT_ASSIGN_FAILED;
+    }
   }
   
-  /* Check message status */
-  if( u8CurrentMesssageId == G_stAntMessageResponse.u8MessageNumber )
-  { 
-    if(G_stAntMessageResponse.u8ResponseCode == RESPONSE_NO_ERROR)
+} /* end AntApiAssignService() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void AntApiAckService(void)
+
+@brief Sends tracked acknowledged messages and times out lost results.
+
+Requires:
+- Called every loop from AntApiRunActiveState()
+
+Promises:
+- A channel with no message being delivered takes its oldest waiting message
+- A message whose backoff has expired is queued to ANT if the channel is open, or 
+  fails if it is not
+- A message with no result after ANT_ACK_TIMEOUT_MS counts as a failed attempt
+
+*/
+static void AntApiAckService(void)
+{
+  u8 u8Slot;
+  AntAckMessageType *psAck;
+  
+  for(u8 u8Channel = 0; u8Channel < ANT_NUM_CHANNELS; u8Channel++)
+  {
+    /* Start the oldest waiting message if the channel is free */
+    u8Slot = AntApi_au8AckActive[u8Channel];
+    if(u8Slot == ANT_ACK_NONE)
     {
-      /* Increment message pointer and check if complete */
-      u8CurrentMessageToSend++;
-      if(u8CurrentMessageToSend == ANT_ASSIGN_MESSAGES)
+      for(u8 i = 0; i < ANT_ACK_MESSAGE_SLOTS; i++)
       {
-        /* Print OK message and update the channel flags */
-        G_au8AntMessageAssign[12] = G_stAntMessageResponse.u8Channel + NUMBER_ASCII_TO_DEC;
-        DebugPrintf(G_au8AntMessageAssign);
-        DebugPrintf(G_au8AntMessageOk);
-        G_asAntChannelConfiguration[G_stAntMessageResponse.u8Channel].AntFlags |= _ANT_FLAGS_CHANNEL_CONFIGURED;
-
-        /* Clean up and exit this state */
-        u8CurrentMessageToSend = 0;
-        AntApi_StateMachine = AntApiSM_Idle;
+        if( (AntApi_asAckMessages[i].eStatus == ANT_ACK_WAITING) &&
+            ((u8)AntApi_asAckMessages[i].eChannel == u8Channel) &&
+            ( (u8Slot == ANT_ACK_NONE) || 
+              ((s16)(AntApi_asAckMessages[i].u16Ticket - AntApi_asAckMessages[u8Slot].u16Ticket) < 0) ) )
+        {
+          u8Slot = i;
+        }
       }
-    } 
-    else
+      
+      if(u8Slot == ANT_ACK_NONE)
+      {
+        continue;
+      }
+      AntApi_au8AckActive[u8Channel] = u8Slot;
+    }
+    
+    psAck = &AntApi_asAckMessages[u8Slot];
+    if( (psAck->eStatus == ANT_ACK_WAITING) && IsTimeUp(&psAck->u32Timer, psAck->u32Delay) )
     {
-      /* Report the error and return.  Channel flags will remain clear for application to check. */
-      DebugPrintf(G_au8AntMessageAssign);
-      DebugPrintf(G_au8AntMessageFail);
-      AntApi_StateMachine = AntApiSM_Idle;
+      if(AntRadioStatusChannel(psAck->eChannel) != ANT_OPEN)
+      {
+        psAck->eStatus = ANT_ACK_FAILED;
+        AntApi_au8AckActive[u8Channel] = ANT_ACK_NONE;
+      }
+      else if(AntQueueAcknowledgedMessage(psAck->eChannel, psAck->au8Data))
+      {
+        psAck->eStatus  = ANT_ACK_SENT;
+        psAck->u32Timer = G_u32SystemTime1ms;
+        psAck->u8Attempts++;
+      }
+    }
+    else if( (psAck->eStatus == ANT_ACK_SENT) && IsTimeUp(&psAck->u32Timer, ANT_ACK_TIMEOUT_MS) )
+    {
+      AntApiAckEvent(u8Channel, FALSE);
     }
+  }
+  
+} /* end AntApiAckService() */
 
-    /* In either case, clean up the following: */
-    bMessageInProgress = FALSE;
 
-  } /* end if( u8CurrentMesssageId == G_stAntMessageResponse.u8MessageNumber ) */
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void AntApiLoadTestService(void)
+
+@brief Queues the load test broadcasts that are due.
+
+The broadcasts of each ANT_LOAD_TEST_PERIOD_MS window are spread evenly across it.
+If the task falls behind by a whole window, the missing messages are not made up.
+
+Requires:
+- NONE
+
+Promises:
+- If a load test is running, broadcasts are queued up to the number due in the 
+  current window and u32Queued or u32Dropped is updated for each one
+
+*/
+static void AntApiLoadTestService(void)
+{
+  u32 u32Elapsed;
+  u32 u32Due;
+  u32 u32Sequence;
+  u8 au8Payload[ANT_DATA_BYTES];
   
-  /* Check for timeout */
-  if(IsTimeUp(&AntApi_u32Timeout, ANT_ACTIVITY_TIME_COUNT) )
+  if(AntApi_sLoadTest.u16MessagesPerSecond == 0)
   {
-    /* Report the error and return.  Channel flags will remain clear for application to check. */
-    DebugPrintf(G_au8AntMessageAssign);
-    DebugPrintf(G_au8AntMessageFail);
-    AntApi_StateMachine = AntApiSM_Idle;
+    return;
+  }
+  
+  u32Elapsed = G_u32SystemTime1ms - AntApi_u32LoadTestTimer;
+  if(u32Elapsed > ANT_LOAD_TEST_PERIOD_MS)
+  {
+    u32Elapsed = ANT_LOAD_TEST_PERIOD_MS;
   }
+  u32Due = (u32Elapsed * AntApi_sLoadTest.u16MessagesPerSecond) / ANT_LOAD_TEST_PERIOD_MS;
   
-} /* end AntApiSM_AssignChannel() */
+  while(AntApi_u16LoadTestThisPeriod < u32Due)
+  {
+    u32Sequence = AntApi_sLoadTest.u32Queued + AntApi_sLoadTest.u32Dropped;
+    au8Payload[0] = (u8)(u32Sequence >> 24);
+    au8Payload[1] = (u8)(u32Sequence >> 16);
+    au8Payload[2] = (u8)(u32Sequence >> 8);
+    au8Payload[3] = (u8)(u32Sequence);
+    au8Payload[4] = (u8)(G_u32SystemTime1ms >> 24);
+    au8Payload[5] = (u8)(G_u32SystemTime1ms >> 16);
+    au8Payload[6] = (u8)(G_u32SystemTime1ms >> 8);
+    au8Payload[7] = (u8)(G_u32SystemTime1ms);
+    
+    if( AntQueueBroadcastMessage(AntApi_sLoadTest.eChannel, au8Payload) )
+    {
+      AntApi_sLoadTest.u32Queued++;
+    }
+    else
+    {
+      AntApi_sLoadTest.u32Dropped++;
+    }
+    AntApi_u16LoadTestThisPeriod++;
+  }
+  
+  /* Start the next window */
+  if(u32Elapsed == ANT_LOAD_TEST_PERIOD_MS)
+  {
+    AntApi_u32LoadTestTimer = G_u32SystemTime1ms;
+    AntApi_u16LoadTestThisPeriod = 0;
+  }
+  
+} /* end AntApiLoadTestService() */
+
+
+/**********************************************************************************************************************
+State Machine Function Definitions
+**********************************************************************************************************************/
 
+/*!-------------------------------------------------------------------------------------------------------------------
+@fn static void AntApiSM_Idle(void)
+
+@brief Wait for a message to be queued.
+*/
+static void AntApiSM_Idle(void)
+{
+  /* Monitor requests to send generic ANT messages */
+  
+} /* end AntApiSM_Idle() */
+     
 
 #if 0
 /*-------------------------------------------------------------------------------------------------------------------*/
@@ -9,6 +9,68 @@
 /**********************************************************************************************************************
 Type definitions
 **********************************************************************************************************************/
+/*! 
+@enum AntAckStatusType
+@brief Delivery status of a tracked acknowledged message 
+*/
+typedef enum {ANT_ACK_UNKNOWN, ANT_ACK_WAITING, ANT_ACK_SENT, ANT_ACK_DELIVERED, ANT_ACK_FAILED} AntAckStatusType;
+
+/*! 
+@struct AntAckMessageType
+@brief Slot of the acknowledged message delivery engine
+*/
+typedef struct
+{
+  AntAckStatusType eStatus;                /*!< @brief Delivery status (ANT_ACK_UNKNOWN when the slot is free) */
+  AntChannelNumberType eChannel;           /*!< @brief Channel to send on */
+  u8 au8Data[ANT_APPLICATION_MESSAGE_BYTES]; /*!< @brief Message payload */
+  u8 u8Attempts;                           /*!< @brief Number of times the message has been sent */
+  u8 u8Generation;                         /*!< @brief Upper byte of the handle so reused slots are detected */
+  u16 u16Ticket;                           /*!< @brief Queue order for messages on the same channel */
+  u32 u32Timer;                            /*!< @brief Start of the current wait */
+  u32 u32Delay;                            /*!< @brief Backoff time before the next attempt */
+} AntAckMessageType;
+
+/*! 
+@enum AntAssignStatusType
+@brief Progress of AntAssignChannel() for one channel
+*/
+typedef enum {ANT_ASSIGN_IDLE, ANT_ASSIGN_BUSY, ANT_ASSIGN_DONE, ANT_ASSIGN_FAILED} AntAssignStatusType;
+
+/*! 
+@struct AntAssignJobType
+@brief Configuration pipeline state for one channel
+*/
+typedef struct
+{
+  AntAssignStatusType eStatus;             /*!< @brief Configuration progress */
+  u8 u8NextMessage;                        /*!< @brief Index of the next configuration message to queue */
+  u8 u8Responses;                          /*!< @brief Configuration messages answered without error */
+  u16 u16Ticket;                           /*!< @brief Start order, used to match responses that have no channel */
+  u32 u32Timer;                            /*!< @brief Time of the start or the latest response */
+} AntAssignJobType;
+
+/*! 
+@struct AntBroadcastBatchType
+@brief One channel's payload for AntQueueBroadcastBatch()
+*/
+typedef struct
+{
+  AntChannelNumberType eChannel;           /*!< @brief Channel to broadcast on */
+  u8 au8Data[ANT_APPLICATION_MESSAGE_BYTES]; /*!< @brief Broadcast payload */
+} AntBroadcastBatchType;
+
+/*! 
+@struct AntLoadTestStatusType
+@brief Progress of the broadcast load generator (see AntLoadTestStart())
+*/
+typedef struct
+{
+  AntChannelNumberType eChannel;           /*!< @brief Channel being loaded */
+  u16 u16MessagesPerSecond;                /*!< @brief Target rate; 0 when no load test is running */
+  u32 u32Queued;                           /*!< @brief Broadcasts added to the outgoing list */
+  u32 u32Dropped;                          /*!< @brief Broadcasts that found the outgoing list full */
+} AntLoadTestStatusType;
 
 
 /**********************************************************************************************************************
@@ -21,6 +83,7 @@ Function Declarations
 AntChannelStatusType AntRadioStatusChannel(AntChannelNumberType eChannel_);
 
 bool AntAssignChannel(AntAssignChannelInfoType* psAntSetupInfo_);
+AntAssignStatusType AntAssignChannelStatus(AntChannelNumberType eChannel_);
 bool AntUnassignChannelNumber(AntChannelNumberType eChannel_);
 
 bool AntOpenChannelNumber(AntChannelNumberType eChannel_);
@@ -28,23 +91,40 @@ bool AntOpenScanningChannel(void);
 bool AntCloseChannelNumber(AntChannelNumberType eChannel_);
 
 bool AntQueueBroadcastMessage(AntChannelNumberType eChannel_, u8 *pu8Data_);
+void AntSetBroadcastLatestValue(AntChannelNumberType eChannel_, bool bEnable_);
+u8 AntQueueBroadcastBatch(AntBroadcastBatchType* psBatch_, u8 u8Count_);
 bool AntQueueAcknowledgedMessage(AntChannelNumberType eChannel_, u8 *pu8Data_);
+u16 AntQueueTrackedAckMessage(AntChannelNumberType eChannel_, u8 *pu8Data_);
+AntAckStatusType AntQueryTrackedAckMessage(u16 u16Handle_);
+bool AntQueueBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Data_, u16 u16Length_);
+bool AntReceiveBurstTransfer(AntChannelNumberType eChannel_, u8 *pu8Buffer_, u16 u16Size_);
 
 bool AntReadAppMessageBuffer(void);
 
 void AntGetdBmAscii(s8 s8RssiValue_, u8* pu8Result_);
 
+bool AntLoadTestStart(AntChannelNumberType eChannel_, u16 u16MessagesPerSecond_);
+void AntLoadTestStop(void);
+void AntLoadTestQuery(AntLoadTestStatusType* psStatus_);
+
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*! @protectedsection */                                                                                            
 /*-------------------------------------------------------------------------------------------------------------------*/
 void AntApiInitialize(void);
 void AntApiRunActiveState(void);
+void AntApiAckEvent(u8 u8Channel_, bool bDelivered_);
+bool AntApiAckPending(u8 u8Channel_);
+void AntApiResponseEvent(u8 u8Channel_, u8 u8MessageId_, u8 u8ResponseCode_);
 
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*! @privatesection */                                                                                            
 /*-------------------------------------------------------------------------------------------------------------------*/
+static void AntApiBuildAssignMessages(AntChannelNumberType eChannel_);
+static void AntApiAssignService(void);
+static void AntApiAckService(void);
+static void AntApiLoadTestService(void);
 
 
 
@@ -52,7 +132,6 @@ void AntApiRunActiveState(void);
 State Machine Declarations
 ***********************************************************************************************************************/
 static void AntApiSM_Idle(void);    
-static void AntApiSM_AssignChannel(void);       
 
 static void AntApiSM_Error(void);         
 static void AntApiSM_FailedInit(void);    
@@ -62,11 +141,21 @@ static void AntApiSM_FailedInit(void);
 Constants
 **********************************************************************************************************************/
 #define ANT_ASSIGN_MESSAGES                 (u8)8    /* Number of messages in AntAssignChannel */       
+#define ANT_ASSIGN_POOL_RESERVE             (u16)4   /* Outgoing pool blocks channel assignment leaves free */
 
 #define ANT_OUTGOING_MESSAGE_BUFFER_SIZE    (u32)32
 #define ANT_APPLICATION_MESSAGE_BUFFER_SIZE (u32)32
 #define ANT_DATA_BYTES                      (u8)8
 
+#define ANT_ACK_MESSAGE_SLOTS               (u8)8      /* Tracked acknowledged messages waiting or in progress */
+#define ANT_ACK_MAX_RETRIES                 (u8)3      /* Retries after the first failed attempt */
+#define ANT_ACK_BACKOFF_MS                  (u32)50    /* Wait before the first retry; doubles for each retry */
+#define ANT_ACK_TIMEOUT_MS                  (u32)5000  /* Longest wait for the result of one attempt */
+#define ANT_ACK_NONE                        (u8)0xFF   /* No slot */
+
+#define ANT_LOAD_TEST_MAX_RATE              (u16)1000  /* Most broadcasts per second the load generator will queue */
+#define ANT_LOAD_TEST_PERIOD_MS             (u32)1000  /* Window in which the load generator spreads its messages */
+
 
 /**********************************************************************************************************************
 Application messages
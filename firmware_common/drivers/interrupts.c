@@ -27,6 +27,8 @@ Global variable definitions with scope across entire project.
 All Global variable names shall start with "G_<type>ISR"
 ***********************************************************************************************************************/
 /* New variables */
+volatile u32 G_u32ISRCycleCount = 0;                   /*!< @brief MCK cycles spent in instrumented ISRs (see ISR_PROFILE_ENTER()) */
+volatile u8 G_u8ISRNesting = 0;                        /*!< @brief Instrumented ISRs currently running */
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -111,6 +113,8 @@ Promises:
 */
 void SysTick_Handler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Clear the sleep flag */
   G_u32SystemFlags &= ~_SYSTEM_SLEEPING;
   
@@ -120,7 +124,8 @@ void SysTick_Handler(void)
   {
     G_u32SystemTime1s++;
   }
-    
+
+  ISR_PROFILE_EXIT();
 } /* end SysTickHandler(void) */
 
 
@@ -146,6 +151,8 @@ void PIOA_IrqHandler(void)
   u32 u32ButtonInterrupts;
   u32 u32CurrentButtonLocation;
 
+  ISR_PROFILE_ENTER();
+
   /* Grab a snapshot of the current PORTA status flags (clears all flags) */
   u32GPIOInterruptSources = AT91C_BASE_PIOA->PIO_ISR;
 
@@ -176,7 +183,8 @@ void PIOA_IrqHandler(void)
   
   /* Clear the PIOA pending flag and exit */
   NVIC_ClearPendingIRQ(IRQn_PIOA);
-  
+
+  ISR_PROFILE_EXIT();
 } /* end PIOA_IrqHandler() */
 
 
@@ -202,6 +210,8 @@ void PIOB_IrqHandler(void)
   u32 u32ButtonInterrupts;
   u32 u32CurrentButtonLocation;
 
+  ISR_PROFILE_ENTER();
+
   /* Grab a snapshot of the current PORTB status flags (clears all flags) */
   u32GPIOInterruptSources = AT91C_BASE_PIOB->PIO_ISR;
 
@@ -232,7 +242,8 @@ void PIOB_IrqHandler(void)
   
   /* Clear the PIOB pending flag and exit */
   NVIC_ClearPendingIRQ(IRQn_PIOB);
-  
+
+  ISR_PROFILE_EXIT();
 } /* end PIOB_IrqHandler() */
 
 
@@ -83,7 +83,7 @@ void PIOB_IrqHandler(void);
 
 
 /***********************************************************************************************************************
-Constants / Definitions
+Interrupt Configuration
 ***********************************************************************************************************************/
 #define U8_SAM3U2_INTERRUPT_SOURCES       (u8)(30)
 
@@ -37,6 +37,8 @@ PROTECTED FUNCTIONS
 - u32 QueueMessage(MessageType** ppsTargetTxBuffer_, u32 u32MessageSize_, u8* pu8MessageData_)
 - void DeQueueMessage(MessageType** pTargetQueue_)
 - void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_)
+- u32 AllocateMessageToken(void)
+- u8 MessagingFreeSlots(void)
 
 
 **********************************************************************************************************************/
@@ -91,7 +93,7 @@ Function Definitions
 
 @brief Checks the state of a message and returns the current MessageStateType
 
-If the state is COMPLETE, TIMEOUT or ABANDONED, calling this function
+If the state is COMPLETE, TIMEOUT, ABANDONED or FAILED, calling this function
 forces the associated status to be cleared from the message queue.
 Since the queue is quite short, most of the time it will hold very little entries.  
 New entries are always filled at the front, using a simple linear search starting at index 0.
@@ -101,7 +103,7 @@ Requires:
 
 Promises:
 - Returns MessageStateType indicating the status of the message
-- if the message is found in COMPLETE, TIMEOUT, or ABANDONED state, the status is removed from
+- if the message is found in COMPLETE, TIMEOUT, ABANDONED or FAILED state, the status is removed from
 the queue and time-stamped for debugging purposes.
 
 */
@@ -125,7 +127,8 @@ MessageStateType QueryMessageStatus(u32 u32Token_)
     eStatus = pListParser->eState;
 
     /* Release the slot if the message state is final (the client must deal with it now) */
-    if( (eStatus == COMPLETE) || (eStatus == TIMEOUT) || (eStatus == ABANDONED) )
+    if( (eStatus == COMPLETE) || (eStatus == TIMEOUT) || 
+        (eStatus == ABANDONED) || (eStatus == FAILED) )
     {
       pListParser->u32Token = 0;
       pListParser->eState = EMPTY;
@@ -313,6 +316,7 @@ u32 QueueMessage(MessageType** ppsTargetTxBuffer_, u32 u32MessageSize_, u8* pu8M
     /* Copy all the data to the allocated message structure */
     psNewMessage->u32Token      = Msg_u32Token;
     psNewMessage->u32Size       = u32CurrentMessageSize;
+    psNewMessage->bMoreSlots    = (bool)(u32BytesRemaining != 0);
     psNewMessage->psNextMessage = NULL;
     
     /* Add the data into the payload */
@@ -449,6 +453,70 @@ void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_)
 } /* end UpdateMessageStatus() */
 
 
+/*!--------------------------------------------------------------------------------------------------------------------
+@fn u32 AllocateMessageToken(void)
+
+@brief Assigns a token and WAITING status to a transfer that has no payload in the message pool.
+
+Some peripheral operations (e.g. TWI reads) deliver their data straight into a client 
+buffer so they do not need a slot in Msg_asPool, but the client still needs a way to
+know when the transfer is finished.  The driver gets a token here and reports progress 
+with UpdateMessageStatus() just like a queued message.  The client uses QueryMessageStatus().
+
+Requires:
+- NONE
+
+Promises:
+- A new status is added to the status queue in the WAITING state
+- Returns the token assigned to the status (never 0)
+
+*/
+u32 AllocateMessageToken(void)
+{
+  u32 u32Token;
+  u32 u32Primask = __get_PRIMASK();
+  
+  /* Token allocation must not be interrupted by another task queuing a message.  
+  PRIMASK is restored rather than cleared so a caller with interrupts off keeps them off. */
+  __disable_irq();
+  u32Token = Msg_u32Token;
+  AddNewMessageStatus(u32Token);
+
+  /* Increment message token and catch the rollover... Token 0 is not allowed. */
+  Msg_u32Token++;
+  if(Msg_u32Token == 0)
+  {
+    Msg_u32Token = 1;
+  }
+  __set_PRIMASK(u32Primask);
+  
+  return(u32Token);
+  
+} /* end AllocateMessageToken() */
+
+
+/*!--------------------------------------------------------------------------------------------------------------------
+@fn u8 MessagingFreeSlots(void)
+
+@brief Returns the number of unused slots in the message pool.
+
+Clients that can choose to skip a message (e.g. debug output) use this to leave
+space for everyone else.
+
+Requires:
+- NONE
+
+Promises:
+- Returns U8_TX_QUEUE_SIZE less the slots currently holding messages
+
+*/
+u8 MessagingFreeSlots(void)
+{
+  return(U8_TX_QUEUE_SIZE - Msg_u8QueuedMessageCount);
+  
+} /* end MessagingFreeSlots() */
+
+
 /*------------------------------------------------------------------------------------------------------------------*/
 /*! @privatesection */                                                                                            
 /*--------------------------------------------------------------------------------------------------------------------*/
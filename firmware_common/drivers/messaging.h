@@ -53,6 +53,7 @@ typedef struct
   u32 u32Token;                             /*!< @brief Unique token for this message */
   u32 u32Size;                              /*!< @brief Size of the data payload in bytes */
   u8 pu8Message[U16_MAX_TX_MESSAGE_LENGTH]; /*!< @brief Data payload array */
+  bool bMoreSlots;                          /*!< @brief TRUE if the message was split and continues in the next slot */
   void* psNextMessage;                      /*!< @brief Pointer to next message */
 } MessageType;
 
@@ -97,6 +98,8 @@ void MessagingRunActiveState(void);
 u32 QueueMessage(MessageType** ppeTargetTxBuffer_, u32 u32MessageSize_, u8* pu8MessageData_);
 void DeQueueMessage(MessageType** pTargetQueue_);
 void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_);
+u32 AllocateMessageToken(void);
+u8 MessagingFreeSlots(void);
 
 
 /*------------------------------------------------------------------------------------------------------------------*/
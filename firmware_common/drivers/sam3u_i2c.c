@@ -1,20 +1,26 @@
 /*!**********************************************************************************************************************
-@file sam3u_i2c.c                                                                
-@brief MASTER ONLY.  Provides a driver to use TWI0 (IIC/I2C) peripheral to send and receive data using 
+@file sam3u_i2c.c
+@brief MASTER ONLY.  Provides a driver to use the TWI0 and TWI1 (IIC/I2C) peripherals to send and receive data using
 interrupts and PDC direct memory access.
 
 Currently Set at 200kHz Master Mode.
 
 Due to the nature of I2C use-cases, this driver does not require tasks to request and release it.
+Each bus is a TwiPeripheralType object with its own local message buffer and state machine, so a
+slow device on one bus never holds up transfers on the other.  Clients select the bus with its
+PeripheralType name (TWI0 or TWI1) or the self-documenting alias from configuration.h (e.g. LCD_I2C).
 Read / write messages information is queued locally with all required details.  The driver will
-continually cycle through the local message buffer and perform the reads or writes on a FIFO basis.
-Read messages stand alone.  Write messages will have associated Message task messages.
+continually cycle through each bus's local message buffer and perform the reads or writes on a FIFO basis.
+Read messages stand alone but are given a status-only token from the Message task so clients
+can use QueryMessageStatus() to find out when the receive buffer is valid.  Write messages will have
+associated Message task messages.  A NACK marks the affected transfer FAILED and a receive timeout
+marks it TIMEOUT.
 
 Clock stretching is supported automatically by the peripheral in Master mode for both read and write.
 
 ------------------------------------------------------------------------------------------------------------------------
 GLOBALS
-- G_u32Twi0ApplicationFlags
+- NONE
 
 CONSTANTS
 - NONE
@@ -26,14 +32,15 @@ TYPES
 - TwiMessageQueueType
 
 PUBLIC FUNCTIONS
-- bool TwiReadData(u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_)
-- u32 TwiWriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType Send_)
+- u32 TwiReadData(PeripheralType eTwi_, u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_)
+- u32 TwiWriteData(PeripheralType eTwi_, u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType Send_)
 
 PROTECTED FUNCTIONS
-- void SspInitialize(void)
-- void SspRunActiveState(void)
-- void SspManualMode(void)
-- void SSP0_IRQHandler(void)
+- void TwiInitialize(void)
+- void TwiRunActiveState(void)
+- void TwiManualMode(void)
+- void TWI0_IrqHandler(void)
+- void TWI1_IrqHandler(void)
 
 
 **********************************************************************************************************************/
@@ -58,17 +65,12 @@ extern volatile u32 G_u32ApplicationFlags;       /*!< @brief From main.c */
 Global variable definitions with scope limited to this local application.
 Variable names shall start with "TWI_<type>" and be declared as static.
 ***********************************************************************************************************************/
-static fnCode_type TWI_pfnStateMachine;           /*!< @brief The application state machine */
-
-static u32 TWI_u32Timer;                          /*!< @brief Timeout counter used across states */
 static u32 TWI_u32Flags;                          /*!< @brief Application flags */
 
 static TwiPeripheralType TWI_Peripheral0;         /*!< @brief TWI0 peripheral object */
+static TwiPeripheralType TWI_Peripheral1;         /*!< @brief TWI1 peripheral object */
 
-static TwiMessageQueueType TWI_asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE]; /*!< @brief Local circular buffer for TWI msgs */
-static TwiMessageQueueType* TWI_psMsgBufferNext;                        /*!< @brief Next position to place a message */
-static TwiMessageQueueType* TWI_psMsgBufferCurrent;                     /*!< @brief Current message that is being processed */
-static u8 TWI_u8MsgQueueCount;                                          /*!< @brief Counter to track the number of messages in the queue */
+static TwiPeripheralType* TWI_psCurrentTwi;       /*!< @brief Current TWI peripheral being processed by the task */
 
 
 /***********************************************************************************************************************
@@ -76,148 +78,172 @@ Function Definitions
 ***********************************************************************************************************************/
 
 /*--------------------------------------------------------------------------------------------------------------------*/
-/*! @publicsection */                                                                                            
+/*! @publicsection */
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 /*!--------------------------------------------------------------------------------------------------------------------
-@fn bool TwiReadData(u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_)
+@fn u32 TwiReadData(PeripheralType eTwi_, u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_)
 
-@brief Queues a TWI Read Message into TWI_asMessageBuffer
+@brief Queues a TWI Read Message into the selected bus's message buffer
 
-Read operations do not have an associated message in the Message task queue.
+Read operations do not have an associated message in the Message task queue,
+but a token is allocated so the read can be tracked with QueryMessageStatus().
+The status is SENDING while the read is in progress, COMPLETE once all bytes
+are in pu8RxBuffer_, FAILED if the slave NACKs or TIMEOUT if the read does
+not finish in U32_RX_TIMEOUT_MS.
 
 Requires:
 - Master mode
+- pu8RxBuffer_ must remain valid until the read is no longer WAITING or SENDING
 
+@param eTwi_ is the bus to use (TWI0 or TWI1)
 @param u8SlaveAddress_ holds the target's IC address
 @param pu8RxBuffer_ has the space to save the data
 @param u32Size_ is the number of bytes to receive
 
 Promises:
-- Queues a multi byte command into the command array
-- Returns TRUE if the queue was successful
+- Queues a multi byte command into the bus's command array
+- Returns the token assigned to the read; 0 is returned if the read cannot be queued
 
 */
-bool TwiReadData(u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_)
+u32 TwiReadData(PeripheralType eTwi_, u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_)
 {
-  if(TWI_u8MsgQueueCount == U8_TWI_MSG_BUFFER_SIZE)
+  u32 u32Token;
+  TwiPeripheralType* psTwi = TwiGetPeripheral(eTwi_);
+
+  if(psTwi == NULL)
   {
-    /* TWI Message Task Queue Full or the Tx transmit isn't complete */
-    return FALSE;
+    return 0;
+  }
+
+  if( (psTwi->u8MsgQueueCount == U8_TWI_MSG_BUFFER_SIZE) || (u32Size_ == 0) )
+  {
+    /* TWI Message Task Queue Full or nothing to read */
+    return 0;
   }
-  
-  /* Critical section: TWI buffer management must be done with interrutps off since 
+
+  /* Get a status token from the Message task so the client can track the read */
+  u32Token = AllocateMessageToken();
+
+  /* Critical section: TWI buffer management must be done with interrutps off since
   an ISR can also manage the buffer values and pointers */
   __disable_irq();
 
   /* Queue Relevant data for TWI register setup */
-  TWI_psMsgBufferNext->eDirection = TWI_READ;
-  TWI_psMsgBufferNext->u32Size = u32Size_;
-  TWI_psMsgBufferNext->u8Address = u8SlaveAddress_;
-  TWI_psMsgBufferNext->pu8RxBuffer = pu8RxBuffer_;
-  
-  /* Stop condition type and message token do not apply for Rx */
-  TWI_psMsgBufferNext->eStopType  = TWI_NA; 
-  TWI_psMsgBufferNext->u32MessageTaskToken = 0;
-      
+  psTwi->psMsgBufferNext->eDirection = TWI_READ;
+  psTwi->psMsgBufferNext->u32Size = u32Size_;
+  psTwi->psMsgBufferNext->u8Address = u8SlaveAddress_;
+  psTwi->psMsgBufferNext->pu8RxBuffer = pu8RxBuffer_;
+
+  /* Stop condition type does not apply for Rx */
+  psTwi->psMsgBufferNext->eStopType  = TWI_NA;
+  psTwi->psMsgBufferNext->u32MessageTaskToken = u32Token;
+
   /* Update array indexers and size */
-  TWI_u8MsgQueueCount++;
-  TWI_psMsgBufferNext++;
-  if( TWI_psMsgBufferNext == &TWI_asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE] )
+  psTwi->u8MsgQueueCount++;
+  psTwi->psMsgBufferNext++;
+  if( psTwi->psMsgBufferNext == &psTwi->asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE] )
   {
-    TWI_psMsgBufferNext = &TWI_asMessageBuffer[0];
+    psTwi->psMsgBufferNext = &psTwi->asMessageBuffer[0];
   }
-  
+
   /* Clear the new location to avoid confusion */
-  TWI_psMsgBufferNext->eDirection = TWI_EMPTY;
-  TWI_psMsgBufferNext->u32Size = 0;
-  TWI_psMsgBufferNext->u8Address = 0;
-  TWI_psMsgBufferNext->pu8RxBuffer = NULL;
-  TWI_psMsgBufferNext->eStopType = TWI_NA; 
-  TWI_psMsgBufferNext->u32MessageTaskToken = 0;
+  psTwi->psMsgBufferNext->eDirection = TWI_EMPTY;
+  psTwi->psMsgBufferNext->u32Size = 0;
+  psTwi->psMsgBufferNext->u8Address = 0;
+  psTwi->psMsgBufferNext->pu8RxBuffer = NULL;
+  psTwi->psMsgBufferNext->eStopType = TWI_NA;
+  psTwi->psMsgBufferNext->u32MessageTaskToken = 0;
 
   /* End of critical section */
   __enable_irq();
-    
+
   /* If the system is initializing, manually cycle the TWI task through one iteration to send the message */
   if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
   {
     TwiManualMode();
   }
 
-  return TRUE;
-  
+  return(u32Token);
+
 } /* end TwiReadData() */
 
 
 /*!--------------------------------------------------------------------------------------------------------------------
-@fn u32 TwiWriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eStop_)
+@fn u32 TwiWriteData(PeripheralType eTwi_, u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eStop_)
 
-@brief Queues a data array for transfer on the TWI0 peripheral.  
+@brief Queues a data array for transfer on the selected TWI peripheral.
 
 Requires:
-- if a transmission is in progress, the node in the buffer that is currently being sent will not 
+- if a transmission is in progress, the node in the buffer that is currently being sent will not
   be destroyed during this function.
 
+@param eTwi_ is the bus to use (TWI0 or TWI1)
 @param u8SlaveAddress_ holds the target's IC address
 @param u32Size_ is the number of bytes to send
 @param pu8Data_ points to the start of the data
 @param eStop_ is the type of operation
 
 Promises:
-- adds the data message at TWI_Peripheral0.pTransmitBuffer buffer that will be sent by the TWI application
+- adds the data message at the bus's pTransmitBuffer buffer that will be sent by the TWI application
   when it is available.
 - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
   G_u32MessagingFlags can be checked for the reason
 
 */
-u32 TwiWriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eStop_)
+u32 TwiWriteData(PeripheralType eTwi_, u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eStop_)
 {
   u32 u32Token;
-    
-  if(TWI_u8MsgQueueCount == U8_TWI_MSG_BUFFER_SIZE)
+  TwiPeripheralType* psTwi = TwiGetPeripheral(eTwi_);
+
+  if(psTwi == NULL)
+  {
+    return 0;
+  }
+
+  if(psTwi->u8MsgQueueCount == U8_TWI_MSG_BUFFER_SIZE)
   {
     /* TWI Message Task Queue Full or the Tx transmit isn't complete */
     return 0;
   }
 
   /* Queue Message in message system */
-  u32Token = QueueMessage(&TWI_Peripheral0.pTransmitBuffer, u32Size_, pu8Data_);
+  u32Token = QueueMessage(&psTwi->pTransmitBuffer, u32Size_, pu8Data_);
   if(u32Token == 0)
   {
     /* TWI Message Task Queue Full or the Tx transmit isn't complete */
     return 0;
   }
 
-  /* Critical section: TWI buffer management must be done with interrutps off since 
+  /* Critical section: TWI buffer management must be done with interrutps off since
   an ISR can also manage the buffer values and pointers */
   __disable_irq();
 
   /* Queue Relevant data for TWI register setup */
-  TWI_psMsgBufferNext->u32MessageTaskToken = u32Token;
-  TWI_psMsgBufferNext->eDirection = TWI_WRITE;
-  TWI_psMsgBufferNext->u32Size    = u32Size_;
-  TWI_psMsgBufferNext->u8Address  = u8SlaveAddress_;
-  TWI_psMsgBufferNext->eStopType  = eStop_; 
-  
+  psTwi->psMsgBufferNext->u32MessageTaskToken = u32Token;
+  psTwi->psMsgBufferNext->eDirection = TWI_WRITE;
+  psTwi->psMsgBufferNext->u32Size    = u32Size_;
+  psTwi->psMsgBufferNext->u8Address  = u8SlaveAddress_;
+  psTwi->psMsgBufferNext->eStopType  = eStop_;
+
   /* Not used by Transmit */
-  TWI_psMsgBufferNext->pu8RxBuffer = NULL;
-  
+  psTwi->psMsgBufferNext->pu8RxBuffer = NULL;
+
   /* Update array pointers and size */
-  TWI_u8MsgQueueCount++;
-  TWI_psMsgBufferNext++;
-  if( TWI_psMsgBufferNext == &TWI_asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE] )
+  psTwi->u8MsgQueueCount++;
+  psTwi->psMsgBufferNext++;
+  if( psTwi->psMsgBufferNext == &psTwi->asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE] )
   {
-    TWI_psMsgBufferNext = &TWI_asMessageBuffer[0];
+    psTwi->psMsgBufferNext = &psTwi->asMessageBuffer[0];
   }
 
   /* Clear the new location to avoid confusion */
-  TWI_psMsgBufferNext->eDirection  = TWI_EMPTY;
-  TWI_psMsgBufferNext->u32Size     = 0;
-  TWI_psMsgBufferNext->u8Address   = 0;
-  TWI_psMsgBufferNext->pu8RxBuffer = NULL;
-  TWI_psMsgBufferNext->eStopType   = TWI_NA; 
-  TWI_psMsgBufferNext->u32MessageTaskToken = 0;
+  psTwi->psMsgBufferNext->eDirection  = TWI_EMPTY;
+  psTwi->psMsgBufferNext->u32Size     = 0;
+  psTwi->psMsgBufferNext->u8Address   = 0;
+  psTwi->psMsgBufferNext->pu8RxBuffer = NULL;
+  psTwi->psMsgBufferNext->eStopType   = TWI_NA;
+  psTwi->psMsgBufferNext->u32MessageTaskToken = 0;
 
   /* End of critical section */
   __enable_irq();
@@ -229,95 +255,92 @@ u32 TwiWriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eSt
   }
 
   return(u32Token);
-  
+
 } /* end TwiWriteData() */
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
-/*! @protectedsection */                                                                                            
+/*! @protectedsection */
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 /*!--------------------------------------------------------------------------------------------------------------------
 @fn void TwiInitialize(void)
 
-@brief Initializes the TWI application and its variables. 
+@brief Initializes the TWI application and its variables.
 
 Requires:
-- NONE 
+- NONE
 
 Promises:
-- TWI peripheral objects are ready 
-- TWI application set to Idle
+- TWI0 and TWI1 peripheral objects are ready with empty message buffers
+- Both bus state machines set to Idle
 
 */
 void TwiInitialize(void)
 {
-  /* Enable the peripheral */
-  AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_TWI0);
-  
-  /* Init flags, pointers and globals */
+  /* Enable the peripherals */
+  AT91C_BASE_PMC->PMC_PCER |= ( (1 << AT91C_ID_TWI0) | (1 << AT91C_ID_TWI1) );
+
+  /* Init flags */
   TWI_u32Flags = 0;
-  TWI_psMsgBufferNext = TWI_asMessageBuffer;
-  TWI_psMsgBufferCurrent = TWI_asMessageBuffer;
-  TWI_u8MsgQueueCount = 0;
-  
-  /* Clear the local message buffer */
-  for(u8 i = 0; i < U8_TWI_MSG_BUFFER_SIZE; i++)
-  {
-    TWI_asMessageBuffer[i].eDirection = TWI_EMPTY;
-    TWI_asMessageBuffer[i].eStopType = TWI_NA;
-    TWI_asMessageBuffer[i].pu8RxBuffer = NULL ;
-    TWI_asMessageBuffer[i].u32MessageTaskToken = 0;
-    TWI_asMessageBuffer[i].u32Size = 0;
-    TWI_asMessageBuffer[i].u8Address = 0;
-  }
-   
+
   /* Initialize the TWI peripheral structures */
-  TWI_Peripheral0.pBaseAddress    = AT91C_BASE_TWI0;
-  TWI_Peripheral0.pTransmitBuffer = NULL;
-  TWI_Peripheral0.u32PrivateFlags = 0;
+  TWI_Peripheral0.pBaseAddress   = AT91C_BASE_TWI0;
+  TWI_Peripheral0.u8PeripheralId = AT91C_ID_TWI0;
+  TwiInitializePeripheral(&TWI_Peripheral0);
 
-  /* Software reset of peripheral */
-  TWI_Peripheral0.pBaseAddress->TWI_CR = AT91C_TWI_SWRST;
-  TWI_u32Timer = G_u32SystemTime1ms;
-  while( !IsTimeUp(&TWI_u32Timer, 1) );
-  
-  /* Configure Peripheral for Master mode */
+  TWI_Peripheral1.pBaseAddress   = AT91C_BASE_TWI1;
+  TWI_Peripheral1.u8PeripheralId = AT91C_ID_TWI1;
+  TwiInitializePeripheral(&TWI_Peripheral1);
+
+  /* Configure Peripherals for Master mode */
   TWI_Peripheral0.pBaseAddress->TWI_CWGR = TWI0_CWGR_INIT;
   TWI_Peripheral0.pBaseAddress->TWI_CR   = TWI0_CR_INIT;
   TWI_Peripheral0.pBaseAddress->TWI_MMR  = TWI0_MMR_INIT;
   TWI_Peripheral0.pBaseAddress->TWI_IER  = TWI0_IER_INIT;
   TWI_Peripheral0.pBaseAddress->TWI_IDR  = ~TWI0_IER_INIT;
-  
+
+  TWI_Peripheral1.pBaseAddress->TWI_CWGR = TWI1_CWGR_INIT;
+  TWI_Peripheral1.pBaseAddress->TWI_CR   = TWI1_CR_INIT;
+  TWI_Peripheral1.pBaseAddress->TWI_MMR  = TWI1_MMR_INIT;
+  TWI_Peripheral1.pBaseAddress->TWI_IER  = TWI1_IER_INIT;
+  TWI_Peripheral1.pBaseAddress->TWI_IDR  = ~TWI1_IER_INIT;
+
   /* Enable TWI interrupts */
   NVIC_ClearPendingIRQ( (IRQn_Type)AT91C_ID_TWI0 );
   NVIC_EnableIRQ( (IRQn_Type)AT91C_ID_TWI0 );
+  NVIC_ClearPendingIRQ( (IRQn_Type)AT91C_ID_TWI1 );
+  NVIC_EnableIRQ( (IRQn_Type)AT91C_ID_TWI1 );
+
+  TWI_psCurrentTwi = &TWI_Peripheral0;
+  DebugPrintf("TWI Peripherals Ready\n\r");
 
-  /* Set application pointer */
-  TWI_pfnStateMachine = TwiSM_Idle;
-  DebugPrintf("TWI Peripheral Ready\n\r");
-  
 } /* end TwiInitialize() */
 
 
 /*!----------------------------------------------------------------------------------------------------------------------
 @fn void TwiRunActiveState(void)
 
-@brief Selects and runs one iteration of the current state in the state machine.
+@brief Selects and runs one iteration of the current state in each bus's state machine.
 
 All state machines have a TOTAL of 1ms to execute, so on average n state machines
 may take 1ms / n to execute.
 
 Requires:
-- State machine function pointer points at current state
+- Each peripheral's state machine function pointer points at its current state
 
 Promises:
-- Calls the function to pointed by the state machine function pointer
+- Calls the function pointed to by each bus's state machine function pointer with
+  TWI_psCurrentTwi set to that bus
 
 */
 void TwiRunActiveState(void)
 {
-  TWI_pfnStateMachine();
+  TWI_psCurrentTwi = &TWI_Peripheral0;
+  TWI_Peripheral0.pfnStateMachine();
+
+  TWI_psCurrentTwi = &TWI_Peripheral1;
+  TWI_Peripheral1.pfnStateMachine();
 
 } /* end TwiRunActiveState */
 
@@ -325,7 +348,7 @@ void TwiRunActiveState(void)
 /*!----------------------------------------------------------------------------------------------------------------------
 @fn void TwiManualMode(void)
 
-@brief Runs a transmit cycle of the TWI application to clock a message.  
+@brief Runs a transmit cycle of the TWI application to clock a message.
 This function is used only during initialization.
 
 Requires:
@@ -333,27 +356,27 @@ Requires:
 - TWI application has been initialized.
 
 Promises:
-- All pending messages sent
-- TWI_u8MsgQueueCount = 0
-    
+- All pending messages on both buses sent
+- u8MsgQueueCount = 0 for both buses
+
 */
 void TwiManualMode(void)
 {
   u32 u32Timer;
-  
+
   TWI_u32Flags |=_TWI_INIT_MODE;
-  
+
   while(TWI_u32Flags &_TWI_INIT_MODE)
   {
     WATCHDOG_BONE();
-    TWI_pfnStateMachine();
+    TwiRunActiveState();
     MessagingRunActiveState();
     DebugRunActiveState();
-    
+
     u32Timer = G_u32SystemTime1ms;
     while( !IsTimeUp(&u32Timer, 1) );
   }
-      
+
 } /* end TwiManualMode() */
 
 
@@ -366,71 +389,194 @@ Requires:
 - NONE
 
 Promises:
-- NACK: flags error, disables ENDTX and sets Error state
+- TwiGenericHandler() runs for TWI_Peripheral0
+
+*/
+void TWI0_IrqHandler(void)
+{
+  ISR_PROFILE_ENTER();
+
+  TwiGenericHandler(&TWI_Peripheral0);
+
+  ISR_PROFILE_EXIT();
+} /* end TWI0_IrqHandler() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn ISR void TWI1_IrqHandler(void)
+
+@brief Handles the TWI1 Peripheral interrupts
+
+Requires:
+- NONE
+
+Promises:
+- TwiGenericHandler() runs for TWI_Peripheral1
+
+*/
+void TWI1_IrqHandler(void)
+{
+  ISR_PROFILE_ENTER();
+
+  TwiGenericHandler(&TWI_Peripheral1);
+
+  ISR_PROFILE_EXIT();
+} /* end TWI1_IrqHandler() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------*/
+/*! @privatesection */
+/*----------------------------------------------------------------------------------------------------------------------*/
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static TwiPeripheralType* TwiGetPeripheral(PeripheralType eTwi_)
+
+@brief Looks up the peripheral object for a bus.
+
+Requires:
+@param eTwi_ is the bus of interest
+
+Promises:
+- Returns a pointer to the TWI peripheral object or NULL if eTwi_ is not a TWI bus
+
+*/
+static TwiPeripheralType* TwiGetPeripheral(PeripheralType eTwi_)
+{
+  switch(eTwi_)
+  {
+    case TWI0:
+      return(&TWI_Peripheral0);
+
+    case TWI1:
+      return(&TWI_Peripheral1);
+
+    default:
+      return(NULL);
+  }
+
+} /* end TwiGetPeripheral() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void TwiInitializePeripheral(TwiPeripheralType* psTwi_)
+
+@brief Clears a bus's message buffer and resets the peripheral.
+
+Requires:
+- The peripheral clock is enabled
+- psTwi_->pBaseAddress is set
+
+@param psTwi_ is the bus to initialize
+
+Promises:
+- The message buffer is empty and the bus state machine is Idle
+- The peripheral has been reset and is ready for configuration
+
+*/
+static void TwiInitializePeripheral(TwiPeripheralType* psTwi_)
+{
+  /* Init flags, pointers and counters */
+  psTwi_->pTransmitBuffer    = NULL;
+  psTwi_->u32PrivateFlags    = 0;
+  psTwi_->psMsgBufferNext    = psTwi_->asMessageBuffer;
+  psTwi_->psMsgBufferCurrent = psTwi_->asMessageBuffer;
+  psTwi_->u8MsgQueueCount    = 0;
+
+  /* Clear the local message buffer */
+  for(u8 i = 0; i < U8_TWI_MSG_BUFFER_SIZE; i++)
+  {
+    psTwi_->asMessageBuffer[i].eDirection = TWI_EMPTY;
+    psTwi_->asMessageBuffer[i].eStopType = TWI_NA;
+    psTwi_->asMessageBuffer[i].pu8RxBuffer = NULL ;
+    psTwi_->asMessageBuffer[i].u32MessageTaskToken = 0;
+    psTwi_->asMessageBuffer[i].u32Size = 0;
+    psTwi_->asMessageBuffer[i].u8Address = 0;
+  }
+
+  /* Software reset of peripheral */
+  psTwi_->pBaseAddress->TWI_CR = AT91C_TWI_SWRST;
+  psTwi_->u32Timer = G_u32SystemTime1ms;
+  while( !IsTimeUp(&psTwi_->u32Timer, 1) );
+
+  psTwi_->pfnStateMachine = TwiSM_Idle;
+
+} /* end TwiInitializePeripheral() */
+
+
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn static void TwiGenericHandler(TwiPeripheralType* psTwi_)
+
+@brief Common interrupt handling for both TWI peripherals.
+
+The peripheral is passed in rather than held in a shared pointer because the
+two TWI interrupts run at different priorities and can nest.
+
+Requires:
+@param psTwi_ is the bus that raised the interrupt
+
+Promises:
+- NACK: flags error, disables ENDTX / ENDRX and sets Error state
 - ENDTX: disables interrupt & PDC, writes STOP (if applicable), and clears _TWI_TRANSMITTING
 - ENDRX: disables interrupt & PDC and writes STOP
 
 */
-void TWI0_IrqHandler(void)
+static void TwiGenericHandler(TwiPeripheralType* psTwi_)
 {
   u32 u32InterruptStatus;
-  
+
   /* Grab active interrupts and compare with status */
-  u32InterruptStatus = AT91C_BASE_TWI0->TWI_IMR;
-  u32InterruptStatus &= AT91C_BASE_TWI0->TWI_SR;
-  
+  u32InterruptStatus = psTwi_->pBaseAddress->TWI_IMR;
+  u32InterruptStatus &= psTwi_->pBaseAddress->TWI_SR;
+
   /*** NACK Received (Master only) ***/
   if(u32InterruptStatus & AT91C_TWI_NACK_MASTER )
   {
     /* Error has occurred, abort the message */
-    TWI_u32Flags |= _TWI_ERROR_NACK;
-    TWI_Peripheral0.pBaseAddress->TWI_IDR = AT91C_TWI_ENDTX;
-    TWI_Peripheral0.pBaseAddress->TWI_PTCR = AT91C_PDC_TXTDIS;
-    TWI_pfnStateMachine = TwiSM_Error;
+    psTwi_->u32PrivateFlags |= _TWI_ERROR_NACK;
+    psTwi_->pBaseAddress->TWI_IDR = (AT91C_TWI_ENDTX | AT91C_TWI_ENDRX);
+    psTwi_->pBaseAddress->TWI_PTCR = (AT91C_PDC_TXTDIS | AT91C_PDC_RXTDIS);
+    psTwi_->pfnStateMachine = TwiSM_Error;
   }
 
   /*** ENDTX (transmit has finished) ***/
   if(u32InterruptStatus & AT91C_TWI_ENDTX )
   {
     /* Disable interrupt and PDC transfer */
-    TWI_Peripheral0.pBaseAddress->TWI_IDR = AT91C_TWI_ENDTX;
-    TWI_Peripheral0.pBaseAddress->TWI_PTCR = AT91C_PDC_TXTDIS;
+    psTwi_->pBaseAddress->TWI_IDR = AT91C_TWI_ENDTX;
+    psTwi_->pBaseAddress->TWI_PTCR = AT91C_PDC_TXTDIS;
 
     /* Set stop condition if multi-byte transfer */
-    if( (TWI_Peripheral0.pTransmitBuffer->u32Size != 1) &&
-        (TWI_psMsgBufferCurrent->eStopType == TWI_STOP) )
+    if( (psTwi_->pTransmitBuffer->u32Size != 1) &&
+        (psTwi_->psMsgBufferCurrent->eStopType == TWI_STOP) )
     {
-      TWI_Peripheral0.pBaseAddress->TWI_CR = AT91C_TWI_STOP;
+      psTwi_->pBaseAddress->TWI_CR = AT91C_TWI_STOP;
     }
-    
-    TWI_Peripheral0.u32PrivateFlags &= ~_TWI_TRANSMITTING;
+
+    psTwi_->u32PrivateFlags &= ~_TWI_TRANSMITTING;
 
   } /* end ENDTX handler */
-  
-  
+
+
   /*** ENDRX (receive has finished ALL BUT ONE bytes) ***/
   if(u32InterruptStatus & AT91C_TWI_ENDRX )
   {
     /* Disable interrupt and PDC transfer */
-    TWI_Peripheral0.pBaseAddress->TWI_IDR = AT91C_TWI_ENDRX;
-    TWI_Peripheral0.pBaseAddress->TWI_PTCR = AT91C_PDC_RXTDIS;
+    psTwi_->pBaseAddress->TWI_IDR = AT91C_TWI_ENDRX;
+    psTwi_->pBaseAddress->TWI_PTCR = AT91C_PDC_RXTDIS;
 
     /* Set stop condition and change states */
-    TWI_Peripheral0.pBaseAddress->TWI_CR = AT91C_TWI_STOP;
-    TWI_pfnStateMachine = TwiSM_ReceiveLastByte;
+    psTwi_->pBaseAddress->TWI_CR = AT91C_TWI_STOP;
+    psTwi_->pfnStateMachine = TwiSM_ReceiveLastByte;
 
   } /* end ENDRX handler */
-  
-} /* end TWI0_IrqHandler() */
 
-
-/*----------------------------------------------------------------------------------------------------------------------*/
-/*! @privatesection */                                                                                            
-/*----------------------------------------------------------------------------------------------------------------------*/
+} /* end TwiGenericHandler() */
 
 
 /***********************************************************************************************************************
 State Machine Function Definitions
+
+All states operate on TWI_psCurrentTwi which TwiRunActiveState() points at the bus being serviced.
 ***********************************************************************************************************************/
 
 /*!-------------------------------------------------------------------------------------------------------------------
@@ -440,86 +586,90 @@ State Machine Function Definitions
 static void TwiSM_Idle(void)
 {
   u32 u32Byte;
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+  TwiMessageQueueType* psMsg = psTwi->psMsgBufferCurrent;
 
   /* Do nothing unless new Tx or Rx messages have been queued */
-  if(TWI_u8MsgQueueCount != 0)
+  if(psTwi->u8MsgQueueCount != 0)
   {
-    if(TWI_psMsgBufferCurrent->eDirection == TWI_WRITE)
+    if(psMsg->eDirection == TWI_WRITE)
     {
       /* Check that the local buffer Message token matches the message queued
       and the transmit buffer */
-      if(TWI_psMsgBufferCurrent->u32MessageTaskToken != TWI_Peripheral0.pTransmitBuffer->u32Token)
+      if(psMsg->u32MessageTaskToken != psTwi->pTransmitBuffer->u32Token)
       {
         DebugPrintf("TWI transmit message out of sync!\n\r");
-        TWI_Peripheral0.u32PrivateFlags |= _TWI_ERROR_TX_MSG_SYNC;
+        psTwi->u32PrivateFlags |= _TWI_ERROR_TX_MSG_SYNC;
       }
       else
       {
         /* Update the message's status */
-        UpdateMessageStatus(TWI_Peripheral0.pTransmitBuffer->u32Token, SENDING);
+        UpdateMessageStatus(psTwi->pTransmitBuffer->u32Token, SENDING);
 
-        /* Set up to transmit the message */
-        TWI_Peripheral0.u32PrivateFlags |= (_TWI_TRANSMITTING | _TWI_TRANS_NOT_COMP);
-        u32Byte = (TWI_psMsgBufferCurrent->u8Address) << TWI_MMR_ADDRESS_SHIFT;
-        TWI_Peripheral0.pBaseAddress->TWI_MMR |= u32Byte; 
+        /* Set up to transmit the message: the address and MREAD bits of MMR are replaced so a previous 
+        address or direction cannot linger (the other MMR bits keep their setup) */
+        psTwi->u32PrivateFlags |= (_TWI_TRANSMITTING | _TWI_TRANS_NOT_COMP);
+        u32Byte = (psMsg->u8Address) << TWI_MMR_ADDRESS_SHIFT;
+        psTwi->pBaseAddress->TWI_MMR = (psTwi->pBaseAddress->TWI_MMR & ~(AT91C_TWI_MREAD | AT91C_TWI_DADR)) | u32Byte;
 
         /* Setup PDC and interrupts */
-        TWI_Peripheral0.pBaseAddress->TWI_TPR = (u32)TWI_Peripheral0.pTransmitBuffer->pu8Message; 
-        TWI_Peripheral0.pBaseAddress->TWI_TCR = TWI_Peripheral0.pTransmitBuffer->u32Size;
+        psTwi->pBaseAddress->TWI_TPR = (u32)psTwi->pTransmitBuffer->pu8Message;
+        psTwi->pBaseAddress->TWI_TCR = psTwi->pTransmitBuffer->u32Size;
 
         /* Enable Tx interrupt and the transmitter (triggers THR load) */
-        TWI_Peripheral0.pBaseAddress->TWI_IER = AT91C_TWI_ENDTX;
-        TWI_Peripheral0.pBaseAddress->TWI_PTCR = AT91C_PDC_TXTEN;
-             
+        psTwi->pBaseAddress->TWI_IER = AT91C_TWI_ENDTX;
+        psTwi->pBaseAddress->TWI_PTCR = AT91C_PDC_TXTEN;
+
         /* Single byte transfers need STOP immediately (if applicable) */
-        if(TWI_Peripheral0.pTransmitBuffer->u32Size == 1)
+        if(psTwi->pTransmitBuffer->u32Size == 1)
         {
           /* Set up the stop condition immediately if applicable */
-          if(TWI_psMsgBufferCurrent->eStopType == TWI_STOP)
+          if(psMsg->eStopType == TWI_STOP)
           {
-            TWI_Peripheral0.pBaseAddress->TWI_CR = AT91C_TWI_STOP;
+            psTwi->pBaseAddress->TWI_CR = AT91C_TWI_STOP;
           }
         }
 
-        TWI_pfnStateMachine = TwiSM_Transmit;
+        psTwi->pfnStateMachine = TwiSM_Transmit;
 
       } /* end WRITE setup */
     } /* end TWI_WRITE */
-    
-    else if(TWI_psMsgBufferCurrent->eDirection == TWI_READ)
+
+    else if(psMsg->eDirection == TWI_READ)
     {
       /* Set up for READ transaction */
-      u32Byte = AT91C_TWI_MREAD | (TWI_psMsgBufferCurrent->u8Address << TWI_MMR_ADDRESS_SHIFT);
-      TWI_Peripheral0.pBaseAddress->TWI_MMR |= u32Byte; 
-      TWI_Peripheral0.u32PrivateFlags |= _TWI_RECEIVING;
+      UpdateMessageStatus(psMsg->u32MessageTaskToken, SENDING);
+      u32Byte = AT91C_TWI_MREAD | (psMsg->u8Address << TWI_MMR_ADDRESS_SHIFT);
+      psTwi->pBaseAddress->TWI_MMR = (psTwi->pBaseAddress->TWI_MMR & ~(AT91C_TWI_MREAD | AT91C_TWI_DADR)) | u32Byte;
+      psTwi->u32PrivateFlags |= _TWI_RECEIVING;
+      psTwi->u32Timer = G_u32SystemTime1ms;
 
       /* Set up to receive the message based on number of bytes */
-      if(TWI_psMsgBufferCurrent->u32Size == 1)
+      if(psMsg->u32Size == 1)
       {
         /* Single byte direct receive (no PDC required) */
-        TWI_Peripheral0.pBaseAddress->TWI_CR = (AT91C_TWI_START | AT91C_TWI_STOP);
-        TWI_pfnStateMachine = TwiSM_ReceiveLastByte;
+        psTwi->pBaseAddress->TWI_CR = (AT91C_TWI_START | AT91C_TWI_STOP);
+        psTwi->pfnStateMachine = TwiSM_ReceiveLastByte;
       }
       else
       {
         /* Multi-byte PDC-based receive */
-        TWI_Peripheral0.pBaseAddress->TWI_RPR = (u32)TWI_psMsgBufferCurrent->pu8RxBuffer;
-        TWI_Peripheral0.pBaseAddress->TWI_RCR = TWI_psMsgBufferCurrent->u32Size - 1;
-        TWI_Peripheral0.pBaseAddress->TWI_IER = AT91C_TWI_ENDRX;
-        TWI_Peripheral0.pBaseAddress->TWI_PTCR = AT91C_PDC_RXTEN;
+        psTwi->pBaseAddress->TWI_RPR = (u32)psMsg->pu8RxBuffer;
+        psTwi->pBaseAddress->TWI_RCR = psMsg->u32Size - 1;
+        psTwi->pBaseAddress->TWI_IER = AT91C_TWI_ENDRX;
+        psTwi->pBaseAddress->TWI_PTCR = AT91C_PDC_RXTEN;
 
         /* Trigger the peripheral to start */
-        TWI_Peripheral0.pBaseAddress->TWI_CR = AT91C_TWI_START;
+        psTwi->pBaseAddress->TWI_CR = AT91C_TWI_START;
 
         /* Proceed to receiving state*/
-        TWI_u32Timer = G_u32SystemTime1ms;
-        TWI_pfnStateMachine = TwiSM_PdcReceive;
+        psTwi->pfnStateMachine = TwiSM_PdcReceive;
       }
-    } /* end TWI_READ */ 
-  } /* if(TWI_u8MsgQueueCount != 0) */  
-  
+    } /* end TWI_READ */
+  } /* if(psTwi->u8MsgQueueCount != 0) */
+
 } /* end TwiSM_Idle() */
-     
+
 
 /*!-------------------------------------------------------------------------------------------------------------------
 @fn static void TwiSM_Transmit(void)
@@ -527,28 +677,29 @@ static void TwiSM_Idle(void)
 */
 static void TwiSM_Transmit(void)
 {
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+
   /* Watch _TWI_TRANSMITTING to indicate transmit is complete */
-  if( !(TWI_Peripheral0.u32PrivateFlags & _TWI_TRANSMITTING) )
+  if( !(psTwi->u32PrivateFlags & _TWI_TRANSMITTING) )
   {
     /*  Clean up the Message task message */
-    UpdateMessageStatus(TWI_Peripheral0.pTransmitBuffer->u32Token, COMPLETE);
-    DeQueueMessage(&TWI_Peripheral0.pTransmitBuffer);
+    UpdateMessageStatus(psTwi->pTransmitBuffer->u32Token, COMPLETE);
+    DeQueueMessage(&psTwi->pTransmitBuffer);
 
-    
     /* Advance states depending on whether TXCOMP is expected */
-    if(TWI_psMsgBufferCurrent->eStopType == TWI_STOP)
+    if(psTwi->psMsgBufferCurrent->eStopType == TWI_STOP)
     {
       /* If a STOP condition is requested, need to wait for TXCOMP */
-      TWI_pfnStateMachine = TwiSM_TxWaitComplete;
+      psTwi->pfnStateMachine = TwiSM_TxWaitComplete;
     }
     else
     {
       /* Otherwise leave the bus active */
-      TWI_u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
-      TWI_pfnStateMachine = TwiSM_NextTransferDelay;
+      psTwi->u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
+      psTwi->pfnStateMachine = TwiSM_NextTransferDelay;
     }
   }
-    
+
 } /* end TwiSM_Transmit() */
 
 
@@ -558,16 +709,18 @@ static void TwiSM_Transmit(void)
 has been placed on the bus). Some Master transmit states will bypass this. */
 static void TwiSM_TxWaitComplete(void)
 {
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+
   /* Wait for TX to complete */
-  if(TWI_Peripheral0.pBaseAddress->TWI_SR & AT91C_TWI_TXCOMP_MASTER)
+  if(psTwi->pBaseAddress->TWI_SR & AT91C_TWI_TXCOMP_MASTER)
   {
     /* Clear flags and advance states */
-    TWI_Peripheral0.u32PrivateFlags &= ~_TWI_TRANS_NOT_COMP;
-    
-    TWI_u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
-    TWI_pfnStateMachine = TwiSM_NextTransferDelay;
+    psTwi->u32PrivateFlags &= ~_TWI_TRANS_NOT_COMP;
+
+    psTwi->u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
+    psTwi->pfnStateMachine = TwiSM_NextTransferDelay;
   }
-    
+
 } /* end TwiSM_TxWaitComplete() */
 
 
@@ -578,12 +731,14 @@ The ENDRX ISR is responsible for changing states to exit here.
 */
 static void TwiSM_PdcReceive(void)
 {
-  if( IsTimeUp(&TWI_u32Timer, U32_RX_TIMEOUT_MS) )
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+
+  if( IsTimeUp(&psTwi->u32Timer, U32_RX_TIMEOUT_MS) )
   {
-    TWI_u32Flags |= _TWI_ERROR_RX_TIMEOUT;
-    TWI_pfnStateMachine = TwiSM_Error;
+    psTwi->u32PrivateFlags |= _TWI_ERROR_RX_TIMEOUT;
+    psTwi->pfnStateMachine = TwiSM_Error;
   }
-     
+
 } /* end TwiSM_PdcReceive() */
 
 
@@ -593,14 +748,23 @@ static void TwiSM_PdcReceive(void)
 */
 static void TwiSM_ReceiveLastByte(void)
 {
-  if( TWI_Peripheral0.pBaseAddress->TWI_SR & AT91C_TWI_RXRDY )
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+  TwiMessageQueueType* psMsg = psTwi->psMsgBufferCurrent;
+
+  if( psTwi->pBaseAddress->TWI_SR & AT91C_TWI_RXRDY )
   {
     /* Read the final byte */
-    *(TWI_psMsgBufferCurrent->pu8RxBuffer + TWI_psMsgBufferCurrent->u32Size - 1) =  TWI_Peripheral0.pBaseAddress->TWI_RHR;
-    
-    TWI_pfnStateMachine = TwiSM_ReceiveComplete;
+    *(psMsg->pu8RxBuffer + psMsg->u32Size - 1) = psTwi->pBaseAddress->TWI_RHR;
+
+    psTwi->pfnStateMachine = TwiSM_ReceiveComplete;
+  }
+  /* The timer started when the read was set up in Idle */
+  else if( IsTimeUp(&psTwi->u32Timer, U32_RX_TIMEOUT_MS) )
+  {
+    psTwi->u32PrivateFlags |= _TWI_ERROR_RX_TIMEOUT;
+    psTwi->pfnStateMachine = TwiSM_Error;
   }
-  
+
 } /* end TwiSM_ReceiveLastByte() */
 
 
@@ -610,77 +774,102 @@ static void TwiSM_ReceiveLastByte(void)
 */
 static void TwiSM_ReceiveComplete(void)
 {
-  if(TWI_Peripheral0.pBaseAddress->TWI_SR & AT91C_TWI_TXCOMP_MASTER)
-  {   
-    /* Clear RX flag and advance states */
-    TWI_Peripheral0.u32PrivateFlags &= ~_TWI_RECEIVING;
-    
-    TWI_u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
-    TWI_pfnStateMachine = TwiSM_NextTransferDelay;
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+
+  if(psTwi->pBaseAddress->TWI_SR & AT91C_TWI_TXCOMP_MASTER)
+  {
+    /* The client's buffer is now valid: clear RX flag and advance states */
+    UpdateMessageStatus(psTwi->psMsgBufferCurrent->u32MessageTaskToken, COMPLETE);
+    psTwi->u32PrivateFlags &= ~_TWI_RECEIVING;
+
+    psTwi->u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
+    psTwi->pfnStateMachine = TwiSM_NextTransferDelay;
   }
-     
+
 } /* end TwiSM_ReceiveComplete() */
 
 
 /*!-------------------------------------------------------------------------------------------------------------------
 @fn static void TwiSM_NextTransferDelay(void)
-@brief Provide a delay before next transfer starts then do final clean-up before Idle. 
+@brief Provide a delay before next transfer starts then do final clean-up before Idle.
 */
-static void TwiSM_NextTransferDelay(void)          
+static void TwiSM_NextTransferDelay(void)
 {
-  TWI_u32Timer--;
-  
-  if(TWI_u32Timer == 0)
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+
+  psTwi->u32Timer--;
+
+  if(psTwi->u32Timer == 0)
   {
     /* Clean up the local message queue (interrupts off, so not critical) */
-    TWI_u8MsgQueueCount--;
-    TWI_psMsgBufferCurrent++;
-    if(TWI_psMsgBufferCurrent == &TWI_asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE])
+    psTwi->u8MsgQueueCount--;
+    psTwi->psMsgBufferCurrent++;
+    if(psTwi->psMsgBufferCurrent == &psTwi->asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE])
     {
-      TWI_psMsgBufferCurrent = &TWI_asMessageBuffer[0];
+      psTwi->psMsgBufferCurrent = &psTwi->asMessageBuffer[0];
     }
 
-    /* Make sure _TWI_INIT_MODE flag is clear if no more messages in case this was a manual cycle */
-    if(TWI_u8MsgQueueCount == 0)
+    /* Make sure _TWI_INIT_MODE flag is clear if no more messages on either bus in case this was a manual cycle */
+    if( (TWI_Peripheral0.u8MsgQueueCount == 0) && (TWI_Peripheral1.u8MsgQueueCount == 0) )
     {
       TWI_u32Flags &= ~_TWI_INIT_MODE;
     }
 
-    TWI_pfnStateMachine = TwiSM_Idle;
+    psTwi->pfnStateMachine = TwiSM_Idle;
   }
-  
+
 } /* TwiSM_NextTransferDelay */
 
 
 /*!-------------------------------------------------------------------------------------------------------------------
 @fn static void TwiSM_Error(void)
-@brief Handle an error 
+@brief Handle an error on the current transfer.
+
+The error is reported against the token of the transfer that caused it
+so the client that queued it can see the failure.
 */
-static void TwiSM_Error(void)          
+static void TwiSM_Error(void)
 {
-  /* NACK recieved (write only) */
-  if(TWI_u32Flags & _TWI_ERROR_NACK)
+  TwiPeripheralType* psTwi = TWI_psCurrentTwi;
+  TwiMessageQueueType* psMsg = psTwi->psMsgBufferCurrent;
+
+  /* NACK recieved */
+  if(psTwi->u32PrivateFlags & _TWI_ERROR_NACK)
   {
     /* Announce the error and clear flag */
-    TWI_u32Flags &= ~_TWI_ERROR_NACK;
-    DebugPrintNumber(TWI_Peripheral0.pTransmitBuffer->u32Token);
+    psTwi->u32PrivateFlags &= ~_TWI_ERROR_NACK;
+    DebugPrintNumber(psMsg->u32MessageTaskToken);
     DebugPrintf(" TWI NACK. Message deleted.\n\r");
-    
-    /* Clear flags and clean up the Message task message */
-    UpdateMessageStatus(TWI_Peripheral0.pTransmitBuffer->u32Token, FAILED);
-    DeQueueMessage(&TWI_Peripheral0.pTransmitBuffer);
-    TWI_Peripheral0.u32PrivateFlags &= ~(_TWI_TRANSMITTING | _TWI_TRANS_NOT_COMP);
+    UpdateMessageStatus(psMsg->u32MessageTaskToken, FAILED);
+
+    if(psMsg->eDirection == TWI_WRITE)
+    {
+      /* Clear flags and clean up the Message task message */
+      DeQueueMessage(&psTwi->pTransmitBuffer);
+      psTwi->u32PrivateFlags &= ~(_TWI_TRANSMITTING | _TWI_TRANS_NOT_COMP);
+    }
+    else
+    {
+      psTwi->u32PrivateFlags &= ~_TWI_RECEIVING;
+    }
   }
-  
+
   /* RX TIMEOUT (receive only) */
-  if(TWI_u32Flags & _TWI_ERROR_RX_TIMEOUT)
+  if(psTwi->u32PrivateFlags & _TWI_ERROR_RX_TIMEOUT)
   {
+    /* Stop the PDC and release the bus */
+    psTwi->pBaseAddress->TWI_IDR = AT91C_TWI_ENDRX;
+    psTwi->pBaseAddress->TWI_PTCR = AT91C_PDC_RXTDIS;
+    psTwi->pBaseAddress->TWI_CR = AT91C_TWI_STOP;
+
+    psTwi->u32PrivateFlags &= ~(_TWI_ERROR_RX_TIMEOUT | _TWI_RECEIVING);
+    UpdateMessageStatus(psMsg->u32MessageTaskToken, TIMEOUT);
     DebugPrintf("TWI Rx Timeout. Message deleted.\n\r");
-  }  
+  }
 
   /* Advance states */
-  TWI_u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
-  TWI_pfnStateMachine = TwiSM_NextTransferDelay;
+  psTwi->u32Timer = U8_NEXT_TRANSFER_DELAY_MS;
+  psTwi->pfnStateMachine = TwiSM_NextTransferDelay;
 
 } /* end TwiSM_Error() */
 
@@ -688,4 +877,4 @@ static void TwiSM_Error(void)
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* End of File */
-/*--------------------------------------------------------------------------------------------------------------------*/
\ No newline at end of file
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -8,6 +8,25 @@
 
 #include "configuration.h"
 
+/**********************************************************************************************************************
+Constants / Definitions
+**********************************************************************************************************************/
+/* TWI_u32Flags */
+#define _TWI_INIT_MODE                 (u32)0x00000001     /*!< @brief Set to push a transmit cycle during initialization mode */
+/* end of TWI_u32Flags */
+
+#define U8_TWI_MSG_BUFFER_SIZE         (u8)32              /*!< @brief Max number of messages in each bus's TWI msg buffer */
+
+#define U8_NEXT_TRANSFER_DELAY_MS      (u8)1               /*!< @brief Time before next transfer will begin */
+#define U32_RX_TIMEOUT_MS              (u32)3000           /*!< @brief Max time allowed for Rx message */
+
+
+/*! @cond DOXYGEN_EXCLUDE */
+#define TWI_MMR_ADDRESS_SHIFT          (u8)0x10            /* Used with << to shift address to correct position in MMR */
+
+/*! @endcond */
+
+
 /**********************************************************************************************************************
 Type Definitions
 **********************************************************************************************************************/
@@ -26,33 +45,13 @@ typedef enum {TWI_STOP, TWI_NO_STOP, TWI_NA} TwiStopType;
 typedef enum {TWI_EMPTY, TWI_WRITE, TWI_READ} TwiDirectionType;
 
 
-/*! 
-@struct TwiPeripheralType
-@brief User-defined TWI configuration information 
-*/
-typedef struct 
-{
-  AT91PS_TWI pBaseAddress;             /*!< @brief Base address of the associated peripheral */
-  MessageType* pTransmitBuffer;        /*!< @brief Pointer to the transmit message struct linked list */
-  u32 u32PrivateFlags;                 /*!< @brief Private peripheral flags */
-} TwiPeripheralType;
-
-/* u32PrivateFlags definitions in TwiPeripheralType */
-#define _TWI_TRANSMITTING              (u32)0x00000001   /* Peripheral is Transmitting */
-#define _TWI_RECEIVING                 (u32)0x00000002   /* Peripheral is Receiving */
-#define _TWI_TRANS_NOT_COMP            (u32)0x00000004   /* Tx Transmit hasn't been completed */
- 
-#define _TWI_ERROR_TX_MSG_SYNC         (u32)0x01000000  /*!< @brief Local Tx message token != queued token */
-/* end u32PrivateFlags */
-
-
 /*! 
 @struct TwiMessageQueueType
 @brief Message-specific information 
 */
 typedef struct
 {
-  u32 u32MessageTaskToken;             /*!< @brief TX ONLY: Token corresponding to Message in message task */
+  u32 u32MessageTaskToken;             /*!< @brief Token from message task (TX: queued message, RX: status only) */
   u32 u32Size;                         /*!< @brief RX ONLY: Size of the transfer */
   u8* pu8RxBuffer;                     /*!< @brief RX ONLY: Pointer to receive buffer in user application */
   u8 u8Address;                        /*!< @brief Slave address */
@@ -62,29 +61,38 @@ typedef struct
 } TwiMessageQueueType;
 
 
-/**********************************************************************************************************************
-Constants / Definitions
-**********************************************************************************************************************/
-/* TWI_u32Flags */
-#define _TWI_INIT_MODE                 (u32)0x00000001     /*!< @brief Set to push a transmit cycle during initialization mode */
-
-#define _TWI_ERROR_NACK                (u32)0x01000000     /*!< @brief Set if a NACK is received */
-#define _TWI_ERROR_INTERRUPT           (u32)0x02000000     /*!< @brief Set if an unexpected interrupt occurs */
-#define _TWI_ERROR_RX_TIMEOUT          (u32)0x04000000     /*!< @brief Set if a NACK is received */
-
-#define TWI_ERROR_FLAG_MASK            (u32)0xFF000000     /*!< @brief AND to TWI_u32Flags to get just error flags */
-/* end of TWI_u32Flags */
-
-#define U8_TWI_MSG_BUFFER_SIZE         (u8)32              /*!< @brief Max number of messages in the TWI msg buffer */
-
-#define U8_NEXT_TRANSFER_DELAY_MS      (u8)1               /*!< @brief Time before next transfer will begin */
-#define U32_RX_TIMEOUT_MS              (u32)3000           /*!< @brief Max time allowed for Rx message */
+/*! 
+@struct TwiPeripheralType
+@brief Full definition of a TWI bus with its own message queue and state machine
+*/
+typedef struct 
+{
+  AT91PS_TWI pBaseAddress;             /*!< @brief Base address of the associated peripheral */
+  MessageType* pTransmitBuffer;        /*!< @brief Pointer to the transmit message struct linked list */
+  u32 u32PrivateFlags;                 /*!< @brief Private peripheral flags */
+  fnCode_type pfnStateMachine;         /*!< @brief The bus state machine */
+  u32 u32Timer;                        /*!< @brief Timeout counter used across states */
+  TwiMessageQueueType asMessageBuffer[U8_TWI_MSG_BUFFER_SIZE]; /*!< @brief Local circular buffer for TWI msgs */
+  TwiMessageQueueType* psMsgBufferNext;    /*!< @brief Next position to place a message */
+  TwiMessageQueueType* psMsgBufferCurrent; /*!< @brief Current message that is being processed */
+  u8 u8MsgQueueCount;                  /*!< @brief Counter to track the number of messages in the queue */
+  u8 u8PeripheralId;                   /*!< @brief Simple peripheral ID number */
+  u16 u16Pad;                          /*!< @brief Preserve 4-byte alignment */
+} TwiPeripheralType;
 
+/* u32PrivateFlags definitions in TwiPeripheralType */
+#define _TWI_TRANSMITTING              (u32)0x00000001   /* Peripheral is Transmitting */
+#define _TWI_RECEIVING                 (u32)0x00000002   /* Peripheral is Receiving */
+#define _TWI_TRANS_NOT_COMP            (u32)0x00000004   /* Tx Transmit hasn't been completed */
+ 
+#define _TWI_ERROR_TX_MSG_SYNC         (u32)0x01000000   /*!< @brief Local Tx message token != queued token */
+#define _TWI_ERROR_NACK                (u32)0x02000000   /*!< @brief Set if a NACK is received */
+#define _TWI_ERROR_INTERRUPT           (u32)0x04000000   /*!< @brief Set if an unexpected interrupt occurs */
+#define _TWI_ERROR_RX_TIMEOUT          (u32)0x08000000   /*!< @brief Set if a receive does not complete in time */
 
-/*! @cond DOXYGEN_EXCLUDE */
-#define TWI_MMR_ADDRESS_SHIFT          (u8)0x10            /* Used with << to shift address to correct position in MMR */
+#define TWI_ERROR_FLAG_MASK            (u32)0xFF000000   /*!< @brief AND to u32PrivateFlags to get just error flags */
+/* end u32PrivateFlags */
 
-/*! @endcond */
 
 #if 0
 #define U32_TWI_INIT_MSG_TIMEOUT       (u32)1000           /* Time in ms for init message to send */
@@ -115,8 +123,8 @@ Constants / Definitions
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*! @publicsection */                                                                                            
 /*-------------------------------------------------------------------------------------------------------------------*/
-bool TwiReadData(u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_);
-u32 TwiWriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eStop_);
+u32 TwiReadData(PeripheralType eTwi_, u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_);
+u32 TwiWriteData(PeripheralType eTwi_, u8 u8SlaveAddress_, u32 u32Size_, u8* pu8Data_, TwiStopType eStop_);
 
 
 /*-------------------------------------------------------------------------------------------------------------------*/
@@ -127,11 +135,15 @@ void TwiRunActiveState(void);
 void TwiManualMode(void);
 
 void TWI0_IrqHandler(void);
+void TWI1_IrqHandler(void);
 
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*! @privatesection */                                                                                            
 /*-------------------------------------------------------------------------------------------------------------------*/
+static TwiPeripheralType* TwiGetPeripheral(PeripheralType eTwi_);
+static void TwiInitializePeripheral(TwiPeripheralType* psTwi_);
+static void TwiGenericHandler(TwiPeripheralType* psTwi_);
 
 
 /***********************************************************************************************************************
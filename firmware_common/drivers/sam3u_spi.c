@@ -1,7 +1,22 @@
 /*!**********************************************************************************************************************
 @file sam3u_spi.c                                                                
 @brief Provides a driver to use the dedicated SPI peripheral to send and 
-receive data using interrupts.
+receive data using the DMAC (Master) or interrupts (Slave).
+
+Up to four Master devices can share SPI0, one on each hardware chip select
+(NPCS0-3).  Each device has its own SPI_CSRx setup which is loaded once when the
+device is requested.  The peripheral runs in variable peripheral select mode so
+every TDR write carries the PCS field of the target device: queued transactions
+for different devices then run back-to-back from the ISR without reconfiguring
+the peripheral between them.
+
+Master transfers are moved by the DMAC.  In variable peripheral select mode each 
+TDR write is a 32-bit word holding the PCS field (and LASTXFER on the last byte), 
+so the bytes of a transfer are copied into a word buffer of up to SPI_DMA_MAX_WORDS
+words that one DMAC channel feeds to TDR.  A read runs a second channel that moves 
+RDR into the device's Rx buffer.  Longer transfers are sent as several DMAC blocks,
+the next one started from the DMAC interrupt.  A Slave is still served one byte 
+per TDRE/RDRF interrupt.
 
 ------------------------------------------------------------------------------------------------------------------------
 GLOBALS
@@ -33,6 +48,7 @@ PROTECTED FUNCTIONS
 - void SpiRunActiveState(void)
 - void SpiManualMode(void)
 - void SPI0_IRQHandler(void)
+- void HDMA_IrqHandler(void)
 
 
 **********************************************************************************************************************/
@@ -63,7 +79,18 @@ static fnCode_type Spi_pfnStateMachine;          /*!< @brief The SPI application
 
 static u32 SPI_u32Flags;                         /*!< @brief Application flags for SPI */
 
-static SpiPeripheralType SPI_Peripheral0;        /*!< @brief SPI peripheral object */
+static SpiPeripheralType SPI_asDevice[U8_SPI_NUM_CHIP_SELECTS]; /*!< @brief SPI device objects, indexed by chip select */
+static SpiPeripheralType* SPI_psCurrentDevice;   /*!< @brief Device that owns the transfer in progress (NULL when the bus is idle) */
+static SpiPeripheralType* SPI_psSlave;           /*!< @brief Device object in use when the peripheral is a Slave (NULL in Master mode) */
+static u8 SPI_u8DevicesAssigned;                 /*!< @brief Number of devices currently requested on the peripheral */
+static u8 SPI_u8LastChipSelect;                  /*!< @brief Chip select of the last transfer started so devices are served round-robin */
+
+static u32 SPI_au32DmaTxWords[SPI_DMA_MAX_WORDS]; /*!< @brief TDR words of the DMAC block in progress */
+static u16 SPI_u16DmaBlockBytes;                 /*!< @brief Number of bytes in the DMAC block in progress */
+
+/*! @brief Default SPI_CSRx values for devices that do not supply their own */
+static const u32 SPI_au32DefaultCsr[U8_SPI_NUM_CHIP_SELECTS] = {SPI0_CSR0_INIT, SPI0_CSR1_INIT,
+                                                                SPI0_CSR2_INIT, SPI0_CSR3_INIT};
 
 
 /***********************************************************************************************************************
@@ -77,140 +104,213 @@ Function Definitions
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn SpiPeripheralType* SpiRequest(SpiConfigurationType* psSpiConfig_)
 
-@brief Requests access to an SPI resource.  
+@brief Requests access to an SPI device on one of the hardware chip selects.
 
-If the resource is available, the transmit and receive parameters are set up
-and the peripheral is made ready to use in the application. The peripheral will be 
+If the chip select is available, the transmit and receive parameters are set up
+and the device is made ready to use in the application. The peripheral will be
 configured in different ways for different SPI modes.  The following modes are supported:
 
-SPI_MASTER: transmit and receive using peripheral registers on byte-wise basis using 
-interrupts.  Transmit is initiated through Message task.  Receive is based on
-queued Rx bytes.  Master receive is non-circular.  The Rx buffer is initialized
-to SPI_DUMMY_BYTE and is the source for the transmit dummies.
+SPI_MASTER: transmit and receive using the DMAC.  Transmit is initiated through 
+Message task.  Receive is based on queued Rx bytes.  Master receive is non-circular.  
+Up to U8_SPI_NUM_CHIP_SELECTS Master devices may be requested, each with its own SPI_CSRx configuration. The chip select
+lines are driven by the peripheral, so any NPCS line used must be assigned to the
+SPI peripheral in the GPIO setup.
 
 SPI_SLAVE: transmit through peripheral registers on byte-wise basis using interrupts.
 Transmit is initiated through Message.  Receive set up per-byte using peripheral
-registers and interrupts and assumes a circular Rx buffer.
+registers and interrupts and assumes a circular Rx buffer.  A Slave owns the whole
+peripheral so it can only be requested when no other device is assigned, and it
+must use chip select 0.
 
 Requires:
 - SPI peripheral register initialization values in configuration.h must be set 
-  correctly; currently this does not support different SPI configurations 
-  for multiple Slaves on the same bus - all peripherals on the bus must work with
-  the same setup.
+  correctly; SPI0_MR_INIT must select variable peripheral select for Master devices.
 
-@param psSpiConfig_ has the SPI peripheral number, address of the RxBuffer and the RxBuffer size
+@param psSpiConfig_ has the SPI peripheral, chip select and CSR setup, address of the
+RxBuffer and the RxBuffer size
 
 Promises:
-- Returns a pointer to the requested SPI peripheral object if the resource is available; otherwise returns NULL
+- Returns a pointer to the requested SPI device object if the chip select is available; otherwise returns NULL
+- The device's SPI_CSRx register is loaded
 - Peripheral is enabled
 - Peripheral interrupts are enabled as required for the selected mode
 
 */
 SpiPeripheralType* SpiRequest(SpiConfigurationType* psSpiConfig_)
 {
-  /* If the peripheral is already assigned, return NULL now */
-  if( (SPI_Peripheral0.u32PrivateFlags) & _SPI_PERIPHERAL_ASSIGNED )
+  SpiPeripheralType* psRequestedSpi;
+  u8 u8ChipSelect = psSpiConfig_->u8ChipSelect;
+
+  /* Only SPI0 with its four hardware chip selects is available */
+  if( (psSpiConfig_->SpiPeripheral != SPI0) || (u8ChipSelect >= U8_SPI_NUM_CHIP_SELECTS) )
   {
     return(NULL);
   }
 
-  /* Activate and configure the peripheral */
-  AT91C_BASE_PMC->PMC_PCER |= (1 << SPI_Peripheral0.u8PeripheralId);
-  
-  SPI_Peripheral0.pCsGpioAddress   = psSpiConfig_->pCsGpioAddress;
-  SPI_Peripheral0.u32CsPin         = psSpiConfig_->u32CsPin;
-  SPI_Peripheral0.eBitOrder        = psSpiConfig_->eBitOrder;
-  SPI_Peripheral0.eSpiMode         = psSpiConfig_->eSpiMode;
-  SPI_Peripheral0.pu8RxBuffer      = psSpiConfig_->pu8RxBufferAddress;
-  SPI_Peripheral0.ppu8RxNextByte   = psSpiConfig_->ppu8RxNextByte;
-  SPI_Peripheral0.u16RxBufferSize  = psSpiConfig_->u16RxBufferSize;
-  SPI_Peripheral0.u32PrivateFlags |= _SPI_PERIPHERAL_ASSIGNED;
-   
-  SPI_Peripheral0.pBaseAddress->SPI_CR  = SPI0_CR_INIT;
-  SPI_Peripheral0.pBaseAddress->SPI_MR  = SPI0_MR_INIT;
-  SPI_Peripheral0.pBaseAddress->SPI_IER = SPI0_IER_INIT;
-  SPI_Peripheral0.pBaseAddress->SPI_IDR = SPI0_IDR_INIT;
-
-  SPI_Peripheral0.pBaseAddress->SPI_CSR[0] = SPI0_CSR0_INIT;
-  SPI_Peripheral0.pBaseAddress->SPI_CSR[1] = SPI0_CSR1_INIT;
-  SPI_Peripheral0.pBaseAddress->SPI_CSR[2] = SPI0_CSR2_INIT;
-  SPI_Peripheral0.pBaseAddress->SPI_CSR[3] = SPI0_CSR3_INIT;
-  
+  /* A Slave cannot share the peripheral with any other device */
+  if( (SPI_psSlave != NULL) ||
+      ( (psSpiConfig_->eSpiMode == SPI_SLAVE) && ( (SPI_u8DevicesAssigned != 0) || (u8ChipSelect != 0) ) ) )
+  {
+    return(NULL);
+  }
+
+  /* If the chip select is already assigned, return NULL now */
+  psRequestedSpi = &SPI_asDevice[u8ChipSelect];
+  if( psRequestedSpi->u32PrivateFlags & _SPI_PERIPHERAL_ASSIGNED )
+  {
+    return(NULL);
+  }
+
+  psRequestedSpi->eBitOrder        = psSpiConfig_->eBitOrder;
+  psRequestedSpi->eSpiMode         = psSpiConfig_->eSpiMode;
+  psRequestedSpi->pu8RxBuffer      = psSpiConfig_->pu8RxBufferAddress;
+  psRequestedSpi->ppu8RxNextByte   = psSpiConfig_->ppu8RxNextByte;
+  psRequestedSpi->u16RxBufferSize  = psSpiConfig_->u16RxBufferSize;
+  psRequestedSpi->u16RxBytes       = 0;
+  psRequestedSpi->u32PrivateFlags |= _SPI_PERIPHERAL_ASSIGNED;
+
+  psRequestedSpi->u32Csr = psSpiConfig_->u32CsrConfig;
+  if(psRequestedSpi->u32Csr == 0)
+  {
+    psRequestedSpi->u32Csr = SPI_au32DefaultCsr[u8ChipSelect];
+  }
+
+  /* Master devices tag every TDR write with the PCS value that drives only their NPCS line low.
+  The PCS field is not used in Slave mode. */
+  psRequestedSpi->u32PcsTag = 0;
+  if(psRequestedSpi->eSpiMode == SPI_MASTER)
+  {
+    psRequestedSpi->u32PcsTag = ( ~((u32)1 << u8ChipSelect) & 0x0000000F ) << SPI_TDR_PCS_SHIFT;
+  }
+
+  /* The first device on the bus activates and configures the peripheral */
+  if(SPI_u8DevicesAssigned == 0)
+  {
+    AT91C_BASE_PMC->PMC_PCER |= (1 << psRequestedSpi->u8PeripheralId);
+
+    psRequestedSpi->pBaseAddress->SPI_CR  = SPI0_CR_INIT;
+    psRequestedSpi->pBaseAddress->SPI_MR  = SPI0_MR_INIT;
+    if(psRequestedSpi->eSpiMode == SPI_SLAVE)
+    {
+      psRequestedSpi->pBaseAddress->SPI_MR  = SPI0_MR_INIT & ~(AT91C_SPI_MSTR | AT91C_SPI_PS_VARIABLE);
+    }
+    psRequestedSpi->pBaseAddress->SPI_IER = SPI0_IER_INIT;
+    psRequestedSpi->pBaseAddress->SPI_IDR = SPI0_IDR_INIT;
+
+    /* Master transfers are run by the DMAC */
+    if(psRequestedSpi->eSpiMode == SPI_MASTER)
+    {
+      AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_HDMA);
+      AT91C_BASE_HDMA->HDMA_EN = AT91C_HDMA_ENABLE_ENABLE;
+      AT91C_BASE_HDMA->HDMA_CHDR = (SPI_DMA_TX_CHANNEL_BIT | SPI_DMA_RX_CHANNEL_BIT);
+      AT91C_BASE_HDMA->HDMA_EBCIDR = (SPI_DMA_TX_CHANNEL_BIT | SPI_DMA_RX_CHANNEL_BIT);
+      (void)AT91C_BASE_HDMA->HDMA_EBCISR;
+      NVIC_ClearPendingIRQ(IRQn_HDMA);
+      NVIC_EnableIRQ(IRQn_HDMA);
+    }
+  }
+
+  /* Each device keeps its own CSR, so nothing is reconfigured between transfers */
+  psRequestedSpi->pBaseAddress->SPI_CSR[u8ChipSelect] = psRequestedSpi->u32Csr;
+  SPI_u8DevicesAssigned++;
+
   /* Special considerations for SPI Slaves */
-  if(SPI_Peripheral0.eSpiMode == SPI_SLAVE)
+  if(psRequestedSpi->eSpiMode == SPI_SLAVE)
   {
+    SPI_psSlave = psRequestedSpi;
+
     /* Initialize the receive buffer to dummies and set up a dummy transfer */
-    memset(SPI_Peripheral0.pu8RxBuffer, SPI_DUMMY, SPI_Peripheral0.u16RxBufferSize);
-    SPI_Peripheral0.u32CurrentTxBytesRemaining = SPI_Peripheral0.u16RxBufferSize;
-    SPI_Peripheral0.pu8CurrentTxData = SPI_Peripheral0.pu8RxBuffer;
-    SPI_Peripheral0.pBaseAddress->SPI_TDR = *SPI_Peripheral0.pu8CurrentTxData;
+    memset(psRequestedSpi->pu8RxBuffer, SPI_DUMMY, psRequestedSpi->u16RxBufferSize);
+    psRequestedSpi->u32CurrentTxBytesRemaining = psRequestedSpi->u16RxBufferSize;
+    psRequestedSpi->pu8CurrentTxData = NULL;
+    SpiWriteNextByte(psRequestedSpi);
 
     /* Enable the transmit and receive interrupts and the SPI peripheral in case the Master starts clocking */
-    SPI_Peripheral0.pBaseAddress->SPI_IER = (AT91C_SPI_TDRE | AT91C_SPI_RDRF);
-    SPI_Peripheral0.pBaseAddress->SPI_CR = AT91C_SPI_SPIEN;
-  }
-  
-  /* Enable SPI interrupts */
-  NVIC_ClearPendingIRQ( (IRQn_Type)SPI_Peripheral0.u8PeripheralId );
-  NVIC_EnableIRQ( (IRQn_Type)SPI_Peripheral0.u8PeripheralId );
-  
-  return(&SPI_Peripheral0);
-  
+    psRequestedSpi->pBaseAddress->SPI_IER = (AT91C_SPI_TDRE | AT91C_SPI_RDRF);
+  }
+
+  /* Enable SPI and its interrupts for the first device; the peripheral stays enabled while any device is assigned */
+  if(SPI_u8DevicesAssigned == 1)
+  {
+    psRequestedSpi->pBaseAddress->SPI_CR = AT91C_SPI_SPIEN;
+    NVIC_ClearPendingIRQ( (IRQn_Type)psRequestedSpi->u8PeripheralId );
+    NVIC_EnableIRQ( (IRQn_Type)psRequestedSpi->u8PeripheralId );
+  }
+
+  return(psRequestedSpi);
+
 } /* end SpiRequest() */
 
 
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn void SpiRelease(SpiPeripheralType* psSpiPeripheral_)
 
-@brief Releases an SPI resource.  
+@brief Releases an SPI device.
 
 Requires:
-- Receive operation is not in progress
-
-@param psSpiPeripheral_ has the SPI peripheral number, address of the RxBuffer, 
-and the RxBuffer size.
+@param psSpiPeripheral_ is the SPI device object from SpiRequest().
 
 Promises:
-- Resets peripheral object's pointers and data to safe values
-- Peripheral is disabled
-- Peripheral interrupts are disabled.
+- A transfer the device has on the bus is stopped first; a Slave stops listening
+- Resets device object's pointers and data to safe values
+- Peripheral is disabled and peripheral interrupts are disabled once the last
+  device is released
 
 */
 void SpiRelease(SpiPeripheralType* psSpiPeripheral_)
 {
-  /* Check to see if the peripheral is already released */
-  if( !(psSpiPeripheral_->u32PrivateFlags) & _SPI_PERIPHERAL_ASSIGNED )
+  /* Check to see if the device is already released */
+  if( !(psSpiPeripheral_->u32PrivateFlags & _SPI_PERIPHERAL_ASSIGNED) )
   {
     return;
   }
-  
-  /* Disable interrupts */
-  NVIC_DisableIRQ( (IRQn_Type)(psSpiPeripheral_->u8PeripheralId) );
-  NVIC_ClearPendingIRQ( (IRQn_Type)(psSpiPeripheral_->u8PeripheralId) );
- 
-  /* Now it's safe to release all of the resources in the target peripheral */
-  psSpiPeripheral_->pCsGpioAddress  = NULL;
+
+  /* The ISRs must not touch the device's buffers once they are released */
+  if( (psSpiPeripheral_ == SPI_psCurrentDevice) || (psSpiPeripheral_ == SPI_psSlave) )
+  {
+    SpiStopTransfer(psSpiPeripheral_);
+  }
+
+  /* Now it's safe to release all of the resources in the target device */
   psSpiPeripheral_->pu8RxBuffer     = NULL;
   psSpiPeripheral_->ppu8RxNextByte  = NULL;
+  psSpiPeripheral_->u16RxBytes      = 0;
   psSpiPeripheral_->u32PrivateFlags = 0;
-  
+
   /* Empty the transmit buffer if there were leftover messages */
   while(psSpiPeripheral_->psTransmitBuffer != NULL)
   {
     UpdateMessageStatus(psSpiPeripheral_->psTransmitBuffer->u32Token, ABANDONED);
     DeQueueMessage(&psSpiPeripheral_->psTransmitBuffer);
   }
-  
+
+  if(psSpiPeripheral_ == SPI_psSlave)
+  {
+    SPI_psSlave = NULL;
+  }
+
+  /* Shut down the peripheral when the last device is gone */
+  SPI_u8DevicesAssigned--;
+  if(SPI_u8DevicesAssigned == 0)
+  {
+    NVIC_DisableIRQ( (IRQn_Type)(psSpiPeripheral_->u8PeripheralId) );
+    NVIC_ClearPendingIRQ( (IRQn_Type)(psSpiPeripheral_->u8PeripheralId) );
+    psSpiPeripheral_->pBaseAddress->SPI_IDR = SPI0_IDR_INIT;
+    psSpiPeripheral_->pBaseAddress->SPI_CR  = AT91C_SPI_SPIDIS;
+    NVIC_DisableIRQ(IRQn_HDMA);
+    NVIC_ClearPendingIRQ(IRQn_HDMA);
+  }
+
 } /* end SpiRelease() */
 
 
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn u32 SpiWriteByte(SpiPeripheralType* psSpiPeripheral_, u8 u8Byte_)
 
-@brief Queues a single byte for transfer on the target SPI peripheral.  
+@brief Queues a single byte for transfer on the target SPI device.
 
 Requires:
-@param psSpiPeripheral_ is the SPI peripheral to use and it has already been requested.
+@param psSpiPeripheral_ is the SPI device to use and it has already been requested.
 @param u8Byte_ is the byte to send
 
 Promises:
@@ -224,7 +324,7 @@ u32 SpiWriteByte(SpiPeripheralType* psSpiPeripheral_, u8 u8Byte_)
 {
   u32 u32Token;
   u8 u8Data = u8Byte_;
-  
+
   /* Attempt to queue message and get a response token */
   u32Token = QueueMessage(&psSpiPeripheral_->psTransmitBuffer, 1, &u8Data);
   if( u32Token != 0 )
@@ -236,19 +336,19 @@ u32 SpiWriteByte(SpiPeripheralType* psSpiPeripheral_, u8 u8Byte_)
       SpiManualMode();
     }
   }
-  
+
   return(u32Token);
-  
+
 } /* end SpiWriteByte() */
 
 
 /*!--------------------------------------------------------------------------------------------------------------------
 @fn u32 SpiWriteData(SpiPeripheralType* psSpiPeripheral_, u32 u32Size_, u8* pu8Data_)
 
-@brief Queues a data array for transfer on the target SPI peripheral.  
+@brief Queues a data array for transfer on the target SPI device.
 
 Requires:
-@param psSpiPeripheral_ is the SPI peripheral to use and it has already been requested.
+@param psSpiPeripheral_ is the SPI device to use and it has already been requested.
 @param u32Size_ is the number of bytes in the data array
 @param pu8Data_ points to the first byte of the data array
 
@@ -275,7 +375,7 @@ u32 SpiWriteData(SpiPeripheralType* psSpiPeripheral_, u32 u32Size_, u8* pu8Data_
   {
     return(0);
   }
-  
+
   /* If the system is initializing, manually cycle the SPI task through one iteration to send the message */
   if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
   {
@@ -291,15 +391,15 @@ u32 SpiWriteData(SpiPeripheralType* psSpiPeripheral_, u32 u32Size_, u8* pu8Data_
 @fn bool SpiReadByte(SpiPeripheralType* psSpiPeripheral_)
 
 @brief Master mode only.  Queues a request for a single byte from the Slave on 
-the target SPI peripheral.  There cannot be pending writes.
+the target SPI device.  There cannot be pending writes.
 
 Requires:
 - Master mode 
 
-@param psSpiPeripheral_ is the SPI peripheral to use and it has already been requested.
+@param psSpiPeripheral_ is the SPI device to use and it has already been requested.
 
 Promises:
-- Creates a message with one SPI_DUMMY_BYTE at psSpiPeripheral_->psTransmitBuffer that will be sent by the SPI application
+- Queues one SPI_DUMMY transfer to the device that will be sent by the SPI application
   when it is available and thus clock in a received byte to the target receive buffer.
 - Returns TRUE and loads the target SPI u16RxBytes
 
@@ -317,27 +417,27 @@ bool SpiReadByte(SpiPeripheralType* psSpiPeripheral_)
   {
     return FALSE;
   }
-  
+
   /* Load the counter and return success */
   psSpiPeripheral_->u16RxBytes = 1;
   return TRUE;
-  
+
 } /* end SpiReadByte() */
 
 
 /*!--------------------------------------------------------------------------------------------------------------------
 @fn bool SpiReadData(SpiPeripheralType* psSpiPeripheral_, u16 u16Size_)
 
-@brief Master mode only. Prepares to get multiple bytes from the Slave on the target SPI peripheral.  
+@brief Master mode only. Prepares to get multiple bytes from the Slave on the target SPI device.
 
 Requires:
 - Master mode 
 
-@param psSpiPeripheral_ is the SPI peripheral to use and it has already been requested.
+@param psSpiPeripheral_ is the SPI device to use and it has already been requested.
 @param u16Size_ is the number of bytes to receive
 
 Promises:
-- Returns FALSE if the message is too big, or the peripheral already has a read request
+- Returns FALSE if the message is too big, or the device already has a read request
 - Returns TRUE and loads the target SPI u16RxBytes
 
 */
@@ -361,11 +461,11 @@ bool SpiReadData(SpiPeripheralType* psSpiPeripheral_, u16 u16Size_)
     DebugPrintf("\r\nSPI message too large\n\r");
     return FALSE;
   }
-  
+
   /* Load the counter and return success */
   psSpiPeripheral_->u16RxBytes = u16Size_;
   return TRUE;
-    
+
 } /* end SpiReadData() */
 
 
@@ -375,7 +475,7 @@ bool SpiReadData(SpiPeripheralType* psSpiPeripheral_, u16 u16Size_)
 @brief Master mode only.  Returns status of currently requested receive data.
 
 Requires:
-@param psSpiPeripheral_ is the SPI peripheral to use and it has already been requested.
+@param psSpiPeripheral_ is the SPI device to use and it has already been requested.
 
 Promises:
 - Returns the SpiRxStatusType status of the currently receiving message.
@@ -416,7 +516,7 @@ SpiRxStatusType SpiQueryReceiveStatus(SpiPeripheralType* psSpiPeripheral_)
       return SPI_RX_WAITING;
     }
   }
-  
+
 } /* end SpiQueryReceiveStatus() */
 
 
@@ -429,32 +529,41 @@ SpiRxStatusType SpiQueryReceiveStatus(SpiPeripheralType* psSpiPeripheral_)
 
 @brief Initializes the SPI application and its variables.  
 
-The peripheral is not configured until requested by a calling application.
+The peripheral is not configured until a device is requested by a calling application.
 
 Requires:
 - NONE
 
 Promises:
-- SPI peripheral object is ready 
+- SPI device objects are ready
 - SPI application set to Idle
 
 */
 void SpiInitialize(void)
 {
-  /* Initialize the SPI peripheral structures */
-  SPI_Peripheral0.pBaseAddress     = AT91C_BASE_SPI0;
-  SPI_Peripheral0.u8PeripheralId   = AT91C_ID_SPI0;
-  SPI_Peripheral0.pCsGpioAddress   = NULL;
-  SPI_Peripheral0.psTransmitBuffer = NULL;
-  SPI_Peripheral0.pu8RxBuffer      = NULL;
-  SPI_Peripheral0.u16RxBufferSize  = 0;
-  SPI_Peripheral0.ppu8RxNextByte   = NULL;
-  SPI_Peripheral0.u32PrivateFlags  = 0;
+  /* Initialize the SPI device structures: all share the SPI0 peripheral */
+  for(u8 i = 0; i < U8_SPI_NUM_CHIP_SELECTS; i++)
+  {
+    SPI_asDevice[i].pBaseAddress     = AT91C_BASE_SPI0;
+    SPI_asDevice[i].u8PeripheralId   = AT91C_ID_SPI0;
+    SPI_asDevice[i].u8ChipSelect     = i;
+    SPI_asDevice[i].psTransmitBuffer = NULL;
+    SPI_asDevice[i].pu8RxBuffer      = NULL;
+    SPI_asDevice[i].u16RxBufferSize  = 0;
+    SPI_asDevice[i].u16RxBytes       = 0;
+    SPI_asDevice[i].ppu8RxNextByte   = NULL;
+    SPI_asDevice[i].u32PrivateFlags  = 0;
+  }
+
+  SPI_psCurrentDevice   = NULL;
+  SPI_psSlave           = NULL;
+  SPI_u8DevicesAssigned = 0;
+  SPI_u8LastChipSelect  = U8_SPI_NUM_CHIP_SELECTS - 1;
 
   /* Clear all flags */
   SPI_u32Flags = 0;
   G_u32Spi0ApplicationFlags = 0;
-  
+
   /* Set application pointer */
   Spi_pfnStateMachine = SpiSM_Idle;
   DebugPrintf("SPI Peripheral Ready\n\r");
@@ -501,21 +610,21 @@ Promises:
 void SpiManualMode(void)
 {
   u32 u32Timer;
-  
+
   /* Set up for manual mode */
   SPI_u32Flags |= _SPI_MANUAL_MODE;
 
-  /* Run the SPI state machine so all SPI peripherals send their current message */  
+  /* Run the SPI state machine until every device has sent its queued messages */
   while(SPI_u32Flags & _SPI_MANUAL_MODE)
   {
     WATCHDOG_BONE();
     Spi_pfnStateMachine();
     MessagingRunActiveState();
-    
+
     u32Timer = G_u32SystemTime1ms;
     while( !IsTimeUp(&u32Timer, 1) );
   }
-      
+
 } /* end SpiManualMode() */
 
 
@@ -524,6 +633,11 @@ void SpiManualMode(void)
 
 @brief Handler for expected SPI interrupts
 
+The interrupt belongs to the device of the transfer in progress.  A Slave is 
+served byte by byte here; for a Master only TXEMPTY is used, to complete a 
+transmit message after the DMAC has loaded its last byte.  When a transfer 
+finishes, the next queued transfer (for any device) is started immediately.
+
 Requires:
 - None
 
@@ -534,112 +648,465 @@ Promises:
 */
 void SPI0_IrqHandler(void)
 {
+  SpiPeripheralType* psSpi;
   u32 u32Byte;
   u32 u32Current_SR;
+  u32 u32Current_IMR;
 
-  /* Get a copy of SR */
-  u32Current_SR = SPI_Peripheral0.pBaseAddress->SPI_SR;
+  ISR_PROFILE_ENTER();
 
-  /*** SPI ISR receive handling (RDRF) for Master and Slave ***/
-  if( (SPI_Peripheral0.pBaseAddress->SPI_IMR & AT91C_SPI_RDRF) && 
-      (u32Current_SR & AT91C_SPI_RDRF) )
+  /* A Slave can receive without a transfer in progress */
+  psSpi = SPI_psCurrentDevice;
+  if(psSpi == NULL)
+  {
+    psSpi = SPI_psSlave;
+  }
+
+  /* Nothing should be interrupting with no device active */
+  if(psSpi == NULL)
+  {
+    AT91C_BASE_SPI0->SPI_IDR = (AT91C_SPI_TDRE | AT91C_SPI_RDRF | AT91C_SPI_TXEMPTY);
+    ISR_PROFILE_EXIT();
+    return;
+  }
+
+  /* Get a copy of SR and IMR */
+  u32Current_SR  = psSpi->pBaseAddress->SPI_SR;
+  u32Current_IMR = psSpi->pBaseAddress->SPI_IMR;
+
+  /*** SPI ISR receive handling (RDRF) for Slave ***/
+  if( (u32Current_IMR & AT91C_SPI_RDRF) && (u32Current_SR & AT91C_SPI_RDRF) )
   {
-    /* Master mode has special conditions if receiving a known number of bytes */
-    if( (SPI_Peripheral0.eSpiMode == SPI_MASTER) &&
-        (SPI_Peripheral0.u32PrivateFlags & _SPI_PERIPHERAL_RX) )
-    {
-      /* Decrement counter and read the byte */
-      SPI_Peripheral0.u16RxBytes--;
-      
-      /* Check if reception is complete */
-      if(SPI_Peripheral0.u16RxBytes == 0)
-      {
-        /* Reset the byte counter and clear the RX flag */
-        SPI_Peripheral0.u32PrivateFlags &= ~_SSP_PERIPHERAL_RX;
-        SPI_Peripheral0.u32PrivateFlags |=  _SSP_PERIPHERAL_RX_COMPLETE;
-             
-        /* Disable the receive interrupt */
-        SPI_Peripheral0.pBaseAddress->SPI_IDR = AT91C_SPI_RDRF;
-
-        /* Disable the SPI peripheral since the transfer must now be complete */
-        SPI_Peripheral0.pBaseAddress->SPI_CR = AT91C_SPI_SPIDIS;
-      }
-    }
-        
-    /* Common receive functionality */
-      
     /* Read the received byte */
-    u32Byte = 0x000000FF & SPI_Peripheral0.pBaseAddress->SPI_RDR;
+    u32Byte = 0x000000FF & psSpi->pBaseAddress->SPI_RDR;
 
     /* If we need LSB first, use inline assembly to flip bits with a single instruction. */
-    if(SPI_Peripheral0.eBitOrder == SPI_LSB_FIRST)
+    if(psSpi->eBitOrder == SPI_LSB_FIRST)
     {
       u32Byte = __RBIT(u32Byte) >> 24;
     }
 
     /* Put the byte in the client's Rx buffer */
-    **(SPI_Peripheral0.ppu8RxNextByte) = (u8)u32Byte; 
+    **(psSpi->ppu8RxNextByte) = (u8)u32Byte;
 
     /* Update the pointer to the next valid Rx location (account for Slave's circular buffer) */
-    (*SPI_Peripheral0.ppu8RxNextByte)++;
-    if( *SPI_Peripheral0.ppu8RxNextByte == (SPI_Peripheral0.pu8RxBuffer + (u32)SPI_Peripheral0.u16RxBufferSize) )
+    (*psSpi->ppu8RxNextByte)++;
+    if( *psSpi->ppu8RxNextByte == (psSpi->pu8RxBuffer + (u32)psSpi->u16RxBufferSize) )
     {
-      *SPI_Peripheral0.ppu8RxNextByte = SPI_Peripheral0.pu8RxBuffer;  
+      *psSpi->ppu8RxNextByte = psSpi->pu8RxBuffer;
     }
   } /* end AT91C_SPI_RDRF handling */
 
 
-  /*** SPI ISR transmit handling (TDRE) for Master and Slave ***/
-  if( (SPI_Peripheral0.pBaseAddress->SPI_IMR & AT91C_SPI_TDRE) && 
-      (u32Current_SR & AT91C_SPI_TDRE) )
+  /*** SPI ISR transmit handling (TDRE) for Slave ***/
+  if( (u32Current_IMR & AT91C_SPI_TDRE) && (u32Current_SR & AT91C_SPI_TDRE) )
   {
-    /* Decrement counter and check if Tx is complete */
-    SPI_Peripheral0.u32CurrentTxBytesRemaining--;
-    if(SPI_Peripheral0.u32CurrentTxBytesRemaining != 0)
+    /* Load the next byte or finish up the transfer */
+    if(psSpi->u32CurrentTxBytesRemaining != 0)
     {
-      /* Advance the pointer (non-circular buffer)and load the next byte */
-      SPI_Peripheral0.pu8CurrentTxData++;
-      u32Byte = 0x000000FF & *SPI_Peripheral0.pu8CurrentTxData;
-
-      /* If we need LSB first, use inline assembly to flip bits with a single instruction. */
-      if(SPI_Peripheral0.eBitOrder == SPI_LSB_FIRST)
-      {
-        u32Byte = __RBIT(u32Byte) >> 24;
-      }
-    
-      /* Load register (clears interrupt flag) */
-      SPI_Peripheral0.pBaseAddress->SPI_TDR = (u8)u32Byte; 
+      SpiWriteNextByte(psSpi);
     }
     else
     {
       /* Done! Disable TX interrupt */
-      SPI_Peripheral0.pBaseAddress->SPI_IDR = AT91C_SPI_TDRE;
-      
-      /* If this was a transmit operation, clean up the message status and flags */
-      if(SPI_Peripheral0.u32PrivateFlags & _SPI_PERIPHERAL_TX)
+      psSpi->pBaseAddress->SPI_IDR = AT91C_SPI_TDRE;
+
+      /* A transmit message is complete only when the last byte has left the shift register */
+      if(psSpi->u32PrivateFlags & _SPI_PERIPHERAL_TX)
       {
-        SPI_Peripheral0.u32PrivateFlags &= ~_SPI_PERIPHERAL_TX;  
-        G_u32Spi0ApplicationFlags |= _SPI_TX_COMPLETE; 
-        UpdateMessageStatus(SPI_Peripheral0.psTransmitBuffer->u32Token, COMPLETE);
-        DeQueueMessage(&SPI_Peripheral0.psTransmitBuffer);
+        psSpi->pBaseAddress->SPI_IER = AT91C_SPI_TXEMPTY;
       }
     }
   } /* end AT91C_SPI_TDRE */
-  
+
+
+  /*** SPI ISR transmit complete handling (TXEMPTY) ***/
+  if( (u32Current_IMR & AT91C_SPI_TXEMPTY) && (u32Current_SR & AT91C_SPI_TXEMPTY) )
+  {
+    psSpi->pBaseAddress->SPI_IDR = AT91C_SPI_TXEMPTY;
+
+    /* Clean up the message status and flags */
+    psSpi->u32PrivateFlags &= ~_SPI_PERIPHERAL_TX;
+    G_u32Spi0ApplicationFlags |= _SPI_TX_COMPLETE;
+    UpdateMessageStatus(psSpi->psTransmitBuffer->u32Token, COMPLETE);
+    DeQueueMessage(&psSpi->psTransmitBuffer);
+
+    /* Start the next queued transfer right away */
+    SPI_psCurrentDevice = NULL;
+    SpiStartNextTransfer();
+  } /* end AT91C_SPI_TXEMPTY */
+
+  ISR_PROFILE_EXIT();
 } /* end SPI0_IrqHandler() */
 
 
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn ISR void HDMA_IrqHandler(void)
+
+@brief Handler for the DMAC block-done interrupts of a Master transfer
+
+Requires:
+- SPI_psCurrentDevice is the Master whose DMAC block just finished
+
+Promises:
+- Read: the received block is bit-flipped for SPI_LSB_FIRST and the device's Rx 
+  pointer moves past it.  The next block is started, or once all bytes are in the 
+  read is _SPI_PERIPHERAL_RX_COMPLETE and the next queued transfer is started.
+- Transmit: the next block is started, or once the last word is in TDR, TXEMPTY 
+  is enabled so SPI0_IrqHandler() completes the message
+
+*/
+void HDMA_IrqHandler(void)
+{
+  SpiPeripheralType* psSpi = SPI_psCurrentDevice;
+  u8* pu8Block;
+  u32 u32Status;
+
+  ISR_PROFILE_ENTER();
+
+  /* Reading EBCISR clears it */
+  u32Status = AT91C_BASE_HDMA->HDMA_EBCISR & AT91C_BASE_HDMA->HDMA_EBCIMR;
+  AT91C_BASE_HDMA->HDMA_EBCIDR = u32Status;
+
+  if(psSpi == NULL)
+  {
+    ISR_PROFILE_EXIT();
+    return;
+  }
+
+  /*** Read block received ***/
+  if(u32Status & SPI_DMA_RX_CHANNEL_BIT)
+  {
+    pu8Block = *psSpi->ppu8RxNextByte;
+    if(psSpi->eBitOrder == SPI_LSB_FIRST)
+    {
+      for(u16 i = 0; i < SPI_u16DmaBlockBytes; i++)
+      {
+        pu8Block[i] = (u8)(__RBIT((u32)pu8Block[i]) >> 24);
+      }
+    }
+
+    /* Move the Rx pointer past the block (a block never runs past the end of the buffer) */
+    *psSpi->ppu8RxNextByte += SPI_u16DmaBlockBytes;
+    if( *psSpi->ppu8RxNextByte == (psSpi->pu8RxBuffer + (u32)psSpi->u16RxBufferSize) )
+    {
+      *psSpi->ppu8RxNextByte = psSpi->pu8RxBuffer;
+    }
+
+    psSpi->u16RxBytes -= SPI_u16DmaBlockBytes;
+    if(psSpi->u16RxBytes != 0)
+    {
+      SpiDmaStartBlock(psSpi);
+    }
+    else
+    {
+      psSpi->u32PrivateFlags &= ~_SPI_PERIPHERAL_RX;
+      psSpi->u32PrivateFlags |=  _SPI_PERIPHERAL_RX_COMPLETE;
+      G_u32Spi0ApplicationFlags |= _SPI_RX_COMPLETE;
+
+      /* The last byte has been clocked so the bus is free for the next device */
+      SPI_psCurrentDevice = NULL;
+      SpiStartNextTransfer();
+    }
+  } /* end Rx block */
+
+  /*** Transmit block loaded into TDR ***/
+  if(u32Status & SPI_DMA_TX_CHANNEL_BIT)
+  {
+    if(psSpi->u32CurrentTxBytesRemaining != 0)
+    {
+      SpiDmaStartBlock(psSpi);
+    }
+    else
+    {
+      /* A transmit message is complete only when the last byte has left the shift register */
+      psSpi->pBaseAddress->SPI_IER = AT91C_SPI_TXEMPTY;
+    }
+  } /* end Tx block */
+
+  ISR_PROFILE_EXIT();
+} /* end HDMA_IrqHandler() */
+
+
 
 /*----------------------------------------------------------------------------------------------------------------------*/
 /*! @privatesection */                                                                                            
 /*----------------------------------------------------------------------------------------------------------------------*/
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void SpiStartNextTransfer(void)
+
+@brief Starts the next queued transfer on the bus.
+
+Devices are checked round-robin starting after the one that was served last so
+one busy device cannot starve the others.  Since every device's CSR is already
+loaded and each TDR write carries the device's PCS value, starting a transfer for
+a different device does not require any peripheral reconfiguration.
+
+Requires:
+- SPI_psCurrentDevice is NULL (the bus is idle)
+- Called from the SPI state machine or the SPI ISR only
+
+Promises:
+- If any device has a queued message or read request, SPI_psCurrentDevice points
+  to it and its transfer is started: by the DMAC for a Master, or with its first 
+  byte loaded and the interrupts enabled for a Slave
+- Before a Master read the device's whole Rx buffer is filled with SPI_DUMMY so 
+  data changes are easy to see
+- Otherwise SPI_psCurrentDevice is left NULL
+
+*/
+static void SpiStartNextTransfer(void)
+{
+  SpiPeripheralType* psDevice = NULL;
+  u8 u8Index;
+
+  /* Find the next device with work to do */
+  for(u8 i = 1; i <= U8_SPI_NUM_CHIP_SELECTS; i++)
+  {
+    u8Index = (SPI_u8LastChipSelect + i) % U8_SPI_NUM_CHIP_SELECTS;
+    if( (SPI_asDevice[u8Index].u32PrivateFlags & _SPI_PERIPHERAL_ASSIGNED) &&
+        ( (SPI_asDevice[u8Index].psTransmitBuffer != NULL) || (SPI_asDevice[u8Index].u16RxBytes != 0) ) )
+    {
+      psDevice = &SPI_asDevice[u8Index];
+      break;
+    }
+  }
+
+  if(psDevice == NULL)
+  {
+    return;
+  }
+
+  SPI_u8LastChipSelect = psDevice->u8ChipSelect;
+  SPI_psCurrentDevice = psDevice;
+
+  /* Receiving (Master only): Check if the message is receiving based on expected byte count.
+  Do not need to check for Master because a Slave is not allowed to change u16RxBytes. */
+  if(psDevice->u16RxBytes != 0)
+  {
+    /* Receiving: flag that the device is now busy */
+    psDevice->u32PrivateFlags |= _SPI_PERIPHERAL_RX;
+
+    /* Initialize the receive buffer so we can see data changes */
+    memset(psDevice->pu8RxBuffer, SPI_DUMMY, psDevice->u16RxBufferSize);
+
+    /* Transmit drives the receive operation, so set it up to send dummies */
+    psDevice->u32CurrentTxBytesRemaining = psDevice->u16RxBytes;
+    psDevice->pu8CurrentTxData = NULL;
+
+    /* Make sure RDR is clear of anything left from a write-only transfer then start */
+    (void)psDevice->pBaseAddress->SPI_RDR;
+    SpiDmaStartBlock(psDevice);
+
+  } /* end of receive function */
+  else
+  {
+    /* Transmitting: update the message's status and flag that the device is now busy */
+    UpdateMessageStatus(psDevice->psTransmitBuffer->u32Token, SENDING);
+    psDevice->u32PrivateFlags |= _SPI_PERIPHERAL_TX;
+    G_u32Spi0ApplicationFlags &= ~_SPI_TX_COMPLETE;
+
+    /* Load in the message parameters and start it: a Slave sends the first byte and continues on TDRE */
+    psDevice->u32CurrentTxBytesRemaining = psDevice->psTransmitBuffer->u32Size;
+    psDevice->pu8CurrentTxData = psDevice->psTransmitBuffer->pu8Message;
+    if(psDevice->eSpiMode == SPI_MASTER)
+    {
+      SpiDmaStartBlock(psDevice);
+    }
+    else
+    {
+      SpiWriteNextByte(psDevice);
+      psDevice->pBaseAddress->SPI_IER = AT91C_SPI_TDRE;
+    }
+
+  } /* end of transmitting function */
+
+} /* end SpiStartNextTransfer() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void SpiStopTransfer(SpiPeripheralType* psSpi_)
+
+@brief Stops the transfer a device has on the bus so the device can be released.
+
+Requires:
+@param psSpi_ is SPI_psCurrentDevice or SPI_psSlave
+
+Promises:
+- The DMAC channels and the SPI interrupts are disabled
+- A Master's chip select is released with LASTXFER
+- SPI_psCurrentDevice is NULL so the state machine starts the next queued transfer
+
+*/
+static void SpiStopTransfer(SpiPeripheralType* psSpi_)
+{
+  __disable_irq();
+
+  psSpi_->pBaseAddress->SPI_IDR = (AT91C_SPI_TDRE | AT91C_SPI_RDRF | AT91C_SPI_TXEMPTY);
+  if(psSpi_->eSpiMode == SPI_MASTER)
+  {
+    AT91C_BASE_HDMA->HDMA_CHDR   = (SPI_DMA_TX_CHANNEL_BIT | SPI_DMA_RX_CHANNEL_BIT);
+    AT91C_BASE_HDMA->HDMA_EBCIDR = (SPI_DMA_TX_CHANNEL_BIT | SPI_DMA_RX_CHANNEL_BIT);
+    psSpi_->pBaseAddress->SPI_CR = AT91C_SPI_LASTXFER;
+  }
+
+  SPI_psCurrentDevice = NULL;
+
+  __enable_irq();
+
+} /* end SpiStopTransfer() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void SpiDmaStartBlock(SpiPeripheralType* psSpi_)
+
+@brief Starts the DMAC on the next block of a Master transfer.
+
+The block is the rest of the transfer, up to SPI_DMA_MAX_WORDS bytes.  A read block
+also stops at the end of the Rx buffer so the DMAC never writes past it.
+
+Requires:
+- psSpi_->u32CurrentTxBytesRemaining is not 0
+- Both DMAC channels are idle
+
+@param psSpi_ is the Master that owns the transfer; it is reading if _SPI_PERIPHERAL_RX is set
+
+Promises:
+- SPI_au32DmaTxWords holds the block's TDR words and SPI_u16DmaBlockBytes its size
+- For a read, the Rx channel is moving RDR to *ppu8RxNextByte and will interrupt 
+  when the block is in; otherwise the Tx channel interrupts when the block is in TDR
+- The Tx channel is feeding TDR
+
+*/
+static void SpiDmaStartBlock(SpiPeripheralType* psSpi_)
+{
+  AT91PS_HDMA_CH psTxChannel = &AT91C_BASE_HDMA->HDMA_CH[SPI_DMA_TX_CHANNEL];
+  AT91PS_HDMA_CH psRxChannel = &AT91C_BASE_HDMA->HDMA_CH[SPI_DMA_RX_CHANNEL];
+  u32 u32Bytes = psSpi_->u32CurrentTxBytesRemaining;
+  u32 u32RxSpace;
+
+  if(u32Bytes > SPI_DMA_MAX_WORDS)
+  {
+    u32Bytes = SPI_DMA_MAX_WORDS;
+  }
+
+  if(psSpi_->u32PrivateFlags & _SPI_PERIPHERAL_RX)
+  {
+    u32RxSpace = (u32)(psSpi_->pu8RxBuffer + psSpi_->u16RxBufferSize - *psSpi_->ppu8RxNextByte);
+    if(u32Bytes > u32RxSpace)
+    {
+      u32Bytes = u32RxSpace;
+    }
+  }
+
+  SPI_u16DmaBlockBytes = (u16)u32Bytes;
+  for(u16 i = 0; i < SPI_u16DmaBlockBytes; i++)
+  {
+    SPI_au32DmaTxWords[i] = SpiNextTxWord(psSpi_);
+  }
+
+  /* Receive is armed first so no byte is missed */
+  if(psSpi_->u32PrivateFlags & _SPI_PERIPHERAL_RX)
+  {
+    psRxChannel->HDMA_SADDR = (u32)&psSpi_->pBaseAddress->SPI_RDR;
+    psRxChannel->HDMA_DADDR = (u32)*psSpi_->ppu8RxNextByte;
+    psRxChannel->HDMA_DSCR  = 0;
+    psRxChannel->HDMA_CTRLA = SPI_DMA_RX_CTRLA | u32Bytes;
+    psRxChannel->HDMA_CTRLB = SPI_DMA_RX_CTRLB;
+    psRxChannel->HDMA_CFG   = SPI_DMA_RX_CFG;
+    AT91C_BASE_HDMA->HDMA_EBCIER = SPI_DMA_RX_CHANNEL_BIT;
+    AT91C_BASE_HDMA->HDMA_CHER   = SPI_DMA_RX_CHANNEL_BIT;
+  }
+  else
+  {
+    AT91C_BASE_HDMA->HDMA_EBCIER = SPI_DMA_TX_CHANNEL_BIT;
+  }
+
+  psTxChannel->HDMA_SADDR = (u32)&SPI_au32DmaTxWords[0];
+  psTxChannel->HDMA_DADDR = (u32)&psSpi_->pBaseAddress->SPI_TDR;
+  psTxChannel->HDMA_DSCR  = 0;
+  psTxChannel->HDMA_CTRLA = SPI_DMA_TX_CTRLA | u32Bytes;
+  psTxChannel->HDMA_CTRLB = SPI_DMA_TX_CTRLB;
+  psTxChannel->HDMA_CFG   = SPI_DMA_TX_CFG;
+  AT91C_BASE_HDMA->HDMA_CHER = SPI_DMA_TX_CHANNEL_BIT;
+
+} /* end SpiDmaStartBlock() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static u32 SpiNextTxWord(SpiPeripheralType* psSpi_)
+
+@brief Builds the TDR word for the next byte of the current transfer.
+
+Requires:
+- psSpi_->u32CurrentTxBytesRemaining is not 0
+
+@param psSpi_ is the device that owns the transfer; pu8CurrentTxData is NULL
+when dummy bytes are sent
+
+Promises:
+- Returns the next data byte (or SPI_DUMMY) with the device's PCS tag
+- The final byte of a Master transfer has LASTXFER set so the chip select is
+  released when it completes
+- u32CurrentTxBytesRemaining and pu8CurrentTxData are advanced
+
+*/
+static u32 SpiNextTxWord(SpiPeripheralType* psSpi_)
+{
+  u32 u32Byte = SPI_DUMMY;
+
+  if(psSpi_->pu8CurrentTxData != NULL)
+  {
+    u32Byte = 0x000000FF & *psSpi_->pu8CurrentTxData;
+    psSpi_->pu8CurrentTxData++;
+  }
+
+  /* If we need LSB first, use inline assembly to flip bits with a single instruction. */
+  if(psSpi_->eBitOrder == SPI_LSB_FIRST)
+  {
+    u32Byte = __RBIT(u32Byte) >> 24;
+  }
+
+  u32Byte |= psSpi_->u32PcsTag;
+  psSpi_->u32CurrentTxBytesRemaining--;
+  if( (psSpi_->u32CurrentTxBytesRemaining == 0) && (psSpi_->eSpiMode == SPI_MASTER) )
+  {
+    u32Byte |= AT91C_SPI_LASTXFER;
+  }
+
+  return(u32Byte);
+
+} /* end SpiNextTxWord() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn static void SpiWriteNextByte(SpiPeripheralType* psSpi_)
+
+@brief Loads the next byte of the current transfer into TDR (Slave transfers).
+
+Requires:
+- psSpi_->u32CurrentTxBytesRemaining is not 0
+
+@param psSpi_ is the device that owns the transfer
+
+Promises:
+- The word from SpiNextTxWord() is written to TDR (clears the TDRE interrupt flag)
+
+*/
+static void SpiWriteNextByte(SpiPeripheralType* psSpi_)
+{
+  psSpi_->pBaseAddress->SPI_TDR = SpiNextTxWord(psSpi_);
+
+} /* end SpiWriteNextByte() */
+
 
 /***********************************************************************************************************************
 State Machine Function Definitions
 
-The SPI state machine monitors messaging activity on the SPI Master peripheral.  
-It manages all SPI outgoing messages and will transmit any message that has been queued.  
+The SPI state machine monitors messaging activity on the SPI devices.
+It starts the first transfer whenever the bus is idle; the ISR chains any further
+queued transfers back-to-back.
 ***********************************************************************************************************************/
 
 /*!-------------------------------------------------------------------------------------------------------------------
@@ -647,68 +1114,23 @@ It manages all SPI outgoing messages and will transmit any message that has been
 
 @brief Wait for a transmit message to be queued -- this can include a dummy transmission 
 to receive bytes.
-Half duplex transmissions are always assumed. Check one peripheral per iteration. 
+Half duplex transmissions are always assumed.
 
 */
 static void SpiSM_Idle(void)
 {
-  u32 u32Byte;
+  /* Only kick off a transfer if the ISR is not already working through the queues */
+  if(SPI_psCurrentDevice == NULL)
+  {
+    SpiStartNextTransfer();
+  }
 
-  if( ( (SPI_Peripheral0.psTransmitBuffer != NULL) || (SPI_Peripheral0.u16RxBytes !=0) ) && 
-     !(SPI_Peripheral0.u32PrivateFlags & (_SPI_PERIPHERAL_TX | _SPI_PERIPHERAL_RX) ) 
-    )
+  /* Manual mode is done when nothing is left to send */
+  if( (SPI_u32Flags & _SPI_MANUAL_MODE) && (SPI_psCurrentDevice == NULL) )
   {
-    /* Receiving (Master only): Check if the message is receiving based on expected byte count.
-    Do not need to check for Master because a Slave is not allowed to change u16RxBytes. */
-    if(SPI_Peripheral0.u16RxBytes !=0)
-    {
-      /* Receiving: flag that the peripheral is now busy */
-      SPI_Peripheral0.u32PrivateFlags |= _SPI_PERIPHERAL_RX;    
-      
-      /* Initialize the receive buffer so we can see data changes but also so we send
-      predictable dummy bytes since we'll point to this buffer to source the transmit dummies */
-      memset(SPI_Peripheral0.pu8RxBuffer, SPI_DUMMY, SPI_Peripheral0.u16RxBufferSize);
-      
-      /* Transmit drives the receive operation, so set it up */
-      SPI_Peripheral0.u32CurrentTxBytesRemaining = SPI_Peripheral0.u16RxBytes;
-      SPI_Peripheral0.pu8CurrentTxData = SPI_Peripheral0.pu8RxBuffer;
-      SPI_Peripheral0.pBaseAddress->SPI_TDR = *SPI_Peripheral0.pu8CurrentTxData;
-      
-      /* Enable the SPI peripheral */
-      SPI_Peripheral0.pBaseAddress->SPI_CR = AT91C_SPI_SPIEN;
-
-      /* Make sure RDR is clear then enable the transmit and receive interrupts */
-      u32Byte = SPI_Peripheral0.pBaseAddress->SPI_RDR;
-      SPI_Peripheral0.pBaseAddress->SPI_IER = (AT91C_SPI_TDRE | AT91C_SPI_RDRF);
-
-      
-    } /* end of receive function */
-    else
-    {
-      /* Transmitting: update the message's status and flag that the peripheral is now busy */
-      UpdateMessageStatus(SPI_Peripheral0.psTransmitBuffer->u32Token, SENDING);
-      SPI_Peripheral0.u32PrivateFlags |= _SPI_PERIPHERAL_TX;    
-      
-      /* Load in the message parameters. */
-      SPI_Peripheral0.u32CurrentTxBytesRemaining = SPI_Peripheral0.psTransmitBuffer->u32Size;
-      SPI_Peripheral0.pu8CurrentTxData = SPI_Peripheral0.psTransmitBuffer->pu8Message;
-       
-      /* Load first byte.  If we need LSB first, use inline assembly to flip bits with a single instruction. */
-      u32Byte = 0x000000FF &  *SPI_Peripheral0.pu8CurrentTxData;
-      if(SPI_Peripheral0.eBitOrder == SPI_LSB_FIRST)
-      {
-        u32Byte = __RBIT(u32Byte) >> 24;
-      }
-       
-      /* Enable the SPI peripheral, load the byte, then enable interrupts */
-      SPI_Peripheral0.pBaseAddress->SPI_CR = AT91C_SPI_SPIEN;
-      SPI_Peripheral0.pBaseAddress->SPI_TDR = (u8)u32Byte; 
-      SPI_Peripheral0.pBaseAddress->SPI_IER = (AT91C_SPI_TDRE | AT91C_SPI_RDRF);
-      
-    } /* end of transmitting function */
-    
-  } /* end if */
-  
+    SPI_u32Flags &= ~_SPI_MANUAL_MODE;
+  }
+
 } /* end SpiSM_Idle() */
 
 
@@ -722,10 +1144,10 @@ static void SpiSM_Idle(void)
 static void SpiSM_Error(void)          
 {
   Spi_pfnStateMachine = SpiSM_Idle;
-  
+
 } /* end SpiSM_Error() */
 #endif
-        
+
 
 
 
@@ -733,4 +1155,3 @@ static void SpiSM_Error(void)
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* End of File */
 /*--------------------------------------------------------------------------------------------------------------------*/
-
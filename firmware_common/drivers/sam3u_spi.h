@@ -38,8 +38,8 @@ typedef enum {SPI_RX_EMPTY = 0, SPI_RX_WAITING, SPI_RX_RECEIVING, SPI_RX_COMPLET
 typedef struct 
 {
   PeripheralType SpiPeripheral;       /*!< @brief Easy name of peripheral */
-  AT91PS_PIO pCsGpioAddress;          /*!< @brief Base address for GPIO port for chip select line */
-  u32 u32CsPin;                       /*!< @brief Pin location for SSEL line */
+  u8 u8ChipSelect;                    /*!< @brief Hardware chip select line NPCS0-3 the device is wired to (must be 0 for SPI_SLAVE) */
+  u32 u32CsrConfig;                   /*!< @brief SPI_CSRx value for the device (baud, mode, delays); 0 selects the default for the chip select */
   SpiBitOrderType eBitOrder;          /*!< @brief MSB_FIRST or LSB_FIRST: this is only available in SPI_SLAVE_FLOW_CONTROL mode */
   SpiModeType eSpiMode;               /*!< @brief Type of SPI configured */
   u16 u16RxBufferSize;                /*!< @brief Size of receive buffer in bytes */
@@ -50,17 +50,18 @@ typedef struct
 
 /*! 
 @struct SpiPeripheralType
-@brief Full definition of SPI peripheral 
+@brief Full definition of one device on the SPI peripheral.  Each hardware chip select
+has its own object so several devices can share SPI0.
 */
 typedef struct 
 {
   AT91PS_SPI pBaseAddress;            /*!< @brief Base address of the associated peripheral */
-  AT91PS_PIO pCsGpioAddress;          /*!< @brief Base address for GPIO port for chip select line */
-  u32 u32CsPin;                       /*!< @brief Pin location for SSEL line */
+  u32 u32Csr;                         /*!< @brief SPI_CSRx value loaded for this device's chip select */
+  u32 u32PcsTag;                      /*!< @brief PCS field OR'd into each TDR write so the hardware selects this device */
   SpiBitOrderType eBitOrder;          /*!< @brief MSB_FIRST or LSB_FIRST: this is only available in SPI_SLAVE_FLOW_CONTROL mode */
   SpiModeType eSpiMode;               /*!< @brief Type of SPI configured */
   u8 u8PeripheralId;                  /*!< @brief Simple peripheral ID number */
-  u8 u8Pad;                           /*!< @brief Preserve 4-byte alignment */
+  u8 u8ChipSelect;                    /*!< @brief Hardware chip select line NPCS0-3 used by this device */
   u32 u32PrivateFlags;                /*!< @brief Private peripheral flags */
   u8* pu8RxBuffer;                    /*!< @brief Pointer to receive buffer in user application */
   u8** ppu8RxNextByte;                /*!< @brief Pointer to buffer location where next received byte will be placed (SPI_SLAVE_FLOW_CONTROL only) */
@@ -97,8 +98,36 @@ Constants / Definitions
 #define SPI_ERROR_FLAG_MASK           (u32)0xFF000000    /*!< @brief AND to SPI_u32Flags to get just error flags */
 /* end of SPI_u32Flags flags */
 
+#define U8_SPI_NUM_CHIP_SELECTS       (u8)4              /*!< @brief Hardware chip selects NPCS0-3 (one device per chip select) */
+#define SPI_TDR_PCS_SHIFT             (u32)16            /*!< @brief Position of the PCS field in SPI_TDR (variable peripheral select) */
+
 #define SPI_DUMMY                     (u8)0xAA           /*!< @brief Byte to send for dummy */
 
+/* DMAC setup for Master transfers */
+#define SPI_DMA_MAX_WORDS             (u16)64            /*!< @brief Size of the TDR word buffer = most bytes moved by one DMAC block */
+#define SPI_DMA_TX_CHANNEL            (u8)0              /*!< @brief DMAC channel that writes SPI_TDR */
+#define SPI_DMA_RX_CHANNEL            (u8)1              /*!< @brief DMAC channel that reads SPI_RDR */
+#define SPI_DMA_TX_CHANNEL_BIT        AT91C_HDMA_ENA0    /*!< @brief Channel bit in CHER/CHDR/CHSR and BTC bit in EBCIxR for the Tx channel */
+#define SPI_DMA_RX_CHANNEL_BIT        AT91C_HDMA_ENA1    /*!< @brief Channel bit in CHER/CHDR/CHSR and BTC bit in EBCIxR for the Rx channel */
+
+/*! @brief Tx channel: 32-bit words (data + PCS + LASTXFER) from the word buffer to TDR, paced by SPI0 Tx (handshake interface 1) */
+#define SPI_DMA_TX_CTRLA              (u32)(AT91C_HDMA_SRC_WIDTH_WORD | AT91C_HDMA_DST_WIDTH_WORD | \
+                                            AT91C_HDMA_SCSIZE_1 | AT91C_HDMA_DCSIZE_1)
+#define SPI_DMA_TX_CTRLB              (u32)(AT91C_HDMA_SRC_DSCR_FETCH_DISABLE | AT91C_HDMA_DST_DSCR_FETCH_DISABLE | \
+                                            AT91C_HDMA_FC_MEM2PER | AT91C_HDMA_SRC_ADDRESS_MODE_INCR | \
+                                            AT91C_HDMA_DST_ADDRESS_MODE_FIXED)
+#define SPI_DMA_TX_CFG                (u32)(AT91C_HDMA_DST_PER_1 | AT91C_HDMA_DST_H2SEL_HW | AT91C_HDMA_SOD_ENABLE | \
+                                            AT91C_HDMA_FIFOCFG_ENOUGHSPACE)
+
+/*! @brief Rx channel: bytes from RDR to the device's Rx buffer, paced by SPI0 Rx (handshake interface 2) */
+#define SPI_DMA_RX_CTRLA              (u32)(AT91C_HDMA_SRC_WIDTH_BYTE | AT91C_HDMA_DST_WIDTH_BYTE | \
+                                            AT91C_HDMA_SCSIZE_1 | AT91C_HDMA_DCSIZE_1)
+#define SPI_DMA_RX_CTRLB              (u32)(AT91C_HDMA_SRC_DSCR_FETCH_DISABLE | AT91C_HDMA_DST_DSCR_FETCH_DISABLE | \
+                                            AT91C_HDMA_FC_PER2MEM | AT91C_HDMA_SRC_ADDRESS_MODE_FIXED | \
+                                            AT91C_HDMA_DST_ADDRESS_MODE_INCR)
+#define SPI_DMA_RX_CFG                (u32)(AT91C_HDMA_SRC_PER_2 | AT91C_HDMA_SRC_H2SEL_HW | AT91C_HDMA_SOD_ENABLE | \
+                                            AT91C_HDMA_FIFOCFG_ENOUGHSPACE)
+
 #define SPI_TXEMPTY_TIMEOUT           (u32)100           /*!< @brief Instruction cycles of a while loop that waits for a register to clear */
 
 
@@ -129,11 +158,17 @@ void SpiRunActiveState(void);
 void SpiManualMode(void);
 
 void SPI0_IrqHandler(void);
+void HDMA_IrqHandler(void);
 
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*! @privatesection */                                                                                            
 /*-------------------------------------------------------------------------------------------------------------------*/
+static void SpiStartNextTransfer(void);
+static void SpiStopTransfer(SpiPeripheralType* psSpi_);
+static void SpiDmaStartBlock(SpiPeripheralType* psSpi_);
+static u32 SpiNextTxWord(SpiPeripheralType* psSpi_);
+static void SpiWriteNextByte(SpiPeripheralType* psSpi_);
 
 
 /***********************************************************************************************************************
@@ -285,6 +285,7 @@ SspPeripheralType* SspRequest(SspConfigurationType* psSspConfig_)
   psRequestedSsp->u32PrivateFlags |= _SSP_PERIPHERAL_ASSIGNED;
   psRequestedSsp->fnSlaveTxFlowCallback = psSspConfig_->fnSlaveTxFlowCallback;
   psRequestedSsp->fnSlaveRxFlowCallback = psSspConfig_->fnSlaveRxFlowCallback;
+  psRequestedSsp->fnSlaveCsAssertCallback = psSspConfig_->fnSlaveCsAssertCallback;
    
   psRequestedSsp->pBaseAddress->US_CR   = u32TargetCR;
   psRequestedSsp->pBaseAddress->US_MR   = u32TargetMR;
@@ -369,6 +370,7 @@ void SspRelease(SspPeripheralType* psSspPeripheral_)
   
   psSspPeripheral_->fnSlaveTxFlowCallback = NULL;
   psSspPeripheral_->fnSlaveRxFlowCallback = NULL;
+  psSspPeripheral_->fnSlaveCsAssertCallback = NULL;
 
   /* Empty the transmit buffer if there were leftover messages */
   while(psSspPeripheral_->psTransmitBuffer != NULL)
@@ -794,6 +796,8 @@ Promises:
 */
 void SSP0_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to SSP0 targets */
   SSP_psCurrentISR = &SSP_Peripheral0;                         
   SSP_pu32SspApplicationFlagsISR = &G_u32Ssp0ApplicationFlags; 
@@ -801,7 +805,8 @@ void SSP0_IRQHandler(void)
 
   /* Go to common SSP interrupt using psCurrentSspISR since the SSP cannot interrupt itself */
   SspGenericHandler();
-  
+
+  ISR_PROFILE_EXIT();
 } /* end SSP0_IRQHandler() */
 
 
@@ -820,6 +825,8 @@ Promises:
 */
 void SSP1_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to SSP1 targets */
   SSP_psCurrentISR = &SSP_Peripheral1;                      
   SSP_pu32SspApplicationFlagsISR = &G_u32Ssp1ApplicationFlags; 
@@ -827,7 +834,8 @@ void SSP1_IRQHandler(void)
 
   /* Go to common SSP interrupt using psCurrentSspISR since the SSP cannot interrupt itself */
   SspGenericHandler();
-  
+
+  ISR_PROFILE_EXIT();
 } /* end SSP1_IRQHandler() */
 
 
@@ -846,6 +854,8 @@ Promises:
 */
 void SSP2_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to SSP2 targets */
   SSP_psCurrentISR = &SSP_Peripheral2;                      
   SSP_pu32SspApplicationFlagsISR = &G_u32Ssp2ApplicationFlags;
@@ -853,7 +863,8 @@ void SSP2_IRQHandler(void)
 
   /* Go to common SSP interrupt using psCurrentSspISR since the SSP cannot interrupt itself */
   SspGenericHandler();
- 
+
+  ISR_PROFILE_EXIT();
 } /* end SSP2_IRQHandler() */
 
 
@@ -925,6 +936,12 @@ static void SspGenericHandler(void)
       if(SSP_psCurrentISR->eSspMode == SSP_SLAVE_FLOW_CONTROL)
       {
         SSP_psCurrentISR->pBaseAddress->US_IER |= AT91C_US_RXRDY;
+        
+        /* Let the application time stamp the start of the transaction */
+        if(SSP_psCurrentISR->fnSlaveCsAssertCallback != NULL)
+        {
+          SSP_psCurrentISR->fnSlaveCsAssertCallback();
+        }
       }
 
     }
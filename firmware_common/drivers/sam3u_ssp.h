@@ -43,6 +43,7 @@ typedef struct
   SspModeType eSspMode;               /*!< @brief Type of SPI configured */
   fnCode_type fnSlaveTxFlowCallback;  /*!< @brief Callback function for SSP_SLAVE_FLOW_CONTROL transmit */
   fnCode_type fnSlaveRxFlowCallback;  /*!< @brief Callback function for SSP_SLAVE_FLOW_CONTROL receive */
+  fnCode_type fnSlaveCsAssertCallback;/*!< @brief Optional callback when CS is asserted for SSP_SLAVE_FLOW_CONTROL (NULL if unused) */
   u8* pu8RxBufferAddress;             /*!< @brief Address to circular receive buffer */
   u8** ppu8RxNextByte;                /*!< @brief Location of pointer to next byte to write in buffer for SSP_SLAVE_FLOW_CONTROL only */
   u16 u16RxBufferSize;                /*!< @brief Size of receive buffer in bytes */
@@ -64,6 +65,7 @@ typedef struct
   u32 u32PrivateFlags;                /*!< @brief Private peripheral flags */
   fnCode_type fnSlaveTxFlowCallback;  /*!< @brief Callback function for SPI SLAVE transmit that uses flow control */
   fnCode_type fnSlaveRxFlowCallback;  /*!< @brief Callback function for SPI SLAVE receive that uses flow control */
+  fnCode_type fnSlaveCsAssertCallback;/*!< @brief Callback function when CS is asserted on a SPI SLAVE that uses flow control (may be NULL) */
   u8* pu8RxBuffer;                    /*!< @brief Pointer to receive buffer in user application */
   u8** ppu8RxNextByte;                /*!< @brief Pointer to buffer location where next received byte will be placed (SSP_SLAVE_FLOW_CONTROL only) */
   u16 u16RxBufferSize;                /*!< @brief Size of receive buffer in bytes */
@@ -31,6 +31,7 @@ PUBLIC FUNCTIONS
 - void UartRelease(UartPeripheralType* psUartPeripheral_)
 - u32 UartWriteByte(UartPeripheralType* psUartPeripheral_, u8 u8Byte_)
 - u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* pu8Data_)
+- u32 UartDropQueuedMessage(UartPeripheralType* psUartPeripheral_)
 
 PROTECTED FUNCTIONS
 - void UartInitialize(void);
@@ -350,6 +351,64 @@ u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* pu8Da
 } /* end UartWriteData() */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u32 UartDropQueuedMessage(UartPeripheralType* psUartPeripheral_)
+
+@brief Removes the oldest message that has not started sending from a UART transmit buffer.  
+
+The first message in the buffer may already be in transfer so it is never removed.
+A message that was split across message slots (bMoreSlots) is handled whole: the
+rest of the message in transfer is kept and every slot of the removed message is
+removed, so a message is never sent in part.
+
+Requires:
+@param psUartPeripheral_ has been requested
+
+Promises:
+- The first message after the one in transfer in psUartPeripheral_->psTransmitBuffer 
+  is taken out with all of its slots, which are returned to the message pool with 
+  their status set to ABANDONED
+- Returns the size in bytes of the removed message; 0 if there was no message to remove
+
+*/
+u32 UartDropQueuedMessage(UartPeripheralType* psUartPeripheral_)
+{
+  MessageType* psInTransfer;
+  MessageType** ppsWaiting;
+  bool bMoreSlots;
+  u32 u32Size = 0;
+  
+  /* The UART ISR dequeues the first message when it is sent, so the list is changed with interrupts off */
+  __disable_irq();
+  psInTransfer = psUartPeripheral_->psTransmitBuffer;
+  if(psInTransfer != NULL)
+  {
+    /* Skip the rest of the message in transfer */
+    while( psInTransfer->bMoreSlots && (psInTransfer->psNextMessage != NULL) )
+    {
+      psInTransfer = psInTransfer->psNextMessage;
+    }
+    
+    /* Remove every slot of the next message (each slot has its own token) */
+    ppsWaiting = (MessageType**)&psInTransfer->psNextMessage;
+    if(*ppsWaiting != NULL)
+    {
+      do
+      {
+        bMoreSlots = (*ppsWaiting)->bMoreSlots;
+        u32Size += (*ppsWaiting)->u32Size;
+        UpdateMessageStatus((*ppsWaiting)->u32Token, ABANDONED);
+        DeQueueMessage(ppsWaiting);
+      } while( bMoreSlots && (*ppsWaiting != NULL) );
+    }
+  }
+  __enable_irq();
+  
+  return(u32Size);
+  
+} /* end UartDropQueuedMessage() */
+
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /*! @protectedsection */                                                                                            
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -481,6 +540,8 @@ Promises:
 */
 void UART_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to UART targets */
   Uart_psCurrentISR = &Uart_sPeripheral;                       
   Uart_u32IntCount++;
@@ -488,6 +549,7 @@ void UART_IRQHandler(void)
   /* Go to common UART interrupt using Uart_psCurrentISR since the SSP cannot interrupt itself */
   UartGenericHandler();
 
+  ISR_PROFILE_EXIT();
 } /* end Uart_IRQHandler() */
 
 
@@ -505,6 +567,8 @@ Promises:
 */
 void UART0_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to UART0 targets */
   Uart_psCurrentISR = &Uart_sPeripheral0;                         
   Uart_u32Int0Count++;
@@ -512,6 +576,7 @@ void UART0_IRQHandler(void)
   /* Go to common interrupt */
   UartGenericHandler();
 
+  ISR_PROFILE_EXIT();
 } /* end UART0_IRQHandler() */
 
 
@@ -529,6 +594,8 @@ Promises:
 */
 void UART1_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to UART1 targets */
   Uart_psCurrentISR = &Uart_sPeripheral1;                          
   Uart_u32Int1Count++;
@@ -536,6 +603,7 @@ void UART1_IRQHandler(void)
   /* Go to common interrupt */
   UartGenericHandler();
 
+  ISR_PROFILE_EXIT();
 } /* end UART1_IRQHandler() */
 
 
@@ -553,6 +621,8 @@ Promises:
 */
 void UART2_IRQHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Set the current ISR pointers to UART2 targets */
   Uart_psCurrentISR = &Uart_sPeripheral2;                          
   Uart_u32Int2Count++;
@@ -560,6 +630,7 @@ void UART2_IRQHandler(void)
   /* Go to common interrupt */
   UartGenericHandler();
 
+  ISR_PROFILE_EXIT();
 } /* end UART2_IRQHandler() */
 
 
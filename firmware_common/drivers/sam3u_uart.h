@@ -61,6 +61,7 @@ void UartRelease(UartPeripheralType* psUartPeripheral_);
 
 u32 UartWriteByte(UartPeripheralType* psUartPeripheral_, u8 u8Byte_);
 u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* pu8Data_);
+u32 UartDropQueuedMessage(UartPeripheralType* psUartPeripheral_);
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -14,10 +14,12 @@ TYPES
 
 PUBLIC FUNCTIONS
 - void TimerSet(TimerChannelType eTimerChannel_, u16 u16TimerValue_)
+- void TimerSetCompareA(TimerChannelType eTimerChannel_, u16 u16CompareValue_)
 - void TimerStart(TimerChannelType eTimerChannel_)
 - void TimerStop(TimerChannelType eTimerChannel_)
 - u16 TimerGetTime(TimerChannelType eTimerChannel_)
 - void TimerAssignCallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCallback_)
+- void TimerAssignCompareACallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCallback_)
  
 PROTECTED FUNCTIONS
 - void TimerInitialize(void)
@@ -48,8 +50,11 @@ Global variable definitions with scope limited to this local application.
 Variable names shall start with "Timer_<type>" and be declared as static.
 ***********************************************************************************************************************/
 static fnCode_type Timer_fpStateMachine;          /*!< @brief The state machine function pointer */
+static fnCode_type Timer_fpTimer0Callback;        /*!< @brief Timer0 RC compare ISR callback function pointer */
+static fnCode_type Timer_fpTimer0CompareACallback;/*!< @brief Timer0 RA compare ISR callback function pointer */
 static fnCode_type Timer_fpTimer1Callback;        /*!< @brief Timer1 ISR callback function pointer */
 
+static u32 Timer_u32Timer0IntCounter = 0;         /*!< @brief Track instances of The TC0 interrupt handler */
 static u32 Timer_u32Timer1IntCounter = 0;         /*!< @brief Track instances of The TC1 interrupt handler */
 
 
@@ -66,9 +71,9 @@ Function Definitions
 
 @brief Sets the timer tick period (interrupt rate).
 
-Based on the configuration value for the timer, each tick is 2.67us.  It is expected
-the user knows this and u16TimerValue_ holds a multiple of 2.67us that is
-desired to be timed.
+Based on the configuration value for the timer, each tick is 2.67us (41.7ns on 
+Channel 0).  It is expected the user knows this and u16TimerValue_ holds a 
+multiple of the tick that is desired to be timed.
 
 Requires:
 - TimerStop should be called before, and TimerStart should be called after 
@@ -93,6 +98,37 @@ void TimerSet(TimerChannelType eTimerChannel_, u16 u16TimerValue_)
 } /* end TimerSet() */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void TimerSetCompareA(TimerChannelType eTimerChannel_, u16 u16CompareValue_)
+
+@brief Sets the RA compare point where the Compare A callback runs.
+
+Only Channel 0 has the RA compare interrupt enabled.  The value is in the same 
+ticks as TimerSet() and must be less than the TimerSet() value to be reached.
+
+Requires:
+- TimerStop should be called before, and TimerStart should be called after 
+this function to reset the counter and avoid glitches.
+
+@param eTimerChannel_ holds a valid channel
+@param u16CompareValue_ is the number of ticks from start until the RA compare
+
+Promises:
+- Updates register TC_RA value with u16CompareValue_
+
+*/
+void TimerSetCompareA(TimerChannelType eTimerChannel_, u16 u16CompareValue_)
+{
+  /* Build the offset to the selected channel */
+  u32 u32TimerBaseAddress = (u32)AT91C_BASE_TC0;
+  u32TimerBaseAddress += (u32)eTimerChannel_;
+
+  /* Load the new compare value */
+  (AT91_CAST(AT91PS_TC)u32TimerBaseAddress)->TC_RA = (u32)(u16CompareValue_) & 0x0000FFFF;
+
+} /* end TimerSetCompareA() */
+
+
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn void TimerStart(TimerChannelType eTimerChannel_)
 
@@ -186,6 +222,7 @@ void TimerAssignCallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCall
   {
     case TIMER0_CHANNEL0:
     {
+      Timer_fpTimer0Callback = fpUserCallback_;
       break;
     }
     case TIMER0_CHANNEL1:
@@ -206,6 +243,30 @@ void TimerAssignCallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCall
 } /* end TimerAssignCallback */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void TimerAssignCompareACallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCallback_)
+
+@brief Allows user to specify a custom callback function for when the RA compare 
+interrupt occurs.  Only Channel 0 supports this.
+
+Requires:
+@param eTimerChannel_ is the channel to which the callback will be assigned
+@param fpUserCallback_ is the function address (name) for the user's callback
+
+Promises:
+- Timer_fpTimer0CompareACallback loaded with fpUserCallback_ if eTimerChannel_ is TIMER0_CHANNEL0
+
+*/
+void TimerAssignCompareACallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCallback_)
+{
+  if(eTimerChannel_ == TIMER0_CHANNEL0)
+  {
+    Timer_fpTimer0CompareACallback = fpUserCallback_;
+  }
+  
+} /* end TimerAssignCompareACallback */
+
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /*! @protectedsection */                                                                                            
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -219,7 +280,7 @@ Requires:
 - NONE
 
 Promises:
-- Timer 1 is configured per timer.h INIT settings
+- Timers 0 and 1 are configured per timer.h INIT settings
 
 */
 void TimerInitialize(void)
@@ -227,7 +288,18 @@ void TimerInitialize(void)
   /* Load the block configuration registers */
   AT91C_BASE_TCB0->TCB_BMR = TCB_BMR_INIT;
  
-  /* Channel 0 and 2 settings not configured at this time */
+  /* Load Channel 0 settings (one-shot) and set the default callbacks */
+  AT91C_BASE_TC0->TC_CMR = TC0_CMR_INIT;
+  AT91C_BASE_TC0->TC_RA  = TC0_RA_INIT;
+  AT91C_BASE_TC0->TC_RC  = TC0_RC_INIT;
+  AT91C_BASE_TC0->TC_IER = TC0_IER_INIT;
+  AT91C_BASE_TC0->TC_IDR = TC0_IDR_INIT;
+  AT91C_BASE_TC0->TC_CCR = TC0_CCR_INIT;
+
+  Timer_fpTimer0Callback = TimerDefaultCallback;
+  Timer_fpTimer0CompareACallback = TimerDefaultCallback;
+
+  /* Channel 2 settings not configured at this time */
 
   /* Load Channel 1 settings and set the default callback */
   AT91C_BASE_TC1->TC_CMR = TC1_CMR_INIT;
@@ -242,6 +314,8 @@ void TimerInitialize(void)
   if( 1 )
   {
     /* Enable required interrupts */
+    NVIC_ClearPendingIRQ(IRQn_TC0);
+    NVIC_EnableIRQ(IRQn_TC0);
     NVIC_ClearPendingIRQ(IRQn_TC1);
     NVIC_EnableIRQ(IRQn_TC1);
     Timer_fpStateMachine = TimerSM_Idle;
@@ -281,6 +355,56 @@ void TimerRunActiveState(void)
 } /* end TimerRunActiveState */
 
 
+/*!----------------------------------------------------------------------------------------------------------------------
+@fn void TC0_IrqHandler(void)
+
+@brief Parses the TC0 interrupts and handles them appropriately.  
+
+Both compares can be pending together if the RA and RC values are close, so 
+the status register is read once and each flag is handled in time order.
+
+Requires:
+- NONE
+
+Promises:
+
+If Channel0 RA interrupt:
+- Associated Compare A callback function is invoked
+
+If Channel0 RC interrupt:
+- Timer Channel 0 clock is stopped (CPCSTOP) until the next TimerStart()
+- Associated callback function is invoked
+
+- IRQn_TC0 interrupt flag is cleared
+
+*/
+void TC0_IrqHandler(void)
+{
+  ISR_PROFILE_ENTER();
+
+  u32 u32Status;
+
+  /* Reading TC_SR clears the bits that are set */
+  u32Status = AT91C_BASE_TC0->TC_SR;
+  Timer_u32Timer0IntCounter++;
+
+  if(u32Status & AT91C_TC_CPAS)
+  {
+    Timer_fpTimer0CompareACallback();
+  }
+
+  if(u32Status & AT91C_TC_CPCS)
+  {
+    Timer_fpTimer0Callback();
+  }
+
+  /* Clear the TC pending flag and exit */
+  NVIC_ClearPendingIRQ(IRQn_TC0);
+
+  ISR_PROFILE_EXIT();
+} /* end TC0_IrqHandler() */
+
+
 /*!----------------------------------------------------------------------------------------------------------------------
 @fn void TC1_IrqHandler(void)
 
@@ -304,6 +428,8 @@ If Channel1 RC interrupt:
 */
 void TC1_IrqHandler(void)
 {
+  ISR_PROFILE_ENTER();
+
   /* Check for RC compare interrupt - reading TC_SR clears the bit if set */
   if(AT91C_BASE_TC1->TC_SR & AT91C_TC_CPCS)
   {
@@ -313,7 +439,8 @@ void TC1_IrqHandler(void)
 
   /* Clear the TC pending flag and exit */
   NVIC_ClearPendingIRQ(IRQn_TC1);
-  
+
+  ISR_PROFILE_EXIT();
 } /* end TC1_IrqHandler() */
 
 
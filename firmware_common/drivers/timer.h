@@ -26,10 +26,12 @@ Function Declarations
 /*! @publicsection */                                                                                            
 /*--------------------------------------------------------------------------------------------------------------------*/
 void TimerSet(TimerChannelType eTimerChannel_, u16 u16TimerValue_);
+void TimerSetCompareA(TimerChannelType eTimerChannel_, u16 u16CompareValue_);
 void TimerStart(TimerChannelType eTimerChannel_);
 void TimerStop(TimerChannelType eTimerChannel_);
 u16 TimerGetTime(TimerChannelType eTimerChannel_);
 void TimerAssignCallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCallBack_);
+void TimerAssignCompareACallback(TimerChannelType eTimerChannel_, fnCode_type fpUserCallBack_);
 
 
 /*------------------------------------------------------------------------------------------------------------------*/
@@ -73,6 +75,96 @@ PB6 is an open pin available for TIOB1 I/O function if set for Peripheral A
 
 */
 
+/* Timer Channel 0 Setup */
+/* Channel 0 is a one-shot: a software trigger starts it, RA compare interrupts part way
+and the clock stops on RC compare.  1 tick = 41.7ns; max 65535 */
+#define TC0_RA_INIT (u32)24
+#define TC0_RC_INIT (u32)48
+
+#define TC0_CCR_INIT (u32)0x00000002
+/*
+    31-04 [0] Reserved
+
+    03 [0] Reserved
+    02 [0] SWTRG no software trigger
+    01 [1] CLKDIS Clock disabled to start
+    00 [0] CLKEN Clock not enabled 
+*/
+
+#define TC0_CMR_INIT (u32)0x0000C440
+/*
+    31 [0] BSWTRG no software trigger effect on TIOB
+    30 [0] "
+    29 [0] BEEVT no external event effect on TIOB
+    28 [0] "
+
+    27 [0] BCPC no RC compare effect on TIOB
+    26 [0] "
+    25 [0] BCPB no RB compare effect on TIOB
+    24 [0] "
+
+    23 [0] ASWTRG no TIOA software trigger effect
+    22 [0] "
+    21 [0] AEEVT no TIOA effect on external compare
+    20 [0] "
+
+    19 [0] ACPC no RC compare effect on TIOA
+    18 [0] "
+    17 [0] ACPA No RA compare effect on TIOA
+    16 [0] "
+
+    15 [1] WAVE Waveform Mode is enabled
+    14 [1] WAVSEL Up to RC mode
+    13 [0] "
+    12 [0] ENETRG external event has no effect
+
+    11 [0] EEVT external event assigned to XC0
+    10 [1] "
+    09 [0] EEVTEDG no external event trigger
+    08 [0] "
+
+    07 [0] CPCDIS clock is NOT disabled when reaches RC
+    06 [1] CPCSTOP clock is stopped when reaches RC (one-shot)
+    05 [0] BURST not gated
+    04 [0] "
+
+    03 [0] CLKI Counter incremented on rising edge
+    02 [0] TCCLKS TIMER_CLOCK1 (MCK/2 = 41.7ns / tick)
+    01 [0] "
+    00 [0] "
+*/
+
+#define TC0_IER_INIT (u32)0x00000014
+/*
+    31-08 [0] Reserved 
+
+    07 [0] ETRGS RC Load interrupt not enabled
+    06 [0] LDRBS RB Load interrupt not enabled
+    05 [0] LDRAS RA Load interrupt not enabled
+    04 [1] CPCS RC compare interrupt is enabled
+
+    03 [0] CPBS RB compare interrupt not enabled
+    02 [1] CPAS RA Compare Interrupt is enabled
+    01 [0] LOVRS Load Overrun interrupt not enabled 
+    00 [0] COVFS Counter Overflow interrupt not enabled
+*/
+
+#define TC0_IDR_INIT (u32)0x000000EB
+/*
+    31-08 [0] Reserved 
+
+    07 [1] ETRGS RC Load interrupt disabled
+    06 [1] LDRBS RB Load interrupt disabled
+    05 [1] LDRAS RA Load interrupt disabled
+    04 [0] CPCS RC compare interrupt not disabled
+
+    03 [1] CPBS RB compare interrupt disabled
+    02 [0] CPAS RA Compare Interrupt not disabled
+    01 [1] LOVRS Load Overrun interrupt disabled 
+    00 [1] COVFS Counter Overflow interrupt disabled
+*/
+
+
 /* Timer Channel 1 Setup */
 
 /* Default Timer 1 interrupt period of just about 100us (1 tick = 2.67us); max 65535 */
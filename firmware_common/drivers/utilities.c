@@ -15,6 +15,13 @@ TYPES
 
 PUBLIC FUNCTIONS
 - bool IsTimeUp(u32 *pu32SavedTick_, u32 u32Period_)
+- u32 GetSystemTimeUs(void)
+- void GetSystemTimeTicks(u32* pu32Ms_, u32* pu32Ticks_)
+- u8 NumberToAscii(u32 u32Number_, u8* pu8AsciiString_)
+- u8 FormatUnsigned(u32 u32Number_, u8* pu8Target_)
+- u8 FormatSigned(s32 s32Number_, u8* pu8Target_)
+- u8 FormatHex(u32 u32Number_, u8* pu8Target_, u8 u8MinDigits_, bool bUpperCase_)
+- u8 FormatFixedPoint(s32 s32Number_, u8 u8Decimals_, u8* pu8Target_)
 
 PROTECTED FUNCTIONS
 - NONE
@@ -46,6 +53,17 @@ extern volatile u32 G_u32ApplicationFlags;             /*!< From main.c */
 Global variable definitions with scope limited to this local application.
 Variable names shall start with "Util_<type>" and be declared as static.
 ***********************************************************************************************************************/
+/*! @brief "00" to "99" so decimal conversions make two digits per division */
+static const u8 Util_au8DigitPairs[] = 
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+/*! @brief Smallest number with 2 to 10 decimal digits */
+static const u32 Util_au32DecimalLimits[] = 
+{10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
 
 
 /***********************************************************************************************************************
@@ -111,6 +129,77 @@ bool IsTimeUp(u32 *pu32SavedTick_, u32 u32Period_)
 } /* end IsTimeUp() */
 
 
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u32 GetSystemTimeUs(void)
+
+@brief Returns the system time in microseconds from G_u32SystemTime1ms and the SysTick counter.
+
+SysTick counts down U32_SYSTICK_COUNT ticks each millisecond, so the resolution is 
+1000 / U32_SYSTICK_COUNT ms.  The value rolls over about every 71 minutes, so use 
+differences between two readings.  This is safe to call from an ISR.
+
+Requires:
+- SysTickSetup() has run
+
+Promises:
+- Returns (G_u32SystemTime1ms * 1000) + the microseconds elapsed in the current millisecond
+
+*/
+u32 GetSystemTimeUs(void)
+{
+  u32 u32Ms;
+  u32 u32Ticks;
+  
+  GetSystemTimeTicks(&u32Ms, &u32Ticks);
+  return( (u32Ms * 1000) + ((U32_SYSTICK_COUNT - 1 - u32Ticks) / (U32_SYSTICK_COUNT / 1000)) );
+  
+} /* end GetSystemTimeUs() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn void GetSystemTimeTicks(u32* pu32Ms_, u32* pu32Ticks_)
+
+@brief Reads G_u32SystemTime1ms and the SysTick down-counter as a matching pair.
+
+Reading the two one after the other is not enough: a SysTick between the reads
+gives a millisecond that does not belong to the counter value.  Two pairs read 
+this way can be subtracted to measure short intervals at SysTick resolution.
+This is safe to call from an ISR.
+
+Requires:
+- SysTickSetup() has run
+
+@param pu32Ms_ points to where the millisecond count is written
+@param pu32Ticks_ points to where NVIC_STICKCVR is written (counts down from U32_SYSTICK_COUNT - 1)
+
+Promises:
+- *pu32Ms_ is the millisecond that *pu32Ticks_ is counting down in
+
+*/
+void GetSystemTimeTicks(u32* pu32Ms_, u32* pu32Ticks_)
+{
+  u32 u32Ms;
+  u32 u32Ticks;
+  
+  /* Read again if the SysTick interrupt updated the ms counter in between */
+  do
+  {
+    u32Ms = G_u32SystemTime1ms;
+    u32Ticks = AT91C_BASE_NVIC->NVIC_STICKCVR;
+  } while(u32Ms != G_u32SystemTime1ms);
+  
+  /* In an ISR or with interrupts off, the counter may have reloaded before the tick was counted */
+  if( (AT91C_BASE_NVIC->NVIC_ICSR & AT91C_NVIC_PENDSTSET) && (u32Ticks > (U32_SYSTICK_COUNT / 2)) )
+  {
+    u32Ms++;
+  }
+  
+  *pu32Ms_ = u32Ms;
+  *pu32Ticks_ = u32Ticks;
+  
+} /* end GetSystemTimeTicks() */
+
+
 /*!---------------------------------------------------------------------------------------------------------------------
 @fn u8 ASCIIHexCharToNum(u8 u8Char_)
 
@@ -218,10 +307,12 @@ u8 HexToASCIICharLower(u8 u8Char_)
 
 @brief Converts a long into an ASCII string.  Maximum of 10 digits + NULL.
 
+Same as FormatUnsigned(); kept for existing callers.
+
 Requires:
 @param u32Number_ is the number to convert
 @param *pu8AsciiString_ points to the destination string location which must
-have sufficient space for the number.
+have sufficient space for the number (UTIL_FORMAT_U32_SIZE).
  
 Promises:
 - Null-terminated string of the number is loaded to pu8AsciiString_
@@ -230,49 +321,217 @@ Promises:
 */
 u8 NumberToAscii(u32 u32Number_, u8* pu8AsciiString_)
 {
-  bool bFoundDigit = FALSE;
-  u8 au8AsciiNumber[11];
-  u8 u8CharCount = 0;
-  u32 u32Divider = 1000000000;
-  u8 u8Temp;
-  
-  /* Parse out all the digits, start counting after leading zeros */
-  for(u8 i = 0; i < 10; i++)
+  return( FormatUnsigned(u32Number_, pu8AsciiString_) );
+
+} /* end NumberToAscii() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u8 FormatUnsigned(u32 u32Number_, u8* pu8Target_)
+
+@brief Writes an unsigned number in decimal without leading zeros.
+
+The digit count is found first so the string is written in place from its 
+last digit.  Each step divides by the constant 100, which the compiler does 
+with a multiply, and copies two digits from Util_au8DigitPairs.
+
+Example:
+u8 au8Number[UTIL_FORMAT_U32_SIZE];
+u8 u8Length = FormatUnsigned(u32Count, au8Number);
+
+Requires:
+@param u32Number_ is the number to convert
+@param pu8Target_ has room for UTIL_FORMAT_U32_SIZE characters
+ 
+Promises:
+- Null-terminated string of the number is written to pu8Target_
+- Returns the number of digits (1 to 10)
+
+*/
+u8 FormatUnsigned(u32 u32Number_, u8* pu8Target_)
+{
+  u8 u8Digits = 1;
+  u8* pu8Next;
+  u32 u32Quotient;
+  u32 u32Pair;
+  
+  while( (u8Digits < 10) && (u32Number_ >= Util_au32DecimalLimits[u8Digits - 1]) )
   {
-    u8Temp = (u32Number_ / u32Divider);
-    
-    /* Check for first non-leading zero */
-    if(u8Temp != 0)
-    {
-      bFoundDigit = TRUE;
-    }
+    u8Digits++;
+  }
+  
+  pu8Next = pu8Target_ + u8Digits;
+  *pu8Next = '\0';
+  
+  while(u32Number_ >= 100)
+  {
+    u32Quotient = u32Number_ / 100;
+    u32Pair = (u32Number_ - (u32Quotient * 100)) * 2;
+    *(--pu8Next) = Util_au8DigitPairs[u32Pair + 1];
+    *(--pu8Next) = Util_au8DigitPairs[u32Pair];
+    u32Number_ = u32Quotient;
+  }
+  
+  if(u32Number_ >= 10)
+  {
+    *(--pu8Next) = Util_au8DigitPairs[(u32Number_ * 2) + 1];
+    *(--pu8Next) = Util_au8DigitPairs[u32Number_ * 2];
+  }
+  else
+  {
+    *(--pu8Next) = (u8)u32Number_ + NUMBER_ASCII_TO_DEC;
+  }
+  
+  return(u8Digits);
 
-    /* As long as a non-leading zero has been found, add the ASCII char */
-    if(bFoundDigit)
-    {
-      au8AsciiNumber[u8CharCount] = u8Temp + 0x30;
-      u8CharCount++;
-    }
+} /* end FormatUnsigned() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u8 FormatSigned(s32 s32Number_, u8* pu8Target_)
+
+@brief Writes a signed number in decimal with a leading '-' if negative.
+
+Requires:
+@param s32Number_ is the number to convert
+@param pu8Target_ has room for UTIL_FORMAT_S32_SIZE characters
+ 
+Promises:
+- Null-terminated string of the number is written to pu8Target_
+- Returns the number of characters including the sign
+
+*/
+u8 FormatSigned(s32 s32Number_, u8* pu8Target_)
+{
+  if(s32Number_ < 0)
+  {
+    *pu8Target_ = '-';
     
-    /* Update for next iteration */
-    u32Number_ %= u32Divider;
-    u32Divider /= 10;
+    /* Negate as unsigned so -2147483648 works */
+    return( 1 + FormatUnsigned(0 - (u32)s32Number_, pu8Target_ + 1) );
   }
   
-  /* Handle special case where u32Number == 0 */
-  if(!bFoundDigit)
+  return( FormatUnsigned((u32)s32Number_, pu8Target_) );
+
+} /* end FormatSigned() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u8 FormatHex(u32 u32Number_, u8* pu8Target_, u8 u8MinDigits_, bool bUpperCase_)
+
+@brief Writes an unsigned number in hexadecimal, zero-padded to a minimum width.
+
+Only shifts and masks are used.
+
+Example:
+FormatHex(0x2A, au8Text, 4, TRUE);  // "002A"
+
+Requires:
+@param u32Number_ is the number to convert
+@param pu8Target_ has room for UTIL_FORMAT_HEX_SIZE characters
+@param u8MinDigits_ is the least number of digits to write (1 to 8)
+@param bUpperCase_ is TRUE for A-F, FALSE for a-f
+ 
+Promises:
+- Null-terminated string of the number is written to pu8Target_
+- Returns the number of digits
+
+*/
+u8 FormatHex(u32 u32Number_, u8* pu8Target_, u8 u8MinDigits_, bool bUpperCase_)
+{
+  u8 u8Digits = 1;
+  u8 u8Nibble;
+  u8 u8LetterOffset = bUpperCase_ ? UPPERCASE_ASCII_TO_DEC : LOWERCASE_ASCII_TO_DEC;
+  
+  while( (u8Digits < 8) && (u32Number_ >> (4 * u8Digits)) )
   {
-    u8CharCount = 1;
-    au8AsciiNumber[0] = '0';
+    u8Digits++;
   }
   
-  /* Add the null and copy to destination */
-  au8AsciiNumber[u8CharCount] = '\0';
-  strcpy((char *)pu8AsciiString_, (const char*)au8AsciiNumber);
+  if(u8MinDigits_ > 8)
+  {
+    u8MinDigits_ = 8;
+  }
   
-  return(u8CharCount);
+  if(u8Digits < u8MinDigits_)
+  {
+    u8Digits = u8MinDigits_;
+  }
+  
+  pu8Target_[u8Digits] = '\0';
+  for(u8 i = u8Digits; i != 0; i--)
+  {
+    u8Nibble = (u8)(u32Number_ & 0x0F);
+    pu8Target_[i - 1] = u8Nibble + ( (u8Nibble < 10) ? NUMBER_ASCII_TO_DEC : u8LetterOffset );
+    u32Number_ >>= 4;
+  }
+  
+  return(u8Digits);
 
-} /* end NumberToAscii() */
+} /* end FormatHex() */
+
+
+/*!---------------------------------------------------------------------------------------------------------------------
+@fn u8 FormatFixedPoint(s32 s32Number_, u8 u8Decimals_, u8* pu8Target_)
+
+@brief Writes a scaled integer as a decimal number, e.g. 12345 with 2 decimals is "123.45".
+
+Requires:
+@param s32Number_ is the value multiplied by 10^u8Decimals_
+@param u8Decimals_ is the number of digits after the decimal point (0 to UTIL_FORMAT_MAX_DECIMALS)
+@param pu8Target_ has room for UTIL_FORMAT_FIXED_SIZE characters
+ 
+Promises:
+- Null-terminated string of the number is written to pu8Target_, with a leading
+  '-' if negative and a '0' before the point if the value is less than 1
+- Returns the number of characters
+
+*/
+u8 FormatFixedPoint(s32 s32Number_, u8 u8Decimals_, u8* pu8Target_)
+{
+  u8 au8Digits[UTIL_FORMAT_FIXED_SIZE];
+  u8* pu8Next = pu8Target_;
+  u8 u8Digits;
+  u8 u8Whole;
+  u32 u32Magnitude;
+  
+  if(u8Decimals_ > UTIL_FORMAT_MAX_DECIMALS)
+  {
+    u8Decimals_ = UTIL_FORMAT_MAX_DECIMALS;
+  }
+  
+  if(u8Decimals_ == 0)
+  {
+    return( FormatSigned(s32Number_, pu8Target_) );
+  }
+  
+  u32Magnitude = (u32)s32Number_;
+  if(s32Number_ < 0)
+  {
+    *pu8Next++ = '-';
+    u32Magnitude = 0 - u32Magnitude;
+  }
+  
+  /* Zero-pad the digits so there is at least one before the point */
+  u8Digits = FormatUnsigned(u32Magnitude, au8Digits);
+  if(u8Digits <= u8Decimals_)
+  {
+    memmove(&au8Digits[u8Decimals_ + 1 - u8Digits], au8Digits, u8Digits);
+    memset(au8Digits, '0', u8Decimals_ + 1 - u8Digits);
+    u8Digits = u8Decimals_ + 1;
+  }
+  
+  u8Whole = u8Digits - u8Decimals_;
+  memcpy(pu8Next, au8Digits, u8Whole);
+  pu8Next += u8Whole;
+  *pu8Next++ = '.';
+  memcpy(pu8Next, &au8Digits[u8Whole], u8Decimals_);
+  pu8Next += u8Decimals_;
+  *pu8Next = '\0';
+  
+  return( (u8)(pu8Next - pu8Target_) );
+
+} /* end FormatFixedPoint() */
 
 
 /*!---------------------------------------------------------------------------------------------------------------------
@@ -75,6 +75,13 @@ Constants / Definitions
 #define MESSAGE_TASK_INIT       " task initializing... "            /*!< @brief Standard message */
 #define MESSAGE_TASK_INIT_SIZE  (u8)(sizeof(MESSAGE_TASK_INIT) - 1) /*!< @brief Message size in bytes less NULL */
 
+/* Buffer sizes for the Format functions including the NULL */
+#define UTIL_FORMAT_U32_SIZE    (u8)11        /*!< @brief FormatUnsigned(): "4294967295" */
+#define UTIL_FORMAT_S32_SIZE    (u8)12        /*!< @brief FormatSigned(): "-2147483648" */
+#define UTIL_FORMAT_HEX_SIZE    (u8)9         /*!< @brief FormatHex(): "FFFFFFFF" */
+#define UTIL_FORMAT_FIXED_SIZE  (u8)13        /*!< @brief FormatFixedPoint(): "-2.147483648" or "-0.000000001" */
+#define UTIL_FORMAT_MAX_DECIMALS (u8)9        /*!< @brief Most decimal places for FormatFixedPoint() */
+
 
 /***********************************************************************************************************************
 * Function Declarations
@@ -85,11 +92,17 @@ Constants / Definitions
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 bool IsTimeUp(u32 *pu32SavedTick_, u32 u32Period_);
+u32 GetSystemTimeUs(void);
+void GetSystemTimeTicks(u32* pu32Ms_, u32* pu32Ticks_);
 
 u8 ASCIIHexCharToNum(u8);
 u8 HexToASCIICharUpper(u8 u8Char_);
 u8 HexToASCIICharLower(u8 u8Char_);
 u8 NumberToAscii(u32 u32Number_, u8* pu8AsciiString_);
+u8 FormatUnsigned(u32 u32Number_, u8* pu8Target_);
+u8 FormatSigned(s32 s32Number_, u8* pu8Target_);
+u8 FormatHex(u32 u32Number_, u8* pu8Target_, u8 u8MinDigits_, bool bUpperCase_);
+u8 FormatFixedPoint(s32 s32Number_, u8 u8Decimals_, u8* pu8Target_);
 bool SearchString(u8* pu8TargetString_, u8* pu8MatchString_);
 
 
@@ -487,11 +487,7 @@ void CapTouchSM_Measure(void)
     {
       u32DebugPrintTimer = G_u32SystemTime1ms;
 
-      DebugPrintf("Captouch (H:V) ");
-      DebugPrintNumber(CapTouch_u8CurrentHSliderValue);
-      DebugPrintf(":");
-      DebugPrintNumber(CapTouch_u8CurrentVSliderValue);
-      DebugLineFeed();
+      DebugPrintfFmt("Captouch (H:V) %u:%u\n\r", CapTouch_u8CurrentHSliderValue, CapTouch_u8CurrentVSliderValue);
     }
   }
                